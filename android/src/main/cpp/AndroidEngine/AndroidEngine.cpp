@@ -1,11 +1,43 @@
 #include "AndroidEngine.h"
+#include <chrono>
+#include "../OfflineEngine/OfflineEngine.h"
 #include "../Utils/Logging.h"
 
+static int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 oboe::DataCallbackResult AndroidEngine::onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames) {
     float* outputBuffer = static_cast<float *>(audioData);
 
+    // Timestamps can be unavailable until the stream has been running for a moment
+    auto latencyMillis = oboeStream->calculateLatencyMillis();
+    if (latencyMillis) {
+        mSchedulerMixer.setOutputLatencyFrames(static_cast<uint32_t>(latencyMillis.value() * oboeStream->getSampleRate() / 1000));
+    }
+
+    auto xRunCount = oboeStream->getXRunCount();
+    if (xRunCount && xRunCount.value() > mXRunCount) {
+        mSchedulerMixer.reportUnderrun(static_cast<uint32_t>(xRunCount.value() - mXRunCount));
+        mXRunCount = xRunCount.value();
+    }
+
     mSchedulerMixer.renderAudio(outputBuffer, numFrames);
 
+    auto isReleasable = mIsStreamReleaseEnabled.load(std::memory_order_relaxed)
+            && mSchedulerMixer.getIdleFrames() >= kStreamReleaseSeconds * oboeStream->getSampleRate();
+
+    if (isReleasable) {
+        mReleasedAtNs.store(steadyNowNs());
+        mIsStreamReleased.store(true);
+
+        // Anything that happened before the flag was set has to be seen here, since its wake()
+        // could have found the flag still clear. If a wake() took the flag since, it restarts us.
+        if (mSchedulerMixer.getIsIdleUndisturbed() || !mIsStreamReleased.exchange(false)) {
+            return oboe::DataCallbackResult::Stop;
+        }
+    }
+
     return oboe::DataCallbackResult::Continue;
 }
 
@@ -20,11 +52,22 @@ AndroidEngine::AndroidEngine(Dart_Port sampleRateCallbackPort) {
             ->openManagedStream(mOutStream);
 
     mSchedulerMixer.setChannelCount(mOutStream->getChannelCount());
+    mSchedulerMixer.setSampleRate(mOutStream->getSampleRate());
 
     callbackToDartInt32(sampleRateCallbackPort, mOutStream->getSampleRate());
 };
 
 AndroidEngine::~AndroidEngine() {
+    {
+        std::lock_guard<std::mutex> lock(mRenderMutex);
+        mIsPlayingAfterRender = false;
+    }
+
+    mIsRenderCancelled.store(true);
+    if (mRenderThread.joinable()) {
+        mRenderThread.join();
+    }
+
     mSchedulerMixer.pause();
 
     oboe::Result result = mOutStream->close();
@@ -48,8 +91,34 @@ int32_t AndroidEngine::getBufferSize() {
 }
 
 void AndroidEngine::play() {
+    std::lock_guard<std::mutex> lock(mRenderMutex);
+
+    if (mIsRendering) {
+        mIsPlayingAfterRender = true;
+        return;
+    }
+
+    startStream();
+}
+
+void AndroidEngine::pause() {
+    std::lock_guard<std::mutex> lock(mRenderMutex);
+
+    if (mIsRendering) {
+        mIsPlayingAfterRender = false;
+        return;
+    }
+
+    pauseStream();
+}
+
+// Caller must hold mRenderMutex.
+void AndroidEngine::startStream() {
     mSchedulerMixer.play();
 
+    // Stopped rather than paused, and maybe still stopping, so it can't be told to start just yet
+    if (mIsStreamReleased.load() && restartReleasedStream()) return;
+
     auto streamState = mOutStream->getState();
 
     // Don't request start if stream is already starting or started
@@ -64,9 +133,16 @@ void AndroidEngine::play() {
     }
 }
 
-void AndroidEngine::pause() {
+// Caller must hold mRenderMutex.
+void AndroidEngine::pauseStream() {
     mSchedulerMixer.pause();
 
+    // Already stopping, which does as well as a pause once it's done
+    if (mIsStreamReleased.exchange(false)) {
+        mOutStream->stop();
+        return;
+    }
+
     oboe::Result result = mOutStream->requestPause();
 
     if (result != oboe::Result::OK){
@@ -74,3 +150,96 @@ void AndroidEngine::pause() {
         return;
     }
 }
+
+void AndroidEngine::wake() {
+    if (!mIsStreamReleased.load()) return;
+
+    // A render has the mixer to itself, and restores the stream when it's done
+    std::lock_guard<std::mutex> lock(mRenderMutex);
+    if (!mIsRendering) {
+        restartReleasedStream();
+    }
+}
+
+void AndroidEngine::setStreamReleaseEnabled(bool isEnabled) {
+    mIsStreamReleaseEnabled.store(isEnabled, std::memory_order_relaxed);
+
+    if (!isEnabled) wake();
+}
+
+// Returns false if another caller got to the released stream first.
+bool AndroidEngine::restartReleasedStream() {
+    if (!mIsStreamReleased.exchange(false)) return false;
+
+    // The transport kept time while there were no callbacks
+    auto releasedNs = steadyNowNs() - mReleasedAtNs.load();
+    mSchedulerMixer.addMissedFrames(static_cast<uint32_t>(releasedNs * mOutStream->getSampleRate() / 1000000000));
+
+    // Returning Stop from the callback only requests a stop, so wait for it to finish
+    mOutStream->stop();
+    oboe::Result result = mOutStream->requestStart();
+
+    if (result != oboe::Result::OK){
+        LOGE("Failed to restart stream. Error: %s", convertToText(result));
+    }
+
+    return true;
+}
+
+// Unlike pause(), this blocks until the stream has stopped, so once it returns the callback is no
+// longer touching the mixer. The transport state is left alone.
+void AndroidEngine::stopStream() {
+    oboe::Result result = mOutStream->stop();
+
+    if (result != oboe::Result::OK){
+        LOGE("Failed to stop stream. Error: %s", convertToText(result));
+        return;
+    }
+}
+
+void AndroidEngine::renderOffline(std::string path, AudioFileFormat format, uint32_t numFrames, Dart_Port callbackPort) {
+    std::lock_guard<std::mutex> lock(mRenderMutex);
+
+    if (mIsRendering) {
+        LOGE("An offline render is already running");
+        callbackToDartDouble(callbackPort, -1.0);
+        return;
+    }
+
+    // The last render has released the mutex for good, so this won't wait on anything but its
+    // callback
+    if (mRenderThread.joinable()) {
+        mRenderThread.join();
+    }
+
+    mIsRendering = true;
+    mIsPlayingAfterRender = mSchedulerMixer.getIsPlaying();
+    mIsRenderCancelled.store(false);
+
+    // Once this returns, the audio callback is no longer touching the mixer
+    stopStream();
+    mSchedulerMixer.play();
+
+    mRenderThread = std::thread([this, path = std::move(path), format, numFrames, callbackPort]() {
+        OfflineEngine offlineEngine(mSchedulerMixer, getSampleRate());
+        auto result = offlineEngine.render(path.c_str(), format, numFrames, mIsRenderCancelled);
+
+        {
+            std::lock_guard<std::mutex> lock(mRenderMutex);
+            mIsRendering = false;
+
+            if (mIsPlayingAfterRender) {
+                startStream();
+            } else {
+                mSchedulerMixer.pause();
+            }
+        }
+
+        callbackToDartDouble(callbackPort, result.didSucceed ? result.realtimeFactor : -1.0);
+    });
+}
+
+void AndroidEngine::cancelOfflineRender() {
+    // A render that hasn't started yet clears this itself, so only a running one is cancelled
+    mIsRenderCancelled.store(true);
+}
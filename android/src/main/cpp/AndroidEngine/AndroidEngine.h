@@ -1,10 +1,14 @@
 #ifndef ANDROID_ENGINE_H
 #define ANDROID_ENGINE_H
 
+#include <mutex>
+#include <string>
+#include <thread>
 #include <oboe/Oboe.h>
 #include "CallbackManager.h"
 #include "IInstrument.h"
 #include "../AndroidInstruments/Mixer.h"
+#include "../Utils/AudioFileWriter.h"
 
 class AndroidEngine : public oboe::AudioStreamCallback {
 public:
@@ -18,12 +22,44 @@ public:
     int32_t getBufferSize();
     void play();
     void pause();
+    void stopStream();
+
+    // Restarts the stream if it was released while the mixer was idle. Call after anything that
+    // could give the mixer something to play.
+    void wake();
+    // Stops the stream once the mixer has been idle for kStreamReleaseSeconds. Off by default.
+    void setStreamReleaseEnabled(bool isEnabled);
+
+    // Renders numFrames from the current position to a file on a thread the engine owns, with the
+    // output stream stopped until it's done. Calls back with the realtime factor that was reached,
+    // or -1 if it failed or another render is still running. While a render runs, play() and
+    // pause() only choose whether the transport plays once it's done.
+    void renderOffline(std::string path, AudioFileFormat format, uint32_t numFrames, Dart_Port callbackPort);
+    // Stops a running render after the block it's on. Its callback reports a failure.
+    void cancelOfflineRender();
 
     Mixer mSchedulerMixer;
 private:
     oboe::ManagedStream mOutStream;
+    int32_t mXRunCount = 0; // Only touched by the audio callback
+
+    std::atomic<bool> mIsStreamReleaseEnabled { false };
+    std::atomic<bool> mIsStreamReleased { false };
+    std::atomic<int64_t> mReleasedAtNs { 0 };
+
+    // Guards the render's state, and the stream while a render is starting or finishing
+    std::mutex mRenderMutex;
+    std::thread mRenderThread;
+    bool mIsRendering = false;
+    bool mIsPlayingAfterRender = false;
+    std::atomic<bool> mIsRenderCancelled { false };
+
+    bool restartReleasedStream();
+    void startStream();
+    void pauseStream();
 
     static int constexpr kSampleRate = 44100;
+    static constexpr float kStreamReleaseSeconds = 5.0f;
 };
 
 #endif //ANDROID_ENGINE_H
@@ -6,32 +6,68 @@
 #ifndef MIXER_H
 #define MIXER_H
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <memory>
 #include <optional>
 #include "BaseScheduler.h"
-#include "IRenderableAudio.h"
-#include "../Utils/OptionArray.h"
+#include "IInstrument.h"
 #include "../Utils/Logging.h"
-
-constexpr int32_t kBufferSize = 192*10;  // Temporary buffer is used for mixing
-constexpr uint8_t kMaxTracks = 100;
+#include "../Utils/MixKernel.h"
+#include "../Utils/QualityGovernor.h"
+#include "../Utils/RenderStats.h"
+#include "../Utils/RenderThreadPool.h"
+#include "../Utils/RoutingGraph.h"
+#include "../Utils/SendEffects.h"
+
+constexpr int32_t kBufferSize = 192*10;  // Size of each track's render buffer, in samples
+constexpr int32_t kMaxTracks = kMaxTrackSlots;
+constexpr int32_t kDefaultSubBlockFrames = 256;
+constexpr uint32_t kDefaultMeterWindowFrames = 1024;
+constexpr int32_t kMinTrackVoiceCap = 2;
+constexpr float kIdleHoldSeconds = 0.5f;
+// Summing is cheap next to handing work to the thread pool, so a stage of buses is only mixed in
+// parallel once its inputs add up to this many frames
+constexpr int32_t kMinParallelBusFrames = 32768;
+// A send bus with no input stops running its effect once the effect's output is this quiet
+constexpr float kSendSilenceLevel = 1e-5f;
 
 /**
  * A Mixer object which sums the output from multiple tracks into a single output. The number of
  * input channels on each track must match the number of output channels (default 1=mono). This can
  * be changed by calling `setChannelCount`.
  * The inputs to the mixer are not owned by the mixer, they should not be deleted while rendering.
+ * Tracks can optionally be rendered in parallel on a pool of worker threads, see
+ * `setRenderThreadCount`.
+ * Level and pan changes are ramped across the next block to avoid zipper noise.
+ * Tracks whose instrument is idle, with nothing due that wakes it, are neither rendered nor mixed.
+ * Once nothing has rendered for kIdleHoldSeconds and no events are left to play, the whole mixer
+ * goes idle and only writes silence, until a call that could give it something to play.
+ * See `setIdleModeEnabled`.
+ * With metering on, each track's levels are measured as it's mixed, and published with the mix's
+ * own levels every meter window, see `getMeterLevels`.
+ * Instruments that can render planar render each channel into its own stretch of the track buffer,
+ * and are mixed from there without interleaving.
+ * With a voice budget set, the tracks share a number of voices, see `setVoiceBudget`.
+ * While callbacks run close to their deadline, the quality governor steps every instrument down to
+ * cheaper quality tiers, and back up once there's headroom again, see `QualityGovernor`.
+ * Tracks can be sent to buses, which sum them with their own level and pan, and send the sum on to
+ * another bus or the master, see `RoutingGraph`. Bus buffers are allocated with the mixer, so
+ * routing changes never allocate.
+ * Each track can also send some of its output, after its level and pan, to shared send buses that
+ * each run one effect and return it to the master, see `SendEffects`. A send bus with nothing sent
+ * to it runs until its effect's tail has died away.
  */
 
-struct TrackInfo {
-    IInstrument* track;
-    float level;
-};
-
 class Mixer : public IRenderableAudio, public BaseScheduler {
 
 public:
-    Mixer() {
+    Mixer() : mBusBuffers(std::make_unique<float[]>(kMaxBuses * kBufferSize)),
+              mSendBuffers(std::make_unique<float[]>(kSendBusCount * kBufferSize)) {
         static_assert(std::is_base_of<IRenderableAudio, IInstrument>::value, "TTrack must be derived from IRenderableAudio");
     }
 
@@ -40,39 +76,123 @@ public:
             return;
         }
 
+        auto missedFrames = mMissedFrames.exchange(0, std::memory_order_relaxed);
+        if (missedFrames > 0 && getIsPlaying()) {
+            advancePosition(getPosition(), missedFrames);
+        }
+
+        // Read before anything is rendered, so whatever happens from here on wakes an idle mixer
+        auto activityCount = getActivityCount();
+        if (mIsIdle.load(std::memory_order_relaxed) && renderIdle(audioData, numFrames, activityCount)) {
+            return;
+        }
+
+        auto callbackStart = RenderClock::now();
+        auto hostTimeUs = getHostTimeUs();
+        mRoutingPlan = mRoutingGraph.acquire();
+        mIsTimingInstruments = mRenderStats.getIsInstrumentTimingEnabled();
+        mIsMeteringBlock = mIsMetering.load(std::memory_order_relaxed);
+
         // Zero out the incoming container array
         memset(audioData, 0, sizeof(float) * numFrames * mChannelCount);
 
-        for (std::pair<track_index_t, TrackInfo> pair : mTrackMap) {
-            auto trackIndex = pair.first;
-            auto trackInfo = pair.second;
+        mRenderJobCount = 0;
+        mRenderedTrackCount = 0;
+        mSkippedTrackCount = 0;
+
+        if (getIsPlaying()) {
+            auto& live = mTracks.acquireLive();
 
-            handleFrames(trackIndex, numFrames);
+            for (int32_t i = 0; i < live.count; i++) {
+                auto trackIndex = live.tracks[i];
 
-            for (int j = 0; j < numFrames * mChannelCount; ++j) {
-                audioData[j] += mixingBuffer[j] * trackInfo.level;
+                // Tracks removed since the list was published are no longer live, and tracks still
+                // being added don't have an instrument yet
+                if (!mTracks.isLive(trackIndex)) continue;
+                if (mInstruments[trackSlot(trackIndex)].load(std::memory_order_acquire) == nullptr) continue;
+
+                mRenderJobs[mRenderJobCount++] = trackIndex;
             }
+
+            mTracks.releaseLive();
         }
+
+        // After the jobs are set up, so the reset of any track just added has been requested
+        mRenderStats.handleResetRequest();
+
+        applyTrackLimits();
+
+        // The callback is rendered as a series of sub-blocks that fit in the track buffers. The
+        // position advances after each one, so events stay sample-accurate across the splits.
+        auto subBlockFrames = std::min(mSubBlockFrames.load(std::memory_order_relaxed), kBufferSize / mChannelCount);
+        int32_t subBlockCount = 0;
+
+        for (int32_t offsetFrame = 0; offsetFrame < numFrames; offsetFrame += subBlockFrames) {
+            auto framesToRender = std::min(subBlockFrames, numFrames - offsetFrame);
+
+            renderSubBlock(audioData + offsetFrame * mChannelCount, framesToRender);
+            subBlockCount++;
+        }
+
+        mRoutingGraph.release();
+        publishTransportSnapshot(hostTimeUs, numFrames);
+
+        if (mIsMeteringBlock && mMeterFrames >= mMeterWindowFrames.load(std::memory_order_relaxed)) {
+            publishMeterLevels();
+        }
+
+        auto budgetNs = mSampleRate > 0 ? numFrames * 1000000000ull / mSampleRate : 0;
+        auto callbackNs = elapsedNs(callbackStart, RenderClock::now());
+        mRenderStats.recordCallback(callbackNs, budgetNs, subBlockCount);
+        mRenderStats.recordSkips(mRenderedTrackCount, mSkippedTrackCount);
+
+        if (mQualityGovernor.update(callbackNs, numFrames, mSampleRate)) {
+            reportQualityTier(mQualityGovernor.getTier());
+        }
+
+        updateIdleState(numFrames, activityCount);
     }
 
     void handleRenderAudioRange(track_index_t trackIndex, uint32_t offsetFrame, uint32_t numFramesToRender) {
         if (numFramesToRender == 0) return;
 
-        auto offsetMixingBuffer = mixingBuffer + offsetFrame * mChannelCount;
+        // The slot may have been taken by another track since this one's job was set up
+        auto instrument = getTrack(trackIndex);
+        if (!instrument.has_value()) return;
+
+        auto slot = trackSlot(trackIndex);
+        auto track = instrument.value();
 
-        auto maybeTrackInfo = getTrackInfo(trackIndex);
-        if (maybeTrackInfo.has_value()) {
-            auto trackInfo = maybeTrackInfo.value();
-            IInstrument *track = trackInfo.track;
-            track->renderAudio(offsetMixingBuffer, numFramesToRender);
+        // An idle instrument stays silent until an event wakes it, and events split the ranges, so
+        // only the parts of the sub-block after it wakes need rendering
+        if (track->isIdle()) {
+            if (mHasAudio[slot]) clearTrackRange(slot, offsetFrame, numFramesToRender);
+            return;
+        }
+
+        if (!mHasAudio[slot]) {
+            clearTrackRange(slot, 0, offsetFrame);
+            mHasAudio[slot] = true;
+        }
+
+        if (mIsTimingInstruments) {
+            auto renderStart = RenderClock::now();
+            renderInstrument(track, slot, offsetFrame, numFramesToRender);
+            mInstrumentRenderNs[slot] += elapsedNs(renderStart, RenderClock::now());
+        } else {
+            renderInstrument(track, slot, offsetFrame, numFramesToRender);
         }
     }
 
-    void handleEvent(track_index_t trackIndex, SchedulerEvent event, position_frame_t offsetFrame) {
+    void handleEvent(track_index_t trackIndex, SchedulerEvent event, position_frame_t /* offsetFrame */) {
         if (event.type == VOLUME_EVENT) {
             auto volumeEvent = VolumeEventData(event.data);
 
             setLevel(trackIndex, volumeEvent.volume);
+        } else if (event.type == SEND_EVENT) {
+            auto sendEvent = SendEventData(event.data);
+
+            setSendLevel(trackIndex, sendEvent.sendBus, sendEvent.level);
         } else if (event.type == MIDI_EVENT) {
             auto midiEvent = MidiEventData(event.data);
             auto track = getTrack(trackIndex);
@@ -90,79 +210,778 @@ public:
 
     track_index_t addTrack(IInstrument *track) {
         auto trackIndex = BaseScheduler::addTrack();
+        if (trackIndex < 0) return -1;
 
-        TrackInfo trackInfo;
-        trackInfo.track = track;
-        trackInfo.level = 1.0;
+        auto slot = trackSlot(trackIndex);
+        if (mTrackBuffers[slot] == nullptr) {
+            mTrackBuffers[slot] = std::make_unique<float[]>(kBufferSize);
+        }
 
-        mTrackMap.insert({ trackIndex, trackInfo });
+        mLevels[slot] = 1.0;
+        mAppliedLevels[slot] = 1.0;
+        mPans[slot] = 0.0;
+        mAppliedPans[slot] = 0.0;
+        mSendLevels[slot] = {};
+        mAppliedSendLevels[slot] = {};
+        mRenderStats.requestTrackReset(slot);
+        mRoutingGraph.setTrackOutput(slot, kMasterBus);
+        mIsPlanar[slot] = track->canRenderPlanar();
+        mVoiceCaps[slot] = INT32_MAX; // Instruments start uncapped, at full quality
+        mQualityTiers[slot] = QUALITY_FULL;
+        // Publishing the instrument makes the track visible to the render thread
+        mInstruments[slot].store(track, std::memory_order_release);
 
         return trackIndex;
     }
 
     void onRemoveTrack(track_index_t trackIndex) {
-        mTrackMap.erase(trackIndex);
+        mInstruments[trackSlot(trackIndex)].store(nullptr, std::memory_order_release);
     }
 
     std::optional<IInstrument*> getTrack(track_index_t trackIndex) {
-        auto maybeTrackInfo = getTrackInfo(trackIndex);
+        // The instrument is read before the id is checked. A track added in the slot publishes its
+        // instrument after its id, so if the instrument is a newer track's, the old id is no longer
+        // live by the time it's checked.
+        auto track = mInstruments[trackSlot(trackIndex)].load(std::memory_order_acquire);
+        if (track == nullptr || !isTrackLive(trackIndex)) return std::nullopt;
 
-        if (maybeTrackInfo.has_value()) {
-            return maybeTrackInfo.value().track;
-        } else {
-            return std::nullopt;
-        }
+        return track;
     }
 
     void onResetTrack(track_index_t trackIndex) {
-        auto search = mTrackMap.find(trackIndex);
-
-        if (search != mTrackMap.end()) {
-            auto trackInfo = search->second;
-            IInstrument *track = trackInfo.track;
+        auto track = getTrack(trackIndex);
 
-            track->reset();
+        if (track.has_value()) {
+            track.value()->reset();
         }
     }
 
     void setLevel(track_index_t trackIndex, float level) {
-        auto maybeTrackInfo = getTrackInfo(trackIndex);
+        if (!isTrackLive(trackIndex)) return;
 
-        if (maybeTrackInfo.has_value()) {
-            TrackInfo nextTrackInfo = maybeTrackInfo.value();
-            nextTrackInfo.level = level;
-            mTrackMap.insert_or_assign(trackIndex, nextTrackInfo);
-        }
+        mLevels[trackSlot(trackIndex)] = level;
     }
 
     float getLevel(track_index_t trackIndex) {
-        auto maybeTrackInfo = getTrackInfo(trackIndex);
+        if (!isTrackLive(trackIndex)) return 0.0;
+
+        return mLevels[trackSlot(trackIndex)];
+    }
+
+    // -1 is hard left, 1 is hard right. Only applies to stereo output.
+    void setPan(track_index_t trackIndex, float pan) {
+        if (!isTrackLive(trackIndex)) return;
+
+        mPans[trackSlot(trackIndex)] = std::min(std::max(pan, -1.0f), 1.0f);
+    }
+
+    float getPan(track_index_t trackIndex) {
+        if (!isTrackLive(trackIndex)) return 0.0;
+
+        return mPans[trackSlot(trackIndex)];
+    }
+
+    // Returns the new bus, at full level and centred, or -1 if every bus is taken.
+    int32_t addBus() {
+        auto bus = mRoutingGraph.addBus();
+        if (bus < 0) return -1;
+
+        mBusLevels[bus] = 1.0;
+        mBusAppliedLevels[bus] = 1.0;
+        mBusPans[bus] = 0.0;
+        mBusAppliedPans[bus] = 0.0;
+
+        return bus;
+    }
+
+    // Whatever was sent to the bus is sent on to where the bus was sending its output.
+    void removeBus(int32_t bus) { mRoutingGraph.removeBus(bus); }
+
+    // output is a bus or kMasterBus. Returns false if it isn't live, or would feed the bus its own
+    // output.
+    bool setBusOutput(int32_t bus, int32_t output) { return mRoutingGraph.setBusOutput(bus, output); }
+    int32_t getBusOutput(int32_t bus) { return mRoutingGraph.getBusOutput(bus); }
+
+    bool setTrackOutput(track_index_t trackIndex, int32_t output) {
+        if (!isTrackLive(trackIndex)) return false;
+
+        return mRoutingGraph.setTrackOutput(trackSlot(trackIndex), output);
+    }
+
+    int32_t getTrackOutput(track_index_t trackIndex) {
+        if (!isTrackLive(trackIndex)) return kMasterBus;
+
+        return mRoutingGraph.getTrackOutput(trackSlot(trackIndex));
+    }
+
+    void setBusLevel(int32_t bus, float level) {
+        if (!mRoutingGraph.isBusLive(bus)) return;
+
+        mBusLevels[bus] = level;
+    }
 
-        if (maybeTrackInfo.has_value()) {
-            TrackInfo nextTrackInfo = maybeTrackInfo.value();
-            return nextTrackInfo.level;
+    float getBusLevel(int32_t bus) {
+        if (!mRoutingGraph.isBusLive(bus)) return 0.0;
+
+        return mBusLevels[bus];
+    }
+
+    // -1 is hard left, 1 is hard right. Only applies to stereo output.
+    void setBusPan(int32_t bus, float pan) {
+        if (!mRoutingGraph.isBusLive(bus)) return;
+
+        mBusPans[bus] = std::min(std::max(pan, -1.0f), 1.0f);
+    }
+
+    float getBusPan(int32_t bus) {
+        if (!mRoutingGraph.isBusLive(bus)) return 0.0;
+
+        return mBusPans[bus];
+    }
+
+    // How much of the track, after its level and pan, goes to a send bus. Tracks start with every
+    // send at 0.
+    void setSendLevel(track_index_t trackIndex, uint32_t sendBus, float level) {
+        if (!isTrackLive(trackIndex) || sendBus >= kSendBusCount) return;
+
+        mSendLevels[trackSlot(trackIndex)][sendBus] = std::max(level, 0.0f);
+    }
+
+    float getSendLevel(track_index_t trackIndex, uint32_t sendBus) {
+        if (!isTrackLive(trackIndex) || sendBus >= kSendBusCount) return 0.0;
+
+        return mSendLevels[trackSlot(trackIndex)][sendBus];
+    }
+
+    // The level a send bus's effect is returned to the master at. 1 by default.
+    void setSendReturnLevel(uint32_t sendBus, float level) {
+        if (sendBus >= kSendBusCount) return;
+
+        mSendReturnLevels[sendBus] = std::max(level, 0.0f);
+    }
+
+    ReverbEffect& getReverb() { return mReverb; }
+    DelayEffect& getDelay() { return mDelay; }
+    EqEffect& getEq() { return mEq; }
+
+    int32_t getChannelCount() { return mChannelCount; }
+    void setChannelCount(int32_t channelCount) {
+        mChannelCount = std::min(std::max(channelCount, 1), MixKernel::kMaxChannels);
+    }
+
+    // Used to work out the time budget of each callback for the render stats, and to size the send
+    // effects, so it allocates and must be called while nothing is rendering.
+    int32_t getSampleRate() { return mSampleRate; }
+    void setSampleRate(int32_t sampleRate) {
+        mSampleRate = sampleRate;
+
+        for (auto effect : mSendEffects) {
+            effect->prepare(sampleRate);
+        }
+    }
+
+    RenderStats<kMaxTracks>& getRenderStats() { return mRenderStats; }
+
+    // Renders tracks on this many worker threads in addition to the audio thread. 0 renders every
+    // track on the audio thread. Spawns or joins threads, so don't call this from the audio thread.
+    void setRenderThreadCount(int32_t workerCount) {
+        if (workerCount > 0) {
+            mThreadPool.start(workerCount);
         } else {
-            return 0.0;
+            mThreadPool.stop();
         }
     }
 
-    int32_t getChannelCount() { return mChannelCount; }
-    void setChannelCount(int32_t channelCount) { mChannelCount = channelCount; }
+    int32_t getRenderThreadCount() { return mThreadPool.getWorkerCount(); }
+
+    // Callbacks are rendered in sub-blocks of at most this many frames, so any callback size works
+    // and the per-track buffers stay small enough to keep in cache. Limited by kBufferSize.
+    int32_t getSubBlockFrames() { return mSubBlockFrames.load(std::memory_order_relaxed); }
+    void setSubBlockFrames(int32_t subBlockFrames) {
+        auto maxSubBlockFrames = kBufferSize / mChannelCount;
+
+        mSubBlockFrames.store(std::min(std::max(subBlockFrames, 1), maxSubBlockFrames), std::memory_order_relaxed);
+    }
+
+    // Metering costs a little extra in the mix pass, so it's off until something wants to show it.
+    void setMeteringEnabled(bool isEnabled) { mIsMetering.store(isEnabled, std::memory_order_relaxed); }
+
+    // Levels are published once at least this many frames have been metered, at the end of a
+    // callback.
+    void setMeterWindowFrames(uint32_t meterWindowFrames) {
+        mMeterWindowFrames.store(std::max(meterWindowFrames, 1u), std::memory_order_relaxed);
+    }
+
+    // Copies the levels of the last meter window, without blocking the audio thread.
+    void getMeterLevels(MeterLevels* meterLevels) {
+        mMeterLevels.read(*meterLevels);
+    }
+
+    // Shares this many voices between the playing tracks, or 0 to leave each instrument to its own
+    // limit. Each track that's sounding gets an even share, at least kMinTrackVoiceCap, so a few
+    // busy tracks can still be cut short while quiet ones leave theirs unused. Idle tracks hold no
+    // voices, so they don't count. Quality tiers cut the voices each instrument keeps to below its
+    // share.
+    void setVoiceBudget(int32_t voiceBudget) {
+        mVoiceBudget.store(std::max(voiceBudget, 0), std::memory_order_relaxed);
+    }
+
+    // The cap each track was given in the last callback, or 0 with no voice budget.
+    int32_t getTrackVoiceCap() { return mTrackVoiceCap.load(std::memory_order_relaxed); }
+
+    // Idle mode is on by default. Turning it off wakes an idle mixer on its next callback.
+    void setIdleModeEnabled(bool isEnabled) { mIsIdleModeEnabled.store(isEnabled, std::memory_order_relaxed); }
+    bool getIsIdle() { return mIsIdle.load(std::memory_order_relaxed); }
+    // Audio thread only. How long the mixer has been idle, or 0 if it isn't.
+    uint64_t getIdleFrames() { return mIdleFrames; }
+    // Audio thread only. False if anything has happened that will wake the mixer on its next callback.
+    bool getIsIdleUndisturbed() {
+        return mIsIdle.load(std::memory_order_relaxed) && getActivityCount() == mIdleActivityCount;
+    }
+
+    // Frames that went by with no callbacks at all, e.g. while the stream was released. The
+    // position catches up by that much on the next callback if the transport is playing.
+    void addMissedFrames(uint32_t numFrames) { mMissedFrames.fetch_add(numFrames, std::memory_order_relaxed); }
+
+    // The governor is on by default. Turning it off restores full quality.
+    void setQualityGovernorEnabled(bool isEnabled) { mQualityGovernor.setEnabled(isEnabled); }
+    bool getQualityGovernorEnabled() { return mQualityGovernor.getIsEnabled(); }
+
+    // 0 is full quality; see QualityTier.
+    int32_t getQualityTier() { return mQualityGovernor.getTier(); }
 
 private:
-    std::optional<TrackInfo> getTrackInfo(track_index_t trackIndex) {
-        auto search = mTrackMap.find(trackIndex);
+    // The fast path while idle: silence, with the position still moving if the transport is
+    // playing. Returns false, leaving idle, if anything has happened since the mixer went idle.
+    bool renderIdle(float *audioData, int32_t numFrames, uint32_t activityCount) {
+        if (activityCount != mIdleActivityCount || !mIsIdleModeEnabled.load(std::memory_order_relaxed)) {
+            mIsIdle.store(false, std::memory_order_relaxed);
+            mIdleFrames = 0;
+            mQuietFrames = 0;
+            return false;
+        }
+
+        memset(audioData, 0, sizeof(float) * numFrames * mChannelCount);
+
+        if (getIsPlaying()) {
+            advancePosition(getPosition(), numFrames);
+            publishTransportSnapshot(getHostTimeUs(), numFrames);
+        }
+
+        mIdleFrames += numFrames;
+        return true;
+    }
+
+    // A callback is quiet if no track rendered and, with the transport playing, nothing is left to
+    // play. Paused, nothing renders, so every callback is quiet.
+    void updateIdleState(int32_t numFrames, uint32_t activityCount) {
+        auto isQuiet = mRenderedTrackCount == 0 && !getIsAnySendRinging() && (!getIsPlaying() || !hasPendingEvents());
+
+        if (!isQuiet || !mIsIdleModeEnabled.load(std::memory_order_relaxed)) {
+            mQuietFrames = 0;
+            return;
+        }
+
+        mQuietFrames += numFrames;
+
+        if (mQuietFrames >= kIdleHoldSeconds * mSampleRate) {
+            mIdleActivityCount = activityCount;
+            mIdleFrames = 0;
+            mIsIdle.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // Hands each job its share of the voice budget and the governor's quality tier, if it hasn't
+    // got them yet. The budget is shared between the tracks that are sounding. A track that wakes
+    // up in this callback gets the same share, and is counted from the next one.
+    void applyTrackLimits() {
+        auto voiceBudget = mVoiceBudget.load(std::memory_order_relaxed);
+        auto trackVoiceCap = INT32_MAX;
+
+        if (voiceBudget > 0) {
+            int32_t soundingCount = 0;
+
+            for (int32_t i = 0; i < mRenderJobCount; i++) {
+                auto instrument = getTrack(mRenderJobs[i]);
+                if (instrument.has_value() && !instrument.value()->isIdle()) soundingCount++;
+            }
+
+            trackVoiceCap = std::max(voiceBudget / std::max(soundingCount, 1), kMinTrackVoiceCap);
+        }
+
+        auto qualityTier = mQualityGovernor.getIsEnabled()
+            ? static_cast<QualityTier>(mQualityGovernor.getTier())
+            : QUALITY_FULL;
+
+        mTrackVoiceCap.store(voiceBudget > 0 ? trackVoiceCap : 0, std::memory_order_relaxed);
+
+        for (int32_t i = 0; i < mRenderJobCount; i++) {
+            auto slot = trackSlot(mRenderJobs[i]);
+            auto instrument = getTrack(mRenderJobs[i]);
+            if (!instrument.has_value()) continue;
+
+            if (mVoiceCaps[slot] != trackVoiceCap) {
+                instrument.value()->setVoiceCap(trackVoiceCap);
+                mVoiceCaps[slot] = trackVoiceCap;
+            }
+            if (mQualityTiers[slot] != qualityTier) {
+                instrument.value()->setQualityTier(qualityTier);
+                mQualityTiers[slot] = qualityTier;
+            }
+        }
+    }
+
+    // Renders and mixes the tracks in mRenderJobs into audioData, which has already been zeroed.
+    void renderSubBlock(float *audioData, int32_t numFrames) {
+        applyTempoMessages();
+        removeStaleJobs();
+
+        mRenderBudgetNs = mSampleRate > 0 ? numFrames * 1000000000ull / mSampleRate : 0;
+        mRenderStartFrame = getPosition();
+        mRenderNumFrames = numFrames;
+
+        // Each track renders into its own buffer, so the tracks can render in any order or in
+        // parallel. They are always summed in the same order, so the output doesn't depend on
+        // which thread rendered which track.
+        if (mRenderJobCount > 1 && mThreadPool.getWorkerCount() > 0) {
+            mThreadPool.run(mRenderJobCount, renderJob, this);
+        } else {
+            for (int32_t i = 0; i < mRenderJobCount; i++) {
+                renderJob(this, i);
+            }
+        }
+
+        // Meters are claimed, and renders counted, before buses are mixed in parallel
+        mBusInputCounts.fill(0);
+
+        for (int32_t i = 0; i < mRenderJobCount; i++) {
+            auto slot = trackSlot(mRenderJobs[i]);
+            auto output = mRoutingPlan->trackOutputs[slot];
+
+            if (mIsMeteringBlock) getTrackLevels(mRenderJobs[i]);
+            if (output != kMasterBus && mHasAudio[slot]) mBusInputCounts[output]++;
+
+            if (mHasAudio[slot]) {
+                mRenderedTrackCount++;
+            } else {
+                mSkippedTrackCount++;
+            }
+        }
+
+        mixSends(numFrames);
+
+        // Each stage's buses only take input from tracks and earlier stages
+        for (int32_t stage = 0; stage < mRoutingPlan->stageCount; stage++) {
+            mBusStageStart = mRoutingPlan->stageStarts[stage];
+            auto busCount = mRoutingPlan->stageStarts[stage + 1] - mBusStageStart;
+            int32_t inputCount = 0;
+
+            for (int32_t i = 0; i < busCount; i++) {
+                auto bus = mRoutingPlan->busOrder[mBusStageStart + i];
+                auto output = mRoutingPlan->busOutputs[bus];
+
+                inputCount += mBusInputCounts[bus];
+                // Counted generously, since a bus that turns out silent still costs a check
+                if (output != kMasterBus) mBusInputCounts[output]++;
+            }
+
+            auto isParallel = busCount > 1 && inputCount * numFrames >= kMinParallelBusFrames;
+
+            if (isParallel && mThreadPool.getWorkerCount() > 0) {
+                mThreadPool.run(busCount, mixBusJob, this);
+            } else {
+                for (int32_t i = 0; i < busCount; i++) {
+                    mixBusJob(this, i);
+                }
+            }
+        }
+
+        // The output is already zeroed, so it counts as having audio
+        auto hasMasterAudio = true;
+        mixInputs(kMasterBus, audioData, hasMasterAudio, numFrames);
+        returnSends(audioData, numFrames);
+
+        if (mIsMeteringBlock) {
+            MixKernel::measure(audioData, numFrames, mChannelCount, mMasterLevels);
+            mMeterFrames += numFrames;
+        }
+
+        if (mRenderJobCount > 0) {
+            advancePosition(mRenderStartFrame, numFrames);
+        }
+    }
+
+    // Drops the jobs of tracks removed since the callback started, so nothing belonging to a track
+    // that has since taken the slot is rendered or mixed under the old id. A track removed while
+    // the sub-block renders is caught by getTrack(), and renders nothing.
+    void removeStaleJobs() {
+        int32_t liveJobCount = 0;
+
+        for (int32_t i = 0; i < mRenderJobCount; i++) {
+            if (isTrackLive(mRenderJobs[i])) mRenderJobs[liveJobCount++] = mRenderJobs[i];
+        }
+
+        mRenderJobCount = liveJobCount;
+    }
+
+    // Sums everything sent to output into outputData, tracks first and then buses, always in the
+    // same order. Until hasAudio is set, outputData holds stale audio, and is overwritten rather
+    // than added to by the first input that has audio.
+    void mixInputs(int32_t output, float* outputData, bool& hasAudio, int32_t numFrames) {
+        for (int32_t i = 0; i < mRenderJobCount; i++) {
+            auto trackIndex = mRenderJobs[i];
+            auto slot = trackSlot(trackIndex);
+            if (mRoutingPlan->trackOutputs[slot] != output) continue;
+
+            auto level = mLevels[slot];
+            auto pan = mPans[slot];
+
+            // Silence adds nothing to the mix or the meters
+            if (mHasAudio[slot]) {
+                float startGains[MixKernel::kMaxChannels];
+                float endGains[MixKernel::kMaxChannels];
+                getChannelGains(mAppliedLevels[slot], mAppliedPans[slot], startGains);
+                getChannelGains(level, pan, endGains);
+
+                auto levels = mIsMeteringBlock ? &mTrackLevels[slot] : nullptr;
+                clearUntilAudio(outputData, hasAudio, numFrames);
+
+                if (mIsPlanar[slot]) {
+                    float* channelData[MixKernel::kMaxChannels];
+                    getPlanarChannels(slot, 0, channelData);
+                    MixKernel::mixPlanarTrack(outputData, channelData, numFrames, mChannelCount, startGains, endGains, levels);
+                } else {
+                    MixKernel::mixTrack(outputData, mTrackBuffers[slot].get(), numFrames, mChannelCount, startGains, endGains, levels);
+                }
+            }
+
+            mAppliedLevels[slot] = level;
+            mAppliedPans[slot] = pan;
+        }
+
+        for (int32_t i = 0; i < mRoutingPlan->busCount; i++) {
+            auto bus = mRoutingPlan->busOrder[i];
+            if (mRoutingPlan->busOutputs[bus] != output) continue;
+
+            auto level = mBusLevels[bus];
+            auto pan = mBusPans[bus];
+
+            if (mBusHasAudio[bus]) {
+                float startGains[MixKernel::kMaxChannels];
+                float endGains[MixKernel::kMaxChannels];
+                getChannelGains(mBusAppliedLevels[bus], mBusAppliedPans[bus], startGains);
+                getChannelGains(level, pan, endGains);
+
+                clearUntilAudio(outputData, hasAudio, numFrames);
+                MixKernel::mixTrack(outputData, getBusBuffer(bus), numFrames, mChannelCount, startGains, endGains, nullptr);
+            }
+
+            mBusAppliedLevels[bus] = level;
+            mBusAppliedPans[bus] = pan;
+        }
+    }
+
+    void clearUntilAudio(float* outputData, bool& hasAudio, int32_t numFrames) {
+        if (hasAudio) return;
+
+        memset(outputData, 0, sizeof(float) * numFrames * mChannelCount);
+        hasAudio = true;
+    }
+
+    float* getBusBuffer(int32_t bus) {
+        return mBusBuffers.get() + bus * kBufferSize;
+    }
+
+    static void mixBusJob(void* context, int32_t jobIndex) {
+        auto mixer = static_cast<Mixer*>(context);
+        auto bus = mixer->mRoutingPlan->busOrder[mixer->mBusStageStart + jobIndex];
 
-        if (search != mTrackMap.end()) {
-            return std::optional(search->second);
+        mixer->mBusHasAudio[bus] = false;
+        mixer->mixInputs(bus, mixer->getBusBuffer(bus), mixer->mBusHasAudio[bus], mixer->mRenderNumFrames);
+    }
+
+    // Sums each track into the send buses it sends to, with its level and pan. Runs before the track
+    // is mixed anywhere else, while its applied level is still where this sub-block ramps from.
+    void mixSends(int32_t numFrames) {
+        mSendHasAudio = {};
+
+        for (int32_t i = 0; i < mRenderJobCount; i++) {
+            auto slot = trackSlot(mRenderJobs[i]);
+            auto& sendLevels = mSendLevels[slot];
+            auto& appliedSendLevels = mAppliedSendLevels[slot];
+
+            for (int32_t sendBus = 0; sendBus < kSendBusCount; sendBus++) {
+                auto sendLevel = sendLevels[sendBus];
+                auto appliedSendLevel = appliedSendLevels[sendBus];
+                appliedSendLevels[sendBus] = sendLevel;
+
+                if (!mHasAudio[slot] || (sendLevel <= 0.0f && appliedSendLevel <= 0.0f)) continue;
+
+                float startGains[MixKernel::kMaxChannels];
+                float endGains[MixKernel::kMaxChannels];
+                getChannelGains(mAppliedLevels[slot] * appliedSendLevel, mAppliedPans[slot], startGains);
+                getChannelGains(mLevels[slot] * sendLevel, mPans[slot], endGains);
+
+                auto sendData = getSendBuffer(sendBus);
+                clearUntilAudio(sendData, mSendHasAudio[sendBus], numFrames);
+
+                if (mIsPlanar[slot]) {
+                    float* channelData[MixKernel::kMaxChannels];
+                    getPlanarChannels(slot, 0, channelData);
+                    MixKernel::mixPlanarTrack(sendData, channelData, numFrames, mChannelCount, startGains, endGains, nullptr);
+                } else {
+                    MixKernel::mixTrack(sendData, mTrackBuffers[slot].get(), numFrames, mChannelCount, startGains, endGains, nullptr);
+                }
+            }
+        }
+    }
+
+    // Runs each send bus's effect once over everything sent to it, and adds it to the mix.
+    void returnSends(float* audioData, int32_t numFrames) {
+        for (int32_t sendBus = 0; sendBus < kSendBusCount; sendBus++) {
+            auto effect = mSendEffects[sendBus];
+            auto hasInput = mSendHasAudio[sendBus];
+            auto returnLevel = mSendReturnLevels[sendBus];
+            auto appliedReturnLevel = mAppliedSendReturnLevels[sendBus];
+            mAppliedSendReturnLevels[sendBus] = returnLevel;
+
+            if (!effect->isPrepared() || (!hasInput && !mIsSendRinging[sendBus])) continue;
+
+            auto sendData = getSendBuffer(sendBus);
+            auto hasAudio = hasInput;
+            clearUntilAudio(sendData, hasAudio, numFrames);
+            effect->process(sendData, numFrames, mChannelCount);
+
+            if (!hasInput && getPeak(sendData, numFrames * mChannelCount) < kSendSilenceLevel) {
+                // The tail has died away, so start the next one from silence rather than denormals
+                effect->reset();
+                mIsSendRinging[sendBus] = false;
+                continue;
+            }
+
+            mIsSendRinging[sendBus] = true;
+
+            float startGains[MixKernel::kMaxChannels];
+            float endGains[MixKernel::kMaxChannels];
+            getChannelGains(appliedReturnLevel, 0.0f, startGains);
+            getChannelGains(returnLevel, 0.0f, endGains);
+            MixKernel::mixTrack(audioData, sendData, numFrames, mChannelCount, startGains, endGains, nullptr);
+        }
+    }
+
+    bool getIsAnySendRinging() {
+        for (auto isRinging : mIsSendRinging) {
+            if (isRinging) return true;
+        }
+
+        return false;
+    }
+
+    float* getSendBuffer(int32_t sendBus) {
+        return mSendBuffers.get() + sendBus * kBufferSize;
+    }
+
+    static float getPeak(const float* data, int32_t samplesCount) {
+        float peak = 0.0f;
+
+        for (int32_t i = 0; i < samplesCount; i++) {
+            peak = std::max(peak, std::abs(data[i]));
+        }
+
+        return peak;
+    }
+
+    // Planar tracks keep each channel in its own stretch of the track buffer, long enough for a whole
+    // sub-block, so they render straight into the layout the mix reads.
+    void getPlanarChannels(int32_t slot, uint32_t offsetFrame, float** channelData) {
+        auto channelStride = kBufferSize / mChannelCount;
+
+        for (int32_t channel = 0; channel < mChannelCount; channel++) {
+            channelData[channel] = mTrackBuffers[slot].get() + channel * channelStride + offsetFrame;
+        }
+    }
+
+    void clearTrackRange(int32_t slot, uint32_t offsetFrame, uint32_t numFrames) {
+        if (numFrames == 0) return;
+
+        if (mIsPlanar[slot]) {
+            float* channelData[MixKernel::kMaxChannels];
+            getPlanarChannels(slot, offsetFrame, channelData);
+
+            for (int32_t channel = 0; channel < mChannelCount; channel++) {
+                memset(channelData[channel], 0, sizeof(float) * numFrames);
+            }
         } else {
-            return std::nullopt;
+            memset(mTrackBuffers[slot].get() + offsetFrame * mChannelCount, 0, sizeof(float) * numFrames * mChannelCount);
         }
     }
 
-    float mixingBuffer[kBufferSize];
-    std::unordered_map<track_index_t, TrackInfo> mTrackMap = {};
+    void renderInstrument(IInstrument* track, int32_t slot, uint32_t offsetFrame, uint32_t numFrames) {
+        if (mIsPlanar[slot]) {
+            float* channelData[MixKernel::kMaxChannels];
+            getPlanarChannels(slot, offsetFrame, channelData);
+            track->renderAudioPlanar(channelData, mChannelCount, numFrames);
+        } else {
+            track->renderAudio(mTrackBuffers[slot].get() + offsetFrame * mChannelCount, numFrames);
+        }
+    }
+
+    // A track's levels for the current meter window, cleared the first time it's mixed in it.
+    MixKernel::Levels& getTrackLevels(track_index_t trackIndex) {
+        auto slot = trackSlot(trackIndex);
+        auto& levels = mTrackLevels[slot];
+
+        if (mTrackMeterWindow[slot] != mMeterWindow) {
+            mTrackMeterWindow[slot] = mMeterWindow;
+            mMeteredTracks[mMeteredTrackCount++] = trackIndex;
+            levels.clear();
+        }
+
+        return levels;
+    }
+
+    void publishMeterLevels() {
+        auto& meterLevels = mPendingMeterLevels;
+
+        meterLevels.windowFrames = mMeterFrames;
+        meterLevels.tracksCount = mMeteredTrackCount;
+        toMeterChannels(mMasterLevels, meterLevels.masterPeaks, meterLevels.masterRms);
+
+        for (int32_t i = 0; i < mMeteredTrackCount; i++) {
+            auto& trackMeter = meterLevels.tracks[i];
+
+            trackMeter.trackIndex = mMeteredTracks[i];
+            toMeterChannels(mTrackLevels[trackSlot(mMeteredTracks[i])], trackMeter.peaks, trackMeter.rms);
+        }
+
+        mMeterLevels.write(meterLevels);
+
+        mMasterLevels.clear();
+        mMeterFrames = 0;
+        mMeteredTrackCount = 0;
+        mMeterWindow++;
+    }
+
+    void toMeterChannels(const MixKernel::Levels& levels, float* peaks, float* rms) {
+        for (int32_t channel = 0; channel < METER_CHANNELS; channel++) {
+            auto sourceChannel = std::min(channel, mChannelCount - 1);
+
+            peaks[channel] = levels.peaks[sourceChannel];
+            rms[channel] = std::sqrt(levels.sumSquares[sourceChannel] / std::max(mMeterFrames, 1u));
+        }
+    }
+
+    void getChannelGains(float level, float pan, float* gains) {
+        if (mChannelCount == 2) {
+            MixKernel::panGains(pan, gains[0], gains[1]);
+            gains[0] *= level;
+            gains[1] *= level;
+        } else {
+            for (int32_t channel = 0; channel < mChannelCount; channel++) {
+                gains[channel] = level;
+            }
+        }
+    }
+
+    static void renderJob(void* context, int32_t jobIndex) {
+        auto mixer = static_cast<Mixer*>(context);
+        auto trackIndex = mixer->mRenderJobs[jobIndex];
+        auto slot = trackSlot(trackIndex);
+
+        mixer->mInstrumentRenderNs[slot] = 0;
+        mixer->mHasAudio[slot] = false;
+        auto renderStart = RenderClock::now();
+        mixer->renderTrackFrames(trackIndex, mixer->mRenderStartFrame, mixer->mRenderNumFrames);
+        auto renderNs = elapsedNs(renderStart, RenderClock::now());
+
+        // The slot's stats belong to whichever track holds it now
+        if (!mixer->isTrackLive(trackIndex)) return;
+
+        mixer->mRenderStats.recordTrack(slot, renderNs, mixer->mInstrumentRenderNs[slot], mixer->mRenderBudgetNs);
+    }
+
+    // Per-track state, indexed by trackSlot()
+    std::array<std::atomic<IInstrument*>, kMaxTracks> mInstruments = {};
+    std::array<float, kMaxTracks> mLevels = {};
+    std::array<float, kMaxTracks> mPans = {};
+    // What the last block was mixed with, so the next block can ramp from there
+    std::array<float, kMaxTracks> mAppliedLevels = {};
+    std::array<float, kMaxTracks> mAppliedPans = {};
+    std::array<std::unique_ptr<float[]>, kMaxTracks> mTrackBuffers;
+    std::array<bool, kMaxTracks> mIsPlanar = {}; // Set before the instrument is published
+    std::array<bool, kMaxTracks> mHasAudio = {}; // Whether the instrument rendered this sub-block
     int32_t mChannelCount = 1; // Default to mono
+    std::atomic<int32_t> mSubBlockFrames { kDefaultSubBlockFrames };
+    int32_t mSampleRate = 0;
+
+    RenderStats<kMaxTracks> mRenderStats;
+    bool mIsTimingInstruments = false;
+    std::array<uint64_t, kMaxTracks> mInstrumentRenderNs = {}; // Accumulated over the current block
+
+    // Set up by the audio thread before each sub-block is rendered
+    RenderThreadPool mThreadPool;
+    std::array<track_index_t, kMaxTracks> mRenderJobs = {};
+    int32_t mRenderJobCount = 0;
+    position_frame_t mRenderStartFrame = 0;
+    uint32_t mRenderNumFrames = 0;
+    uint64_t mRenderBudgetNs = 0;
+    uint32_t mRenderedTrackCount = 0; // Over the current callback
+    uint32_t mSkippedTrackCount = 0;
+
+    // Metering, only touched by the audio thread apart from the atomics and the published levels
+    std::atomic<bool> mIsMetering { false };
+    std::atomic<uint32_t> mMeterWindowFrames { kDefaultMeterWindowFrames };
+    bool mIsMeteringBlock = false;
+    std::array<MixKernel::Levels, kMaxTracks> mTrackLevels;
+    std::array<uint32_t, kMaxTracks> mTrackMeterWindow = {};
+    std::array<track_index_t, kMaxTracks> mMeteredTracks = {};
+    int32_t mMeteredTrackCount = 0;
+    MixKernel::Levels mMasterLevels = {};
+    uint32_t mMeterFrames = 0;
+    uint32_t mMeterWindow = 1;
+    Seqlock<MeterLevels> mMeterLevels;
+    MeterLevels mPendingMeterLevels = {};
+
+    // Routing, with per-bus state indexed by bus
+    RoutingGraph<kMaxTracks> mRoutingGraph;
+    const RoutingPlan<kMaxTracks>* mRoutingPlan = nullptr; // Held by the audio thread for a callback
+    std::unique_ptr<float[]> mBusBuffers; // kBufferSize samples for each bus
+    std::array<float, kMaxBuses> mBusLevels = {};
+    std::array<float, kMaxBuses> mBusPans = {};
+    std::array<float, kMaxBuses> mBusAppliedLevels = {};
+    std::array<float, kMaxBuses> mBusAppliedPans = {};
+    std::array<bool, kMaxBuses> mBusHasAudio = {}; // Whether any input had audio this sub-block
+    std::array<int32_t, kMaxBuses> mBusInputCounts = {}; // Inputs with audio, over the current sub-block
+    int32_t mBusStageStart = 0;
+
+    // Send buses, indexed by SendBus, with each track's send levels indexed by slot
+    ReverbEffect mReverb;
+    DelayEffect mDelay;
+    EqEffect mEq;
+    std::array<SendEffect*, kSendBusCount> mSendEffects = { &mReverb, &mDelay, &mEq };
+    std::unique_ptr<float[]> mSendBuffers; // kBufferSize samples for each send bus
+    std::array<std::array<float, kSendBusCount>, kMaxTracks> mSendLevels = {};
+    std::array<std::array<float, kSendBusCount>, kMaxTracks> mAppliedSendLevels = {};
+    std::array<float, kSendBusCount> mSendReturnLevels = { 1.0f, 1.0f, 1.0f };
+    std::array<float, kSendBusCount> mAppliedSendReturnLevels = { 1.0f, 1.0f, 1.0f };
+    std::array<bool, kSendBusCount> mSendHasAudio = {}; // Whether any track sent audio this sub-block
+    std::array<bool, kSendBusCount> mIsSendRinging = {}; // Whether the effect's output is still audible
+
+    // Voice budget and quality tiers, only touched by the audio thread apart from the atomics
+    std::atomic<int32_t> mVoiceBudget { 0 };
+    std::atomic<int32_t> mTrackVoiceCap { 0 };
+    // What each instrument was last told
+    std::array<int32_t, kMaxTracks> mVoiceCaps = {};
+    std::array<QualityTier, kMaxTracks> mQualityTiers = {};
+    QualityGovernor mQualityGovernor;
+
+    // Idle mode, only touched by the audio thread apart from the atomics
+    std::atomic<bool> mIsIdleModeEnabled { true };
+    std::atomic<bool> mIsIdle { false };
+    uint32_t mIdleActivityCount = 0; // The activity count when the mixer went idle
+    uint64_t mQuietFrames = 0;
+    uint64_t mIdleFrames = 0;
+    std::atomic<uint32_t> mMissedFrames { 0 };
 };
 
 #endif //MIXER_H
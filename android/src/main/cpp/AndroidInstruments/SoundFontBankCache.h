@@ -0,0 +1,125 @@
+/*
+ * This is used on Android only, on iOS we use the built in SoundFont AudioUnit
+ */
+
+#ifndef SOUND_FONT_BANK_CACHE_H
+#define SOUND_FONT_BANK_CACHE_H
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "tsf.h"
+
+/**
+ * Parses each SoundFont once, however many tracks use it. The first track to ask for a bank
+ * parses it; every track then gets its own tsf_copy(), which shares the parsed presets and sample
+ * data and only owns its voices, channels and output format. When the last track that uses a bank
+ * releases it, the bank is closed.
+ *
+ * Banks are keyed by file path, or by asset path for banks read from the APK.
+ *
+ * Tracks load in parallel, so a track that asks for a bank another track is still parsing waits
+ * for that parse instead of starting its own. Banks that fail to parse aren't cached.
+ */
+class SoundFontBankCache {
+public:
+    using ParseFunction = std::function<tsf*()>;
+
+    static SoundFontBankCache& shared() {
+        static SoundFontBankCache cache;
+        return cache;
+    }
+
+    // Returns a new tsf_copy() of the bank, parsing it first if it isn't cached. Returns nullptr if
+    // it couldn't be parsed. Every copy must be handed back to release().
+    tsf* acquire(const std::string& key, const ParseFunction& parse) {
+        std::shared_ptr<Bank> bank;
+        std::promise<tsf*> parsed;
+        auto isParser = false;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            auto found = mBanks.find(key);
+            if (found != mBanks.end()) {
+                bank = found->second;
+            } else {
+                bank = std::make_shared<Bank>();
+                bank->master = parsed.get_future().share();
+                mBanks[key] = bank;
+                isParser = true;
+            }
+
+            bank->usersCount++;
+        }
+
+        if (isParser) parsed.set_value(parse());
+
+        auto master = bank->master.get();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (master == nullptr) {
+            // Every waiter sees the failure, and the last one out lets the next load try again
+            bank->usersCount--;
+            if (bank->usersCount == 0) eraseBank(bank);
+            return nullptr;
+        }
+
+        // tsf_copy() bumps a reference count that the bank's copies share, so it needs the lock
+        auto copy = tsf_copy(master);
+        mOwners[copy] = bank;
+        return copy;
+    }
+
+    void release(tsf* copy) {
+        if (copy == nullptr) return;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto owner = mOwners.find(copy);
+        if (owner == mOwners.end()) return;
+
+        auto bank = owner->second;
+        mOwners.erase(owner);
+
+        tsf_close(copy);
+
+        bank->usersCount--;
+        if (bank->usersCount == 0) {
+            tsf_close(bank->master.get());
+            eraseBank(bank);
+        }
+    }
+
+    // Number of banks that are parsed or being parsed.
+    size_t getBankCount() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mBanks.size();
+    }
+
+private:
+    struct Bank {
+        std::shared_future<tsf*> master;
+        int32_t usersCount = 0;
+    };
+
+    // Caller must hold mMutex. The bank may already have been replaced after a failed parse.
+    void eraseBank(const std::shared_ptr<Bank>& bank) {
+        for (auto it = mBanks.begin(); it != mBanks.end(); it++) {
+            if (it->second == bank) {
+                mBanks.erase(it);
+                return;
+            }
+        }
+    }
+
+    std::mutex mMutex;
+    std::map<std::string, std::shared_ptr<Bank>> mBanks;
+    std::map<tsf*, std::shared_ptr<Bank>> mOwners;
+};
+
+#endif //SOUND_FONT_BANK_CACHE_H
@@ -5,21 +5,28 @@
 #ifndef SOUND_FONT_INSTRUMENT_H
 #define SOUND_FONT_INSTRUMENT_H
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
 #include "IInstrument.h"
 #include "../Utils/AssetManager.h"
+#include "../Utils/MappedFile.h"
 
 #define TSF_IMPLEMENTATION
 #include "tsf.h"
+#include "SoundFontBankCache.h"
 
 class SoundFontInstrument : public IInstrument {
 public:
+    static constexpr int32_t kDefaultMaxVoices = 64;
+
     int presetIndex;
 
     SoundFontInstrument() {
     }
 
     ~SoundFontInstrument() {
-        tsf_close(mTsf);
+        SoundFontBankCache::shared().release(mTsf);
     }
 
     bool setOutputFormat(int32_t sampleRate, bool isStereo) override {
@@ -37,27 +44,42 @@ public:
         }
     }
 
-    bool loadSf2File(const char* path, bool isAsset, int32_t presetIndex) {
+    // maxVoices voices are allocated up front, so notes never allocate on the audio thread. A note
+    // that would go over the limit, or over the cap the mixer sets, steals a voice by stealPolicy.
+    bool loadSf2File(const char* path, bool isAsset, int32_t presetIndex,
+                     int32_t maxVoices = kDefaultMaxVoices, VoiceStealPolicy stealPolicy = STEAL_OLDEST) {
         this->presetIndex = presetIndex;
+        mMaxVoices = maxVoices > 0 ? maxVoices : kDefaultMaxVoices;
+        mStealPolicy = stealPolicy;
+
+        std::string pathString = path;
+        auto key = (isAsset ? "asset:" : "file:") + pathString;
+
+        // Tracks that use the same bank share its presets and samples, and only this track's voices
+        // are its own
+        mTsf = SoundFontBankCache::shared().acquire(key, [&]() -> tsf* {
+            if (!isAsset) return loadMappedSf2(pathString.c_str());
 
-        if (isAsset) {
-            auto asset = openAssetBuffer(path);
+            auto asset = openAssetBuffer(pathString.c_str());
             auto assetBuffer = AAsset_getBuffer(asset);
             auto assetLength = AAsset_getLength(asset);
 
-            mTsf = tsf_load_memory(assetBuffer, assetLength);
+            auto bank = tsf_load_memory(assetBuffer, assetLength);
 
             AAsset_close(asset);
-        } else {
-            mTsf = tsf_load_filename(path);
-        }
+            return bank;
+        });
+
+        if (mTsf == nullptr || !tsf_set_max_voices(mTsf, mMaxVoices)) return false;
 
         setTsfOutputFormat();
 
-        return mTsf != nullptr;
+        return true;
     }
 
     void renderAudio(float *audioData, int32_t numFrames) override {
+        if (mQualityTier >= QUALITY_REDUCED_VOICES) cutInaudibleTails();
+
         tsf_render_float(mTsf, audioData, numFrames);
     }
 
@@ -67,6 +89,7 @@ public:
 
         if (statusCode == 0x9) {
             // Note On
+            if (data2 > 0) makeRoomForNote(data1);
             tsf_note_on(mTsf, presetIndex, data1, data2 / 255.0);
         } else if (statusCode == 0x8) {
             // Note Off
@@ -86,8 +109,96 @@ public:
     void reset() override {
     }
 
+    // TinySoundFont has no effects, so a track with no voices is silent.
+    bool isIdle() override {
+        return tsf_active_voice_count(mTsf) == 0;
+    }
+
+    void setVoiceCap(int32_t voiceCap) override {
+        mVoiceCap = voiceCap;
+    }
+
+    // TinySoundFont has a single interpolation mode, so only the voice limit and tails change.
+    void setQualityTier(QualityTier tier) override {
+        mQualityTier = tier;
+    }
+
 private:
+    // TinySoundFont converts every sample to float as it parses, so the mapping is only needed until
+    // tsf_load_memory() returns. Parsing from the page cache skips stdio's copy of the whole file.
+    static tsf* loadMappedSf2(const char* path) {
+        MappedFile file;
+
+        // int is as large as TinySoundFont's memory loader goes
+        if (!file.open(path) || file.getSize() > INT32_MAX) return tsf_load_filename(path);
+
+        // The parser reads the whole file in one pass, so have the kernel start reading it now
+        file.advise(MADV_WILLNEED);
+
+        return tsf_load_memory(file.getData(), static_cast<int>(file.getSize()));
+    }
+
+    // Kills voices until the new note fits. Voices that are already releasing go first, then the
+    // one stealPolicy picks.
+    void makeRoomForNote(uint8_t key) {
+        auto voiceLimit = std::min(getTierVoiceLimit(mMaxVoices, mQualityTier), mVoiceCap);
+        auto activeCount = tsf_active_voice_count(mTsf);
+
+        for (; activeCount >= voiceLimit; activeCount--) {
+            auto victim = findVoiceToSteal(key);
+            if (victim == nullptr) return;
+
+            tsf_voice_kill(victim);
+        }
+    }
+
+    tsf_voice* findVoiceToSteal(uint8_t key) {
+        tsf_voice* victim = nullptr;
+
+        for (int i = 0; i < mTsf->voiceNum; i++) {
+            auto voice = &mTsf->voices[i];
+            if (voice->playingPreset == -1) continue;
+
+            if (mStealPolicy == STEAL_SAME_NOTE && voice->playingKey == key) return voice;
+            if (victim == nullptr) {
+                victim = voice;
+                continue;
+            }
+
+            auto isReleasing = voice->ampenv.segment == TSF_SEGMENT_RELEASE;
+            auto isVictimReleasing = victim->ampenv.segment == TSF_SEGMENT_RELEASE;
+            if (isReleasing != isVictimReleasing) {
+                if (isReleasing) victim = voice;
+                continue;
+            }
+
+            auto isBetter = mStealPolicy == STEAL_QUIETEST
+                ? getVoiceLevel(voice) < getVoiceLevel(victim)
+                : voice->playIndex < victim->playIndex;
+            if (isBetter) victim = voice;
+        }
+
+        return victim;
+    }
+
+    void cutInaudibleTails() {
+        for (int i = 0; i < mTsf->voiceNum; i++) {
+            auto voice = &mTsf->voices[i];
+            if (voice->playingPreset == -1 || voice->ampenv.segment != TSF_SEGMENT_RELEASE) continue;
+
+            if (getVoiceLevel(voice) < kInaudibleTailLevel) tsf_voice_kill(voice);
+        }
+    }
+
+    static float getVoiceLevel(const tsf_voice* voice) {
+        return voice->ampenv.level * powf(10.0f, voice->noteGainDB / 20.0f);
+    }
+
     tsf* mTsf = nullptr;
+    int32_t mMaxVoices = kDefaultMaxVoices;
+    int32_t mVoiceCap = INT32_MAX;
+    VoiceStealPolicy mStealPolicy = STEAL_OLDEST;
+    QualityTier mQualityTier = QUALITY_FULL;
     bool mIsStereo;
     int32_t mSampleRate;
 };
@@ -0,0 +1,72 @@
+#include "OfflineEngine.h"
+#include <algorithm>
+#include <chrono>
+#include "../Utils/Logging.h"
+
+OfflineEngine::OfflineEngine(Mixer& mixer, int32_t sampleRate) : mMixer(mixer) {
+    mSampleRate = sampleRate;
+    // Setting the rate prepares the send effects again, which allocates and clears their tails
+    if (mMixer.getSampleRate() != sampleRate) {
+        mMixer.setSampleRate(sampleRate);
+    }
+    setBlockSize(kDefaultBlockSize);
+}
+
+void OfflineEngine::setBlockSize(int32_t blockSize) {
+    // The mixer splits large blocks into sub-blocks itself, so this only sets the write size
+    mBlockSize = std::max(blockSize, 1);
+    mBlockBuffer.resize(mBlockSize * mMixer.getChannelCount());
+}
+
+OfflineRenderResult OfflineEngine::render(const char* path, AudioFileFormat format, uint32_t numFrames, const std::atomic<bool>& isCancelled) {
+    OfflineRenderResult result = {};
+    AudioFileWriter writer;
+
+    if (!writer.open(path, format, mSampleRate, mMixer.getChannelCount())) {
+        LOGE("Failed to open %s for offline render", path);
+        return result;
+    }
+
+    // Offline blocks have no deadline, so the render keeps full quality however long it takes
+    auto wasGovernorEnabled = mMixer.getQualityGovernorEnabled();
+    mMixer.setQualityGovernorEnabled(false);
+
+    auto startTime = std::chrono::steady_clock::now();
+    uint32_t framesRemaining = numFrames;
+
+    while (framesRemaining > 0) {
+        if (isCancelled.load(std::memory_order_relaxed)) {
+            LOGI("Offline render to %s was cancelled", path);
+            break;
+        }
+
+        auto framesToRender = std::min(framesRemaining, static_cast<uint32_t>(mBlockSize));
+
+        mMixer.renderAudio(mBlockBuffer.data(), framesToRender);
+
+        if (!writer.write(mBlockBuffer.data(), framesToRender)) {
+            LOGE("Failed to write offline render to %s", path);
+            break;
+        }
+
+        framesRemaining -= framesToRender;
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    writer.close();
+    mMixer.setQualityGovernorEnabled(wasGovernorEnabled);
+
+    result.framesRendered = numFrames - framesRemaining;
+    result.didSucceed = framesRemaining == 0;
+    result.elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+    if (result.elapsedUs > 0) {
+        auto audioUs = result.framesRendered * 1000000.0 / mSampleRate;
+        result.realtimeFactor = audioUs / result.elapsedUs;
+    }
+
+    LOGI("Rendered %llu frames offline in %llu us (%.1fx realtime)",
+         (unsigned long long) result.framesRendered, (unsigned long long) result.elapsedUs, result.realtimeFactor);
+
+    return result;
+}
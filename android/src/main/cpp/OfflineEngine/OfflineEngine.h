@@ -0,0 +1,42 @@
+#ifndef OFFLINE_ENGINE_H
+#define OFFLINE_ENGINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "../AndroidInstruments/Mixer.h"
+#include "../Utils/AudioFileWriter.h"
+
+struct OfflineRenderResult {
+    bool didSucceed;
+    uint64_t framesRendered;
+    uint64_t elapsedUs;
+    double realtimeFactor; // Seconds of audio rendered per second of wall-clock time
+};
+
+/**
+ * Drives a Mixer without an audio device, pulling blocks as fast as the CPU allows and streaming
+ * them to a file. The tracks and scheduled events are the ones already set up on the Mixer.
+ * Nothing else may call Mixer::renderAudio while a render is in progress.
+ *
+ * A render stops early, and fails, once isCancelled is set. The file is left as far as it got.
+ */
+class OfflineEngine {
+public:
+    OfflineEngine(Mixer& mixer, int32_t sampleRate);
+
+    OfflineRenderResult render(const char* path, AudioFileFormat format, uint32_t numFrames, const std::atomic<bool>& isCancelled);
+
+    int32_t getBlockSize() { return mBlockSize; }
+    void setBlockSize(int32_t blockSize);
+
+private:
+    Mixer& mMixer;
+    int32_t mSampleRate;
+    int32_t mBlockSize;
+    std::vector<float> mBlockBuffer;
+
+    static int32_t constexpr kDefaultBlockSize = 512;
+};
+
+#endif //OFFLINE_ENGINE_H
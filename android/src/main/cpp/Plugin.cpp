@@ -1,10 +1,19 @@
+#include <mutex>
 #include <thread>
+#include <vector>
 #include "SharedInstruments/SfizzSamplerInstrument.h"
 #include "AndroidEngine/AndroidEngine.h"
 #include "AndroidInstruments/SoundFontInstrument.h"
+#include "Utils/InstrumentLoader.h"
 #include "Utils/OptionArray.h"
 
 std::unique_ptr<AndroidEngine> engine;
+std::unique_ptr<InstrumentLoader> loader;
+std::atomic<Dart_Port> loadProgressPort { 0 };
+
+// The track table and routing graph take changes from one thread at a time, but tracks are added
+// from loader workers as well as from Dart, so every change to either goes through this.
+std::mutex trackMutex;
 
 void check_engine() {
     if (engine == nullptr) {
@@ -20,86 +29,190 @@ void setInstrumentOutputFormat(IInstrument* instrument) {
     instrument->setOutputFormat(sampleRate, isStereo);
 }
 
+void enqueueLoad(uint32_t loadId, int32_t priority, Dart_Port callbackPort, InstrumentLoader::LoadFunction load) {
+    loader->enqueue(loadId, priority, std::move(load), [callbackPort](int32_t trackIndex) {
+        callbackToDartInt32(callbackPort, trackIndex);
+    });
+}
+
+const SfizzConfig kDefaultSfizzConfig = { -1, -1, -1, -1, -1, -1 };
+
+SfizzSamplerInstrument* getSfzInstrument(track_index_t trackIndex) {
+    auto track = engine->mSchedulerMixer.getTrack(trackIndex);
+    if (!track.has_value()) return nullptr;
+
+    return dynamic_cast<SfizzSamplerInstrument*>(track.value());
+}
+
+// Adds a loaded instrument to the mixer, unless it failed to load or its load was cancelled.
+int32_t commitInstrument(IInstrument* instrument, bool didLoad, const std::atomic<bool>& isCancelled) {
+    if (!didLoad || isCancelled.load()) {
+        delete instrument;
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(trackMutex);
+    return engine->mSchedulerMixer.addTrack(instrument);
+}
+
 extern "C" {
     __attribute__((visibility("default"))) __attribute__((used))
     void setup_engine(Dart_Port sampleRateCallbackPort) {
+        loader.reset();
         engine = std::make_unique<AndroidEngine>(sampleRateCallbackPort);
+        loader = std::make_unique<InstrumentLoader>();
+        loader->setReportFunction([](const LoadReport& report) {
+            auto progressPort = loadProgressPort.load();
+            if (progressPort == 0) return;
+
+            uint32_t values[] = { report.loadId, report.state, static_cast<uint32_t>(report.trackIndex), report.waitUs, report.loadUs, report.pendingCount };
+            callbackToDartUint32Array(progressPort, 6, values);
+        });
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
     void destroy_engine() {
+        // Loads hold on to the engine, so they have to stop first
+        loader.reset();
         engine.reset();
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
-    void add_track_sf2(const char* filename, bool isAsset, int32_t presetIndex, Dart_Port callbackPort) {
+    void add_track_sf2(const char* filename, bool isAsset, int32_t presetIndex, int32_t maxVoices, int32_t stealPolicy, uint32_t loadId, int32_t priority, Dart_Port callbackPort) {
         check_engine();
 
-        std::thread([=]() {
+        std::string filenameString = filename;
+
+        enqueueLoad(loadId, priority, callbackPort, [=](const std::atomic<bool>& isCancelled) {
             auto sf2Instrument = new SoundFontInstrument();
             setInstrumentOutputFormat(sf2Instrument);
 
-            auto didLoad = sf2Instrument->loadSf2File(filename, isAsset, presetIndex);
-
-            if (didLoad) {
-                auto trackIndex = engine->mSchedulerMixer.addTrack(sf2Instrument);
-
-                callbackToDartInt32(callbackPort, trackIndex);
-            } else {
-                callbackToDartInt32(callbackPort, -1);
-            }
+            auto didLoad = sf2Instrument->loadSf2File(filenameString.c_str(), isAsset, presetIndex, maxVoices,
+                                                         static_cast<VoiceStealPolicy>(stealPolicy));
 
-        }).detach();
+            return commitInstrument(sf2Instrument, didLoad, isCancelled);
+        });
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
-    void add_track_sfz(const char* filename, const char* tuningFilename, Dart_Port callbackPort) {
+    void add_track_sfz(const char* filename, const char* tuningFilename, const SfizzConfig* config, uint32_t loadId, int32_t priority, Dart_Port callbackPort) {
         check_engine();
 
-        std::thread([=]() {
+        auto sfizzConfig = config != nullptr ? *config : kDefaultSfizzConfig;
+        std::string filenameString = filename;
+        auto hasTuning = tuningFilename != nullptr;
+        std::string tuningFilenameString = hasTuning ? tuningFilename : "";
+
+        enqueueLoad(loadId, priority, callbackPort, [=](const std::atomic<bool>& isCancelled) {
             auto sfzInstrument = new SfizzSamplerInstrument();
             setInstrumentOutputFormat(sfzInstrument);
+            sfzInstrument->applyConfig(sfizzConfig);
 
-            auto didLoad = sfzInstrument->loadSfzFile(filename, tuningFilename);
+            auto didLoad = sfzInstrument->loadSfzFile(filenameString.c_str(), hasTuning ? tuningFilenameString.c_str() : nullptr);
 
             if (didLoad) {
                 auto bufferSize = engine->getBufferSize();
                 sfzInstrument->setSamplesPerBlock(bufferSize);
-                auto trackIndex = engine->mSchedulerMixer.addTrack(sfzInstrument);
-
-                callbackToDartInt32(callbackPort, trackIndex);
-            } else {
-                callbackToDartInt32(callbackPort, -1);
             }
-        }).detach();
+
+            return commitInstrument(sfzInstrument, didLoad, isCancelled);
+        });
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
-    void add_track_sfz_string(const char* sampleRoot, const char* sfzString, const char* tuningString, Dart_Port callbackPort) {
+    void add_track_sfz_string(const char* sampleRoot, const char* sfzString, const char* tuningString, const SfizzConfig* config, uint32_t loadId, int32_t priority, Dart_Port callbackPort) {
         check_engine();
 
-        std::thread([=]() {
+        auto sfizzConfig = config != nullptr ? *config : kDefaultSfizzConfig;
+        std::string sampleRootString = sampleRoot;
+        std::string sfzStringCopy = sfzString;
+        auto hasTuning = tuningString != nullptr;
+        std::string tuningStringCopy = hasTuning ? tuningString : "";
+
+        enqueueLoad(loadId, priority, callbackPort, [=](const std::atomic<bool>& isCancelled) {
             auto sfzInstrument = new SfizzSamplerInstrument();
             setInstrumentOutputFormat(sfzInstrument);
+            sfzInstrument->applyConfig(sfizzConfig);
 
-            auto didLoad = sfzInstrument->loadSfzString(sampleRoot, sfzString, tuningString);
+            auto didLoad = sfzInstrument->loadSfzString(sampleRootString.c_str(), sfzStringCopy.c_str(), hasTuning ? tuningStringCopy.c_str() : nullptr);
 
             if (didLoad) {
                 auto bufferSize = engine->getBufferSize();
                 sfzInstrument->setSamplesPerBlock(bufferSize);
-                auto trackIndex = engine->mSchedulerMixer.addTrack(sfzInstrument);
-
-                callbackToDartInt32(callbackPort, trackIndex);
-            } else {
-                callbackToDartInt32(callbackPort, -1);
             }
-        }).detach();
+
+            return commitInstrument(sfzInstrument, didLoad, isCancelled);
+        });
+    }
+
+    // Reconfigures an SFZ track on the loader pool, since a new preload size or oversampling factor
+    // reloads sample data. The callback gets the track index, or -1 if the track isn't an SFZ track
+    // or an option was invalid.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_track_sfz_config(track_index_t trackIndex, const SfizzConfig* config, Dart_Port callbackPort) {
+        check_engine();
+
+        auto sfizzConfig = *config;
+
+        // Dart never hands out load id 0, so reconfigurations can't be cancelled
+        enqueueLoad(0, 0, callbackPort, [=](const std::atomic<bool>& /* isCancelled */) {
+            auto sfzInstrument = getSfzInstrument(trackIndex);
+            if (sfzInstrument == nullptr) return -1;
+
+            return sfzInstrument->applyConfig(sfizzConfig) ? trackIndex : -1;
+        });
     }
 
-__attribute__((visibility("default"))) __attribute__((used))
+    // The options in effect on an SFZ track, with what they cost. Returns false if the track isn't
+    // an SFZ track.
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool get_track_sfz_stats(track_index_t trackIndex, SfizzStats* stats) {
+        check_engine();
+
+        auto sfzInstrument = getSfzInstrument(trackIndex);
+        if (sfzInstrument == nullptr) return false;
+
+        sfzInstrument->getStats(*stats);
+
+        TrackRenderStats renderStats;
+        if (engine->mSchedulerMixer.getRenderStats().getTrackStats(trackSlot(trackIndex), renderStats)) {
+            stats->renderMeanUs = renderStats.handleFrames.meanUs;
+            stats->renderP99Us = renderStats.handleFrames.p99Us;
+        }
+
+        return true;
+    }
+
+    // Moves a queued load up or down. Loads that have started can't be reprioritized.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_load_priority(uint32_t loadId, int32_t priority) {
+        check_engine();
+
+        loader->setPriority(loadId, priority);
+    }
+
+    // The load's callback gets -1. A load that has already started still reads its files, but its
+    // track is never added.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void cancel_load(uint32_t loadId) {
+        check_engine();
+
+        loader->cancel(loadId);
+    }
+
+    // Every load state change is posted here as six uint32s: see LoadReport. 0 turns it off.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_load_progress_port(Dart_Port progressPort) {
+        check_engine();
+
+        loadProgressPort.store(progressPort);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
     void remove_track(track_index_t trackIndex) {
         check_engine();
 
+        std::lock_guard<std::mutex> lock(trackMutex);
         engine->mSchedulerMixer.removeTrack(trackIndex);
     }
 
@@ -117,6 +230,115 @@ __attribute__((visibility("default"))) __attribute__((used))
         return engine->mSchedulerMixer.getLevel(trackIndex);
     }
 
+    // Constant-power pan from -1 (left) to 1 (right). Changes are ramped over the next block.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_track_pan(track_index_t trackIndex, float pan) {
+        check_engine();
+
+        engine->mSchedulerMixer.setPan(trackIndex, pan);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    float get_track_pan(track_index_t trackIndex) {
+        check_engine();
+
+        return engine->mSchedulerMixer.getPan(trackIndex);
+    }
+
+    // How much of the track goes to a send bus. Send levels are set with SEND_EVENT events.
+    __attribute__((visibility("default"))) __attribute__((used))
+    float get_track_send(track_index_t trackIndex, uint32_t sendBus) {
+        check_engine();
+
+        return engine->mSchedulerMixer.getSendLevel(trackIndex, sendBus);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_send_return_level(uint32_t sendBus, float level) {
+        check_engine();
+
+        engine->mSchedulerMixer.setSendReturnLevel(sendBus, level);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_reverb_params(float roomSize, float damping) {
+        check_engine();
+
+        engine->mSchedulerMixer.getReverb().setParams(roomSize, damping);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_delay_params(float delaySeconds, float feedback) {
+        check_engine();
+
+        engine->mSchedulerMixer.getDelay().setParams(delaySeconds, feedback);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_eq_params(float lowGainDb, float midGainDb, float highGainDb) {
+        check_engine();
+
+        engine->mSchedulerMixer.getEq().setParams(lowGainDb, midGainDb, highGainDb);
+    }
+
+    // Returns a new bus that sums whatever is sent to it into the master, or -1 if there are
+    // already kMaxBuses.
+    __attribute__((visibility("default"))) __attribute__((used))
+    int32_t add_bus() {
+        check_engine();
+
+        std::lock_guard<std::mutex> lock(trackMutex);
+        return engine->mSchedulerMixer.addBus();
+    }
+
+    // Whatever was sent to the bus is sent on to the bus's own output.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void remove_bus(int32_t bus) {
+        check_engine();
+
+        std::lock_guard<std::mutex> lock(trackMutex);
+        engine->mSchedulerMixer.removeBus(bus);
+    }
+
+    // output is a bus, or -1 for the master. Returns false if the bus would end up feeding itself.
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool set_bus_output(int32_t bus, int32_t output) {
+        check_engine();
+
+        std::lock_guard<std::mutex> lock(trackMutex);
+        return engine->mSchedulerMixer.setBusOutput(bus, output);
+    }
+
+    // output is a bus, or -1 for the master.
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool set_track_output(track_index_t trackIndex, int32_t output) {
+        check_engine();
+
+        std::lock_guard<std::mutex> lock(trackMutex);
+        return engine->mSchedulerMixer.setTrackOutput(trackIndex, output);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    int32_t get_track_output(track_index_t trackIndex) {
+        check_engine();
+
+        return engine->mSchedulerMixer.getTrackOutput(trackIndex);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_bus_volume(int32_t bus, float volume) {
+        check_engine();
+
+        engine->mSchedulerMixer.setBusLevel(bus, volume);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_bus_pan(int32_t bus, float pan) {
+        check_engine();
+
+        engine->mSchedulerMixer.setBusPan(bus, pan);
+    }
+
     __attribute__((visibility("default"))) __attribute__((used))
     int32_t get_position() {
         check_engine();
@@ -131,31 +353,216 @@ __attribute__((visibility("default"))) __attribute__((used))
         return engine->mSchedulerMixer.getLastRenderTimeUs();
     }
 
+    // Starts posting notifications from the audio thread to a Dart port, or stops with a port of 0.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_notification_port(Dart_Port notificationPort) {
+        check_engine();
+
+        engine->mSchedulerMixer.setNotificationPort(notificationPort);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_buffer_low_watermark(uint32_t bufferLowWatermark) {
+        check_engine();
+
+        engine->mSchedulerMixer.setBufferLowWatermark(bufferLowWatermark);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_metering_enabled(bool isEnabled) {
+        check_engine();
+
+        engine->mSchedulerMixer.setMeteringEnabled(isEnabled);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_meter_window_frames(uint32_t meterWindowFrames) {
+        check_engine();
+
+        engine->mSchedulerMixer.setMeterWindowFrames(meterWindowFrames);
+    }
+
+    // Shares this many voices between the playing tracks, fewer while the audio thread is close to
+    // its deadline. 0 leaves each instrument to its own voice limit.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_voice_budget(int32_t voiceBudget) {
+        check_engine();
+
+        engine->mSchedulerMixer.setVoiceBudget(voiceBudget);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    int32_t get_track_voice_cap() {
+        check_engine();
+
+        return engine->mSchedulerMixer.getTrackVoiceCap();
+    }
+
+    // Steps instruments down to cheaper quality tiers while callbacks run close to their deadline,
+    // posting NOTIFICATION_QUALITY_CHANGED each time. On by default.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_quality_governor_enabled(bool isEnabled) {
+        check_engine();
+
+        engine->mSchedulerMixer.setQualityGovernorEnabled(isEnabled);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    int32_t get_quality_tier() {
+        check_engine();
+
+        return engine->mSchedulerMixer.getQualityTier();
+    }
+
+    // With idle mode on, the mixer writes silence without rendering once the transport is stopped,
+    // or has nothing left to play, and every instrument has gone quiet. releaseStream also stops the
+    // stream after a while idle. Either wakes on the next event, schedule or play call.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_idle_mode(bool isEnabled, bool isReleasingStream) {
+        check_engine();
+
+        engine->mSchedulerMixer.setIdleModeEnabled(isEnabled);
+        engine->setStreamReleaseEnabled(isEnabled && isReleasingStream);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool get_is_idle() {
+        check_engine();
+
+        return engine->mSchedulerMixer.getIsIdle();
+    }
+
+    // Copies every metered track's levels and the mix's levels in one call.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void get_meter_levels(MeterLevels* meterLevels) {
+        check_engine();
+
+        engine->mSchedulerMixer.getMeterLevels(meterLevels);
+    }
+
+    // Copies the transport as of the last rendered block in one call.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void get_transport_snapshot(TransportSnapshot* snapshot) {
+        check_engine();
+
+        engine->mSchedulerMixer.getTransportSnapshot(snapshot);
+    }
+
+    // Timing of the whole audio callback since the last reset.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void get_render_stats(RenderTimingStats* stats) {
+        check_engine();
+
+        *stats = engine->mSchedulerMixer.getRenderStats().getCallbackStats();
+    }
+
+    // How many sub-blocks each audio callback was split into since the last reset.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void get_sub_block_stats(SubBlockStats* stats) {
+        check_engine();
+
+        *stats = engine->mSchedulerMixer.getRenderStats().getSubBlockStats();
+    }
+
+    // How many track renders were skipped because the track's instrument was idle, since the last
+    // reset.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void get_skip_stats(SkipStats* stats) {
+        check_engine();
+
+        *stats = engine->mSchedulerMixer.getRenderStats().getSkipStats();
+    }
+
+    // Timing of one track's handleFrames and instrument render. Returns false for an invalid track.
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool get_track_render_stats(track_index_t trackIndex, TrackRenderStats* stats) {
+        check_engine();
+
+        if (!engine->mSchedulerMixer.isTrackLive(trackIndex)) return false;
+
+        return engine->mSchedulerMixer.getRenderStats().getTrackStats(trackSlot(trackIndex), *stats);
+    }
+
+    // Instrument render times are only recorded while this is enabled.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_instrument_render_stats_enabled(bool isEnabled) {
+        check_engine();
+
+        engine->mSchedulerMixer.getRenderStats().setIsInstrumentTimingEnabled(isEnabled);
+    }
+
+    // The histograms are cleared on the next audio callback.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void reset_render_stats() {
+        check_engine();
+
+        engine->mSchedulerMixer.getRenderStats().requestReset();
+    }
+
     __attribute__((visibility("default"))) __attribute__((used))
     uint32_t get_buffer_available_count(track_index_t trackIndex) {
         return engine->mSchedulerMixer.getBufferAvailableCount(trackIndex);
     }
 
+    __attribute__((visibility("default"))) __attribute__((used))
+    void get_buffer_available_counts(const track_index_t* trackIndices, uint32_t tracksCount, uint32_t* availableCounts) {
+        check_engine();
+
+        engine->mSchedulerMixer.getBufferAvailableCounts(trackIndices, tracksCount, availableCounts);
+    }
+
+    // Shares a track's event ring so Dart can write events straight into it. Returns the ring's
+    // capacity, or 0 for an invalid track.
+    __attribute__((visibility("default"))) __attribute__((used))
+    uint32_t get_event_ring(track_index_t trackIndex, SchedulerEvent** events, uint32_t** readPosition, uint32_t** writePosition) {
+        check_engine();
+
+        return engine->mSchedulerMixer.getEventRing(trackIndex, events, readPosition, writePosition);
+    }
+
+    // Makes events written into the rings visible to the audio thread.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void publish_event_rings(const track_index_t* trackIndices, const uint32_t* writePositions, uint32_t tracksCount) {
+        check_engine();
+
+        engine->mSchedulerMixer.publishEventRings(trackIndices, writePositions, tracksCount);
+        engine->wake();
+    }
+
     __attribute__((visibility("default"))) __attribute__((used))
     void handle_events_now(track_index_t trackIndex, const uint8_t* eventData, int32_t eventsCount) {
         check_engine();
 
-        SchedulerEvent events[eventsCount];
+        // On the heap, since a big batch could overflow the stack
+        std::vector<SchedulerEvent> events(eventsCount);
 
-        rawEventDataToEvents(eventData, eventsCount, events);
+        rawEventDataToEvents(eventData, eventsCount, events.data());
 
-        engine->mSchedulerMixer.handleEventsNow(trackIndex, events, eventsCount);
+        engine->mSchedulerMixer.handleEventsNow(trackIndex, events.data(), eventsCount);
+        engine->wake();
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
     int32_t schedule_events(track_index_t trackIndex, const uint8_t* eventData, int32_t eventsCount) {
         check_engine();
 
-        SchedulerEvent events[eventsCount];
+        auto result = engine->mSchedulerMixer.scheduleRawEvents(trackIndex, eventData, eventsCount);
+        engine->wake();
+
+        return result;
+    }
+
+    // Schedules events for many tracks in one call. eventData holds runsCount runs, each a track
+    // index and events count followed by the events. Writes each run's accepted count to
+    // acceptedCounts.
+    __attribute__((visibility("default"))) __attribute__((used))
+    uint32_t schedule_events_multi(const uint8_t* eventData, uint32_t eventDataSize, uint32_t runsCount, uint32_t* acceptedCounts) {
+        check_engine();
 
-        rawEventDataToEvents(eventData, eventsCount, events);
+        auto result = engine->mSchedulerMixer.scheduleEventsMulti(eventData, eventDataSize, runsCount, acceptedCounts);
+        engine->wake();
 
-        return engine->mSchedulerMixer.scheduleEvents(trackIndex, events, eventsCount);
+        return result;
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
@@ -165,6 +572,100 @@ __attribute__((visibility("default"))) __attribute__((used))
         return engine->mSchedulerMixer.clearEvents(trackIndex, fromFrame);
     }
 
+    // Adds events in any order to the track's event store and writes their ids to ids. Stored
+    // events can be edited individually while they play.
+    __attribute__((visibility("default"))) __attribute__((used))
+    uint32_t insert_events(track_index_t trackIndex, const uint8_t* eventData, int32_t eventsCount, event_id_t* ids) {
+        check_engine();
+
+        // On the heap, since a big batch could overflow the stack
+        std::vector<SchedulerEvent> events(eventsCount);
+
+        rawEventDataToEvents(eventData, eventsCount, events.data());
+
+        auto result = engine->mSchedulerMixer.insertEvents(trackIndex, events.data(), eventsCount, ids);
+        engine->wake();
+
+        return result;
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    uint32_t remove_events(track_index_t trackIndex, const event_id_t* ids, int32_t idsCount) {
+        check_engine();
+
+        return engine->mSchedulerMixer.removeEvents(trackIndex, ids, idsCount);
+    }
+
+    // Removes stored events from fromFrame up to but not including toFrame.
+    __attribute__((visibility("default"))) __attribute__((used))
+    uint32_t erase_events(track_index_t trackIndex, position_frame_t fromFrame, position_frame_t toFrame) {
+        check_engine();
+
+        return engine->mSchedulerMixer.eraseEvents(trackIndex, fromFrame, toFrame);
+    }
+
+    // Loop events are sorted by frame, relative to loopStartFrame. The audio thread repeats them every
+    // loopLengthFrames until the loop is cleared. Returns the number of events accepted.
+    __attribute__((visibility("default"))) __attribute__((used))
+    uint32_t set_track_loop(track_index_t trackIndex, position_frame_t loopStartFrame, uint32_t loopLengthFrames, const uint8_t* eventData, int32_t eventsCount) {
+        check_engine();
+
+        // On the heap, since a big batch could overflow the stack
+        std::vector<SchedulerEvent> events(eventsCount);
+
+        rawEventDataToEvents(eventData, eventsCount, events.data());
+
+        auto result = engine->mSchedulerMixer.setTrackLoop(trackIndex, loopStartFrame, loopLengthFrames, events.data(), eventsCount);
+        engine->wake();
+
+        return result;
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void clear_track_loop(track_index_t trackIndex) {
+        check_engine();
+
+        engine->mSchedulerMixer.clearTrackLoop(trackIndex);
+    }
+
+    // Event times are read as ticks from here on, with tick 0 on originFrame. Returns false if the
+    // scheduler has too many tempo changes waiting to be applied.
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool set_tick_timebase(position_frame_t originFrame, uint32_t sampleRate) {
+        check_engine();
+
+        return engine->mSchedulerMixer.setTickTimebase(originFrame, sampleRate);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool set_frame_timebase() {
+        check_engine();
+
+        return engine->mSchedulerMixer.setFrameTimebase();
+    }
+
+    // Holds bpm from tick onwards. Pass 0xFFFFFFFF as the tick to change the tempo at the playhead.
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool set_tempo(position_tick_t tick, float bpm) {
+        check_engine();
+
+        auto result = engine->mSchedulerMixer.setTempo(tick, bpm);
+        engine->wake();
+
+        return result;
+    }
+
+    // Ramps linearly from the tempo at startTick to endBpm at endTick.
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool ramp_tempo(position_tick_t startTick, position_tick_t endTick, float endBpm) {
+        check_engine();
+
+        auto result = engine->mSchedulerMixer.rampTempo(startTick, endTick, endBpm);
+        engine->wake();
+
+        return result;
+    }
+
     __attribute__((visibility("default"))) __attribute__((used))
     void engine_play() {
         check_engine();
@@ -178,4 +679,44 @@ __attribute__((visibility("default"))) __attribute__((used))
 
         engine->pause();
     }
+
+    // Renders tracks on this many worker threads as well as the audio thread. 0 disables parallel
+    // rendering.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_render_thread_count(int32_t workerCount) {
+        check_engine();
+
+        engine->mSchedulerMixer.setRenderThreadCount(workerCount);
+    }
+
+    // Largest number of frames the mixer renders in one pass. Callbacks bigger than this are split.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_sub_block_size(int32_t frames) {
+        check_engine();
+
+        engine->mSchedulerMixer.setSubBlockFrames(frames);
+    }
+
+    // Renders numFrames from the current position to a file, as fast as possible. The output
+    // stream is stopped for the duration of the render. Calls back with the realtime factor that
+    // was reached, or -1 on failure, for an unknown format, or if a render is already running.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void render_offline(const char* path, int32_t format, uint32_t numFrames, Dart_Port callbackPort) {
+        check_engine();
+
+        if (!isAudioFileFormat(format)) {
+            callbackToDartDouble(callbackPort, -1.0);
+            return;
+        }
+
+        engine->renderOffline(path, static_cast<AudioFileFormat>(format), numFrames, callbackPort);
+    }
+
+    // Stops a running offline render, which then calls back with -1. Does nothing if none is running.
+    __attribute__((visibility("default"))) __attribute__((used))
+    void cancel_offline_render() {
+        check_engine();
+
+        engine->cancelOfflineRender();
+    }
 }
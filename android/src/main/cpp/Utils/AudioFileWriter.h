@@ -0,0 +1,117 @@
+#ifndef AUDIO_FILE_WRITER_H
+#define AUDIO_FILE_WRITER_H
+
+#include <cstdint>
+#include <cstdio>
+
+enum AudioFileFormat {
+    WAV_FLOAT = 0, // 32-bit IEEE float WAV
+    RAW_FLOAT = 1, // Headerless interleaved 32-bit float, native endianness
+};
+
+// For formats that come in from outside as plain integers.
+inline bool isAudioFileFormat(int32_t format) {
+    return format == WAV_FLOAT || format == RAW_FLOAT;
+}
+
+/**
+ * Streams interleaved float frames to a file. For WAV files, a header with placeholder sizes is
+ * written on open and patched on close, so the total length doesn't need to be known up front.
+ */
+class AudioFileWriter {
+public:
+    ~AudioFileWriter() {
+        close();
+    }
+
+    bool open(const char* path, AudioFileFormat format, int32_t sampleRate, int32_t channelCount) {
+        close();
+
+        mFile = fopen(path, "wb");
+        if (mFile == nullptr) return false;
+
+        mFormat = format;
+        mSampleRate = sampleRate;
+        mChannelCount = channelCount;
+        mFramesWritten = 0;
+
+        if (mFormat == WAV_FLOAT) {
+            writeWavHeader();
+        }
+
+        return true;
+    }
+
+    bool write(const float* audioData, int32_t numFrames) {
+        if (mFile == nullptr) return false;
+
+        auto samplesCount = static_cast<size_t>(numFrames) * mChannelCount;
+        auto samplesWritten = fwrite(audioData, sizeof(float), samplesCount, mFile);
+        mFramesWritten += samplesWritten / mChannelCount;
+
+        return samplesWritten == samplesCount;
+    }
+
+    void close() {
+        if (mFile == nullptr) return;
+
+        if (mFormat == WAV_FLOAT) {
+            fseek(mFile, 0, SEEK_SET);
+            writeWavHeader();
+        }
+
+        fclose(mFile);
+        mFile = nullptr;
+    }
+
+    uint64_t getFramesWritten() { return mFramesWritten; }
+
+private:
+    void writeWavHeader() {
+        uint32_t dataSize = static_cast<uint32_t>(mFramesWritten * mChannelCount * sizeof(float));
+        uint16_t blockAlign = static_cast<uint16_t>(mChannelCount * sizeof(float));
+
+        fwrite("RIFF", 1, 4, mFile);
+        writeUint32(36 + dataSize);
+        fwrite("WAVE", 1, 4, mFile);
+
+        fwrite("fmt ", 1, 4, mFile);
+        writeUint32(16);
+        writeUint16(3); // WAVE_FORMAT_IEEE_FLOAT
+        writeUint16(static_cast<uint16_t>(mChannelCount));
+        writeUint32(static_cast<uint32_t>(mSampleRate));
+        writeUint32(static_cast<uint32_t>(mSampleRate) * blockAlign);
+        writeUint16(blockAlign);
+        writeUint16(32);
+
+        fwrite("data", 1, 4, mFile);
+        writeUint32(dataSize);
+    }
+
+    // WAV is little-endian regardless of the host
+    void writeUint32(uint32_t value) {
+        uint8_t bytes[4] = {
+            static_cast<uint8_t>(value),
+            static_cast<uint8_t>(value >> 8),
+            static_cast<uint8_t>(value >> 16),
+            static_cast<uint8_t>(value >> 24),
+        };
+        fwrite(bytes, 1, 4, mFile);
+    }
+
+    void writeUint16(uint16_t value) {
+        uint8_t bytes[2] = {
+            static_cast<uint8_t>(value),
+            static_cast<uint8_t>(value >> 8),
+        };
+        fwrite(bytes, 1, 2, mFile);
+    }
+
+    FILE* mFile = nullptr;
+    AudioFileFormat mFormat = WAV_FLOAT;
+    int32_t mSampleRate = 0;
+    int32_t mChannelCount = 0;
+    uint64_t mFramesWritten = 0;
+};
+
+#endif //AUDIO_FILE_WRITER_H
@@ -0,0 +1,271 @@
+#ifndef INSTRUMENT_LOADER_H
+#define INSTRUMENT_LOADER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Remember to keep lib/models/instrument_load.dart in sync.
+enum LoadState {
+    LOAD_QUEUED = 0,
+    LOAD_STARTED = 1,
+    LOAD_FINISHED = 2,
+    LOAD_FAILED = 3,
+    LOAD_CANCELLED = 4,
+};
+
+// Posted to Dart as six uint32s whenever a load changes state.
+struct LoadReport {
+    uint32_t loadId;
+    uint32_t state;
+    int32_t trackIndex; // -1 until the load has finished
+    uint32_t waitUs;    // Time spent queued, once the load has started
+    uint32_t loadUs;    // Time spent loading, once the load is over
+    uint32_t pendingCount; // Loads queued or running after this change
+};
+
+/**
+ * Loads instruments on a fixed set of worker threads, highest priority first and in submission
+ * order among equal priorities, so a project with many tracks doesn't start a thread per track.
+ *
+ * A load is a function that returns the new track's index, or -1 if it failed. It's handed a
+ * cancellation flag to check before committing its track to the engine, since cancel() can't stop
+ * a load that is already reading from disk. Loads cancelled while still queued never run.
+ *
+ * Every load's completion function is called exactly once, on a worker, or on the calling thread
+ * for loads that were cancelled or discarded by the destructor before they started.
+ */
+class InstrumentLoader {
+public:
+    using LoadFunction = std::function<int32_t(const std::atomic<bool>& isCancelled)>;
+    using CompleteFunction = std::function<void(int32_t trackIndex)>;
+    using ReportFunction = std::function<void(const LoadReport& report)>;
+
+    static constexpr int32_t kMaxWorkers = 4;
+
+    // Leaves a core for the audio thread, and caps the workers so loads don't fight over the disk.
+    static int32_t getDefaultWorkerCount() {
+        auto coreCount = static_cast<int32_t>(std::thread::hardware_concurrency());
+        return std::max(1, std::min(coreCount - 1, kMaxWorkers));
+    }
+
+    explicit InstrumentLoader(int32_t workerCount = getDefaultWorkerCount()) {
+        workerCount = std::max(1, std::min(workerCount, kMaxWorkers));
+
+        for (int32_t i = 0; i < workerCount; i++) {
+            mThreads.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    // Cancels queued loads, then waits for running ones to finish.
+    ~InstrumentLoader() {
+        std::vector<std::unique_ptr<Load>> queued;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mIsRunning = false;
+            queued.swap(mQueue);
+            for (auto load : mRunning) {
+                load->isCancelled.store(true);
+            }
+        }
+        mCondition.notify_all();
+
+        for (auto& thread : mThreads) {
+            thread.join();
+        }
+
+        for (auto& load : queued) {
+            load->onComplete(-1);
+        }
+    }
+
+    // Called with every state change, from whichever thread made it.
+    void setReportFunction(ReportFunction onReport) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOnReport = std::move(onReport);
+    }
+
+    void enqueue(uint32_t loadId, int32_t priority, LoadFunction run, CompleteFunction onComplete) {
+        auto load = std::make_unique<Load>();
+        load->loadId = loadId;
+        load->priority = priority;
+        load->queuedTime = Clock::now();
+        load->run = std::move(run);
+        load->onComplete = std::move(onComplete);
+
+        ReportFunction onReport;
+        LoadReport report = { loadId, LOAD_QUEUED, -1, 0, 0, 0 };
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            load->sequenceNumber = mNextSequenceNumber++;
+            mQueue.push_back(std::move(load));
+            report.pendingCount = countPending();
+            onReport = mOnReport;
+        }
+        mCondition.notify_one();
+
+        if (onReport) onReport(report);
+    }
+
+    // Returns false if the load has already finished or never existed.
+    bool cancel(uint32_t loadId) {
+        std::unique_ptr<Load> cancelled;
+        ReportFunction onReport;
+        LoadReport report = { loadId, LOAD_CANCELLED, -1, 0, 0, 0 };
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            auto queued = findQueued(loadId);
+            if (queued != mQueue.end()) {
+                cancelled = std::move(*queued);
+                mQueue.erase(queued);
+                report.waitUs = elapsedUs(cancelled->queuedTime, Clock::now());
+                report.pendingCount = countPending();
+                onReport = mOnReport;
+            } else {
+                for (auto load : mRunning) {
+                    if (load->loadId == loadId) {
+                        load->isCancelled.store(true);
+                        return true;
+                    }
+                }
+                return false;
+            }
+        }
+
+        cancelled->onComplete(-1);
+        if (onReport) onReport(report);
+        return true;
+    }
+
+    // Moves a queued load up or down the queue. Returns false if it isn't queued.
+    bool setPriority(uint32_t loadId, int32_t priority) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto queued = findQueued(loadId);
+        if (queued == mQueue.end()) return false;
+
+        (*queued)->priority = priority;
+        return true;
+    }
+
+    int32_t getWorkerCount() {
+        return static_cast<int32_t>(mThreads.size());
+    }
+
+    // Loads queued or running.
+    uint32_t getPendingCount() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return countPending();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Load {
+        uint32_t loadId;
+        int32_t priority;
+        uint64_t sequenceNumber;
+        Clock::time_point queuedTime;
+        LoadFunction run;
+        CompleteFunction onComplete;
+        std::atomic<bool> isCancelled { false };
+    };
+
+    // Caller must hold mMutex.
+    uint32_t countPending() {
+        return static_cast<uint32_t>(mQueue.size() + mRunning.size());
+    }
+
+    static uint32_t elapsedUs(Clock::time_point start, Clock::time_point end) {
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+    }
+
+    std::vector<std::unique_ptr<Load>>::iterator findQueued(uint32_t loadId) {
+        return std::find_if(mQueue.begin(), mQueue.end(), [loadId](const std::unique_ptr<Load>& load) {
+            return load->loadId == loadId;
+        });
+    }
+
+    // A project has tens of tracks, so a linear scan is cheaper than keeping a heap that has to be
+    // rebuilt whenever a priority changes.
+    std::unique_ptr<Load> popNext() {
+        auto next = std::min_element(mQueue.begin(), mQueue.end(), [](const std::unique_ptr<Load>& a, const std::unique_ptr<Load>& b) {
+            if (a->priority != b->priority) return a->priority > b->priority;
+            return a->sequenceNumber < b->sequenceNumber;
+        });
+
+        auto load = std::move(*next);
+        mQueue.erase(next);
+        return load;
+    }
+
+    void workerLoop() {
+        while (true) {
+            std::unique_ptr<Load> load;
+            ReportFunction onReport;
+            LoadReport report;
+
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return !mIsRunning || !mQueue.empty(); });
+
+                if (!mIsRunning) return;
+
+                load = popNext();
+                mRunning.push_back(load.get());
+                report = { load->loadId, LOAD_STARTED, -1, elapsedUs(load->queuedTime, Clock::now()), 0, countPending() };
+                onReport = mOnReport;
+            }
+
+            if (onReport) onReport(report);
+
+            auto startTime = Clock::now();
+            auto trackIndex = load->run(load->isCancelled);
+            report.loadUs = elapsedUs(startTime, Clock::now());
+            report.trackIndex = trackIndex;
+
+            if (trackIndex != -1) {
+                report.state = LOAD_FINISHED;
+            } else if (load->isCancelled.load()) {
+                report.state = LOAD_CANCELLED;
+            } else {
+                report.state = LOAD_FAILED;
+            }
+
+            // Still counted as pending until its completion has run, so a caller waiting for the
+            // pending count to reach 0 sees every result.
+            load->onComplete(trackIndex);
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mRunning.erase(std::find(mRunning.begin(), mRunning.end(), load.get()));
+                report.pendingCount = countPending();
+                onReport = mOnReport;
+            }
+
+            if (onReport) onReport(report);
+        }
+    }
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mIsRunning = true;
+    uint64_t mNextSequenceNumber = 0;
+    std::vector<std::unique_ptr<Load>> mQueue;
+    std::vector<Load*> mRunning;
+    ReportFunction mOnReport;
+    std::vector<std::thread> mThreads;
+};
+
+#endif //INSTRUMENT_LOADER_H
@@ -1,12 +1,19 @@
 #ifndef ANDROID_LOGGING_H
 #define ANDROID_LOGGING_H
 
-#include <android/log.h>
-
 #define APP_NAME "FLUTTER_SEQUENCER"
 
+#ifdef __ANDROID__
+#include <android/log.h>
+
 #define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, APP_NAME, __VA_ARGS__))
 #define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, APP_NAME, __VA_ARGS__))
+#else
+// Headless builds (offline rendering, benchmarks) log to stderr
+#include <cstdio>
 
-#endif //ANDROID_LOGGING_H
+#define LOGI(...) ((void)(fprintf(stderr, APP_NAME ": " __VA_ARGS__), fputc('\n', stderr)))
+#define LOGE(...) ((void)(fprintf(stderr, APP_NAME " ERROR: " __VA_ARGS__), fputc('\n', stderr)))
+#endif
 
+#endif //ANDROID_LOGGING_H
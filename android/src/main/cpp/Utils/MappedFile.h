@@ -0,0 +1,79 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * A whole file mapped read-only into memory. Its pages come straight from the kernel's page cache,
+ * so nothing is copied until it's read, and processes that map the same file share the pages.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    // Returns false if the file can't be opened or mapped, or is empty.
+    bool open(const char* path) {
+        close();
+
+        auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1) return false;
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == -1 || fileStat.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+
+        auto data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // The mapping keeps the file alive on its own
+        ::close(fd);
+
+        if (data == MAP_FAILED) return false;
+
+        mData = static_cast<const uint8_t*>(data);
+        mSize = static_cast<size_t>(fileStat.st_size);
+        return true;
+    }
+
+    void close() {
+        if (mData != nullptr) {
+            munmap(const_cast<uint8_t*>(mData), mSize);
+            mData = nullptr;
+            mSize = 0;
+        }
+    }
+
+    // Tells the kernel how the mapping will be read, e.g. MADV_WILLNEED to start reading it ahead.
+    void advise(int advice) {
+        if (mData != nullptr) {
+            madvise(const_cast<uint8_t*>(mData), mSize, advice);
+        }
+    }
+
+    const uint8_t* getData() const {
+        return mData;
+    }
+
+    size_t getSize() const {
+        return mSize;
+    }
+
+private:
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+};
+
+#endif //MAPPED_FILE_H
@@ -0,0 +1,391 @@
+#ifndef MIX_KERNEL_H
+#define MIX_KERNEL_H
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Kernels that add one track's interleaved or planar buffer into the mix while ramping its gain.
+ *
+ * Each channel has its own start and end gain, so a volume or pan change fades in linearly over the
+ * block instead of stepping at the block boundary. The gain on frame f is
+ * start + (end - start) * f / numFrames, so the next block picks up exactly where this one stopped.
+ *
+ * Mono and stereo are compiled separately so the lane layout of the gain vector is known at compile
+ * time. Other channel counts use the scalar loop.
+ *
+ * Mixing can also meter the track as it goes, while its samples are in registers anyway, and
+ * measure() meters a finished mix.
+ */
+namespace MixKernel {
+
+// Mixer clamps its channel count to this so gains can live in fixed-size arrays
+constexpr int32_t kMaxChannels = 8;
+
+#if defined(__AVX__)
+#define MIX_KERNEL_SIMD 1
+constexpr int32_t kVectorWidth = 8;
+typedef __m256 Vector;
+inline Vector load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, Vector v) { _mm256_storeu_ps(p, v); }
+inline Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+inline Vector multiplyAdd(Vector acc, Vector a, Vector b) { return _mm256_add_ps(acc, _mm256_mul_ps(a, b)); }
+inline Vector multiply(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+inline Vector absolute(Vector v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+inline Vector maximum(Vector a, Vector b) { return _mm256_max_ps(a, b); }
+inline Vector zero() { return _mm256_setzero_ps(); }
+inline void interleave(Vector left, Vector right, Vector& low, Vector& high) {
+    // unpack works within 128-bit halves, so the halves are swapped back into frame order after
+    auto lowHalves = _mm256_unpacklo_ps(left, right);
+    auto highHalves = _mm256_unpackhi_ps(left, right);
+    low = _mm256_permute2f128_ps(lowHalves, highHalves, 0x20);
+    high = _mm256_permute2f128_ps(lowHalves, highHalves, 0x31);
+}
+#elif defined(__SSE__)
+#define MIX_KERNEL_SIMD 1
+constexpr int32_t kVectorWidth = 4;
+typedef __m128 Vector;
+inline Vector load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Vector v) { _mm_storeu_ps(p, v); }
+inline Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+inline Vector multiplyAdd(Vector acc, Vector a, Vector b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+inline Vector multiply(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+inline Vector absolute(Vector v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+inline Vector maximum(Vector a, Vector b) { return _mm_max_ps(a, b); }
+inline Vector zero() { return _mm_setzero_ps(); }
+inline void interleave(Vector left, Vector right, Vector& low, Vector& high) {
+    low = _mm_unpacklo_ps(left, right);
+    high = _mm_unpackhi_ps(left, right);
+}
+#elif defined(__ARM_NEON)
+#define MIX_KERNEL_SIMD 1
+constexpr int32_t kVectorWidth = 4;
+typedef float32x4_t Vector;
+inline Vector load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, Vector v) { vst1q_f32(p, v); }
+inline Vector add(Vector a, Vector b) { return vaddq_f32(a, b); }
+inline Vector multiplyAdd(Vector acc, Vector a, Vector b) { return vmlaq_f32(acc, a, b); }
+inline Vector multiply(Vector a, Vector b) { return vmulq_f32(a, b); }
+inline Vector absolute(Vector v) { return vabsq_f32(v); }
+inline Vector maximum(Vector a, Vector b) { return vmaxq_f32(a, b); }
+inline Vector zero() { return vdupq_n_f32(0.0f); }
+inline void interleave(Vector left, Vector right, Vector& low, Vector& high) {
+    auto zipped = vzipq_f32(left, right);
+    low = zipped.val[0];
+    high = zipped.val[1];
+}
+#else
+constexpr int32_t kVectorWidth = 1;
+#endif
+
+// Peak and sum of squares per channel, accumulated over as many blocks as the meter's window.
+struct Levels {
+    float peaks[kMaxChannels];
+    float sumSquares[kMaxChannels];
+
+    void clear() {
+        for (int32_t channel = 0; channel < kMaxChannels; channel++) {
+            peaks[channel] = 0.0f;
+            sumSquares[channel] = 0.0f;
+        }
+    }
+
+    void addSample(int32_t channel, float sample) {
+        peaks[channel] = std::fmax(peaks[channel], std::fabs(sample));
+        sumSquares[channel] += sample * sample;
+    }
+};
+
+#ifdef MIX_KERNEL_SIMD
+// Folds per-lane peaks and sums of squares into their channels.
+inline void addLanes(Levels& levels, int32_t channelCount, Vector peak, Vector sumSquare) {
+    float lanePeaks[kVectorWidth];
+    float laneSumSquares[kVectorWidth];
+    store(lanePeaks, peak);
+    store(laneSumSquares, sumSquare);
+
+    for (int32_t lane = 0; lane < kVectorWidth; lane++) {
+        auto channel = lane % channelCount;
+
+        levels.peaks[channel] = std::fmax(levels.peaks[channel], lanePeaks[lane]);
+        levels.sumSquares[channel] += laneSumSquares[lane];
+    }
+}
+
+// Folds lanes that all belong to one channel, as they do when the input is planar.
+inline void addChannelLanes(Levels& levels, int32_t channel, Vector peak, Vector sumSquare) {
+    float lanePeaks[kVectorWidth];
+    float laneSumSquares[kVectorWidth];
+    store(lanePeaks, peak);
+    store(laneSumSquares, sumSquare);
+
+    for (int32_t lane = 0; lane < kVectorWidth; lane++) {
+        levels.peaks[channel] = std::fmax(levels.peaks[channel], lanePeaks[lane]);
+        levels.sumSquares[channel] += laneSumSquares[lane];
+    }
+}
+#endif
+
+// Per-channel gains for a constant-power pan. pan runs from -1 (left) to 1 (right). The gains are
+// scaled so a centred track plays at unity on both channels, as it did before panning existed.
+inline void panGains(float pan, float& left, float& right) {
+    if (pan < -1.0f) pan = -1.0f;
+    if (pan > 1.0f) pan = 1.0f;
+
+    auto angle = (pan + 1.0f) * float(M_PI) / 4.0f;
+    left = std::cos(angle) * float(M_SQRT2);
+    right = std::sin(angle) * float(M_SQRT2);
+}
+
+// Any channel count, one sample at a time. Also the reference the SIMD kernels are tested against.
+// Adds the track's levels after gain to levels, if it isn't null.
+inline void mixScalar(float* output, const float* input, int32_t numFrames, int32_t channelCount,
+                      const float* startGains, const float* endGains, Levels* levels = nullptr) {
+    if (numFrames <= 0) return;
+
+    for (int32_t channel = 0; channel < channelCount; channel++) {
+        auto gain = startGains[channel];
+        auto step = (endGains[channel] - gain) / numFrames;
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            auto i = frame * channelCount + channel;
+            auto sample = input[i] * (gain + step * frame);
+
+            output[i] += sample;
+            if (levels != nullptr) levels->addSample(channel, sample);
+        }
+    }
+}
+
+template <int32_t channelCount, bool isMetered = false>
+inline void mix(float* output, const float* input, int32_t numFrames,
+                const float* startGains, const float* endGains, Levels* levels = nullptr) {
+    static_assert(channelCount == 1 || channelCount == 2, "Only mono and stereo are specialised");
+    if (numFrames <= 0) return;
+
+    float steps[channelCount];
+    for (int32_t channel = 0; channel < channelCount; channel++) {
+        steps[channel] = (endGains[channel] - startGains[channel]) / numFrames;
+    }
+
+    auto numSamples = numFrames * channelCount;
+    int32_t i = 0;
+
+#ifdef MIX_KERNEL_SIMD
+    // Lanes hold consecutive interleaved samples, so lane l belongs to channel l % channelCount and
+    // frame l / channelCount. Each iteration moves every lane forward by the same number of frames.
+    constexpr int32_t framesPerVector = kVectorWidth / channelCount;
+    float laneGains[kVectorWidth];
+    float laneSteps[kVectorWidth];
+
+    for (int32_t lane = 0; lane < kVectorWidth; lane++) {
+        auto channel = lane % channelCount;
+
+        laneGains[lane] = startGains[channel] + steps[channel] * (lane / channelCount);
+        laneSteps[lane] = steps[channel] * framesPerVector;
+    }
+
+    auto gain = load(laneGains);
+    auto gainStep = load(laneSteps);
+
+    if constexpr (isMetered) {
+        auto peak = zero();
+        auto sumSquare = zero();
+
+        for (; i + kVectorWidth <= numSamples; i += kVectorWidth) {
+            auto sample = multiply(load(input + i), gain);
+
+            store(output + i, add(load(output + i), sample));
+            peak = maximum(peak, absolute(sample));
+            sumSquare = multiplyAdd(sumSquare, sample, sample);
+            gain = add(gain, gainStep);
+        }
+
+        addLanes(*levels, channelCount, peak, sumSquare);
+    } else {
+        for (; i + kVectorWidth <= numSamples; i += kVectorWidth) {
+            store(output + i, multiplyAdd(load(output + i), load(input + i), gain));
+            gain = add(gain, gainStep);
+        }
+    }
+#endif
+
+    for (; i < numSamples; i++) {
+        auto channel = i % channelCount;
+        auto frame = i / channelCount;
+        auto sample = input[i] * (startGains[channel] + steps[channel] * frame);
+
+        output[i] += sample;
+        if constexpr (isMetered) levels->addSample(channel, sample);
+    }
+}
+
+// Picks the specialisation for the channel count. Meters the track into levels if it isn't null.
+inline void mixTrack(float* output, const float* input, int32_t numFrames, int32_t channelCount,
+                     const float* startGains, const float* endGains, Levels* levels = nullptr) {
+    if (channelCount == 1) {
+        if (levels != nullptr) {
+            mix<1, true>(output, input, numFrames, startGains, endGains, levels);
+        } else {
+            mix<1>(output, input, numFrames, startGains, endGains);
+        }
+    } else if (channelCount == 2) {
+        if (levels != nullptr) {
+            mix<2, true>(output, input, numFrames, startGains, endGains, levels);
+        } else {
+            mix<2>(output, input, numFrames, startGains, endGains);
+        }
+    } else {
+        mixScalar(output, input, numFrames, channelCount, startGains, endGains, levels);
+    }
+}
+
+// Like mixScalar, but each channel of the input is its own buffer. The output is still interleaved.
+inline void mixPlanarScalar(float* output, const float* const* inputs, int32_t numFrames, int32_t channelCount,
+                            const float* startGains, const float* endGains, Levels* levels = nullptr) {
+    if (numFrames <= 0) return;
+
+    for (int32_t channel = 0; channel < channelCount; channel++) {
+        auto input = inputs[channel];
+        auto gain = startGains[channel];
+        auto step = (endGains[channel] - gain) / numFrames;
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            auto sample = input[frame] * (gain + step * frame);
+
+            output[frame * channelCount + channel] += sample;
+            if (levels != nullptr) levels->addSample(channel, sample);
+        }
+    }
+}
+
+// Mixes planar stereo into interleaved output, interleaving in registers so each input sample is
+// read once and never copied to an interleaved buffer first.
+template <bool isMetered = false>
+inline void mixPlanarStereo(float* output, const float* left, const float* right, int32_t numFrames,
+                            const float* startGains, const float* endGains, Levels* levels = nullptr) {
+    if (numFrames <= 0) return;
+
+    auto leftStep = (endGains[0] - startGains[0]) / numFrames;
+    auto rightStep = (endGains[1] - startGains[1]) / numFrames;
+    int32_t frame = 0;
+
+#ifdef MIX_KERNEL_SIMD
+    // Every lane is its own frame of one channel
+    float laneLeftGains[kVectorWidth];
+    float laneRightGains[kVectorWidth];
+    float laneLeftSteps[kVectorWidth];
+    float laneRightSteps[kVectorWidth];
+
+    for (int32_t lane = 0; lane < kVectorWidth; lane++) {
+        laneLeftGains[lane] = startGains[0] + leftStep * lane;
+        laneRightGains[lane] = startGains[1] + rightStep * lane;
+        laneLeftSteps[lane] = leftStep * kVectorWidth;
+        laneRightSteps[lane] = rightStep * kVectorWidth;
+    }
+
+    auto leftGain = load(laneLeftGains);
+    auto rightGain = load(laneRightGains);
+    auto leftGainStep = load(laneLeftSteps);
+    auto rightGainStep = load(laneRightSteps);
+    auto leftPeak = zero();
+    auto rightPeak = zero();
+    auto leftSumSquare = zero();
+    auto rightSumSquare = zero();
+
+    for (; frame + kVectorWidth <= numFrames; frame += kVectorWidth) {
+        auto leftSample = multiply(load(left + frame), leftGain);
+        auto rightSample = multiply(load(right + frame), rightGain);
+        Vector low, high;
+        interleave(leftSample, rightSample, low, high);
+
+        auto out = output + frame * 2;
+        store(out, add(load(out), low));
+        store(out + kVectorWidth, add(load(out + kVectorWidth), high));
+
+        if constexpr (isMetered) {
+            leftPeak = maximum(leftPeak, absolute(leftSample));
+            rightPeak = maximum(rightPeak, absolute(rightSample));
+            leftSumSquare = multiplyAdd(leftSumSquare, leftSample, leftSample);
+            rightSumSquare = multiplyAdd(rightSumSquare, rightSample, rightSample);
+        }
+
+        leftGain = add(leftGain, leftGainStep);
+        rightGain = add(rightGain, rightGainStep);
+    }
+
+    if constexpr (isMetered) {
+        addChannelLanes(*levels, 0, leftPeak, leftSumSquare);
+        addChannelLanes(*levels, 1, rightPeak, rightSumSquare);
+    }
+#endif
+
+    for (; frame < numFrames; frame++) {
+        auto leftSample = left[frame] * (startGains[0] + leftStep * frame);
+        auto rightSample = right[frame] * (startGains[1] + rightStep * frame);
+
+        output[frame * 2] += leftSample;
+        output[frame * 2 + 1] += rightSample;
+        if constexpr (isMetered) {
+            levels->addSample(0, leftSample);
+            levels->addSample(1, rightSample);
+        }
+    }
+}
+
+// Picks the specialisation for a planar track. A mono track is laid out the same either way.
+inline void mixPlanarTrack(float* output, const float* const* inputs, int32_t numFrames, int32_t channelCount,
+                           const float* startGains, const float* endGains, Levels* levels = nullptr) {
+    if (channelCount == 1) {
+        mixTrack(output, inputs[0], numFrames, 1, startGains, endGains, levels);
+    } else if (channelCount == 2) {
+        if (levels != nullptr) {
+            mixPlanarStereo<true>(output, inputs[0], inputs[1], numFrames, startGains, endGains, levels);
+        } else {
+            mixPlanarStereo(output, inputs[0], inputs[1], numFrames, startGains, endGains);
+        }
+    } else {
+        mixPlanarScalar(output, inputs, numFrames, channelCount, startGains, endGains, levels);
+    }
+}
+
+// Adds the levels of interleaved samples to levels.
+inline void measure(const float* samples, int32_t numFrames, int32_t channelCount, Levels& levels) {
+    if (numFrames <= 0) return;
+
+    auto numSamples = numFrames * channelCount;
+    int32_t i = 0;
+
+#ifdef MIX_KERNEL_SIMD
+    // Lanes only map to fixed channels when the channel count divides the vector width
+    if (kVectorWidth % channelCount == 0) {
+        auto peak = zero();
+        auto sumSquare = zero();
+
+        for (; i + kVectorWidth <= numSamples; i += kVectorWidth) {
+            auto sample = load(samples + i);
+
+            peak = maximum(peak, absolute(sample));
+            sumSquare = multiplyAdd(sumSquare, sample, sample);
+        }
+
+        addLanes(levels, channelCount, peak, sumSquare);
+    }
+#endif
+
+    for (; i < numSamples; i++) {
+        levels.addSample(i % channelCount, samples[i]);
+    }
+}
+
+}
+
+#endif //MIX_KERNEL_H
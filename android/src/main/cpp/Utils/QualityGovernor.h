@@ -0,0 +1,108 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Decides how much render quality to give up so callbacks keep meeting their deadline. Each
+ * callback reports how long it took against its period. Sustained load over kStepDownLoad, or a
+ * single missed deadline, steps down one tier; load under kStepUpLoad for kRecoverSeconds steps
+ * back up one tier. The gap between the two thresholds, and the time it takes to recover, keep the
+ * tier from flapping when the load sits near one of them.
+ *
+ * update() is for the audio thread only. The enabled flag and the current tier can be read and set
+ * from any thread.
+ */
+class QualityGovernor {
+public:
+    static constexpr int32_t kMaxTier = 3;
+    static constexpr float kStepDownLoad = 0.85f;
+    static constexpr float kStepUpLoad = 0.5f;
+    static constexpr int32_t kStepDownCallbacks = 3;
+    // After a step down, give the cheaper tier this long to take effect before stepping again
+    static constexpr float kSettleSeconds = 0.25f;
+    static constexpr float kRecoverSeconds = 2.0f;
+
+    // Returns true if the tier changed. numFrames and sampleRate give the callback's period.
+    bool update(uint64_t callbackNs, uint32_t numFrames, int32_t sampleRate) {
+        if (numFrames == 0 || sampleRate <= 0) return false;
+
+        auto tier = mTier.load(std::memory_order_relaxed);
+
+        if (!mIsEnabled.load(std::memory_order_relaxed)) {
+            resetCounters();
+            if (tier == 0) return false;
+
+            mTier.store(0, std::memory_order_relaxed);
+            return true;
+        }
+
+        auto periodNs = numFrames * 1000000000ull / sampleRate;
+        auto load = static_cast<float>(callbackNs) / periodNs;
+
+        mSettleFrames = mSettleFrames > numFrames ? mSettleFrames - numFrames : 0;
+
+        if (load > kStepDownLoad) {
+            mOverloadCount++;
+            mHeadroomFrames = 0;
+
+            auto isOverloaded = load > 1.0f || mOverloadCount >= kStepDownCallbacks;
+            if (isOverloaded && tier < kMaxTier && mSettleFrames == 0) {
+                mOverloadCount = 0;
+                mSettleFrames = static_cast<uint32_t>(kSettleSeconds * sampleRate);
+                mTier.store(tier + 1, std::memory_order_relaxed);
+                return true;
+            }
+
+            return false;
+        }
+
+        mOverloadCount = 0;
+
+        if (load < kStepUpLoad) {
+            mHeadroomFrames += numFrames;
+
+            if (tier > 0 && mHeadroomFrames >= kRecoverSeconds * sampleRate) {
+                mHeadroomFrames = 0;
+                mTier.store(tier - 1, std::memory_order_relaxed);
+                return true;
+            }
+        } else {
+            // Load between the thresholds holds the tier where it is
+            mHeadroomFrames = 0;
+        }
+
+        return false;
+    }
+
+    // 0 is full quality, kMaxTier the cheapest.
+    int32_t getTier() const {
+        return mTier.load(std::memory_order_relaxed);
+    }
+
+    // Turning it off goes back to full quality on the next update().
+    void setEnabled(bool isEnabled) {
+        mIsEnabled.store(isEnabled, std::memory_order_relaxed);
+    }
+
+    bool getIsEnabled() const {
+        return mIsEnabled.load(std::memory_order_relaxed);
+    }
+
+private:
+    void resetCounters() {
+        mOverloadCount = 0;
+        mHeadroomFrames = 0;
+        mSettleFrames = 0;
+    }
+
+    std::atomic<bool> mIsEnabled { true };
+    std::atomic<int32_t> mTier { 0 };
+    int32_t mOverloadCount = 0;
+    uint64_t mHeadroomFrames = 0;
+    uint32_t mSettleFrames = 0;
+};
+
+#endif //QUALITY_GOVERNOR_H
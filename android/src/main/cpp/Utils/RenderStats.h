@@ -0,0 +1,324 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+using RenderClock = std::chrono::steady_clock;
+
+inline uint64_t elapsedNs(RenderClock::time_point start, RenderClock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// Plain struct so it can be filled in through the C API.
+struct RenderTimingStats {
+    uint64_t count;
+    uint64_t deadlineMisses;
+    uint32_t meanUs;
+    uint32_t p50Us;
+    uint32_t p99Us;
+    uint32_t maxUs;
+    float meanBudgetUtilisation; // Fraction of the callback period spent, on average
+    float maxBudgetUtilisation;
+};
+
+/**
+ * Histogram of render durations with four buckets per power of two microseconds, so percentiles
+ * are accurate to within 25%. Only the audio thread may call record() and reset(); any thread may
+ * call summarize(). Every counter is atomic, so there are no locks, but a summary taken while the
+ * audio thread is writing may mix values from two consecutive callbacks.
+ */
+class RenderTimingHistogram {
+public:
+    static constexpr int kSubBuckets = 4;
+    static constexpr int kBucketCount = 22 * kSubBuckets; // Up to ~4 seconds
+
+    void record(uint64_t durationNs, uint64_t budgetNs) {
+        auto durationUs = durationNs / 1000;
+
+        increment(mBuckets[bucketIndex(durationUs)]);
+        increment(mCount);
+        add(mTotalNs, durationNs);
+        add(mTotalBudgetNs, budgetNs);
+
+        if (durationUs > mMaxUs.load(std::memory_order_relaxed)) {
+            mMaxUs.store(static_cast<uint32_t>(durationUs), std::memory_order_relaxed);
+        }
+
+        if (budgetNs > 0) {
+            auto utilisationPermille = static_cast<uint32_t>(durationNs * 1000 / budgetNs);
+
+            if (utilisationPermille > mMaxUtilisationPermille.load(std::memory_order_relaxed)) {
+                mMaxUtilisationPermille.store(utilisationPermille, std::memory_order_relaxed);
+            }
+
+            if (durationNs > budgetNs) {
+                increment(mDeadlineMisses);
+            }
+        }
+    }
+
+    void reset() {
+        for (auto& bucket : mBuckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        mCount.store(0, std::memory_order_relaxed);
+        mDeadlineMisses.store(0, std::memory_order_relaxed);
+        mTotalNs.store(0, std::memory_order_relaxed);
+        mTotalBudgetNs.store(0, std::memory_order_relaxed);
+        mMaxUs.store(0, std::memory_order_relaxed);
+        mMaxUtilisationPermille.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t getCount() const {
+        return mCount.load(std::memory_order_relaxed);
+    }
+
+    RenderTimingStats summarize() const {
+        RenderTimingStats stats = {};
+        std::array<uint64_t, kBucketCount> buckets;
+        uint64_t bucketsTotal = 0;
+
+        for (int i = 0; i < kBucketCount; i++) {
+            buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+            bucketsTotal += buckets[i];
+        }
+
+        stats.count = mCount.load(std::memory_order_relaxed);
+        stats.deadlineMisses = mDeadlineMisses.load(std::memory_order_relaxed);
+        stats.maxUs = mMaxUs.load(std::memory_order_relaxed);
+        stats.maxBudgetUtilisation = mMaxUtilisationPermille.load(std::memory_order_relaxed) / 1000.0f;
+
+        if (stats.count > 0) {
+            auto totalNs = mTotalNs.load(std::memory_order_relaxed);
+            auto totalBudgetNs = mTotalBudgetNs.load(std::memory_order_relaxed);
+
+            stats.meanUs = static_cast<uint32_t>(totalNs / stats.count / 1000);
+            stats.meanBudgetUtilisation = totalBudgetNs > 0 ? static_cast<float>(totalNs) / totalBudgetNs : 0.0f;
+        }
+
+        stats.p50Us = percentile(buckets, bucketsTotal, 0.5, stats.maxUs);
+        stats.p99Us = percentile(buckets, bucketsTotal, 0.99, stats.maxUs);
+
+        return stats;
+    }
+
+    static int bucketIndex(uint64_t durationUs) {
+        if (durationUs < kSubBuckets) return static_cast<int>(durationUs);
+
+        int msb = 63 - __builtin_clzll(durationUs);
+        int subBucket = static_cast<int>((durationUs >> (msb - 2)) & (kSubBuckets - 1));
+        int index = (msb - 1) * kSubBuckets + subBucket;
+
+        return index < kBucketCount ? index : kBucketCount - 1;
+    }
+
+    // Smallest duration that falls into the bucket
+    static uint64_t bucketLowerBoundUs(int index) {
+        if (index < kSubBuckets) return index;
+
+        int msb = index / kSubBuckets + 1;
+        int subBucket = index % kSubBuckets;
+
+        return static_cast<uint64_t>(kSubBuckets + subBucket) << (msb - 2);
+    }
+
+private:
+    // Only the audio thread writes, so a plain load and store is enough and avoids a locked
+    // read-modify-write on every callback.
+    template <typename T>
+    static void increment(std::atomic<T>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    static void add(std::atomic<T>& counter, T value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // Reports the upper bound of the bucket containing the percentile, clamped to the max seen.
+    static uint32_t percentile(const std::array<uint64_t, kBucketCount>& buckets, uint64_t total, double p, uint32_t maxUs) {
+        if (total == 0) return 0;
+
+        // Nearest-rank: the smallest bucket covering at least p of the samples
+        auto threshold = static_cast<uint64_t>(std::ceil(p * total));
+        uint64_t cumulative = 0;
+
+        for (int i = 0; i < kBucketCount; i++) {
+            cumulative += buckets[i];
+
+            if (cumulative >= threshold) {
+                auto upperBoundUs = i + 1 < kBucketCount ? bucketLowerBoundUs(i + 1) - 1 : maxUs;
+                return static_cast<uint32_t>(upperBoundUs < maxUs ? upperBoundUs : maxUs);
+            }
+        }
+
+        return maxUs;
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> mBuckets = {};
+    std::atomic<uint64_t> mCount { 0 };
+    std::atomic<uint64_t> mDeadlineMisses { 0 };
+    std::atomic<uint64_t> mTotalNs { 0 };
+    std::atomic<uint64_t> mTotalBudgetNs { 0 };
+    std::atomic<uint32_t> mMaxUs { 0 };
+    std::atomic<uint32_t> mMaxUtilisationPermille { 0 };
+};
+
+// How many sub-blocks the Mixer split each callback into.
+struct SubBlockStats {
+    uint32_t lastCount;
+    uint32_t maxCount;
+    float meanCount;
+};
+
+// How many track sub-blocks the Mixer rendered, and how many it skipped because the track's
+// instrument was idle.
+struct SkipStats {
+    uint64_t renderedCount;
+    uint64_t skippedCount;
+    uint32_t lastSkippedCount; // In the last callback
+};
+
+struct TrackRenderStats {
+    RenderTimingStats handleFrames; // Scheduling plus instrument rendering
+    RenderTimingStats instrument; // IInstrument::renderAudio only, if instrument timing is enabled
+};
+
+/**
+ * Render timing for a whole engine: one histogram for the audio callback, and two per track.
+ * A reset requested from another thread, of everything or of one track, is carried out by the audio
+ * thread at the start of its next callback, so the histograms keep a single writer.
+ *
+ * Timing each instrument render separately takes two clock reads per event, which adds up with
+ * dense sequences, so it is off by default.
+ */
+template <int maxTracks>
+class RenderStats {
+public:
+    bool getIsInstrumentTimingEnabled() const {
+        return mIsInstrumentTimingEnabled.load(std::memory_order_relaxed);
+    }
+
+    void setIsInstrumentTimingEnabled(bool isEnabled) {
+        mIsInstrumentTimingEnabled.store(isEnabled, std::memory_order_relaxed);
+    }
+
+    void requestReset() {
+        mIsResetRequested.store(true, std::memory_order_release);
+    }
+
+    // Called when a track is added, before it is rendered for the first time.
+    void requestTrackReset(int32_t trackIndex) {
+        if (trackIndex < 0 || trackIndex >= maxTracks) return;
+
+        mIsTrackResetRequested[trackIndex].store(true, std::memory_order_relaxed);
+        mIsAnyTrackResetRequested.store(true, std::memory_order_release);
+    }
+
+    // Audio thread only, at the start of a callback, before anything is recorded.
+    void handleResetRequest() {
+        if (mIsAnyTrackResetRequested.exchange(false, std::memory_order_acquire)) {
+            for (int i = 0; i < maxTracks; i++) {
+                if (!mIsTrackResetRequested[i].exchange(false, std::memory_order_relaxed)) continue;
+
+                mTrackHandleFrames[i].reset();
+                mTrackInstrument[i].reset();
+            }
+        }
+
+        if (!mIsResetRequested.load(std::memory_order_acquire)) return;
+
+        mCallback.reset();
+        mSubBlockTotal.store(0, std::memory_order_relaxed);
+        mSubBlockMax.store(0, std::memory_order_relaxed);
+        mRenderedCount.store(0, std::memory_order_relaxed);
+        mSkippedCount.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < maxTracks; i++) {
+            mTrackHandleFrames[i].reset();
+            mTrackInstrument[i].reset();
+        }
+
+        mIsResetRequested.store(false, std::memory_order_release);
+    }
+
+    void recordCallback(uint64_t durationNs, uint64_t budgetNs, uint32_t subBlockCount) {
+        mCallback.record(durationNs, budgetNs);
+
+        // Single writer, see RenderTimingHistogram
+        mSubBlockLast.store(subBlockCount, std::memory_order_relaxed);
+        mSubBlockTotal.store(mSubBlockTotal.load(std::memory_order_relaxed) + subBlockCount, std::memory_order_relaxed);
+        if (subBlockCount > mSubBlockMax.load(std::memory_order_relaxed)) {
+            mSubBlockMax.store(subBlockCount, std::memory_order_relaxed);
+        }
+    }
+
+    // Audio thread only, once per callback.
+    void recordSkips(uint32_t renderedCount, uint32_t skippedCount) {
+        // Single writer, see RenderTimingHistogram
+        mRenderedCount.store(mRenderedCount.load(std::memory_order_relaxed) + renderedCount, std::memory_order_relaxed);
+        mSkippedCount.store(mSkippedCount.load(std::memory_order_relaxed) + skippedCount, std::memory_order_relaxed);
+        mLastSkippedCount.store(skippedCount, std::memory_order_relaxed);
+    }
+
+    void recordTrack(int32_t trackIndex, uint64_t handleFramesNs, uint64_t instrumentNs, uint64_t budgetNs) {
+        if (trackIndex < 0 || trackIndex >= maxTracks) return;
+
+        mTrackHandleFrames[trackIndex].record(handleFramesNs, budgetNs);
+        mTrackInstrument[trackIndex].record(instrumentNs, budgetNs);
+    }
+
+    RenderTimingStats getCallbackStats() const {
+        return mCallback.summarize();
+    }
+
+    SubBlockStats getSubBlockStats() const {
+        SubBlockStats stats = {};
+        auto callbackCount = mCallback.getCount();
+
+        stats.lastCount = mSubBlockLast.load(std::memory_order_relaxed);
+        stats.maxCount = mSubBlockMax.load(std::memory_order_relaxed);
+        if (callbackCount > 0) {
+            stats.meanCount = static_cast<float>(mSubBlockTotal.load(std::memory_order_relaxed)) / callbackCount;
+        }
+
+        return stats;
+    }
+
+    SkipStats getSkipStats() const {
+        SkipStats stats = {};
+
+        stats.renderedCount = mRenderedCount.load(std::memory_order_relaxed);
+        stats.skippedCount = mSkippedCount.load(std::memory_order_relaxed);
+        stats.lastSkippedCount = mLastSkippedCount.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    bool getTrackStats(int32_t trackIndex, TrackRenderStats& stats) const {
+        if (trackIndex < 0 || trackIndex >= maxTracks) return false;
+
+        stats.handleFrames = mTrackHandleFrames[trackIndex].summarize();
+        stats.instrument = mTrackInstrument[trackIndex].summarize();
+        return true;
+    }
+
+private:
+    std::atomic<bool> mIsResetRequested { false };
+    std::atomic<bool> mIsAnyTrackResetRequested { false };
+    std::array<std::atomic<bool>, maxTracks> mIsTrackResetRequested = {};
+    std::atomic<bool> mIsInstrumentTimingEnabled { false };
+    RenderTimingHistogram mCallback;
+    std::atomic<uint64_t> mSubBlockTotal { 0 };
+    std::atomic<uint32_t> mSubBlockLast { 0 };
+    std::atomic<uint32_t> mSubBlockMax { 0 };
+    std::atomic<uint64_t> mRenderedCount { 0 };
+    std::atomic<uint64_t> mSkippedCount { 0 };
+    std::atomic<uint32_t> mLastSkippedCount { 0 };
+    std::array<RenderTimingHistogram, maxTracks> mTrackHandleFrames;
+    std::array<RenderTimingHistogram, maxTracks> mTrackInstrument;
+};
+
+#endif //RENDER_STATS_H
@@ -0,0 +1,143 @@
+#ifndef RENDER_THREAD_POOL_H
+#define RENDER_THREAD_POOL_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <semaphore.h>
+#include <thread>
+
+/**
+ * A fixed set of worker threads that help the audio thread run a batch of independent jobs.
+ *
+ * The audio thread publishes a batch by storing the job count and next job index in one atomic
+ * word, wakes the workers with sem_post, and then claims jobs itself alongside them. Claiming a job
+ * is a single compare-and-swap on that word, so nothing blocks and nothing allocates once the
+ * threads are running. run() returns when every job in the batch has finished, so callers can
+ * read the results without further synchronization.
+ *
+ * start() and stop() spawn and join threads, so they must be called from a non-realtime thread.
+ * They may race with run(): jobs that no worker claims are run by the calling thread.
+ */
+class RenderThreadPool {
+public:
+    using JobFunction = void (*)(void* context, int32_t jobIndex);
+
+    static constexpr int32_t kMaxWorkers = 8;
+
+    RenderThreadPool() {
+        for (auto& semaphore : mWakeSemaphores) {
+            sem_init(&semaphore, 0, 0);
+        }
+    }
+
+    ~RenderThreadPool() {
+        stop();
+
+        for (auto& semaphore : mWakeSemaphores) {
+            sem_destroy(&semaphore);
+        }
+    }
+
+    void start(int32_t workerCount) {
+        stop();
+
+        if (workerCount > kMaxWorkers) workerCount = kMaxWorkers;
+
+        mIsRunning.store(true, std::memory_order_release);
+
+        for (int32_t i = 0; i < workerCount; i++) {
+            mThreads[i] = std::thread([this, i]() { workerLoop(i); });
+        }
+
+        mWorkerCount.store(workerCount, std::memory_order_release);
+    }
+
+    void stop() {
+        auto workerCount = mWorkerCount.exchange(0, std::memory_order_acq_rel);
+        mIsRunning.store(false, std::memory_order_release);
+
+        for (int32_t i = 0; i < workerCount; i++) {
+            sem_post(&mWakeSemaphores[i]);
+        }
+
+        for (int32_t i = 0; i < workerCount; i++) {
+            mThreads[i].join();
+        }
+    }
+
+    int32_t getWorkerCount() {
+        return mWorkerCount.load(std::memory_order_acquire);
+    }
+
+    // Runs fn(context, i) for every i in [0, jobCount) and waits for all of them to finish.
+    void run(int32_t jobCount, JobFunction fn, void* context) {
+        if (jobCount <= 0) return;
+
+        mJobFunction = fn;
+        mJobContext = context;
+        mCompletedCount.store(0, std::memory_order_relaxed);
+        mCursor.store(packCursor(jobCount, 0), std::memory_order_release);
+
+        auto workerCount = mWorkerCount.load(std::memory_order_acquire);
+        auto workersToWake = jobCount - 1 < workerCount ? jobCount - 1 : workerCount;
+
+        for (int32_t i = 0; i < workersToWake; i++) {
+            sem_post(&mWakeSemaphores[i]);
+        }
+
+        runAvailableJobs();
+
+        while (mCompletedCount.load(std::memory_order_acquire) < jobCount) {
+            // Remaining jobs are already running on workers, so this is bounded by the longest one
+        }
+    }
+
+private:
+    static uint64_t packCursor(int32_t jobCount, int32_t nextJobIndex) {
+        return (static_cast<uint64_t>(jobCount) << 32) | static_cast<uint32_t>(nextJobIndex);
+    }
+
+    // Claims and runs jobs until the current batch has none left.
+    void runAvailableJobs() {
+        auto cursor = mCursor.load(std::memory_order_acquire);
+
+        while (true) {
+            auto jobCount = static_cast<int32_t>(cursor >> 32);
+            auto jobIndex = static_cast<int32_t>(cursor & 0xFFFFFFFF);
+
+            if (jobIndex >= jobCount) return;
+
+            // Count and index come from the same snapshot, so a successful exchange means the job
+            // belongs to the batch that is currently published.
+            if (mCursor.compare_exchange_weak(cursor, cursor + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                mJobFunction(mJobContext, jobIndex);
+                mCompletedCount.fetch_add(1, std::memory_order_release);
+                cursor = mCursor.load(std::memory_order_acquire);
+            }
+        }
+    }
+
+    void workerLoop(int32_t workerIndex) {
+        while (true) {
+            sem_wait(&mWakeSemaphores[workerIndex]);
+
+            if (!mIsRunning.load(std::memory_order_acquire)) return;
+
+            runAvailableJobs();
+        }
+    }
+
+    std::atomic<uint64_t> mCursor { 0 };
+    std::atomic<int32_t> mCompletedCount { 0 };
+    // Written before the cursor is published, read after a job is claimed
+    JobFunction mJobFunction = nullptr;
+    void* mJobContext = nullptr;
+
+    std::atomic<bool> mIsRunning { false };
+    std::atomic<int32_t> mWorkerCount { 0 };
+    std::array<std::thread, kMaxWorkers> mThreads;
+    std::array<sem_t, kMaxWorkers> mWakeSemaphores;
+};
+
+#endif //RENDER_THREAD_POOL_H
@@ -0,0 +1,202 @@
+#ifndef ROUTING_GRAPH_H
+#define ROUTING_GRAPH_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+constexpr int32_t kMaxBuses = 16;
+constexpr int32_t kMasterBus = -1;
+
+/**
+ * Where everything sends its output, in the order the audio thread mixes it. Buses are listed
+ * inputs first, grouped into stages: every bus a bus takes input from is in an earlier stage, so
+ * the buses of one stage don't depend on each other and can be mixed in any order, or in parallel.
+ */
+template <int32_t MAX_TRACKS>
+struct RoutingPlan {
+    int32_t busCount;
+    int32_t stageCount;
+    std::array<int32_t, kMaxBuses> busOrder;
+    // Stage s is busOrder[stageStarts[s]] up to busOrder[stageStarts[s + 1]]
+    std::array<int32_t, kMaxBuses + 1> stageStarts;
+    std::array<int32_t, kMaxBuses> busOutputs;
+    std::array<int32_t, MAX_TRACKS> trackOutputs; // By track slot
+};
+
+/**
+ * Routes tracks into buses, and buses into other buses or the master. Every change that's accepted
+ * works out the plan's order again and publishes it, so the audio thread only ever reads a plan
+ * that's ready to mix, and never allocates or sorts anything.
+ *
+ * The plan is double-buffered like a track loop: a change fills the bank the audio thread isn't
+ * using and then publishes it, waiting at most one render call if the audio thread is still
+ * reading the bank it wants. Changes must be made from a single non-realtime thread.
+ */
+template <int32_t MAX_TRACKS>
+class RoutingGraph {
+public:
+    using Plan = RoutingPlan<MAX_TRACKS>;
+
+    RoutingGraph() {
+        mBusOutputs.fill(kMasterBus);
+        mTrackOutputs.fill(kMasterBus);
+        publish();
+    }
+
+    // Returns the new bus, sending its output to the master, or -1 if every bus is taken.
+    int32_t addBus() {
+        for (int32_t bus = 0; bus < kMaxBuses; bus++) {
+            if (mIsBusLive[bus]) continue;
+
+            mIsBusLive[bus] = true;
+            mBusOutputs[bus] = kMasterBus;
+            publish();
+            return bus;
+        }
+
+        return -1;
+    }
+
+    // Whatever was sent to the bus is sent on to where the bus was sending its output.
+    void removeBus(int32_t bus) {
+        if (!isBusLive(bus)) return;
+
+        auto output = mBusOutputs[bus];
+
+        for (auto& trackOutput : mTrackOutputs) {
+            if (trackOutput == bus) trackOutput = output;
+        }
+        for (int32_t input = 0; input < kMaxBuses; input++) {
+            if (mIsBusLive[input] && mBusOutputs[input] == bus) mBusOutputs[input] = output;
+        }
+
+        mIsBusLive[bus] = false;
+        publish();
+    }
+
+    bool isBusLive(int32_t bus) const {
+        return bus >= 0 && bus < kMaxBuses && mIsBusLive[bus];
+    }
+
+    // Returns false, changing nothing, if output isn't a live bus or kMasterBus, or if the bus
+    // would end up taking its own output as input.
+    bool setBusOutput(int32_t bus, int32_t output) {
+        if (!isBusLive(bus) || !isValidOutput(output)) return false;
+
+        for (auto next = output; next != kMasterBus; next = mBusOutputs[next]) {
+            if (next == bus) return false;
+        }
+
+        if (mBusOutputs[bus] != output) {
+            mBusOutputs[bus] = output;
+            publish();
+        }
+
+        return true;
+    }
+
+    int32_t getBusOutput(int32_t bus) const {
+        return isBusLive(bus) ? mBusOutputs[bus] : kMasterBus;
+    }
+
+    // Returns false, changing nothing, if output isn't a live bus or kMasterBus.
+    bool setTrackOutput(int32_t slot, int32_t output) {
+        if (slot < 0 || slot >= MAX_TRACKS || !isValidOutput(output)) return false;
+
+        if (mTrackOutputs[slot] != output) {
+            mTrackOutputs[slot] = output;
+            publish();
+        }
+
+        return true;
+    }
+
+    int32_t getTrackOutput(int32_t slot) const {
+        return slot >= 0 && slot < MAX_TRACKS ? mTrackOutputs[slot] : kMasterBus;
+    }
+
+    // Audio thread only. Must be followed by release() once the render call is done with the plan.
+    const Plan* acquire() {
+        while (true) {
+            auto bank = mActiveBank.load(std::memory_order_acquire);
+
+            mReadingBank.store(bank, std::memory_order_seq_cst);
+
+            // Re-check, in case publish() started overwriting the bank before it saw mReadingBank
+            if (mActiveBank.load(std::memory_order_seq_cst) == bank) {
+                return &mBanks[bank];
+            }
+        }
+    }
+
+    void release() {
+        mReadingBank.store(-1, std::memory_order_release);
+    }
+
+private:
+    bool isValidOutput(int32_t output) const {
+        return output == kMasterBus || isBusLive(output);
+    }
+
+    // Orders the buses into stages, each bus one stage after the latest of its inputs, and
+    // publishes the result.
+    void publish() {
+        auto bank = 1 - mActiveBank.load(std::memory_order_relaxed);
+
+        while (mReadingBank.load(std::memory_order_seq_cst) == bank) {
+            std::this_thread::yield();
+        }
+
+        auto& plan = mBanks[bank];
+        std::array<int32_t, kMaxBuses> stages;
+        stages.fill(0);
+        int32_t stageCount = 0;
+
+        // Outputs never form a cycle, so no chain is longer than kMaxBuses and each bus pushes its
+        // stage down its chain of outputs
+        for (int32_t bus = 0; bus < kMaxBuses; bus++) {
+            if (!mIsBusLive[bus]) continue;
+
+            auto stage = stages[bus];
+            for (auto output = mBusOutputs[bus]; output != kMasterBus; output = mBusOutputs[output]) {
+                stage++;
+                stages[output] = std::max(stages[output], stage);
+                stage = stages[output];
+            }
+        }
+
+        plan.busCount = 0;
+        for (int32_t bus = 0; bus < kMaxBuses; bus++) {
+            if (mIsBusLive[bus]) stageCount = std::max(stageCount, stages[bus] + 1);
+        }
+
+        for (int32_t stage = 0; stage < stageCount; stage++) {
+            plan.stageStarts[stage] = plan.busCount;
+
+            for (int32_t bus = 0; bus < kMaxBuses; bus++) {
+                if (mIsBusLive[bus] && stages[bus] == stage) plan.busOrder[plan.busCount++] = bus;
+            }
+        }
+
+        plan.stageStarts[stageCount] = plan.busCount;
+        plan.stageCount = stageCount;
+        plan.busOutputs = mBusOutputs;
+        plan.trackOutputs = mTrackOutputs;
+
+        mActiveBank.store(bank, std::memory_order_seq_cst);
+    }
+
+    // The graph as the control thread last changed it
+    std::array<bool, kMaxBuses> mIsBusLive = {};
+    std::array<int32_t, kMaxBuses> mBusOutputs;
+    std::array<int32_t, MAX_TRACKS> mTrackOutputs;
+
+    std::array<Plan, 2> mBanks;
+    std::atomic<int32_t> mActiveBank { 1 }; // The constructor publishes bank 0
+    std::atomic<int32_t> mReadingBank { -1 };
+};
+
+#endif //ROUTING_GRAPH_H
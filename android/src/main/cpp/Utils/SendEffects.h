@@ -0,0 +1,359 @@
+#ifndef SEND_EFFECTS_H
+#define SEND_EFFECTS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// The shared effects tracks can send to. Keep lib/models/events.dart in sync with this.
+enum SendBus {
+    SEND_REVERB = 0,
+    SEND_DELAY = 1,
+    SEND_EQ = 2,
+};
+
+constexpr int32_t kSendBusCount = 3;
+
+/**
+ * An effect that a send bus runs once over everything sent to it, so tracks share one instance
+ * instead of each running their own. Effects are stereo: mono input is used for both sides, and
+ * channels past the second are left silent.
+ *
+ * Parameters can be set from any thread and are picked up at the start of the next process().
+ */
+class SendEffect {
+public:
+    virtual ~SendEffect() = default;
+
+    // Allocates everything the effect needs at this sample rate. Not for the audio thread.
+    void prepare(int32_t sampleRate) {
+        if (sampleRate <= 0 || sampleRate == mSampleRate) return;
+
+        mSampleRate = sampleRate;
+        allocate();
+        reset();
+        mAppliedParamsVersion = 0;
+    }
+
+    bool isPrepared() const { return mSampleRate > 0; }
+
+    // Audio thread only. Replaces the interleaved input with the effect's output, in place.
+    void process(float* data, int32_t numFrames, int32_t channelCount) {
+        auto paramsVersion = mParamsVersion.load(std::memory_order_acquire);
+        if (paramsVersion != mAppliedParamsVersion) {
+            applyParams();
+            mAppliedParamsVersion = paramsVersion;
+        }
+
+        processFrames(data, numFrames, channelCount);
+
+        for (int32_t channel = 2; channel < channelCount; channel++) {
+            for (int32_t frame = 0; frame < numFrames; frame++) {
+                data[frame * channelCount + channel] = 0.0f;
+            }
+        }
+    }
+
+    // Audio thread only. Clears the effect's tail, e.g. once it has decayed into silence.
+    virtual void reset() = 0;
+
+protected:
+    virtual void allocate() = 0;
+    virtual void applyParams() = 0;
+    virtual void processFrames(float* data, int32_t numFrames, int32_t channelCount) = 0;
+
+    void onParamsChanged() { mParamsVersion.fetch_add(1, std::memory_order_release); }
+
+    int32_t mSampleRate = 0;
+
+private:
+    std::atomic<uint32_t> mParamsVersion { 1 };
+    uint32_t mAppliedParamsVersion = 0;
+};
+
+/**
+ * An algorithmic reverb: a feedback delay network of four lines, mixed through a Hadamard matrix
+ * and damped by a one-pole lowpass in each line's feedback. Each step works on all four lines
+ * lane by lane, so the matrix and the filters vectorize. Two allpasses diffuse the input first so
+ * the onset isn't a row of distinct echoes.
+ */
+class ReverbEffect : public SendEffect {
+public:
+    // roomSize from 0 to 1 sets the decay time, damping from 0 to 1 how fast highs decay.
+    void setParams(float roomSize, float damping) {
+        mRoomSize.store(std::min(std::max(roomSize, 0.0f), 1.0f), std::memory_order_relaxed);
+        mDamping.store(std::min(std::max(damping, 0.0f), 1.0f), std::memory_order_relaxed);
+        onParamsChanged();
+    }
+
+    void reset() override {
+        for (auto& line : mLines) std::fill(line.begin(), line.end(), 0.0f);
+        for (auto& diffuser : mDiffusers) std::fill(diffuser.begin(), diffuser.end(), 0.0f);
+        mLowpass = {};
+    }
+
+private:
+    static constexpr int32_t kLines = 4;
+    static constexpr int32_t kDiffusers = 2;
+    static constexpr float kDiffuserGain = 0.6f;
+    // Mutually prime-ish lengths, so the lines' echoes don't pile up on each other
+    static constexpr std::array<float, kLines> kLineSeconds = { 0.0297f, 0.0371f, 0.0411f, 0.0437f };
+    static constexpr std::array<float, kDiffusers> kDiffuserSeconds = { 0.0050f, 0.0017f };
+
+    void allocate() override {
+        for (int32_t i = 0; i < kLines; i++) {
+            mLines[i].assign(std::max(static_cast<int32_t>(kLineSeconds[i] * mSampleRate), 1), 0.0f);
+            mLinePositions[i] = 0;
+        }
+
+        for (int32_t i = 0; i < kDiffusers; i++) {
+            mDiffusers[i].assign(std::max(static_cast<int32_t>(kDiffuserSeconds[i] * mSampleRate), 1), 0.0f);
+            mDiffuserPositions[i] = 0;
+        }
+    }
+
+    // Each line's feedback gain is set so every line decays by 60dB over the same time
+    void applyParams() override {
+        auto decaySeconds = 0.3f + mRoomSize.load(std::memory_order_relaxed) * 4.7f;
+
+        for (int32_t i = 0; i < kLines; i++) {
+            auto lineSeconds = static_cast<float>(mLines[i].size()) / mSampleRate;
+            mFeedback[i] = std::pow(10.0f, -3.0f * lineSeconds / decaySeconds);
+        }
+
+        mDampingCoefficient = mDamping.load(std::memory_order_relaxed) * 0.7f;
+    }
+
+    void processFrames(float* data, int32_t numFrames, int32_t channelCount) override {
+        auto rightChannel = std::min(channelCount - 1, 1);
+        auto damping = mDampingCoefficient;
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            auto sample = data + frame * channelCount;
+            auto input = (sample[0] + sample[rightChannel]) * 0.5f;
+
+            for (int32_t i = 0; i < kDiffusers; i++) {
+                auto& diffuser = mDiffusers[i];
+                auto& position = mDiffuserPositions[i];
+                auto delayed = diffuser[position];
+                auto toDelay = input + delayed * kDiffuserGain;
+
+                input = delayed - toDelay * kDiffuserGain;
+                diffuser[position] = toDelay;
+                if (++position == static_cast<int32_t>(diffuser.size())) position = 0;
+            }
+
+            std::array<float, kLines> outputs;
+            for (int32_t i = 0; i < kLines; i++) {
+                outputs[i] = mLines[i][mLinePositions[i]];
+            }
+
+            // Hadamard mixing keeps the network lossless, so only the feedback gains set the decay
+            std::array<float, kLines> mixed = {
+                (outputs[0] + outputs[1] + outputs[2] + outputs[3]) * 0.5f,
+                (outputs[0] - outputs[1] + outputs[2] - outputs[3]) * 0.5f,
+                (outputs[0] + outputs[1] - outputs[2] - outputs[3]) * 0.5f,
+                (outputs[0] - outputs[1] - outputs[2] + outputs[3]) * 0.5f,
+            };
+
+            for (int32_t i = 0; i < kLines; i++) {
+                mLowpass[i] = mixed[i] * (1.0f - damping) + mLowpass[i] * damping;
+                mLines[i][mLinePositions[i]] = input + mLowpass[i] * mFeedback[i];
+                if (++mLinePositions[i] == static_cast<int32_t>(mLines[i].size())) mLinePositions[i] = 0;
+            }
+
+            if (channelCount == 1) {
+                sample[0] = (outputs[0] + outputs[1] + outputs[2] + outputs[3]) * 0.25f;
+            } else {
+                sample[0] = (outputs[0] + outputs[2]) * 0.5f;
+                sample[1] = (outputs[1] + outputs[3]) * 0.5f;
+            }
+        }
+    }
+
+    std::atomic<float> mRoomSize { 0.5f };
+    std::atomic<float> mDamping { 0.5f };
+
+    // Only touched by the audio thread once prepared
+    std::array<std::vector<float>, kLines> mLines;
+    std::array<int32_t, kLines> mLinePositions = {};
+    std::array<float, kLines> mFeedback = {};
+    std::array<float, kLines> mLowpass = {};
+    std::array<std::vector<float>, kDiffusers> mDiffusers;
+    std::array<int32_t, kDiffusers> mDiffuserPositions = {};
+    float mDampingCoefficient = 0.0f;
+};
+
+/**
+ * A stereo feedback delay. Each channel has its own line, long enough for kMaxDelaySeconds, so
+ * changing the time never allocates.
+ */
+class DelayEffect : public SendEffect {
+public:
+    static constexpr float kMaxDelaySeconds = 2.0f;
+
+    // feedback from 0 to 0.95 is how much of each echo is fed back to make the next.
+    void setParams(float delaySeconds, float feedback) {
+        mDelaySeconds.store(std::min(std::max(delaySeconds, 0.001f), kMaxDelaySeconds), std::memory_order_relaxed);
+        mFeedback.store(std::min(std::max(feedback, 0.0f), 0.95f), std::memory_order_relaxed);
+        onParamsChanged();
+    }
+
+    void reset() override {
+        for (auto& line : mLines) std::fill(line.begin(), line.end(), 0.0f);
+    }
+
+private:
+    static constexpr int32_t kChannels = 2;
+
+    void allocate() override {
+        mLineLength = static_cast<int32_t>(kMaxDelaySeconds * mSampleRate) + 1;
+
+        for (auto& line : mLines) line.assign(mLineLength, 0.0f);
+        mWritePosition = 0;
+    }
+
+    void applyParams() override {
+        mDelayFrames = std::min(std::max(static_cast<int32_t>(mDelaySeconds.load(std::memory_order_relaxed) * mSampleRate), 1), mLineLength - 1);
+        mAppliedFeedback = mFeedback.load(std::memory_order_relaxed);
+    }
+
+    void processFrames(float* data, int32_t numFrames, int32_t channelCount) override {
+        auto channels = std::min(channelCount, kChannels);
+        auto readPosition = mWritePosition - mDelayFrames;
+        if (readPosition < 0) readPosition += mLineLength;
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            auto sample = data + frame * channelCount;
+
+            for (int32_t channel = 0; channel < channels; channel++) {
+                auto delayed = mLines[channel][readPosition];
+
+                mLines[channel][mWritePosition] = sample[channel] + delayed * mAppliedFeedback;
+                sample[channel] = delayed;
+            }
+
+            if (++readPosition == mLineLength) readPosition = 0;
+            if (++mWritePosition == mLineLength) mWritePosition = 0;
+        }
+    }
+
+    std::atomic<float> mDelaySeconds { 0.375f };
+    std::atomic<float> mFeedback { 0.35f };
+
+    // Only touched by the audio thread once prepared
+    std::array<std::vector<float>, kChannels> mLines;
+    int32_t mLineLength = 0;
+    int32_t mWritePosition = 0;
+    int32_t mDelayFrames = 1;
+    float mAppliedFeedback = 0.0f;
+};
+
+/**
+ * A three band EQ: a low shelf, a peak and a high shelf, each a biquad from the RBJ cookbook.
+ * At 0dB each band passes its input through unchanged.
+ */
+class EqEffect : public SendEffect {
+public:
+    static constexpr float kLowHz = 250.0f;
+    static constexpr float kMidHz = 1000.0f;
+    static constexpr float kHighHz = 4000.0f;
+
+    // Gains are clamped to +-24dB.
+    void setParams(float lowGainDb, float midGainDb, float highGainDb) {
+        mGainsDb[0].store(clampGain(lowGainDb), std::memory_order_relaxed);
+        mGainsDb[1].store(clampGain(midGainDb), std::memory_order_relaxed);
+        mGainsDb[2].store(clampGain(highGainDb), std::memory_order_relaxed);
+        onParamsChanged();
+    }
+
+    void reset() override {
+        for (auto& band : mBands) band.state = {};
+    }
+
+private:
+    static constexpr int32_t kBands = 3;
+    static constexpr int32_t kChannels = 2;
+
+    struct Band {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+        // Transposed direct form II state for each channel
+        std::array<std::array<float, 2>, kChannels> state = {};
+    };
+
+    static float clampGain(float gainDb) {
+        return std::min(std::max(gainDb, -24.0f), 24.0f);
+    }
+
+    void allocate() override {}
+
+    void applyParams() override {
+        setBand(mBands[0], kLowHz, mGainsDb[0].load(std::memory_order_relaxed), -1);
+        setBand(mBands[1], kMidHz, mGainsDb[1].load(std::memory_order_relaxed), 0);
+        setBand(mBands[2], kHighHz, mGainsDb[2].load(std::memory_order_relaxed), 1);
+    }
+
+    // shape is -1 for a low shelf, 0 for a peak and 1 for a high shelf
+    void setBand(Band& band, float hz, float gainDb, int32_t shape) {
+        auto a = std::pow(10.0f, gainDb / 40.0f);
+        auto w0 = 2.0f * float(M_PI) * hz / mSampleRate;
+        auto cosW0 = std::cos(w0);
+        // Q of 1/sqrt(2) for the shelves, 1 for the peak
+        auto alpha = std::sin(w0) / (shape == 0 ? 2.0f : std::sqrt(2.0f));
+        float b0, b1, b2, a0, a1, a2;
+
+        if (shape == 0) {
+            b0 = 1 + alpha * a;
+            b1 = -2 * cosW0;
+            b2 = 1 - alpha * a;
+            a0 = 1 + alpha / a;
+            a1 = -2 * cosW0;
+            a2 = 1 - alpha / a;
+        } else {
+            auto sqrtA = 2 * std::sqrt(a) * alpha;
+            auto sign = static_cast<float>(-shape); // Flips the shelf from low to high
+
+            b0 = a * ((a + 1) - sign * (a - 1) * cosW0 + sqrtA);
+            b1 = 2 * sign * a * ((a - 1) - sign * (a + 1) * cosW0);
+            b2 = a * ((a + 1) - sign * (a - 1) * cosW0 - sqrtA);
+            a0 = (a + 1) + sign * (a - 1) * cosW0 + sqrtA;
+            a1 = -2 * sign * ((a - 1) + sign * (a + 1) * cosW0);
+            a2 = (a + 1) + sign * (a - 1) * cosW0 - sqrtA;
+        }
+
+        band.b0 = b0 / a0;
+        band.b1 = b1 / a0;
+        band.b2 = b2 / a0;
+        band.a1 = a1 / a0;
+        band.a2 = a2 / a0;
+    }
+
+    void processFrames(float* data, int32_t numFrames, int32_t channelCount) override {
+        auto channels = std::min(channelCount, kChannels);
+
+        for (auto& band : mBands) {
+            for (int32_t frame = 0; frame < numFrames; frame++) {
+                auto sample = data + frame * channelCount;
+
+                for (int32_t channel = 0; channel < channels; channel++) {
+                    auto& state = band.state[channel];
+                    auto input = sample[channel];
+                    auto output = band.b0 * input + state[0];
+
+                    state[0] = band.b1 * input - band.a1 * output + state[1];
+                    state[1] = band.b2 * input - band.a2 * output;
+                    sample[channel] = output;
+                }
+            }
+        }
+    }
+
+    std::array<std::atomic<float>, kBands> mGainsDb = {};
+    std::array<Band, kBands> mBands;
+};
+
+#endif //SEND_EFFECTS_H
@@ -0,0 +1,165 @@
+#ifndef Benchmark_h
+#define Benchmark_h
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BaseScheduler.h"
+#include "IInstrument.h"
+
+// Emits one JSON object per line, so results can be diffed or fed into a regression checker.
+class BenchmarkReporter {
+public:
+    explicit BenchmarkReporter(const char* filter) : mFilter(filter) {}
+
+    bool shouldRun(const char* name) {
+        return mFilter == nullptr || strstr(name, mFilter) != nullptr;
+    }
+
+    // Params are printed as-is, so they must be valid JSON values.
+    void report(const char* name, const std::vector<std::pair<const char*, std::string>>& params, std::vector<int64_t>& samplesNs) {
+        if (samplesNs.empty()) return;
+
+        std::sort(samplesNs.begin(), samplesNs.end());
+
+        int64_t totalNs = 0;
+        for (auto sample : samplesNs) totalNs += sample;
+
+        printf("{\"benchmark\":\"%s\"", name);
+        for (auto& param : params) {
+            printf(",\"%s\":%s", param.first, param.second.c_str());
+        }
+        printf(",\"iterations\":%zu,\"mean_ns\":%lld,\"p50_ns\":%lld,\"p99_ns\":%lld,\"max_ns\":%lld}\n",
+               samplesNs.size(),
+               (long long) (totalNs / (int64_t) samplesNs.size()),
+               (long long) percentile(samplesNs, 0.5),
+               (long long) percentile(samplesNs, 0.99),
+               (long long) samplesNs.back());
+        fflush(stdout);
+    }
+
+private:
+    static int64_t percentile(const std::vector<int64_t>& sortedSamples, double p) {
+        auto index = static_cast<size_t>(p * (sortedSamples.size() - 1));
+        return sortedSamples[index];
+    }
+
+    const char* mFilter;
+};
+
+// Times a single call of fn, in nanoseconds.
+template <typename F>
+int64_t timeNs(F&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// Stand-in for a real instrument. By default it is cheap, so the benchmarks measure the engine and
+// not the synth. Give it some work per sample to emulate a synth's CPU cost.
+class MockInstrument : public IInstrument {
+public:
+    explicit MockInstrument(int32_t workPerSample = 0) : mWorkPerSample(workPerSample) {}
+
+    bool setOutputFormat(int32_t /* sampleRate */, bool isStereo) override {
+        mChannelCount = isStereo ? 2 : 1;
+        return true;
+    }
+
+    void handleMidiEvent(uint8_t /* status */, uint8_t /* data1 */, uint8_t data2) override {
+        mEventsHandled++;
+        mValue = data2 / 127.0f;
+    }
+
+    void renderAudio(float *audioData, int32_t numFrames) override {
+        for (int32_t i = 0; i < numFrames * mChannelCount; i++) {
+            float sample = mValue;
+
+            for (int32_t w = 0; w < mWorkPerSample; w++) {
+                sample = sample * 0.999f + 0.0001f * w;
+            }
+
+            audioData[i] = mIsSilent ? 0.0f : sample;
+        }
+    }
+
+    void reset() override {}
+
+    bool isIdle() override {
+        return mIsSilent && mIsReportingIdle;
+    }
+
+    // A silent instrument renders zeros, and only tells the mixer it's idle if isReportingIdle.
+    void setSilent(bool isSilent, bool isReportingIdle) {
+        mIsSilent = isSilent;
+        mIsReportingIdle = isReportingIdle;
+    }
+
+    uint64_t mEventsHandled = 0;
+
+private:
+    int32_t mWorkPerSample;
+    int32_t mChannelCount = 2;
+    float mValue = 0.5f;
+    bool mIsSilent = false;
+    bool mIsReportingIdle = false;
+};
+
+// Keeps a track's event buffer topped off with evenly spaced note on/off pairs, the way the Dart
+// side would.
+class EventFeeder {
+public:
+    EventFeeder(uint32_t eventsPerBlock, uint32_t blockFrames) {
+        mSpacing = eventsPerBlock == 0 ? 0 : std::max(blockFrames / eventsPerBlock, 1u);
+    }
+
+    template <typename TScheduler>
+    void topOff(TScheduler& scheduler, track_index_t trackIndex) {
+        if (mSpacing == 0) return;
+
+        auto availableCount = scheduler.getBufferAvailableCount(trackIndex);
+        if (availableCount < kBatchSize) return;
+
+        SchedulerEvent events[kBatchSize];
+        for (uint32_t i = 0; i < kBatchSize; i++) {
+            events[i].frame = mNextFrame;
+            events[i].type = MIDI_EVENT;
+            events[i].data[0] = (mEventsCreated % 2 == 0) ? 0x90 : 0x80;
+            events[i].data[1] = 60;
+            events[i].data[2] = 100;
+            mNextFrame += mSpacing;
+            mEventsCreated++;
+        }
+
+        scheduler.scheduleEvents(trackIndex, events, kBatchSize);
+    }
+
+private:
+    static constexpr uint32_t kBatchSize = 256;
+    uint32_t mSpacing;
+    position_frame_t mNextFrame = 0;
+    uint64_t mEventsCreated = 0;
+};
+
+inline std::string jsonInt(int64_t value) {
+    return std::to_string(value);
+}
+
+inline std::string jsonStr(const char* value) {
+    return std::string("\"") + value + "\"";
+}
+
+void runBufferBenchmarks(BenchmarkReporter& reporter);
+void runEventStoreBenchmarks(BenchmarkReporter& reporter);
+void runSchedulerBenchmarks(BenchmarkReporter& reporter);
+void runMixerBenchmarks(BenchmarkReporter& reporter);
+void runMixKernelBenchmarks(BenchmarkReporter& reporter);
+void runSf2LoadBenchmarks(BenchmarkReporter& reporter);
+
+#endif /* Benchmark_h */
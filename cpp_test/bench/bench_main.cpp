@@ -0,0 +1,17 @@
+#include "Benchmark.h"
+
+// Usage: sequencer_bench [filter]
+// Only benchmarks whose name contains the filter are run. Results are written to stdout as one
+// JSON object per line.
+int main(int argc, char **argv) {
+    BenchmarkReporter reporter(argc > 1 ? argv[1] : nullptr);
+
+    runBufferBenchmarks(reporter);
+    runEventStoreBenchmarks(reporter);
+    runSchedulerBenchmarks(reporter);
+    runMixerBenchmarks(reporter);
+    runMixKernelBenchmarks(reporter);
+    runSf2LoadBenchmarks(reporter);
+
+    return 0;
+}
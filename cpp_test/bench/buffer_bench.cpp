@@ -0,0 +1,88 @@
+#include "Benchmark.h"
+#include "Buffer.h"
+
+static constexpr int kIterations = 2000;
+
+static void fillEvents(SchedulerEvent* events, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        events[i].frame = i * 10;
+        events[i].type = MIDI_EVENT;
+    }
+}
+
+static void benchAdd(BenchmarkReporter& reporter, uint32_t batchSize) {
+    Buffer<> buffer;
+    std::vector<SchedulerEvent> events(1024);
+    std::vector<int64_t> samplesNs;
+    fillEvents(events.data(), 1024);
+
+    for (int i = 0; i < kIterations; i++) {
+        buffer.clear();
+
+        samplesNs.push_back(timeNs([&]() {
+            for (uint32_t offset = 0; offset < 1024; offset += batchSize) {
+                buffer.add(events.data() + offset, batchSize);
+            }
+        }));
+    }
+
+    reporter.report("buffer_add", { { "batch_size", jsonInt(batchSize) }, { "events", jsonInt(1024) } }, samplesNs);
+}
+
+static void benchPeekRemove(BenchmarkReporter& reporter) {
+    Buffer<> buffer;
+    std::vector<SchedulerEvent> events(1024);
+    std::vector<int64_t> samplesNs;
+    fillEvents(events.data(), 1024);
+    volatile uint64_t frameSum = 0; // Keeps the reads from being optimized away
+
+    for (int i = 0; i < kIterations; i++) {
+        buffer.add(events.data(), 1024);
+
+        samplesNs.push_back(timeNs([&]() {
+            SchedulerEvent event;
+            while (buffer.peek(event)) {
+                frameSum = frameSum + event.frame;
+                buffer.removeTop();
+            }
+        }));
+    }
+
+    reporter.report("buffer_peek_remove", { { "events", jsonInt(1024) } }, samplesNs);
+}
+
+static void benchClearAfter(BenchmarkReporter& reporter, uint32_t clearAtEvent) {
+    Buffer<> buffer;
+    std::vector<SchedulerEvent> events(1024);
+    std::vector<int64_t> samplesNs;
+    fillEvents(events.data(), 1024);
+
+    for (int i = 0; i < kIterations; i++) {
+        buffer.clear();
+        buffer.add(events.data(), 1024);
+
+        samplesNs.push_back(timeNs([&]() {
+            buffer.clearAfter(events[clearAtEvent].frame);
+        }));
+    }
+
+    reporter.report("buffer_clear_after", { { "events", jsonInt(1024) }, { "clear_at_event", jsonInt(clearAtEvent) } }, samplesNs);
+}
+
+void runBufferBenchmarks(BenchmarkReporter& reporter) {
+    if (reporter.shouldRun("buffer_add")) {
+        for (uint32_t batchSize : { 1, 16, 256, 1024 }) {
+            benchAdd(reporter, batchSize);
+        }
+    }
+
+    if (reporter.shouldRun("buffer_peek_remove")) {
+        benchPeekRemove(reporter);
+    }
+
+    if (reporter.shouldRun("buffer_clear_after")) {
+        for (uint32_t clearAtEvent : { 0, 512, 1023 }) {
+            benchClearAfter(reporter, clearAtEvent);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#include "Benchmark.h"
+#include "EventStore.h"
+
+static constexpr int kIterations = 2000;
+
+static SchedulerEvent makeEvent(position_frame_t frame) {
+    SchedulerEvent event = {};
+    event.frame = frame;
+    event.type = MIDI_EVENT;
+    return event;
+}
+
+static void fillStore(EventStore& store, uint32_t eventsCount, std::vector<event_id_t>& ids) {
+    std::vector<SchedulerEvent> events;
+    for (uint32_t i = 0; i < eventsCount; i++) {
+        events.push_back(makeEvent(i * 10));
+    }
+
+    ids.resize(eventsCount);
+    store.insert(events.data(), eventsCount, ids.data());
+}
+
+// Moves one event from the middle of the store: the edit that used to mean clearing the buffer and
+// rescheduling everything after it.
+static void benchMoveEvent(BenchmarkReporter& reporter, uint32_t eventsCount) {
+    EventStore store;
+    std::vector<event_id_t> ids;
+    std::vector<int64_t> samplesNs;
+    fillStore(store, eventsCount, ids);
+
+    for (int i = 0; i < kIterations; i++) {
+        auto index = (i * 7919u) % ids.size();
+        auto event = makeEvent(index * 10 + 5);
+
+        samplesNs.push_back(timeNs([&]() {
+            store.remove(&ids[index], 1);
+            store.insert(&event, 1, &ids[index]);
+        }));
+    }
+
+    reporter.report("event_store_move", { { "events", jsonInt(eventsCount) } }, samplesNs);
+}
+
+static void benchEraseRange(BenchmarkReporter& reporter, uint32_t eventsCount) {
+    EventStore store;
+    std::vector<event_id_t> ids;
+    std::vector<int64_t> samplesNs;
+    fillStore(store, eventsCount, ids);
+
+    for (int i = 0; i < kIterations; i++) {
+        position_frame_t fromFrame = ((i * 7919u) % eventsCount) * 10;
+        std::vector<SchedulerEvent> events;
+        for (uint32_t j = 0; j < 16; j++) {
+            events.push_back(makeEvent(fromFrame + j * 10));
+        }
+
+        // Replaces 16 events, as when a bar is rewritten
+        samplesNs.push_back(timeNs([&]() {
+            store.erase(fromFrame, fromFrame + 160);
+            store.insert(events.data(), 16, nullptr);
+        }));
+    }
+
+    reporter.report("event_store_erase_range", { { "events", jsonInt(eventsCount) }, { "erased", jsonInt(16) } }, samplesNs);
+}
+
+// One block's worth of reading, as the audio thread does it.
+static void benchRead(BenchmarkReporter& reporter, uint32_t eventsCount) {
+    EventStore store;
+    std::vector<event_id_t> ids;
+    std::vector<int64_t> samplesNs;
+    fillStore(store, eventsCount, ids);
+    volatile uint64_t frameSum = 0;
+    position_frame_t blockStart = 0;
+
+    for (int i = 0; i < kIterations; i++) {
+        samplesNs.push_back(timeNs([&]() {
+            SchedulerEvent event;
+
+            store.beginRead(blockStart);
+            while (store.peek(event) && event.frame < blockStart + 256) {
+                frameSum = frameSum + event.frame;
+                store.removeTop();
+            }
+            store.endRead();
+        }));
+
+        blockStart = (blockStart + 256) % (eventsCount * 10);
+        if (blockStart < 256) store.resetReadPosition();
+    }
+
+    reporter.report("event_store_read_block", { { "events", jsonInt(eventsCount) }, { "block_frames", jsonInt(256) } }, samplesNs);
+}
+
+void runEventStoreBenchmarks(BenchmarkReporter& reporter) {
+    for (auto eventsCount : { 1000u, 10000u, 100000u }) {
+        if (reporter.shouldRun("event_store_move")) benchMoveEvent(reporter, eventsCount);
+        if (reporter.shouldRun("event_store_erase_range")) benchEraseRange(reporter, eventsCount);
+        if (reporter.shouldRun("event_store_read_block")) benchRead(reporter, eventsCount);
+    }
+}
@@ -0,0 +1,82 @@
+#include "Benchmark.h"
+#include "MixKernel.h"
+
+static constexpr int kIterations = 2000;
+static constexpr int32_t kTrackCount = 32;
+
+enum MixImplementation { CONSTANT_GAIN_LOOP, SCALAR_RAMP, KERNEL_RAMP, KERNEL_PLANAR };
+
+static const char* implementationName(MixImplementation implementation) {
+    switch (implementation) {
+        case CONSTANT_GAIN_LOOP: return "constant_gain_loop";
+        case SCALAR_RAMP: return "scalar_ramp";
+        case KERNEL_PLANAR: return "kernel_planar";
+        default: return "kernel_ramp";
+    }
+}
+
+// Mixes kTrackCount track buffers into one output, the way Mixer::renderAudio does once per block.
+// constant_gain_loop is the loop the Mixer used before gain ramps were added. kernel_planar reads
+// each track buffer as one channel after another, the way planar instruments fill it.
+static void benchMix(BenchmarkReporter& reporter, MixImplementation implementation, int32_t channelCount, int32_t blockFrames) {
+    auto numSamples = blockFrames * channelCount;
+    std::vector<std::vector<float>> trackBuffers(kTrackCount, std::vector<float>(numSamples));
+    std::vector<float> output(numSamples);
+    std::vector<int64_t> samplesNs;
+    float startGains[2] = { 0.2f, 0.9f };
+    float endGains[2] = { 0.8f, 0.3f };
+
+    for (int32_t t = 0; t < kTrackCount; t++) {
+        for (int32_t i = 0; i < numSamples; i++) {
+            trackBuffers[t][i] = ((t * 31 + i * 17) % 200) / 100.0f - 1.0f;
+        }
+    }
+
+    for (int i = 0; i < kIterations; i++) {
+        memset(output.data(), 0, sizeof(float) * numSamples);
+
+        samplesNs.push_back(timeNs([&]() {
+            for (int32_t t = 0; t < kTrackCount; t++) {
+                auto trackBuffer = trackBuffers[t].data();
+
+                if (implementation == CONSTANT_GAIN_LOOP) {
+                    auto audioData = output.data();
+                    auto level = endGains[0];
+                    for (int j = 0; j < numSamples; ++j) {
+                        audioData[j] += trackBuffer[j] * level;
+                    }
+                } else if (implementation == SCALAR_RAMP) {
+                    MixKernel::mixScalar(output.data(), trackBuffer, blockFrames, channelCount, startGains, endGains);
+                } else if (implementation == KERNEL_PLANAR) {
+                    const float* channels[2] = { trackBuffer, trackBuffer + blockFrames };
+                    MixKernel::mixPlanarTrack(output.data(), channels, blockFrames, channelCount, startGains, endGains);
+                } else {
+                    MixKernel::mixTrack(output.data(), trackBuffer, blockFrames, channelCount, startGains, endGains);
+                }
+            }
+        }));
+    }
+
+    reporter.report("mix_kernel", {
+        { "implementation", jsonStr(implementationName(implementation)) },
+        { "vector_width", jsonInt(MixKernel::kVectorWidth) },
+        { "channels", jsonInt(channelCount) },
+        { "tracks", jsonInt(kTrackCount) },
+        { "block_frames", jsonInt(blockFrames) },
+    }, samplesNs);
+}
+
+void runMixKernelBenchmarks(BenchmarkReporter& reporter) {
+    if (!reporter.shouldRun("mix_kernel")) return;
+
+    for (int32_t channelCount : { 1, 2 }) {
+        for (int32_t blockFrames : { 64, 192, 512 }) {
+            for (auto implementation : { CONSTANT_GAIN_LOOP, SCALAR_RAMP, KERNEL_RAMP, KERNEL_PLANAR }) {
+                // Planar mono is the same mix as interleaved mono
+                if (implementation == KERNEL_PLANAR && channelCount == 1) continue;
+
+                benchMix(reporter, implementation, channelCount, blockFrames);
+            }
+        }
+    }
+}
@@ -0,0 +1,491 @@
+#include <thread>
+#include "Benchmark.h"
+#include "Mixer.h"
+
+static constexpr int kIterations = 2000;
+static constexpr int32_t kChannelCount = 2;
+
+static void benchRenderAudio(BenchmarkReporter& reporter, int32_t trackCount, uint32_t eventsPerBlock, uint32_t blockFrames) {
+    Mixer mixer;
+    std::vector<MockInstrument> instruments(trackCount);
+    std::vector<EventFeeder> feeders;
+    std::vector<float> output(blockFrames * kChannelCount);
+    std::vector<int64_t> samplesNs;
+
+    mixer.setChannelCount(kChannelCount);
+
+    for (auto& instrument : instruments) {
+        instrument.setOutputFormat(44100, kChannelCount > 1);
+        mixer.addTrack(&instrument);
+        feeders.emplace_back(eventsPerBlock, blockFrames);
+    }
+
+    mixer.play();
+
+    for (int i = 0; i < kIterations; i++) {
+        for (track_index_t trackIndex = 0; trackIndex < trackCount; trackIndex++) {
+            feeders[trackIndex].topOff(mixer, trackIndex);
+        }
+
+        samplesNs.push_back(timeNs([&]() {
+            mixer.renderAudio(output.data(), blockFrames);
+        }));
+    }
+
+    reporter.report("mixer_render_audio", {
+        { "tracks", jsonInt(trackCount) },
+        { "events_per_block", jsonInt(eventsPerBlock) },
+        { "block_frames", jsonInt(blockFrames) },
+    }, samplesNs);
+}
+
+// Renders with metering on and off, to show what measuring every track costs on top of mixing it.
+static void benchMetering(BenchmarkReporter& reporter, int32_t trackCount, uint32_t blockFrames, bool isMetering) {
+    Mixer mixer;
+    std::vector<MockInstrument> instruments(trackCount);
+    std::vector<float> output(blockFrames * kChannelCount);
+    std::vector<int64_t> samplesNs;
+
+    mixer.setChannelCount(kChannelCount);
+    mixer.setMeteringEnabled(isMetering);
+
+    for (auto& instrument : instruments) {
+        instrument.setOutputFormat(44100, kChannelCount > 1);
+        mixer.addTrack(&instrument);
+    }
+
+    mixer.play();
+
+    for (int i = 0; i < kIterations; i++) {
+        samplesNs.push_back(timeNs([&]() {
+            mixer.renderAudio(output.data(), blockFrames);
+        }));
+    }
+
+    MeterLevels meterLevels;
+    mixer.getMeterLevels(&meterLevels);
+
+    reporter.report("mixer_metering", {
+        { "tracks", jsonInt(trackCount) },
+        { "block_frames", jsonInt(blockFrames) },
+        { "metering", isMetering ? "true" : "false" },
+        { "metered_tracks", jsonInt(meterLevels.tracksCount) },
+    }, samplesNs);
+}
+
+// Renders the same sequence with and without worker threads, and checks the output is identical.
+static void benchParallelRender(BenchmarkReporter& reporter, int32_t trackCount, int32_t workerCount, uint32_t blockFrames) {
+    const int32_t workPerSample = 16;
+    Mixer mixers[2];
+    std::vector<std::vector<MockInstrument>> instruments(2);
+    std::vector<std::vector<EventFeeder>> feeders(2);
+    std::vector<float> outputs[2];
+    std::vector<int64_t> samplesNs;
+    bool matchesSerial = true;
+
+    for (int m = 0; m < 2; m++) {
+        mixers[m].setChannelCount(kChannelCount);
+        outputs[m].resize(blockFrames * kChannelCount);
+
+        for (int32_t i = 0; i < trackCount; i++) {
+            instruments[m].emplace_back(workPerSample);
+            feeders[m].emplace_back(1, blockFrames);
+        }
+
+        for (auto& instrument : instruments[m]) {
+            instrument.setOutputFormat(44100, kChannelCount > 1);
+            mixers[m].addTrack(&instrument);
+        }
+
+        mixers[m].play();
+    }
+
+    Mixer& serialMixer = mixers[0];
+    Mixer& parallelMixer = mixers[1];
+    parallelMixer.setRenderThreadCount(workerCount);
+
+    for (int i = 0; i < kIterations / 4; i++) {
+        for (track_index_t trackIndex = 0; trackIndex < trackCount; trackIndex++) {
+            feeders[0][trackIndex].topOff(serialMixer, trackIndex);
+            feeders[1][trackIndex].topOff(parallelMixer, trackIndex);
+        }
+
+        serialMixer.renderAudio(outputs[0].data(), blockFrames);
+
+        samplesNs.push_back(timeNs([&]() {
+            parallelMixer.renderAudio(outputs[1].data(), blockFrames);
+        }));
+
+        if (memcmp(outputs[0].data(), outputs[1].data(), outputs[0].size() * sizeof(float)) != 0) {
+            matchesSerial = false;
+        }
+    }
+
+    parallelMixer.setRenderThreadCount(0);
+
+    reporter.report("mixer_parallel_render", {
+        { "tracks", jsonInt(trackCount) },
+        { "worker_threads", jsonInt(workerCount) },
+        { "block_frames", jsonInt(blockFrames) },
+        { "work_per_sample", jsonInt(workPerSample) },
+        { "matches_serial", matchesSerial ? "true" : "false" },
+    }, samplesNs);
+}
+
+// Renders callbacks larger than the track buffers with different sub-block sizes, and checks the
+// output matches the smallest sub-block size, i.e. events land on the same frame however the
+// callback is split.
+static void benchSubBlocks(BenchmarkReporter& reporter, int32_t trackCount, uint32_t callbackFrames) {
+    const int32_t subBlockSizes[] = { 32, 64, 128, 256, 512 };
+    const int32_t mixerCount = sizeof(subBlockSizes) / sizeof(subBlockSizes[0]);
+    Mixer mixers[mixerCount];
+    std::vector<std::vector<MockInstrument>> instruments(mixerCount, std::vector<MockInstrument>(trackCount));
+    std::vector<std::vector<EventFeeder>> feeders(mixerCount);
+    std::vector<std::vector<float>> outputs(mixerCount, std::vector<float>(callbackFrames * kChannelCount));
+    std::vector<std::vector<int64_t>> samplesNs(mixerCount);
+    std::vector<bool> matchesReference(mixerCount, true);
+
+    for (int32_t m = 0; m < mixerCount; m++) {
+        mixers[m].setChannelCount(kChannelCount);
+        mixers[m].setSubBlockFrames(subBlockSizes[m]);
+
+        for (auto& instrument : instruments[m]) {
+            instrument.setOutputFormat(44100, kChannelCount > 1);
+            mixers[m].addTrack(&instrument);
+            // An odd spacing puts events at every offset within a sub-block
+            feeders[m].emplace_back(7, callbackFrames);
+        }
+
+        mixers[m].play();
+    }
+
+    for (int i = 0; i < kIterations / 4; i++) {
+        for (int32_t m = 0; m < mixerCount; m++) {
+            for (track_index_t trackIndex = 0; trackIndex < trackCount; trackIndex++) {
+                feeders[m][trackIndex].topOff(mixers[m], trackIndex);
+            }
+
+            samplesNs[m].push_back(timeNs([&]() {
+                mixers[m].renderAudio(outputs[m].data(), callbackFrames);
+            }));
+
+            if (memcmp(outputs[0].data(), outputs[m].data(), outputs[0].size() * sizeof(float)) != 0) {
+                matchesReference[m] = false;
+            }
+        }
+    }
+
+    for (int32_t m = 0; m < mixerCount; m++) {
+        reporter.report("mixer_sub_block", {
+            { "tracks", jsonInt(trackCount) },
+            { "callback_frames", jsonInt(callbackFrames) },
+            { "sub_block_frames", jsonInt(mixers[m].getSubBlockFrames()) },
+            { "sub_blocks_per_callback", jsonInt(mixers[m].getRenderStats().getSubBlockStats().lastCount) },
+            { "matches_reference", matchesReference[m] ? "true" : "false" },
+        }, samplesNs[m]);
+    }
+}
+
+// Renders an arrangement where most tracks are silent, with the silent instruments reporting that
+// they're idle or not, and checks skipping them doesn't change the output.
+static void benchIdleTracks(BenchmarkReporter& reporter, int32_t trackCount, int32_t activeCount, uint32_t blockFrames) {
+    const int32_t workPerSample = 4;
+    Mixer mixers[2];
+    std::vector<std::vector<MockInstrument>> instruments(2);
+    std::vector<float> outputs[2];
+    std::vector<int64_t> samplesNs[2];
+    bool matchesRendered = true;
+
+    for (int m = 0; m < 2; m++) {
+        mixers[m].setChannelCount(kChannelCount);
+        outputs[m].resize(blockFrames * kChannelCount);
+
+        for (int32_t i = 0; i < trackCount; i++) {
+            instruments[m].emplace_back(workPerSample);
+        }
+
+        for (int32_t i = 0; i < trackCount; i++) {
+            auto& instrument = instruments[m][i];
+            instrument.setOutputFormat(44100, kChannelCount > 1);
+            instrument.setSilent(i >= activeCount, m == 1);
+            mixers[m].addTrack(&instrument);
+        }
+
+        mixers[m].play();
+    }
+
+    for (int i = 0; i < kIterations; i++) {
+        for (int m = 0; m < 2; m++) {
+            samplesNs[m].push_back(timeNs([&]() {
+                mixers[m].renderAudio(outputs[m].data(), blockFrames);
+            }));
+        }
+
+        if (memcmp(outputs[0].data(), outputs[1].data(), outputs[0].size() * sizeof(float)) != 0) {
+            matchesRendered = false;
+        }
+    }
+
+    for (int m = 0; m < 2; m++) {
+        reporter.report("mixer_idle_tracks", {
+            { "tracks", jsonInt(trackCount) },
+            { "active_tracks", jsonInt(activeCount) },
+            { "block_frames", jsonInt(blockFrames) },
+            { "skip_idle", m == 1 ? "true" : "false" },
+            { "skipped_per_callback", jsonInt(mixers[m].getRenderStats().getSkipStats().lastSkippedCount) },
+            { "matches_rendered", matchesRendered ? "true" : "false" },
+        }, samplesNs[m]);
+    }
+}
+
+// Mixes the same tracks flat into the master and through buses, nested two deep when there's more
+// than one, to show what the extra pass costs and that the mix comes out the same.
+static void benchBusRouting(BenchmarkReporter& reporter, int32_t trackCount, int32_t busCount, int32_t workerCount, uint32_t blockFrames) {
+    Mixer mixers[2];
+    std::vector<std::vector<MockInstrument>> instruments(2);
+    std::vector<float> outputs[2];
+    std::vector<int64_t> samplesNs;
+    float maxDifference = 0.0f;
+
+    for (int m = 0; m < 2; m++) {
+        mixers[m].setChannelCount(kChannelCount);
+        mixers[m].setRenderThreadCount(workerCount);
+        outputs[m].resize(blockFrames * kChannelCount);
+        instruments[m] = std::vector<MockInstrument>(trackCount);
+
+        for (auto& instrument : instruments[m]) {
+            instrument.setOutputFormat(44100, kChannelCount > 1);
+            mixers[m].addTrack(&instrument);
+        }
+
+        mixers[m].play();
+    }
+
+    std::vector<int32_t> buses;
+    for (int32_t i = 0; i < busCount; i++) {
+        buses.push_back(mixers[1].addBus());
+    }
+
+    // Half the buses feed the other half, which feed the master
+    for (int32_t i = 0; i < busCount / 2; i++) {
+        mixers[1].setBusOutput(buses[i], buses[busCount / 2 + i]);
+    }
+    for (track_index_t trackIndex = 0; busCount > 0 && trackIndex < trackCount; trackIndex++) {
+        mixers[1].setTrackOutput(trackIndex, buses[trackIndex % busCount]);
+    }
+
+    for (int i = 0; i < kIterations; i++) {
+        mixers[0].renderAudio(outputs[0].data(), blockFrames);
+
+        samplesNs.push_back(timeNs([&]() {
+            mixers[1].renderAudio(outputs[1].data(), blockFrames);
+        }));
+
+        for (size_t s = 0; s < outputs[0].size(); s++) {
+            maxDifference = std::max(maxDifference, std::abs(outputs[0][s] - outputs[1][s]));
+        }
+    }
+
+    reporter.report("mixer_bus_routing", {
+        { "tracks", jsonInt(trackCount) },
+        { "buses", jsonInt(busCount) },
+        { "workers", jsonInt(workerCount) },
+        { "block_frames", jsonInt(blockFrames) },
+        { "matches_flat", maxDifference < 1e-4f ? "true" : "false" },
+    }, samplesNs);
+}
+
+// Like an SFZ track carrying its own <effect>: each instrument runs a reverb over its own output.
+class ReverbInstrument : public MockInstrument {
+public:
+    explicit ReverbInstrument(int32_t sampleRate) : mWet(kBufferSize) {
+        mReverb.prepare(sampleRate);
+    }
+
+    void renderAudio(float *audioData, int32_t numFrames) override {
+        MockInstrument::renderAudio(audioData, numFrames);
+
+        auto samplesCount = numFrames * kChannelCount;
+        std::copy(audioData, audioData + samplesCount, mWet.begin());
+        mReverb.process(mWet.data(), numFrames, kChannelCount);
+
+        for (int32_t i = 0; i < samplesCount; i++) {
+            audioData[i] += mWet[i] * kSendLevel;
+        }
+    }
+
+    static constexpr float kSendLevel = 0.3f;
+
+private:
+    ReverbEffect mReverb;
+    std::vector<float> mWet;
+};
+
+// Reverb on every track, either from one reverb per instrument or from one shared send bus.
+static void benchSendEffects(BenchmarkReporter& reporter, int32_t trackCount, bool isShared, uint32_t blockFrames) {
+    const int32_t sampleRate = 44100;
+    Mixer mixer;
+    std::vector<std::unique_ptr<MockInstrument>> instruments;
+    std::vector<float> output(blockFrames * kChannelCount);
+    std::vector<int64_t> samplesNs;
+
+    mixer.setChannelCount(kChannelCount);
+    mixer.setSampleRate(sampleRate);
+
+    for (int32_t i = 0; i < trackCount; i++) {
+        if (isShared) {
+            instruments.push_back(std::make_unique<MockInstrument>());
+        } else {
+            instruments.push_back(std::make_unique<ReverbInstrument>(sampleRate));
+        }
+
+        instruments.back()->setOutputFormat(sampleRate, kChannelCount > 1);
+        auto trackIndex = mixer.addTrack(instruments.back().get());
+        if (isShared) mixer.setSendLevel(trackIndex, SEND_REVERB, ReverbInstrument::kSendLevel);
+    }
+
+    mixer.play();
+
+    for (int i = 0; i < kIterations; i++) {
+        samplesNs.push_back(timeNs([&]() {
+            mixer.renderAudio(output.data(), blockFrames);
+        }));
+    }
+
+    reporter.report("mixer_send_effects", {
+        { "tracks", jsonInt(trackCount) },
+        { "reverb", jsonStr(isShared ? "shared_send" : "per_instrument") },
+        { "block_frames", jsonInt(blockFrames) },
+    }, samplesNs);
+}
+
+// Lets the mixer go idle with every track silent, then times callbacks with idle mode on and off,
+// and checks that a live event brings it back on the very next callback.
+static void benchIdleEngine(BenchmarkReporter& reporter, int32_t trackCount, uint32_t blockFrames, bool isIdleModeEnabled) {
+    const int32_t sampleRate = 44100;
+    Mixer mixer;
+    std::vector<MockInstrument> instruments(trackCount);
+    std::vector<float> output(blockFrames * kChannelCount);
+    std::vector<int64_t> samplesNs;
+
+    mixer.setChannelCount(kChannelCount);
+    mixer.setSampleRate(sampleRate);
+    mixer.setIdleModeEnabled(isIdleModeEnabled);
+
+    for (auto& instrument : instruments) {
+        instrument.setOutputFormat(sampleRate, kChannelCount > 1);
+        instrument.setSilent(true, true);
+        mixer.addTrack(&instrument);
+    }
+
+    mixer.play();
+
+    // Past the hold time, with nothing scheduled
+    for (uint32_t frames = 0; frames < sampleRate; frames += blockFrames) {
+        mixer.renderAudio(output.data(), blockFrames);
+    }
+
+    auto isIdle = mixer.getIsIdle();
+    auto startFrame = mixer.getPosition();
+
+    for (int i = 0; i < kIterations; i++) {
+        samplesNs.push_back(timeNs([&]() {
+            mixer.renderAudio(output.data(), blockFrames);
+        }));
+    }
+
+    auto keepsTime = mixer.getPosition() == startFrame + kIterations * blockFrames;
+
+    SchedulerEvent noteOn;
+    noteOn.frame = 0;
+    noteOn.type = MIDI_EVENT;
+    noteOn.data[0] = 0x90;
+    noteOn.data[1] = 60;
+    noteOn.data[2] = 100;
+
+    instruments[0].setSilent(false, false);
+    mixer.handleEventsNow(0, &noteOn, 1);
+    mixer.renderAudio(output.data(), blockFrames);
+
+    reporter.report("mixer_idle_engine", {
+        { "tracks", jsonInt(trackCount) },
+        { "block_frames", jsonInt(blockFrames) },
+        { "idle_mode", isIdleModeEnabled ? "true" : "false" },
+        { "went_idle", isIdle ? "true" : "false" },
+        { "keeps_time", keepsTime ? "true" : "false" },
+        { "wakes_next_callback", !mixer.getIsIdle() && mixer.getRenderStats().getSkipStats().lastSkippedCount < static_cast<uint32_t>(trackCount) ? "true" : "false" },
+    }, samplesNs);
+}
+
+void runMixerBenchmarks(BenchmarkReporter& reporter) {
+    if (reporter.shouldRun("mixer_bus_routing")) {
+        for (int32_t workerCount : { 0, 3 }) {
+            // No buses at all is the flat mix's own cost
+            for (int32_t busCount : { 0, 1, 4, 16 }) {
+                // 128 tracks are still too few for a stage of buses to be worth mixing in parallel
+                for (int32_t trackCount : { 32, 128 }) {
+                    benchBusRouting(reporter, trackCount, busCount, workerCount, 192);
+                }
+            }
+        }
+    }
+
+    if (reporter.shouldRun("mixer_send_effects")) {
+        for (int32_t trackCount : { 1, 8, 20 }) {
+            benchSendEffects(reporter, trackCount, false, 192);
+            benchSendEffects(reporter, trackCount, true, 192);
+        }
+    }
+
+    if (reporter.shouldRun("mixer_idle_engine")) {
+        for (int32_t trackCount : { 8, 40 }) {
+            benchIdleEngine(reporter, trackCount, 192, false);
+            benchIdleEngine(reporter, trackCount, 192, true);
+        }
+    }
+
+    if (reporter.shouldRun("mixer_idle_tracks")) {
+        for (int32_t activeCount : { 4, 10, 40 }) {
+            benchIdleTracks(reporter, 40, activeCount, 192);
+        }
+    }
+
+    if (reporter.shouldRun("mixer_sub_block")) {
+        for (int32_t trackCount : { 8, 32 }) {
+            // 2048 stereo frames is larger than the track buffers can hold in one pass
+            for (uint32_t callbackFrames : { 192, 2048 }) {
+                benchSubBlocks(reporter, trackCount, callbackFrames);
+            }
+        }
+    }
+
+    if (reporter.shouldRun("mixer_metering")) {
+        for (int32_t trackCount : { 8, 32, 100 }) {
+            benchMetering(reporter, trackCount, 192, false);
+            benchMetering(reporter, trackCount, 192, true);
+        }
+    }
+
+    if (reporter.shouldRun("mixer_parallel_render")) {
+        // Sweeps worker counts up to one less than the number of cores, since the audio thread
+        // renders too
+        auto coreCount = static_cast<int32_t>(std::thread::hardware_concurrency());
+        auto maxWorkers = std::min(std::max(coreCount - 1, 1), RenderThreadPool::kMaxWorkers);
+
+        for (int32_t trackCount : { 8, 32, 100 }) {
+            for (int32_t workerCount = 0; workerCount <= maxWorkers; workerCount = workerCount == 0 ? 1 : workerCount * 2) {
+                benchParallelRender(reporter, trackCount, workerCount, 192);
+            }
+        }
+    }
+
+    if (!reporter.shouldRun("mixer_render_audio")) return;
+
+    for (int32_t trackCount : { 1, 10, 50, 100 }) {
+        for (uint32_t eventsPerBlock : { 0, 1, 8 }) {
+            for (uint32_t blockFrames : { 64, 192, 512 }) {
+                benchRenderAudio(reporter, trackCount, eventsPerBlock, blockFrames);
+            }
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#include "Benchmark.h"
+
+static constexpr int kIterations = 2000;
+
+// Does no rendering, so only the scheduler's own bookkeeping is measured.
+class BenchScheduler : public BaseScheduler {
+public:
+    void onRemoveTrack(track_index_t /* trackIndex */) override {}
+    void onResetTrack(track_index_t /* trackIndex */) override {}
+    void handleRenderAudioRange(track_index_t /* trackIndex */, uint32_t /* offsetFrame */, uint32_t /* numFramesToRender */) override {}
+    void handleEvent(track_index_t /* trackIndex */, SchedulerEvent /* event */, position_frame_t /* offsetFrame */) override {
+        mEventsHandled++;
+    }
+
+    uint64_t mEventsHandled = 0;
+};
+
+static void benchHandleFrames(BenchmarkReporter& reporter, int32_t trackCount, uint32_t eventsPerBlock, uint32_t blockFrames) {
+    BenchScheduler scheduler;
+    std::vector<EventFeeder> feeders;
+    std::vector<int64_t> samplesNs;
+
+    for (int32_t i = 0; i < trackCount; i++) {
+        scheduler.addTrack();
+        feeders.emplace_back(eventsPerBlock, blockFrames);
+    }
+
+    scheduler.play();
+
+    for (int i = 0; i < kIterations; i++) {
+        for (track_index_t trackIndex = 0; trackIndex < trackCount; trackIndex++) {
+            feeders[trackIndex].topOff(scheduler, trackIndex);
+        }
+
+        samplesNs.push_back(timeNs([&]() {
+            for (track_index_t trackIndex = 0; trackIndex < trackCount; trackIndex++) {
+                scheduler.handleFrames(trackIndex, blockFrames);
+            }
+        }));
+    }
+
+    reporter.report("scheduler_handle_frames", {
+        { "tracks", jsonInt(trackCount) },
+        { "events_per_block", jsonInt(eventsPerBlock) },
+        { "block_frames", jsonInt(blockFrames) },
+    }, samplesNs);
+}
+
+enum ResyncMode { PER_TRACK, MULTI, RING };
+
+// Refills every track's buffer from raw event data: with a scheduleEvents call per track after
+// converting the events, with a single scheduleEventsMulti call, or by writing into the shared
+// event rings and publishing them, the way Dart does.
+static void benchResync(BenchmarkReporter& reporter, int32_t trackCount, uint32_t eventsPerTrack, ResyncMode mode) {
+    BenchScheduler scheduler;
+    std::vector<int64_t> samplesNs;
+    std::vector<uint8_t> rawData;
+    std::vector<uint32_t> acceptedCounts(trackCount);
+    std::vector<track_index_t> trackIndices(trackCount);
+    std::vector<uint32_t> writePositions(trackCount);
+
+    for (int32_t i = 0; i < trackCount; i++) {
+        scheduler.addTrack();
+    }
+
+    for (track_index_t trackIndex = 0; trackIndex < trackCount; trackIndex++) {
+        auto headerOffset = rawData.size();
+        rawData.resize(headerOffset + 8 + eventsPerTrack * sizeof(SchedulerEvent));
+        memcpy(rawData.data() + headerOffset, &trackIndex, sizeof(int32_t));
+        memcpy(rawData.data() + headerOffset + 4, &eventsPerTrack, sizeof(uint32_t));
+
+        for (uint32_t i = 0; i < eventsPerTrack; i++) {
+            SchedulerEvent event = {};
+            event.frame = i * 100;
+            event.type = MIDI_EVENT;
+            memcpy(rawData.data() + headerOffset + 8 + i * sizeof(SchedulerEvent), &event, sizeof(SchedulerEvent));
+        }
+    }
+
+    uint64_t acceptedTotal = 0;
+
+    for (int i = 0; i < kIterations; i++) {
+        for (track_index_t trackIndex = 0; trackIndex < trackCount; trackIndex++) {
+            scheduler.clearEvents(trackIndex, 0);
+        }
+
+        samplesNs.push_back(timeNs([&]() {
+            if (mode == MULTI) {
+                acceptedTotal += scheduler.scheduleEventsMulti(rawData.data(), rawData.size(), trackCount, acceptedCounts.data());
+                return;
+            }
+
+            if (mode == RING) {
+                size_t offset = 0;
+                for (track_index_t trackIndex = 0; trackIndex < trackCount; trackIndex++) {
+                    SchedulerEvent* events;
+                    uint32_t* readPosition;
+                    uint32_t* writePosition;
+                    auto capacity = scheduler.getEventRing(trackIndex, &events, &readPosition, &writePosition);
+                    auto count = std::min(eventsPerTrack, capacity - (*writePosition - *readPosition));
+
+                    offset += 8;
+                    for (uint32_t i = 0; i < count; i++) {
+                        memcpy(&events[(*writePosition + i) & (capacity - 1)], rawData.data() + offset + i * sizeof(SchedulerEvent), sizeof(SchedulerEvent));
+                    }
+                    offset += eventsPerTrack * sizeof(SchedulerEvent);
+
+                    trackIndices[trackIndex] = trackIndex;
+                    writePositions[trackIndex] = *writePosition + count;
+                    acceptedTotal += count;
+                }
+
+                scheduler.publishEventRings(trackIndices.data(), writePositions.data(), trackCount);
+                return;
+            }
+
+            size_t offset = 0;
+            for (track_index_t trackIndex = 0; trackIndex < trackCount; trackIndex++) {
+                std::vector<SchedulerEvent> events(eventsPerTrack);
+
+                offset += 8;
+                rawEventDataToEvents(rawData.data() + offset, eventsPerTrack, events.data());
+                acceptedTotal += scheduler.scheduleEvents(trackIndex, events.data(), eventsPerTrack);
+                offset += eventsPerTrack * sizeof(SchedulerEvent);
+            }
+        }));
+    }
+
+    reporter.report("scheduler_resync", {
+        { "tracks", jsonInt(trackCount) },
+        { "events_per_track", jsonInt(eventsPerTrack) },
+        { "mode", jsonStr(mode == MULTI ? "multi" : (mode == RING ? "ring" : "per_track")) },
+        { "all_accepted", acceptedTotal == uint64_t(kIterations) * trackCount * eventsPerTrack ? "true" : "false" },
+    }, samplesNs);
+}
+
+void runSchedulerBenchmarks(BenchmarkReporter& reporter) {
+    if (reporter.shouldRun("scheduler_handle_frames")) {
+        for (int32_t trackCount : { 1, 10, 50, 100 }) {
+            for (uint32_t eventsPerBlock : { 0, 1, 8 }) {
+                for (uint32_t blockFrames : { 64, 192, 512 }) {
+                    benchHandleFrames(reporter, trackCount, eventsPerBlock, blockFrames);
+                }
+            }
+        }
+    }
+
+    if (reporter.shouldRun("scheduler_resync")) {
+        for (int32_t trackCount : { 8, 64 }) {
+            for (uint32_t eventsPerTrack : { 16, 256 }) {
+                benchResync(reporter, trackCount, eventsPerTrack, PER_TRACK);
+                benchResync(reporter, trackCount, eventsPerTrack, MULTI);
+                benchResync(reporter, trackCount, eventsPerTrack, RING);
+            }
+        }
+    }
+}
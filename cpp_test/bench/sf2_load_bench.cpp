@@ -0,0 +1,147 @@
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Benchmark.h"
+#include "MappedFile.h"
+
+// Compares the ways SoundFontInstrument can read a bank's sample data. TinySoundFont itself isn't
+// built here, so each path does what its loader does with the samples: convert 16-bit PCM to a
+// float array on the heap.
+//
+// The file is read from a warm page cache, since dropping caches needs root, so cold loads from
+// disk aren't measured.
+
+static constexpr int kIterations = 5;
+static constexpr size_t kFileBytes = 64 * 1024 * 1024;
+static constexpr size_t kStreamChunkBytes = 4096;
+
+// Resident set size in KB, including file pages that are mapped in.
+static int64_t getResidentKb() {
+    long totalPages = 0, residentPages = 0;
+    auto statm = fopen("/proc/self/statm", "r");
+    if (statm == nullptr) return 0;
+
+    if (fscanf(statm, "%ld %ld", &totalPages, &residentPages) != 2) residentPages = 0;
+    fclose(statm);
+
+    return static_cast<int64_t>(residentPages) * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static bool writeBank(const char* path) {
+    auto file = fopen(path, "wb");
+    if (file == nullptr) return false;
+
+    std::vector<int16_t> chunk(kStreamChunkBytes / sizeof(int16_t));
+    uint32_t seed = 1;
+
+    for (size_t written = 0; written < kFileBytes; written += kStreamChunkBytes) {
+        for (auto& sample : chunk) {
+            seed = seed * 1664525 + 1013904223;
+            sample = static_cast<int16_t>(seed >> 16);
+        }
+        fwrite(chunk.data(), 1, kStreamChunkBytes, file);
+    }
+
+    fclose(file);
+    return true;
+}
+
+static void convertSamples(const int16_t* samples, size_t count, float* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = samples[i] / 32767.0f;
+    }
+}
+
+// Like tsf_load_filename: stdio reads in chunks, converting each one.
+static float* loadStreamed(const char* path, size_t& samplesCount) {
+    auto file = fopen(path, "rb");
+    if (file == nullptr) return nullptr;
+
+    samplesCount = kFileBytes / sizeof(int16_t);
+    auto samples = static_cast<float*>(malloc(samplesCount * sizeof(float)));
+    int16_t chunk[kStreamChunkBytes / sizeof(int16_t)];
+    size_t offset = 0;
+    size_t readCount;
+
+    while ((readCount = fread(chunk, sizeof(int16_t), kStreamChunkBytes / sizeof(int16_t), file)) > 0) {
+        convertSamples(chunk, readCount, samples + offset);
+        offset += readCount;
+    }
+
+    fclose(file);
+    return samples;
+}
+
+// Like loadMappedSf2: convert straight out of the page cache.
+static float* loadMapped(MappedFile& file, size_t& samplesCount) {
+    file.advise(MADV_WILLNEED);
+
+    samplesCount = file.getSize() / sizeof(int16_t);
+    auto samples = static_cast<float*>(malloc(samplesCount * sizeof(float)));
+    convertSamples(reinterpret_cast<const int16_t*>(file.getData()), samplesCount, samples);
+
+    return samples;
+}
+
+static void benchLoad(BenchmarkReporter& reporter, const char* path, const char* mode) {
+    std::vector<int64_t> samplesNs;
+    int64_t maxRssDeltaKb = 0;
+    volatile float checksum = 0; // Keeps the reads from being optimized away
+
+    for (int i = 0; i < kIterations; i++) {
+        MappedFile file;
+        float* samples = nullptr;
+        size_t samplesCount = 0;
+        auto rssBeforeKb = getResidentKb();
+
+        samplesNs.push_back(timeNs([&]() {
+            if (strcmp(mode, "stream") == 0) {
+                samples = loadStreamed(path, samplesCount);
+            } else if (strcmp(mode, "mmap") == 0) {
+                if (file.open(path)) samples = loadMapped(file, samplesCount);
+            } else if (file.open(path)) {
+                // What referencing samples in place would cost: one read of every page, no copy
+                file.advise(MADV_RANDOM);
+                auto mapped = reinterpret_cast<const int16_t*>(file.getData());
+                int64_t sum = 0;
+
+                for (size_t s = 0; s < file.getSize() / sizeof(int16_t); s += 2048) {
+                    sum += mapped[s];
+                }
+                checksum = checksum + sum;
+            }
+        }));
+
+        // loadMappedSf2 unmaps the file once it's parsed, but in place loading would keep it
+        if (strcmp(mode, "in_place") != 0) file.close();
+        maxRssDeltaKb = std::max(maxRssDeltaKb, getResidentKb() - rssBeforeKb);
+
+        if (samples != nullptr) {
+            checksum = checksum + samples[samplesCount / 2];
+            free(samples);
+        }
+    }
+
+    reporter.report("sf2_load", {
+        { "mode", jsonStr(mode) },
+        { "file_mb", jsonInt(kFileBytes / (1024 * 1024)) },
+        { "rss_delta_kb", jsonInt(maxRssDeltaKb) },
+    }, samplesNs);
+}
+
+void runSf2LoadBenchmarks(BenchmarkReporter& reporter) {
+    if (!reporter.shouldRun("sf2_load")) return;
+
+    char path[] = "/tmp/sf2_load_benchXXXXXX";
+    auto fd = mkstemp(path);
+    if (fd == -1) return;
+    close(fd);
+
+    if (writeBank(path)) {
+        for (auto mode : { "stream", "mmap", "in_place" }) {
+            benchLoad(reporter, path, mode);
+        }
+    }
+
+    unlink(path);
+}
@@ -0,0 +1,63 @@
+#ifndef STUB_INSTRUMENT_H
+#define STUB_INSTRUMENT_H
+
+#include <functional>
+#include <vector>
+#include "IInstrument.h"
+
+struct HandledMidiEvent {
+    uint64_t frame; // How many frames the instrument had rendered when the event came in
+    uint8_t status;
+    uint8_t data1;
+};
+
+// Renders a constant value and records what the mixer asks of it.
+class StubInstrument : public IInstrument {
+public:
+    explicit StubInstrument(float value = 1.0f) : mValue(value) {}
+
+    bool setOutputFormat(int32_t /* sampleRate */, bool isStereo) override {
+        mChannelCount = isStereo ? 2 : 1;
+        return true;
+    }
+
+    // Like a real instrument, any event wakes it
+    void handleMidiEvent(uint8_t status, uint8_t data1, uint8_t /* data2 */) override {
+        mMidiEvents.push_back({ mFramesRendered, status, data1 });
+        mIsIdle = false;
+    }
+
+    void renderAudio(float *audioData, int32_t numFrames) override {
+        // Cleared before it's called, so it can't run twice if it renders this instrument again
+        if (mOnRender) {
+            auto onRender = std::move(mOnRender);
+            mOnRender = nullptr;
+            onRender();
+        }
+
+        for (int32_t i = 0; i < numFrames * mChannelCount; i++) {
+            audioData[i] = mValue;
+        }
+
+        mRenderCalls.push_back(numFrames);
+        mFramesRendered += numFrames;
+    }
+
+    void reset() override {}
+
+    bool isIdle() override { return mIsIdle; }
+
+    float mValue;
+    bool mIsIdle = false;
+    // Runs once, at the start of the next render
+    std::function<void()> mOnRender;
+
+    std::vector<HandledMidiEvent> mMidiEvents;
+    std::vector<int32_t> mRenderCalls; // The frame count of each render
+    uint64_t mFramesRendered = 0;
+
+private:
+    int32_t mChannelCount = 1;
+};
+
+#endif //STUB_INSTRUMENT_H
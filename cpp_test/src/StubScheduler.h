@@ -0,0 +1,59 @@
+#ifndef STUB_SCHEDULER_H
+#define STUB_SCHEDULER_H
+
+#include <vector>
+#include "BaseScheduler.h"
+
+struct HandledEvent {
+    track_index_t trackIndex;
+    position_frame_t offsetFrame; // From the start of the block
+    SchedulerEvent event;
+};
+
+struct RenderedRange {
+    track_index_t trackIndex;
+    uint32_t offsetFrame;
+    uint32_t numFrames;
+};
+
+// Records what the scheduler asks of its tracks instead of rendering anything.
+class StubScheduler : public BaseScheduler {
+public:
+    void onRemoveTrack(track_index_t /* trackIndex */) override {}
+    void onResetTrack(track_index_t /* trackIndex */) override {}
+
+    void handleRenderAudioRange(track_index_t trackIndex, uint32_t offsetFrame, uint32_t numFramesToRender) override {
+        if (numFramesToRender > 0) mRenderedRanges.push_back({ trackIndex, offsetFrame, numFramesToRender });
+    }
+
+    void handleEvent(track_index_t trackIndex, SchedulerEvent event, position_frame_t offsetFrame) override {
+        mHandledEvents.push_back({ trackIndex, offsetFrame, event });
+    }
+
+    // Renders one block of every track, and returns the block's start frame.
+    position_frame_t renderBlock(const std::vector<track_index_t>& trackIndices, uint32_t numFrames) {
+        auto startFrame = getPosition();
+
+        for (auto trackIndex : trackIndices) {
+            handleFrames(trackIndex, numFrames);
+        }
+
+        return startFrame;
+    }
+
+    std::vector<HandledEvent> mHandledEvents;
+    std::vector<RenderedRange> mRenderedRanges;
+};
+
+// A note-on, with the note number as its first data byte.
+static inline SchedulerEvent makeNoteOn(position_frame_t frame, uint8_t noteNumber) {
+    SchedulerEvent event = {};
+    event.frame = frame;
+    event.type = MIDI_EVENT;
+    event.data[0] = 0x90;
+    event.data[1] = noteNumber;
+    event.data[2] = 100;
+    return event;
+}
+
+#endif //STUB_SCHEDULER_H
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "AudioFileWriter.h"
+
+static std::vector<uint8_t> readFile(const std::string& path) {
+    std::vector<uint8_t> bytes;
+    auto file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return bytes;
+
+    uint8_t chunk[4096];
+    size_t bytesRead;
+    while ((bytesRead = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + bytesRead);
+    }
+
+    fclose(file);
+    return bytes;
+}
+
+static uint32_t readUint32(const std::vector<uint8_t>& bytes, size_t offset) {
+    return bytes[offset] | (bytes[offset + 1] << 8) | (bytes[offset + 2] << 16) | (static_cast<uint32_t>(bytes[offset + 3]) << 24);
+}
+
+static uint16_t readUint16(const std::vector<uint8_t>& bytes, size_t offset) {
+    return static_cast<uint16_t>(bytes[offset] | (bytes[offset + 1] << 8));
+}
+
+static std::string readTag(const std::vector<uint8_t>& bytes, size_t offset) {
+    return std::string(bytes.begin() + offset, bytes.begin() + offset + 4);
+}
+
+static std::vector<float> makeFrames(int32_t numFrames, int32_t channelCount) {
+    std::vector<float> samples(numFrames * channelCount);
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = static_cast<float>(i) / samples.size() - 0.5f;
+    }
+
+    return samples;
+}
+
+TEST(AudioFileWriterTest, WavFloatHeaderDescribesTheData) {
+    auto path = ::testing::TempDir() + "audio_file_writer_test.wav";
+    auto samples = makeFrames(300, 2);
+
+    AudioFileWriter writer;
+    ASSERT_TRUE(writer.open(path.c_str(), WAV_FLOAT, 48000, 2));
+    // Written in two parts, so the sizes have to come from the header patched on close
+    ASSERT_TRUE(writer.write(samples.data(), 100));
+    ASSERT_TRUE(writer.write(samples.data() + 200, 200));
+    EXPECT_EQ(writer.getFramesWritten(), 300u);
+    writer.close();
+
+    auto bytes = readFile(path);
+    uint32_t dataSize = 300 * 2 * sizeof(float);
+    ASSERT_EQ(bytes.size(), 44 + dataSize);
+
+    EXPECT_EQ(readTag(bytes, 0), "RIFF");
+    EXPECT_EQ(readUint32(bytes, 4), 36 + dataSize);
+    EXPECT_EQ(readTag(bytes, 8), "WAVE");
+    EXPECT_EQ(readTag(bytes, 12), "fmt ");
+    EXPECT_EQ(readUint32(bytes, 16), 16u);
+    EXPECT_EQ(readUint16(bytes, 20), 3); // WAVE_FORMAT_IEEE_FLOAT
+    EXPECT_EQ(readUint16(bytes, 22), 2);
+    EXPECT_EQ(readUint32(bytes, 24), 48000u);
+    EXPECT_EQ(readUint32(bytes, 28), 48000u * 8);
+    EXPECT_EQ(readUint16(bytes, 32), 8);
+    EXPECT_EQ(readUint16(bytes, 34), 32);
+    EXPECT_EQ(readTag(bytes, 36), "data");
+    EXPECT_EQ(readUint32(bytes, 40), dataSize);
+    EXPECT_EQ(memcmp(bytes.data() + 44, samples.data(), dataSize), 0);
+
+    remove(path.c_str());
+}
+
+TEST(AudioFileWriterTest, RawFloatIsJustTheSamples) {
+    auto path = ::testing::TempDir() + "audio_file_writer_test.raw";
+    auto samples = makeFrames(256, 1);
+
+    AudioFileWriter writer;
+    ASSERT_TRUE(writer.open(path.c_str(), RAW_FLOAT, 44100, 1));
+    ASSERT_TRUE(writer.write(samples.data(), 256));
+    writer.close();
+
+    auto bytes = readFile(path);
+    ASSERT_EQ(bytes.size(), samples.size() * sizeof(float));
+    EXPECT_EQ(memcmp(bytes.data(), samples.data(), bytes.size()), 0);
+
+    remove(path.c_str());
+}
+
+TEST(AudioFileWriterTest, FailsWithoutAFile) {
+    AudioFileWriter writer;
+    float sample = 0.0f;
+
+    EXPECT_FALSE(writer.write(&sample, 1));
+    EXPECT_FALSE(writer.open((::testing::TempDir() + "missing_dir/out.wav").c_str(), WAV_FLOAT, 44100, 1));
+    EXPECT_FALSE(writer.write(&sample, 1));
+}
+
+TEST(AudioFileWriterTest, KnowsItsFormats) {
+    EXPECT_TRUE(isAudioFileFormat(WAV_FLOAT));
+    EXPECT_TRUE(isAudioFileFormat(RAW_FLOAT));
+    EXPECT_FALSE(isAudioFileFormat(2));
+    EXPECT_FALSE(isAudioFileFormat(-1));
+}
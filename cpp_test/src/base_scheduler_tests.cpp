@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+#include "StubScheduler.h"
+
+static constexpr uint32_t kBlockFrames = 512;
+
+// Appends a run as Dart packs it: an int32 track index, a uint32 events count, then the events.
+static void appendRun(std::vector<uint8_t>& data, track_index_t trackIndex, uint32_t eventsCount, const std::vector<SchedulerEvent>& events) {
+    auto offset = data.size();
+    data.resize(offset + sizeof(int32_t) + sizeof(uint32_t) + events.size() * sizeof(SchedulerEvent));
+
+    memcpy(data.data() + offset, &trackIndex, sizeof(int32_t));
+    memcpy(data.data() + offset + sizeof(int32_t), &eventsCount, sizeof(uint32_t));
+    if (!events.empty()) {
+        memcpy(data.data() + offset + sizeof(int32_t) + sizeof(uint32_t), events.data(), events.size() * sizeof(SchedulerEvent));
+    }
+}
+
+static void appendRun(std::vector<uint8_t>& data, track_index_t trackIndex, const std::vector<SchedulerEvent>& events) {
+    appendRun(data, trackIndex, static_cast<uint32_t>(events.size()), events);
+}
+
+static std::vector<uint8_t> getNotes(const StubScheduler& scheduler, track_index_t trackIndex) {
+    std::vector<uint8_t> notes;
+
+    for (auto& handled : scheduler.mHandledEvents) {
+        if (handled.trackIndex == trackIndex) notes.push_back(handled.event.data[1]);
+    }
+
+    return notes;
+}
+
+TEST(ScheduleEventsMultiTest, SchedulesEachRunOnItsTrack) {
+    StubScheduler scheduler;
+    auto track0 = scheduler.addTrack();
+    auto track1 = scheduler.addTrack();
+
+    std::vector<uint8_t> data;
+    appendRun(data, track0, { makeNoteOn(10, 60), makeNoteOn(20, 61) });
+    appendRun(data, track1, { makeNoteOn(5, 70), makeNoteOn(15, 71), makeNoteOn(25, 72) });
+
+    uint32_t acceptedCounts[2];
+    EXPECT_EQ(scheduler.scheduleEventsMulti(data.data(), static_cast<uint32_t>(data.size()), 2, acceptedCounts), 5u);
+    EXPECT_EQ(acceptedCounts[0], 2u);
+    EXPECT_EQ(acceptedCounts[1], 3u);
+
+    scheduler.play();
+    scheduler.renderBlock({ track0, track1 }, kBlockFrames);
+
+    EXPECT_EQ(getNotes(scheduler, track0), std::vector<uint8_t>({ 60, 61 }));
+    EXPECT_EQ(getNotes(scheduler, track1), std::vector<uint8_t>({ 70, 71, 72 }));
+    EXPECT_EQ(scheduler.mHandledEvents[0].offsetFrame, 10u);
+}
+
+TEST(ScheduleEventsMultiTest, SkipsRunsForStaleOrUnknownTracks) {
+    StubScheduler scheduler;
+    auto removedTrack = scheduler.addTrack();
+    scheduler.removeTrack(removedTrack);
+    auto track = scheduler.addTrack();
+
+    // The new track reuses the removed track's slot, under a new id
+    ASSERT_EQ(trackSlot(track), trackSlot(removedTrack));
+
+    std::vector<uint8_t> data;
+    appendRun(data, removedTrack, { makeNoteOn(10, 40) });
+    appendRun(data, 99, { makeNoteOn(10, 41), makeNoteOn(11, 42) });
+    appendRun(data, track, { makeNoteOn(10, 60) });
+
+    uint32_t acceptedCounts[3];
+    EXPECT_EQ(scheduler.scheduleEventsMulti(data.data(), static_cast<uint32_t>(data.size()), 3, acceptedCounts), 1u);
+    EXPECT_EQ(acceptedCounts[0], 0u);
+    EXPECT_EQ(acceptedCounts[1], 0u);
+    EXPECT_EQ(acceptedCounts[2], 1u);
+
+    scheduler.play();
+    scheduler.renderBlock({ track }, kBlockFrames);
+
+    EXPECT_EQ(getNotes(scheduler, track), std::vector<uint8_t>({ 60 }));
+}
+
+TEST(ScheduleEventsMultiTest, StopsAtTheEndOfTruncatedInput) {
+    StubScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    // Claims four events but only holds two, and the next run's header is cut short
+    std::vector<uint8_t> data;
+    appendRun(data, track, 4, { makeNoteOn(10, 60), makeNoteOn(20, 61) });
+    data.resize(data.size() + sizeof(int32_t));
+
+    uint32_t acceptedCounts[3] = { 99, 99, 99 };
+    EXPECT_EQ(scheduler.scheduleEventsMulti(data.data(), static_cast<uint32_t>(data.size()), 3, acceptedCounts), 2u);
+    EXPECT_EQ(acceptedCounts[0], 2u);
+    EXPECT_EQ(acceptedCounts[1], 0u);
+    EXPECT_EQ(acceptedCounts[2], 0u);
+
+    // A run cut off partway through an event only takes the whole events
+    std::vector<uint8_t> partial;
+    appendRun(partial, track, { makeNoteOn(30, 62), makeNoteOn(40, 63) });
+    partial.resize(partial.size() - 1);
+
+    EXPECT_EQ(scheduler.scheduleEventsMulti(partial.data(), static_cast<uint32_t>(partial.size()), 1, acceptedCounts), 1u);
+    EXPECT_EQ(acceptedCounts[0], 1u);
+
+    scheduler.play();
+    scheduler.renderBlock({ track }, kBlockFrames);
+
+    EXPECT_EQ(getNotes(scheduler, track), std::vector<uint8_t>({ 60, 61, 62 }));
+}
+
+TEST(ScheduleEventsMultiTest, AcceptsWhatFitsInAPartlyFullRing) {
+    StubScheduler scheduler;
+    auto fullTrack = scheduler.addTrack();
+    auto emptyTrack = scheduler.addTrack();
+
+    std::vector<SchedulerEvent> filler(Buffer<>::kCapacity - 3, makeNoteOn(1000, 1));
+    ASSERT_EQ(scheduler.scheduleEvents(fullTrack, filler.data(), static_cast<uint32_t>(filler.size())), filler.size());
+
+    std::vector<SchedulerEvent> events;
+    for (uint8_t i = 0; i < 5; i++) {
+        events.push_back(makeNoteOn(2000 + i, 60 + i));
+    }
+
+    std::vector<uint8_t> data;
+    appendRun(data, fullTrack, events);
+    appendRun(data, emptyTrack, events);
+
+    uint32_t acceptedCounts[2];
+    EXPECT_EQ(scheduler.scheduleEventsMulti(data.data(), static_cast<uint32_t>(data.size()), 2, acceptedCounts), 8u);
+    EXPECT_EQ(acceptedCounts[0], 3u);
+    EXPECT_EQ(acceptedCounts[1], 5u);
+    EXPECT_EQ(scheduler.getBufferAvailableCount(fullTrack), 0u);
+}
+
+struct PlayedNote {
+    position_frame_t frame;
+    uint8_t noteNumber;
+
+    bool operator==(const PlayedNote& other) const {
+        return frame == other.frame && noteNumber == other.noteNumber;
+    }
+};
+
+static std::ostream& operator<<(std::ostream& stream, const PlayedNote& note) {
+    return stream << "{" << note.frame << ", " << static_cast<int>(note.noteNumber) << "}";
+}
+
+// Renders blocks of one track, and returns the absolute frame of every event it handled. Checks
+// that each block's rendered ranges cover it without gaps or overlaps.
+static std::vector<PlayedNote> renderBlocks(StubScheduler& scheduler, track_index_t trackIndex, uint32_t blockFrames, int32_t blocksCount) {
+    std::vector<PlayedNote> notes;
+
+    for (int32_t block = 0; block < blocksCount; block++) {
+        auto firstEvent = scheduler.mHandledEvents.size();
+        scheduler.mRenderedRanges.clear();
+        auto startFrame = scheduler.renderBlock({ trackIndex }, blockFrames);
+
+        for (auto i = firstEvent; i < scheduler.mHandledEvents.size(); i++) {
+            auto& handled = scheduler.mHandledEvents[i];
+            notes.push_back({ startFrame + handled.offsetFrame, handled.event.data[1] });
+        }
+
+        uint32_t nextOffset = 0;
+        for (auto& range : scheduler.mRenderedRanges) {
+            EXPECT_EQ(range.offsetFrame, nextOffset);
+            nextOffset = range.offsetFrame + range.numFrames;
+        }
+        EXPECT_EQ(nextOffset, blockFrames);
+    }
+
+    return notes;
+}
+
+TEST(TrackLoopPlaybackTest, WrapsInsideABlock) {
+    StubScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    // Frames relative to the loop start, so it plays on 100, 250, 300, 450, 500...
+    SchedulerEvent loopEvents[] = { makeNoteOn(0, 60), makeNoteOn(150, 61) };
+    ASSERT_EQ(scheduler.setTrackLoop(track, 100, 200, loopEvents, 2), 2u);
+
+    scheduler.play();
+    auto notes = renderBlocks(scheduler, track, 128, 4);
+
+    EXPECT_EQ(notes, std::vector<PlayedNote>({ { 100, 60 }, { 250, 61 }, { 300, 60 }, { 450, 61 }, { 500, 60 } }));
+    EXPECT_EQ(scheduler.getPosition(), 512u);
+}
+
+TEST(TrackLoopPlaybackTest, MergesBufferStoreAndLoopAcrossBlocks) {
+    StubScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    // The events at 40 land exactly on the second block's first frame, one from each source
+    SchedulerEvent bufferEvents[] = { makeNoteOn(10, 1), makeNoteOn(40, 2) };
+    SchedulerEvent storeEvents[] = { makeNoteOn(40, 12), makeNoteOn(30, 11) };
+    SchedulerEvent loopEvents[] = { makeNoteOn(40, 21), makeNoteOn(70, 22) };
+    event_id_t ids[2];
+
+    ASSERT_EQ(scheduler.scheduleEvents(track, bufferEvents, 2), 2u);
+    ASSERT_EQ(scheduler.insertEvents(track, storeEvents, 2, ids), 2u);
+    ASSERT_EQ(scheduler.setTrackLoop(track, 0, 1000, loopEvents, 2), 2u);
+
+    scheduler.play();
+    auto notes = renderBlocks(scheduler, track, 40, 2);
+
+    // On a tie the buffer goes first, then the store, then the loop
+    EXPECT_EQ(notes, std::vector<PlayedNote>({ { 10, 1 }, { 30, 11 }, { 40, 2 }, { 40, 12 }, { 40, 21 }, { 70, 22 } }));
+}
+
+TEST(TrackLoopPlaybackTest, StartsPartwayThroughALoopSetLate) {
+    StubScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    scheduler.play();
+    renderBlocks(scheduler, track, 100, 3);
+
+    // Set at 300, partway through the second iteration of a loop that started at 0. Nothing from
+    // before 300 plays, and the iteration carries on from there.
+    SchedulerEvent loopEvents[] = { makeNoteOn(50, 60), makeNoteOn(220, 61) };
+    ASSERT_EQ(scheduler.setTrackLoop(track, 0, 250, loopEvents, 2), 2u);
+
+    auto notes = renderBlocks(scheduler, track, 100, 3);
+
+    EXPECT_EQ(notes, std::vector<PlayedNote>({ { 300, 60 }, { 470, 61 }, { 550, 60 } }));
+}
@@ -23,6 +23,7 @@ buffer_index_t addNEvents(SmallBuffer* buffer, buffer_index_t n, u_int8_t type,
         events[i] = {
             .frame = static_cast<u_int32_t>(i * 10 + frameOffset),
             .type = type,
+            .data = {},
         };
     }
 
@@ -116,3 +117,48 @@ TEST_F(BufferTest, ClearAfter) {
     buffer.clearAfter(0);
     EXPECT_EQ(buffer.count(), 0);
 }
+
+TEST_F(BufferTest, AddRawWrapsAround) {
+    auto buffer = new SmallBuffer();
+    SchedulerEvent events[BUFFER_SIZE];
+
+    for (uint32_t i = 0; i < BUFFER_SIZE; i++) {
+        events[i] = { .frame = i, .type = MIDI_EVENT, .data = {} };
+    }
+
+    // Move the read and write positions so the next add wraps past the end of the ring
+    addNEvents(buffer, 100, MIDI_EVENT, 0);
+    for (int i = 0; i < 100; i++) buffer->removeTop();
+
+    EXPECT_EQ(buffer->addRaw(reinterpret_cast<const uint8_t*>(events), BUFFER_SIZE), BUFFER_SIZE);
+    EXPECT_EQ(buffer->addRaw(reinterpret_cast<const uint8_t*>(events), 1), 0);
+
+    SchedulerEvent event;
+    for (uint32_t i = 0; i < BUFFER_SIZE; i++) {
+        ASSERT_TRUE(buffer->peek(event));
+        EXPECT_EQ(event.frame, i);
+        buffer->removeTop();
+    }
+
+    delete buffer;
+}
+
+TEST_F(BufferTest, ExternalWriterPublishesInPlace) {
+    auto buffer = new SmallBuffer();
+    auto events = buffer->getEvents();
+    buffer_index_t writePosition = buffer->getWritePosition()->load();
+
+    for (uint32_t i = 0; i < 3; i++) {
+        events[(writePosition + i) % BUFFER_SIZE] = { .frame = 10 * i, .type = MIDI_EVENT, .data = {} };
+    }
+
+    EXPECT_EQ(buffer->count(), 0);
+    buffer->publishWritePosition(writePosition + 3);
+    EXPECT_EQ(buffer->count(), 3);
+
+    SchedulerEvent event;
+    ASSERT_TRUE(buffer->peek(event));
+    EXPECT_EQ(event.frame, 0);
+
+    delete buffer;
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "ChannelKernel.h"
+
+TEST(ChannelKernelTest, Interleaves) {
+    // Odd lengths exercise the scalar tail after the vector loop
+    for (int32_t numFrames : { 1, 3, 4, 9, 64 }) {
+        std::vector<float> left(numFrames), right(numFrames);
+        std::vector<float> output(numFrames * 2, -1.0f);
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            left[frame] = frame;
+            right[frame] = -frame - 0.5f;
+        }
+
+        ChannelKernel::interleave(left.data(), right.data(), output.data(), numFrames);
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            EXPECT_EQ(output[frame * 2], left[frame]) << "frame " << frame;
+            EXPECT_EQ(output[frame * 2 + 1], right[frame]) << "frame " << frame;
+        }
+    }
+}
+
+TEST(ChannelKernelTest, DownmixesInPlace) {
+    for (int32_t numFrames : { 1, 3, 4, 9, 64 }) {
+        std::vector<float> left(numFrames), right(numFrames);
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            left[frame] = frame * 0.25f;
+            right[frame] = 1.0f - frame;
+        }
+
+        auto expectedRight = right;
+        ChannelKernel::downmix(left.data(), right.data(), left.data(), numFrames);
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            EXPECT_FLOAT_EQ(left[frame], (frame * 0.25f + expectedRight[frame]) * 0.5f) << "frame " << frame;
+            EXPECT_EQ(right[frame], expectedRight[frame]);
+        }
+    }
+}
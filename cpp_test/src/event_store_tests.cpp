@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "EventStore.h"
+
+static SchedulerEvent makeEvent(position_frame_t frame, uint8_t noteNumber) {
+    SchedulerEvent event = {};
+    event.frame = frame;
+    event.type = MIDI_EVENT;
+    event.data[1] = noteNumber;
+    return event;
+}
+
+static std::vector<uint8_t> readNotes(EventStore& store, position_frame_t fromTime, position_frame_t toTime) {
+    std::vector<uint8_t> notes;
+    SchedulerEvent event;
+
+    store.beginRead(fromTime);
+    while (store.peek(event) && event.frame < toTime) {
+        notes.push_back(event.data[1]);
+        store.removeTop();
+    }
+    store.endRead();
+
+    return notes;
+}
+
+TEST(EventStoreTest, KeepsEventsSortedWhateverTheInsertOrder) {
+    EventStore store;
+    SchedulerEvent events[] = { makeEvent(300, 3), makeEvent(100, 1), makeEvent(200, 2), makeEvent(100, 4) };
+    event_id_t ids[4];
+
+    store.insert(events, 4, ids);
+
+    EXPECT_EQ(store.count(), 4);
+    EXPECT_NE(ids[1], ids[3]);
+    // Events on the same time keep the order they were added in
+    EXPECT_EQ(readNotes(store, 0, 1000), std::vector<uint8_t>({ 1, 4, 2, 3 }));
+}
+
+TEST(EventStoreTest, RemovesByIdAndErasesRanges) {
+    EventStore store;
+    std::vector<SchedulerEvent> events;
+    std::vector<event_id_t> ids(10);
+
+    for (uint8_t i = 0; i < 10; i++) {
+        events.push_back(makeEvent(i * 100, i));
+    }
+    store.insert(events.data(), 10, ids.data());
+
+    event_id_t toRemove[] = { ids[2], ids[7], 12345 };
+    EXPECT_EQ(store.remove(toRemove, 3), 2);
+    EXPECT_EQ(store.remove(toRemove, 1), 0);
+
+    EXPECT_EQ(store.erase(400, 600), 2);
+    EXPECT_EQ(store.count(), 6);
+    EXPECT_EQ(readNotes(store, 0, 1000), std::vector<uint8_t>({ 0, 1, 3, 6, 8, 9 }));
+
+    store.clear();
+    EXPECT_EQ(store.count(), 0);
+}
+
+TEST(EventStoreTest, ReadsEachEventOnceAcrossEdits) {
+    EventStore store;
+    SchedulerEvent events[] = { makeEvent(100, 1), makeEvent(200, 2), makeEvent(300, 3) };
+    store.insert(events, 3, nullptr);
+
+    EXPECT_EQ(readNotes(store, 0, 250), std::vector<uint8_t>({ 1, 2 }));
+
+    // An event added before the read position has already been passed, one after it hasn't
+    SchedulerEvent lateEvents[] = { makeEvent(150, 4), makeEvent(250, 5) };
+    store.insert(lateEvents, 2, nullptr);
+
+    EXPECT_EQ(readNotes(store, 0, 1000), std::vector<uint8_t>({ 5, 3 }));
+
+    store.resetReadPosition();
+    EXPECT_EQ(readNotes(store, 200, 1000), std::vector<uint8_t>({ 2, 5, 3 }));
+}
+
+TEST(EventStoreTest, ReaderSeesConsistentVersionsWhileEditing) {
+    EventStore store;
+    std::atomic<bool> isDone { false };
+    std::atomic<int32_t> badReads { 0 };
+
+    // Every version holds whole pairs of events, so a reader must always see an even count
+    std::thread reader([&]() {
+        while (!isDone.load()) {
+            store.resetReadPosition();
+            store.beginRead(0);
+
+            SchedulerEvent event;
+            int32_t count = 0;
+            position_frame_t lastFrame = 0;
+
+            while (store.peek(event)) {
+                if (event.frame < lastFrame) badReads++;
+                lastFrame = event.frame;
+                count++;
+                store.removeTop();
+            }
+            store.endRead();
+
+            if (count % 2 != 0) badReads++;
+        }
+    });
+
+    std::vector<event_id_t> ids;
+    for (uint32_t i = 0; i < 2000; i++) {
+        SchedulerEvent pair[] = { makeEvent((i * 7919) % 10000, 1), makeEvent((i * 7919) % 10000 + 5, 2) };
+        event_id_t pairIds[2];
+        store.insert(pair, 2, pairIds);
+        ids.push_back(pairIds[0]);
+        ids.push_back(pairIds[1]);
+
+        if (i > 0 && i % 3 == 0) {
+            store.remove(&ids[ids.size() - 4], 2);
+        }
+    }
+
+    isDone.store(true);
+    reader.join();
+
+    EXPECT_EQ(badReads.load(), 0);
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <future>
+#include <mutex>
+#include <vector>
+#include "InstrumentLoader.h"
+
+TEST(InstrumentLoaderTest, LoadsHighestPriorityFirst) {
+    InstrumentLoader loader(1);
+    std::promise<void> gate;
+    auto gateFuture = gate.get_future().share();
+    std::mutex mutex;
+    std::vector<uint32_t> order;
+    std::vector<int32_t> results(5, -2);
+
+    // Holds the only worker so the rest queue up behind it.
+    loader.enqueue(0, 0, [gateFuture](const std::atomic<bool>&) { gateFuture.wait(); return 0; },
+                   [&](int32_t trackIndex) { results[0] = trackIndex; });
+
+    int32_t priorities[] = { 0, 5, 5, 1 };
+    for (uint32_t loadId = 1; loadId <= 4; loadId++) {
+        loader.enqueue(loadId, priorities[loadId - 1], [&, loadId](const std::atomic<bool>&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(loadId);
+            return static_cast<int32_t>(loadId * 10);
+        }, [&, loadId](int32_t trackIndex) { results[loadId] = trackIndex; });
+    }
+
+    EXPECT_TRUE(loader.setPriority(4, 10));
+    EXPECT_FALSE(loader.setPriority(99, 10));
+
+    gate.set_value();
+    while (loader.getPendingCount() > 0) {
+        std::this_thread::yield();
+    }
+
+    EXPECT_EQ(order, std::vector<uint32_t>({ 4, 2, 3, 1 }));
+    EXPECT_EQ(results, std::vector<int32_t>({ 0, 10, 20, 30, 40 }));
+}
+
+TEST(InstrumentLoaderTest, CancelsQueuedAndRunningLoads) {
+    InstrumentLoader loader(1);
+    std::promise<void> started;
+    std::atomic<bool> isReleased { false };
+    std::atomic<int32_t> runningResult { -2 };
+    std::atomic<int32_t> queuedResult { -2 };
+    std::atomic<bool> didRunQueued { false };
+    std::mutex mutex;
+    std::vector<LoadReport> reports;
+
+    loader.setReportFunction([&](const LoadReport& report) {
+        std::lock_guard<std::mutex> lock(mutex);
+        reports.push_back(report);
+    });
+
+    loader.enqueue(1, 0, [&](const std::atomic<bool>& isCancelled) {
+        started.set_value();
+        while (!isReleased.load()) {
+            std::this_thread::yield();
+        }
+        // A real load would delete its instrument here instead of adding a track
+        return isCancelled.load() ? -1 : 7;
+    }, [&](int32_t trackIndex) { runningResult.store(trackIndex); });
+
+    loader.enqueue(2, 0, [&](const std::atomic<bool>&) { didRunQueued.store(true); return 8; },
+                   [&](int32_t trackIndex) { queuedResult.store(trackIndex); });
+
+    started.get_future().wait();
+
+    EXPECT_TRUE(loader.cancel(2));
+    EXPECT_EQ(queuedResult.load(), -1);
+    EXPECT_TRUE(loader.cancel(1));
+    EXPECT_FALSE(loader.cancel(3));
+
+    isReleased.store(true);
+    // Two queued, one started and two cancelled
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (reports.size() == 5) break;
+        }
+        std::this_thread::yield();
+    }
+
+    EXPECT_EQ(runningResult.load(), -1);
+    EXPECT_FALSE(didRunQueued.load());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    int32_t cancelledCount = 0;
+    for (auto& report : reports) {
+        if (report.state == LOAD_CANCELLED) cancelledCount++;
+        EXPECT_NE(report.state, LOAD_FINISHED);
+    }
+    EXPECT_EQ(cancelledCount, 2);
+    EXPECT_EQ(reports.back().pendingCount, 0);
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "MixKernel.h"
+
+static void expectMatchesScalar(int32_t channelCount, int32_t numFrames) {
+    auto numSamples = numFrames * channelCount;
+    std::vector<float> input(numSamples);
+    std::vector<float> expected(numSamples, 0.25f);
+    std::vector<float> actual(numSamples, 0.25f);
+    float startGains[2] = { 0.0f, 1.0f };
+    float endGains[2] = { 1.0f, 0.5f };
+
+    for (int32_t i = 0; i < numSamples; i++) {
+        input[i] = std::sin(i * 0.1f);
+    }
+
+    MixKernel::mixScalar(expected.data(), input.data(), numFrames, channelCount, startGains, endGains);
+    MixKernel::mixTrack(actual.data(), input.data(), numFrames, channelCount, startGains, endGains);
+
+    for (int32_t i = 0; i < numSamples; i++) {
+        EXPECT_NEAR(actual[i], expected[i], 1e-5f) << "channels " << channelCount << ", sample " << i;
+    }
+}
+
+TEST(MixKernelTest, MatchesScalarMix) {
+    // Odd lengths exercise the scalar tail after the vector loop
+    for (int32_t numFrames : { 1, 3, 7, 64, 191 }) {
+        expectMatchesScalar(1, numFrames);
+        expectMatchesScalar(2, numFrames);
+    }
+}
+
+TEST(MixKernelTest, RampsFromStartGain) {
+    std::vector<float> input(8, 1.0f);
+    std::vector<float> output(8, 0.0f);
+    float startGains[1] = { 0.0f };
+    float endGains[1] = { 1.0f };
+
+    MixKernel::mixTrack(output.data(), input.data(), 8, 1, startGains, endGains);
+
+    for (int32_t frame = 0; frame < 8; frame++) {
+        EXPECT_FLOAT_EQ(output[frame], frame / 8.0f);
+    }
+}
+
+TEST(MixKernelTest, PanIsConstantPower) {
+    float left, right;
+
+    MixKernel::panGains(0.0f, left, right);
+    EXPECT_NEAR(left, 1.0f, 1e-6f);
+    EXPECT_NEAR(right, 1.0f, 1e-6f);
+
+    for (float pan : { -1.0f, -0.5f, 0.3f, 1.0f }) {
+        MixKernel::panGains(pan, left, right);
+        EXPECT_NEAR(left * left + right * right, 2.0f, 1e-5f);
+    }
+
+    MixKernel::panGains(-1.0f, left, right);
+    EXPECT_NEAR(right, 0.0f, 1e-6f);
+}
+
+TEST(MixKernelTest, MeteredMixMatchesScalarLevels) {
+    for (int32_t channelCount : { 1, 2, 3 }) {
+        for (int32_t numFrames : { 5, 64, 191 }) {
+            auto numSamples = numFrames * channelCount;
+            std::vector<float> input(numSamples);
+            std::vector<float> expected(numSamples, 0.0f);
+            std::vector<float> actual(numSamples, 0.0f);
+            float startGains[3] = { 0.5f, 1.0f, 0.25f };
+            float endGains[3] = { 1.0f, 0.5f, 0.75f };
+            MixKernel::Levels expectedLevels = {};
+            MixKernel::Levels actualLevels = {};
+
+            for (int32_t i = 0; i < numSamples; i++) {
+                input[i] = std::sin(i * 0.37f) * (i % 7 == 0 ? -1.5f : 1.0f);
+            }
+
+            MixKernel::mixScalar(expected.data(), input.data(), numFrames, channelCount, startGains, endGains, &expectedLevels);
+            MixKernel::mixTrack(actual.data(), input.data(), numFrames, channelCount, startGains, endGains, &actualLevels);
+
+            for (int32_t channel = 0; channel < channelCount; channel++) {
+                EXPECT_NEAR(actualLevels.peaks[channel], expectedLevels.peaks[channel], 1e-5f);
+                EXPECT_NEAR(actualLevels.sumSquares[channel], expectedLevels.sumSquares[channel], 1e-3f);
+            }
+        }
+    }
+}
+
+TEST(MixKernelTest, MeasuresEachChannel) {
+    // A full-scale square wave on the left and half-scale DC on the right
+    std::vector<float> samples;
+    for (int32_t frame = 0; frame < 100; frame++) {
+        samples.push_back(frame % 2 == 0 ? 1.0f : -1.0f);
+        samples.push_back(0.5f);
+    }
+
+    MixKernel::Levels levels = {};
+    MixKernel::measure(samples.data(), 100, 2, levels);
+
+    EXPECT_FLOAT_EQ(levels.peaks[0], 1.0f);
+    EXPECT_FLOAT_EQ(levels.peaks[1], 0.5f);
+    EXPECT_NEAR(std::sqrt(levels.sumSquares[0] / 100), 1.0f, 1e-6f);
+    EXPECT_NEAR(std::sqrt(levels.sumSquares[1] / 100), 0.5f, 1e-6f);
+}
+
+TEST(MixKernelTest, PlanarMixMatchesScalarMix) {
+    for (int32_t channelCount : { 1, 2, 3 }) {
+        for (int32_t numFrames : { 1, 3, 7, 64, 191 }) {
+            std::vector<std::vector<float>> channels(channelCount, std::vector<float>(numFrames));
+            const float* inputs[3];
+            std::vector<float> expected(numFrames * channelCount, 0.25f);
+            std::vector<float> actual(numFrames * channelCount, 0.25f);
+            float startGains[3] = { 0.0f, 1.0f, 0.5f };
+            float endGains[3] = { 1.0f, 0.5f, 0.25f };
+            MixKernel::Levels expectedLevels = {};
+            MixKernel::Levels actualLevels = {};
+
+            for (int32_t channel = 0; channel < channelCount; channel++) {
+                for (int32_t frame = 0; frame < numFrames; frame++) {
+                    channels[channel][frame] = std::sin((frame * channelCount + channel) * 0.37f);
+                }
+                inputs[channel] = channels[channel].data();
+            }
+
+            MixKernel::mixPlanarScalar(expected.data(), inputs, numFrames, channelCount, startGains, endGains, &expectedLevels);
+            MixKernel::mixPlanarTrack(actual.data(), inputs, numFrames, channelCount, startGains, endGains, &actualLevels);
+
+            for (int32_t i = 0; i < numFrames * channelCount; i++) {
+                EXPECT_NEAR(actual[i], expected[i], 1e-5f) << "channels " << channelCount << ", sample " << i;
+            }
+            for (int32_t channel = 0; channel < channelCount; channel++) {
+                EXPECT_NEAR(actualLevels.peaks[channel], expectedLevels.peaks[channel], 1e-5f);
+                EXPECT_NEAR(actualLevels.sumSquares[channel], expectedLevels.sumSquares[channel], 1e-3f);
+            }
+        }
+    }
+}
+
+TEST(MixKernelTest, PlanarMixMatchesInterleavedMix) {
+    constexpr int32_t numFrames = 67;
+    std::vector<float> left(numFrames), right(numFrames), interleaved(numFrames * 2);
+    const float* inputs[2] = { left.data(), right.data() };
+    std::vector<float> fromPlanar(numFrames * 2, 0.0f);
+    std::vector<float> fromInterleaved(numFrames * 2, 0.0f);
+    float startGains[2] = { 0.2f, 0.9f };
+    float endGains[2] = { 0.7f, 0.4f };
+
+    for (int32_t frame = 0; frame < numFrames; frame++) {
+        left[frame] = std::sin(frame * 0.1f);
+        right[frame] = std::cos(frame * 0.3f);
+        interleaved[frame * 2] = left[frame];
+        interleaved[frame * 2 + 1] = right[frame];
+    }
+
+    MixKernel::mixPlanarTrack(fromPlanar.data(), inputs, numFrames, 2, startGains, endGains);
+    MixKernel::mixTrack(fromInterleaved.data(), interleaved.data(), numFrames, 2, startGains, endGains);
+
+    for (int32_t i = 0; i < numFrames * 2; i++) {
+        EXPECT_NEAR(fromPlanar[i], fromInterleaved[i], 1e-5f) << "sample " << i;
+    }
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "Mixer.h"
+#include "StubInstrument.h"
+#include "StubScheduler.h"
+
+static constexpr int32_t kSampleRate = 48000;
+
+static void expectAllEqual(const std::vector<float>& output, float value) {
+    for (size_t i = 0; i < output.size(); i++) {
+        ASSERT_FLOAT_EQ(output[i], value) << "at sample " << i;
+    }
+}
+
+TEST(MixerTest, TrackAddedToARemovedTracksSlotIsNotRenderedUnderTheOldId) {
+    Mixer mixer;
+    mixer.setSampleRate(kSampleRate);
+    mixer.setSubBlockFrames(256);
+
+    StubInstrument first(1.0f);
+    StubInstrument removed(2.0f);
+    StubInstrument replacement(4.0f);
+    auto firstTrack = mixer.addTrack(&first);
+    auto removedTrack = mixer.addTrack(&removed);
+    track_index_t replacementTrack = -1;
+
+    // Swaps the second track out while the first renders, after the callback has set up its jobs
+    first.mOnRender = [&]() {
+        mixer.removeTrack(removedTrack);
+        replacementTrack = mixer.addTrack(&replacement);
+    };
+
+    mixer.play();
+
+    // Two sub-blocks: the first finds the slot taken mid-render, the second starts without the job
+    std::vector<float> output(512);
+    mixer.renderAudio(output.data(), 512);
+
+    ASSERT_EQ(trackSlot(replacementTrack), trackSlot(removedTrack));
+    EXPECT_NE(replacementTrack, removedTrack);
+    EXPECT_EQ(first.mFramesRendered, 512u);
+    EXPECT_EQ(removed.mFramesRendered, 0u);
+    EXPECT_EQ(replacement.mFramesRendered, 0u);
+    expectAllEqual(output, 1.0f);
+
+    // From the next callback it renders as its own track
+    mixer.renderAudio(output.data(), 512);
+
+    EXPECT_EQ(replacement.mFramesRendered, 512u);
+    EXPECT_EQ(removed.mFramesRendered, 0u);
+    expectAllEqual(output, 5.0f);
+    EXPECT_TRUE(mixer.getTrack(firstTrack).has_value());
+    EXPECT_FALSE(mixer.getTrack(removedTrack).has_value());
+}
+
+TEST(MixerTest, SplitsCallbacksIntoSubBlocksWithSampleAccurateEvents) {
+    Mixer mixer;
+    mixer.setSampleRate(kSampleRate);
+    mixer.setSubBlockFrames(64);
+
+    StubInstrument instrument;
+    auto trackIndex = mixer.addTrack(&instrument);
+    // One inside the second sub-block, and one just after the start of the third
+    SchedulerEvent events[] = { makeNoteOn(100, 60), makeNoteOn(130, 62) };
+    ASSERT_EQ(mixer.scheduleEvents(trackIndex, events, 2), 2u);
+
+    mixer.play();
+
+    std::vector<float> output(200);
+    mixer.renderAudio(output.data(), 200);
+
+    // Each sub-block is split again at its events
+    EXPECT_EQ(instrument.mRenderCalls, std::vector<int32_t>({ 64, 36, 28, 2, 62, 8 }));
+    ASSERT_EQ(instrument.mMidiEvents.size(), 2u);
+    EXPECT_EQ(instrument.mMidiEvents[0].frame, 100u);
+    EXPECT_EQ(instrument.mMidiEvents[0].data1, 60);
+    EXPECT_EQ(instrument.mMidiEvents[1].frame, 130u);
+    EXPECT_EQ(instrument.mMidiEvents[1].data1, 62);
+    EXPECT_EQ(mixer.getPosition(), 200u);
+    EXPECT_EQ(mixer.getRenderStats().getSubBlockStats().lastCount, 4u);
+    expectAllEqual(output, 1.0f);
+}
+
+TEST(MixerTest, RendersCallbacksLargerThanTheTrackBuffers) {
+    Mixer mixer;
+    mixer.setSampleRate(kSampleRate);
+    mixer.setChannelCount(2);
+
+    StubInstrument instrument(0.5f);
+    instrument.setOutputFormat(kSampleRate, true);
+    mixer.addTrack(&instrument);
+    mixer.play();
+
+    // Far more than a track buffer holds
+    const int32_t numFrames = kBufferSize * 3 + 17;
+    std::vector<float> output(numFrames * 2);
+    mixer.renderAudio(output.data(), numFrames);
+
+    EXPECT_EQ(instrument.mFramesRendered, static_cast<uint64_t>(numFrames));
+    for (auto renderFrames : instrument.mRenderCalls) {
+        EXPECT_LE(renderFrames, mixer.getSubBlockFrames());
+    }
+    EXPECT_EQ(mixer.getPosition(), static_cast<position_frame_t>(numFrames));
+
+    // Every frame is mixed, through to the last sub-block
+    auto firstSample = output[0];
+    EXPECT_GT(firstSample, 0.0f);
+    for (auto sample : output) {
+        ASSERT_FLOAT_EQ(sample, firstSample);
+    }
+}
+
+TEST(MixerTest, SkipsIdleTracks) {
+    Mixer mixer;
+    mixer.setSampleRate(kSampleRate);
+
+    StubInstrument sounding(1.0f);
+    StubInstrument idle(2.0f);
+    idle.mIsIdle = true;
+    mixer.addTrack(&sounding);
+    mixer.addTrack(&idle);
+    mixer.play();
+
+    std::vector<float> output(128);
+    mixer.renderAudio(output.data(), 128);
+
+    EXPECT_EQ(sounding.mFramesRendered, 128u);
+    EXPECT_TRUE(idle.mRenderCalls.empty());
+    expectAllEqual(output, 1.0f);
+
+    auto skipStats = mixer.getRenderStats().getSkipStats();
+    EXPECT_EQ(skipStats.renderedCount, 1u);
+    EXPECT_EQ(skipStats.skippedCount, 1u);
+    EXPECT_EQ(skipStats.lastSkippedCount, 1u);
+}
+
+TEST(MixerTest, IdleTrackRendersFromTheEventThatWakesIt) {
+    Mixer mixer;
+    mixer.setSampleRate(kSampleRate);
+
+    StubInstrument instrument;
+    instrument.mIsIdle = true;
+    auto trackIndex = mixer.addTrack(&instrument);
+    SchedulerEvent event = makeNoteOn(100, 60);
+    ASSERT_EQ(mixer.scheduleEvents(trackIndex, &event, 1), 1u);
+    mixer.play();
+
+    std::vector<float> output(256);
+    mixer.renderAudio(output.data(), 256);
+
+    // Nothing is rendered before the event, and the frames before it are silent
+    ASSERT_EQ(instrument.mMidiEvents.size(), 1u);
+    EXPECT_EQ(instrument.mMidiEvents[0].frame, 0u);
+    EXPECT_EQ(instrument.mRenderCalls, std::vector<int32_t>({ 156 }));
+    expectAllEqual(std::vector<float>(output.begin(), output.begin() + 100), 0.0f);
+    expectAllEqual(std::vector<float>(output.begin() + 100, output.end()), 1.0f);
+}
+
+TEST(MixerTest, GoesIdleOnceQuietForTheHoldTime) {
+    Mixer mixer;
+    mixer.setSampleRate(kSampleRate);
+
+    StubInstrument instrument;
+    instrument.mIsIdle = true;
+    auto trackIndex = mixer.addTrack(&instrument);
+    mixer.play();
+
+    const int32_t blockFrames = 256;
+    const auto holdFrames = static_cast<int32_t>(kIdleHoldSeconds * kSampleRate);
+    const auto holdBlocks = (holdFrames + blockFrames - 1) / blockFrames;
+    std::vector<float> output(blockFrames);
+
+    for (int32_t block = 0; block < holdBlocks - 1; block++) {
+        mixer.renderAudio(output.data(), blockFrames);
+    }
+    EXPECT_FALSE(mixer.getIsIdle());
+
+    mixer.renderAudio(output.data(), blockFrames);
+    EXPECT_TRUE(mixer.getIsIdle());
+
+    // Idle, the position keeps moving but nothing is asked of the instrument
+    auto idlePosition = mixer.getPosition();
+    mixer.renderAudio(output.data(), blockFrames);
+    EXPECT_TRUE(mixer.getIsIdle());
+    EXPECT_EQ(mixer.getIdleFrames(), static_cast<uint64_t>(blockFrames));
+    EXPECT_EQ(mixer.getPosition(), idlePosition + blockFrames);
+    EXPECT_TRUE(instrument.mRenderCalls.empty());
+    expectAllEqual(output, 0.0f);
+
+    // Scheduling anything wakes it on the next callback
+    SchedulerEvent event = makeNoteOn(mixer.getPosition() + 10, 60);
+    ASSERT_EQ(mixer.scheduleEvents(trackIndex, &event, 1), 1u);
+    EXPECT_FALSE(mixer.getIsIdleUndisturbed());
+
+    mixer.renderAudio(output.data(), blockFrames);
+    EXPECT_FALSE(mixer.getIsIdle());
+    EXPECT_EQ(instrument.mMidiEvents.size(), 1u);
+    EXPECT_EQ(instrument.mRenderCalls, std::vector<int32_t>({ blockFrames - 10 }));
+}
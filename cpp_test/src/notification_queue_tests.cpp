@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "NotificationQueue.h"
+
+TEST(NotificationQueueTest, PopsInOrderAndCountsDrops) {
+    NotificationQueue<4> queue;
+    Notification notification;
+
+    EXPECT_FALSE(queue.pop(notification));
+
+    for (uint32_t i = 0; i < 6; i++) {
+        EXPECT_EQ(queue.push({ NOTIFICATION_MARKER, 3, i * 100, i }), i < 4);
+    }
+
+    EXPECT_EQ(queue.takeDroppedCount(), 2);
+    EXPECT_EQ(queue.takeDroppedCount(), 0);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue.pop(notification));
+        EXPECT_EQ(notification.trackIndex, 3);
+        EXPECT_EQ(notification.frame, i * 100);
+        EXPECT_EQ(notification.value, i);
+    }
+    EXPECT_FALSE(queue.pop(notification));
+}
+
+TEST(NotificationQueueTest, PassesEveryNotificationBetweenThreads) {
+    NotificationQueue<> queue;
+    const uint32_t notificationsCount = 20000;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < notificationsCount; i++) {
+            while (!queue.push({ NOTIFICATION_BUFFER_LOW, 0, i, i })) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t nextValue = 0;
+    int32_t badCount = 0;
+    Notification notification;
+
+    while (nextValue < notificationsCount) {
+        if (!queue.pop(notification)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (notification.value != nextValue || notification.frame != nextValue) badCount++;
+        nextValue++;
+    }
+
+    producer.join();
+
+    EXPECT_EQ(badCount, 0);
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "OfflineEngine.h"
+#include "StubInstrument.h"
+
+static std::vector<float> readRawFloats(const std::string& path) {
+    std::vector<float> samples;
+    auto file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return samples;
+
+    float sample;
+    while (fread(&sample, sizeof(float), 1, file) == 1) {
+        samples.push_back(sample);
+    }
+
+    fclose(file);
+    return samples;
+}
+
+TEST(OfflineEngineTest, RendersEveryFrameToTheFile) {
+    Mixer mixer;
+    StubInstrument instrument(0.25f);
+    mixer.addTrack(&instrument);
+    mixer.play();
+
+    auto path = ::testing::TempDir() + "offline_engine_test.raw";
+    std::atomic<bool> isCancelled { false };
+    OfflineEngine offlineEngine(mixer, 44100);
+    offlineEngine.setBlockSize(300);
+
+    auto result = offlineEngine.render(path.c_str(), RAW_FLOAT, 1000, isCancelled);
+
+    EXPECT_TRUE(result.didSucceed);
+    EXPECT_EQ(result.framesRendered, 1000u);
+    EXPECT_EQ(instrument.mFramesRendered, 1000u);
+    EXPECT_EQ(mixer.getPosition(), 1000u);
+    EXPECT_EQ(mixer.getSampleRate(), 44100);
+
+    auto samples = readRawFloats(path);
+    ASSERT_EQ(samples.size(), 1000u);
+    for (auto sample : samples) {
+        ASSERT_FLOAT_EQ(sample, 0.25f);
+    }
+
+    remove(path.c_str());
+}
+
+TEST(OfflineEngineTest, WritesAWavHeaderAtTheEngineRate) {
+    Mixer mixer;
+    StubInstrument instrument;
+    mixer.setChannelCount(2);
+    mixer.setSampleRate(48000);
+    mixer.addTrack(&instrument);
+    mixer.play();
+
+    auto path = ::testing::TempDir() + "offline_engine_test.wav";
+    std::atomic<bool> isCancelled { false };
+    OfflineEngine offlineEngine(mixer, 48000);
+
+    EXPECT_TRUE(offlineEngine.render(path.c_str(), WAV_FLOAT, 256, isCancelled).didSucceed);
+
+    auto file = fopen(path.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    uint8_t header[44];
+    ASSERT_EQ(fread(header, 1, sizeof(header), file), sizeof(header));
+    fseek(file, 0, SEEK_END);
+    auto fileSize = ftell(file);
+    fclose(file);
+
+    EXPECT_EQ(header[22], 2);
+    EXPECT_EQ(header[24] | (header[25] << 8) | (header[26] << 16), 48000);
+    EXPECT_EQ(fileSize, static_cast<long>(44 + 256 * 2 * sizeof(float)));
+
+    remove(path.c_str());
+}
+
+TEST(OfflineEngineTest, StopsOnceCancelled) {
+    Mixer mixer;
+    StubInstrument instrument;
+    mixer.addTrack(&instrument);
+    mixer.play();
+
+    auto path = ::testing::TempDir() + "offline_engine_cancel_test.raw";
+    std::atomic<bool> isCancelled { false };
+    OfflineEngine offlineEngine(mixer, 44100);
+    offlineEngine.setBlockSize(100);
+
+    // Cancelled partway through the third block, so the render stops before the fourth
+    instrument.mOnRender = [&]() {
+        instrument.mOnRender = [&]() {
+            instrument.mOnRender = [&]() { isCancelled.store(true); };
+        };
+    };
+
+    auto result = offlineEngine.render(path.c_str(), RAW_FLOAT, 1000, isCancelled);
+
+    EXPECT_FALSE(result.didSucceed);
+    EXPECT_EQ(result.framesRendered, 300u);
+    EXPECT_EQ(readRawFloats(path).size(), 300u);
+
+    remove(path.c_str());
+}
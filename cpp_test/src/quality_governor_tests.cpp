@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "QualityGovernor.h"
+
+static constexpr int32_t kSampleRate = 48000;
+static constexpr uint32_t kCallbackFrames = 192;
+static constexpr uint64_t kPeriodNs = kCallbackFrames * 1000000000ull / kSampleRate;
+
+/**
+ * Stands in for the mixer: each callback costs a base load plus a cost per tier step it hasn't
+ * taken, so stepping down really does free up time, the way cheaper instruments would.
+ */
+class SyntheticLoad {
+public:
+    SyntheticLoad(float baseLoad, float loadPerTier) : mBaseLoad(baseLoad), mLoadPerTier(loadPerTier) {}
+
+    // Runs the governor for this many seconds of callbacks, recording each tier change.
+    void run(QualityGovernor& governor, float seconds) {
+        auto callbackCount = static_cast<int32_t>(seconds * kSampleRate / kCallbackFrames);
+
+        for (int32_t i = 0; i < callbackCount; i++) {
+            auto load = mBaseLoad + mLoadPerTier * (QualityGovernor::kMaxTier - governor.getTier());
+
+            if (governor.update(static_cast<uint64_t>(load * kPeriodNs), kCallbackFrames, kSampleRate)) {
+                transitions.push_back(governor.getTier());
+            }
+        }
+    }
+
+    void setBaseLoad(float baseLoad) { mBaseLoad = baseLoad; }
+
+    std::vector<int32_t> transitions;
+
+private:
+    float mBaseLoad;
+    float mLoadPerTier;
+};
+
+TEST(QualityGovernorTest, StaysAtFullQualityWithHeadroom) {
+    QualityGovernor governor;
+    SyntheticLoad load(0.1f, 0.1f);
+
+    load.run(governor, 5.0f);
+
+    EXPECT_EQ(governor.getTier(), 0);
+    EXPECT_TRUE(load.transitions.empty());
+}
+
+TEST(QualityGovernorTest, StepsDownUntilCallbacksFit) {
+    QualityGovernor governor;
+    // 1.0 at full quality, 0.8 one tier down
+    SyntheticLoad load(0.4f, 0.2f);
+
+    load.run(governor, 2.0f);
+
+    EXPECT_EQ(governor.getTier(), 1);
+    EXPECT_EQ(load.transitions, std::vector<int32_t>({ 1 }));
+}
+
+TEST(QualityGovernorTest, StepsDownOneTierPerSettlePeriod) {
+    QualityGovernor governor;
+    // Over budget at every tier
+    SyntheticLoad load(1.1f, 0.1f);
+
+    load.run(governor, QualityGovernor::kSettleSeconds * 0.5f);
+    EXPECT_EQ(governor.getTier(), 1);
+
+    load.run(governor, QualityGovernor::kSettleSeconds * 3.0f);
+    EXPECT_EQ(governor.getTier(), QualityGovernor::kMaxTier);
+    EXPECT_EQ(load.transitions, std::vector<int32_t>({ 1, 2, 3 }));
+}
+
+TEST(QualityGovernorTest, IgnoresBriefSpikesUnderTheDeadline) {
+    QualityGovernor governor;
+
+    for (int32_t i = 0; i < 1000; i++) {
+        // Two busy callbacks in a row, never three, and none past the deadline
+        auto load = i % 3 == 2 ? 0.3f : 0.9f;
+        governor.update(static_cast<uint64_t>(load * kPeriodNs), kCallbackFrames, kSampleRate);
+    }
+
+    EXPECT_EQ(governor.getTier(), 0);
+}
+
+TEST(QualityGovernorTest, RestoresQualityAfterSustainedHeadroom) {
+    QualityGovernor governor;
+    SyntheticLoad load(1.1f, 0.1f);
+
+    load.run(governor, 1.0f);
+    ASSERT_EQ(governor.getTier(), QualityGovernor::kMaxTier);
+
+    load.setBaseLoad(0.1f);
+    load.run(governor, QualityGovernor::kRecoverSeconds * 0.9f);
+    EXPECT_EQ(governor.getTier(), QualityGovernor::kMaxTier);
+
+    load.run(governor, QualityGovernor::kRecoverSeconds * 3.5f);
+    EXPECT_EQ(governor.getTier(), 0);
+    EXPECT_EQ(load.transitions, std::vector<int32_t>({ 1, 2, 3, 2, 1, 0 }));
+}
+
+TEST(QualityGovernorTest, HoldsTierBetweenThresholds) {
+    QualityGovernor governor;
+    // 0.95 at full quality is over the top threshold and 0.7 at tier 1 is between the two, so
+    // the governor should settle at tier 1 rather than flap between it and full quality
+    SyntheticLoad load(0.2f, 0.25f);
+
+    load.run(governor, 20.0f);
+
+    EXPECT_EQ(governor.getTier(), 1);
+    EXPECT_EQ(load.transitions, std::vector<int32_t>({ 1 }));
+}
+
+TEST(QualityGovernorTest, DisablingRestoresFullQuality) {
+    QualityGovernor governor;
+    SyntheticLoad load(1.1f, 0.1f);
+
+    load.run(governor, 1.0f);
+    ASSERT_GT(governor.getTier(), 0);
+
+    governor.setEnabled(false);
+    load.run(governor, 1.0f);
+
+    EXPECT_EQ(governor.getTier(), 0);
+    EXPECT_EQ(load.transitions.back(), 0);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "RenderStats.h"
+
+TEST(RenderTimingHistogramTest, BucketBoundsAreContiguous) {
+    for (int i = 0; i < RenderTimingHistogram::kBucketCount - 1; i++) {
+        auto lowerBound = RenderTimingHistogram::bucketLowerBoundUs(i);
+        auto nextLowerBound = RenderTimingHistogram::bucketLowerBoundUs(i + 1);
+
+        EXPECT_LT(lowerBound, nextLowerBound);
+        EXPECT_EQ(RenderTimingHistogram::bucketIndex(lowerBound), i);
+        EXPECT_EQ(RenderTimingHistogram::bucketIndex(nextLowerBound - 1), i);
+    }
+}
+
+TEST(RenderTimingHistogramTest, Summarize) {
+    RenderTimingHistogram histogram;
+    const uint64_t budgetNs = 1000000; // 1 ms
+
+    for (int i = 0; i < 98; i++) {
+        histogram.record(100000, budgetNs); // 100 us
+    }
+    histogram.record(900000, budgetNs);
+    histogram.record(2000000, budgetNs); // Misses the deadline
+
+    auto stats = histogram.summarize();
+
+    EXPECT_EQ(stats.count, 100);
+    EXPECT_EQ(stats.deadlineMisses, 1);
+    EXPECT_EQ(stats.maxUs, 2000);
+    EXPECT_GE(stats.p50Us, 100);
+    EXPECT_LT(stats.p50Us, 125);
+    EXPECT_GE(stats.p99Us, 900);
+    EXPECT_LT(stats.p99Us, 1125);
+    EXPECT_FLOAT_EQ(stats.maxBudgetUtilisation, 2.0f);
+    EXPECT_NEAR(stats.meanBudgetUtilisation, 0.127f, 0.001f);
+
+    histogram.reset();
+
+    EXPECT_EQ(histogram.summarize().count, 0);
+}
+
+TEST(RenderStatsTest, ResetIsDeferredToAudioThread) {
+    RenderStats<4> renderStats;
+    TrackRenderStats trackStats;
+
+    renderStats.recordCallback(1000, 2000, 1);
+    renderStats.recordTrack(1, 500, 400, 2000);
+    renderStats.requestReset();
+
+    EXPECT_EQ(renderStats.getCallbackStats().count, 1);
+
+    renderStats.handleResetRequest();
+
+    EXPECT_EQ(renderStats.getCallbackStats().count, 0);
+    EXPECT_TRUE(renderStats.getTrackStats(1, trackStats));
+    EXPECT_EQ(trackStats.handleFrames.count, 0);
+    EXPECT_FALSE(renderStats.getTrackStats(4, trackStats));
+}
+
+TEST(RenderStatsTest, TrackResetIsDeferredToAudioThread) {
+    RenderStats<4> renderStats;
+    TrackRenderStats trackStats;
+
+    renderStats.recordCallback(1000, 2000, 1);
+    renderStats.recordTrack(1, 500, 400, 2000);
+    renderStats.recordTrack(2, 500, 400, 2000);
+    renderStats.requestTrackReset(1);
+
+    renderStats.getTrackStats(1, trackStats);
+    EXPECT_EQ(trackStats.handleFrames.count, 1);
+
+    renderStats.handleResetRequest();
+
+    renderStats.getTrackStats(1, trackStats);
+    EXPECT_EQ(trackStats.handleFrames.count, 0);
+    EXPECT_EQ(trackStats.instrument.count, 0);
+    renderStats.getTrackStats(2, trackStats);
+    EXPECT_EQ(trackStats.handleFrames.count, 1);
+    EXPECT_EQ(renderStats.getCallbackStats().count, 1);
+
+    // Handled once
+    renderStats.recordTrack(1, 500, 400, 2000);
+    renderStats.handleResetRequest();
+
+    renderStats.getTrackStats(1, trackStats);
+    EXPECT_EQ(trackStats.handleFrames.count, 1);
+}
+
+TEST(RenderStatsTest, CountsSubBlocksPerCallback) {
+    RenderStats<4> renderStats;
+
+    renderStats.recordCallback(1000, 2000, 4);
+    renderStats.recordCallback(1000, 2000, 1);
+    renderStats.recordCallback(1000, 2000, 1);
+
+    auto stats = renderStats.getSubBlockStats();
+    EXPECT_EQ(stats.lastCount, 1);
+    EXPECT_EQ(stats.maxCount, 4);
+    EXPECT_FLOAT_EQ(stats.meanCount, 2.0f);
+
+    renderStats.requestReset();
+    renderStats.handleResetRequest();
+
+    EXPECT_EQ(renderStats.getSubBlockStats().maxCount, 0);
+    EXPECT_FLOAT_EQ(renderStats.getSubBlockStats().meanCount, 0.0f);
+}
+
+TEST(RenderStatsTest, CountsSkippedRenders) {
+    RenderStats<4> renderStats;
+
+    renderStats.recordSkips(3, 37);
+    renderStats.recordSkips(10, 30);
+
+    auto stats = renderStats.getSkipStats();
+    EXPECT_EQ(stats.renderedCount, 13);
+    EXPECT_EQ(stats.skippedCount, 67);
+    EXPECT_EQ(stats.lastSkippedCount, 30);
+
+    renderStats.requestReset();
+    renderStats.handleResetRequest();
+
+    EXPECT_EQ(renderStats.getSkipStats().renderedCount, 0);
+    EXPECT_EQ(renderStats.getSkipStats().skippedCount, 0);
+}
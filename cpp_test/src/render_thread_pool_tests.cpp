@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include "RenderThreadPool.h"
+
+struct JobCounts {
+    std::atomic<int32_t> counts[64];
+};
+
+static void countJob(void* context, int32_t jobIndex) {
+    auto jobCounts = static_cast<JobCounts*>(context);
+    jobCounts->counts[jobIndex].fetch_add(1);
+}
+
+TEST(RenderThreadPoolTest, RunsEveryJobOnce) {
+    RenderThreadPool pool;
+    pool.start(3);
+
+    for (int32_t batch = 0; batch < 1000; batch++) {
+        JobCounts jobCounts = {};
+        auto jobCount = batch % 64 + 1;
+
+        pool.run(jobCount, countJob, &jobCounts);
+
+        for (int32_t i = 0; i < 64; i++) {
+            EXPECT_EQ(jobCounts.counts[i].load(), i < jobCount ? 1 : 0);
+        }
+    }
+
+    pool.stop();
+}
+
+TEST(RenderThreadPoolTest, RunsWithoutWorkers) {
+    RenderThreadPool pool;
+    JobCounts jobCounts = {};
+
+    pool.run(10, countJob, &jobCounts);
+
+    EXPECT_EQ(pool.getWorkerCount(), 0);
+    for (int32_t i = 0; i < 10; i++) {
+        EXPECT_EQ(jobCounts.counts[i].load(), 1);
+    }
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "RoutingGraph.h"
+
+static constexpr int32_t kTracks = 8;
+using Graph = RoutingGraph<kTracks>;
+
+// Each stage's buses, in order.
+static std::vector<std::vector<int32_t>> getStages(Graph& graph) {
+    std::vector<std::vector<int32_t>> stages;
+    auto plan = graph.acquire();
+
+    for (int32_t stage = 0; stage < plan->stageCount; stage++) {
+        stages.emplace_back();
+
+        for (auto i = plan->stageStarts[stage]; i < plan->stageStarts[stage + 1]; i++) {
+            stages.back().push_back(plan->busOrder[i]);
+        }
+    }
+
+    graph.release();
+    return stages;
+}
+
+TEST(RoutingGraphTest, StartsWithEverythingOnTheMaster) {
+    Graph graph;
+    auto plan = graph.acquire();
+
+    EXPECT_EQ(plan->busCount, 0);
+    EXPECT_EQ(plan->stageCount, 0);
+    for (auto output : plan->trackOutputs) {
+        EXPECT_EQ(output, kMasterBus);
+    }
+
+    graph.release();
+}
+
+TEST(RoutingGraphTest, OrdersBusesAfterTheirInputs) {
+    Graph graph;
+    auto drums = graph.addBus();
+    auto group = graph.addBus();
+    auto strings = graph.addBus();
+    auto reverb = graph.addBus();
+
+    ASSERT_TRUE(graph.setBusOutput(drums, group));
+    ASSERT_TRUE(graph.setBusOutput(strings, group));
+    ASSERT_TRUE(graph.setBusOutput(group, reverb));
+
+    // drums and strings don't depend on each other, so they share a stage
+    EXPECT_EQ(getStages(graph), std::vector<std::vector<int32_t>>({ { drums, strings }, { group }, { reverb } }));
+}
+
+TEST(RoutingGraphTest, UsesTheLongestChainForStages) {
+    Graph graph;
+    auto a = graph.addBus();
+    auto b = graph.addBus();
+    auto c = graph.addBus();
+
+    // a feeds c directly, and through b, so c has to wait for b
+    ASSERT_TRUE(graph.setBusOutput(b, c));
+    ASSERT_TRUE(graph.setBusOutput(a, b));
+
+    EXPECT_EQ(getStages(graph), std::vector<std::vector<int32_t>>({ { a }, { b }, { c } }));
+}
+
+TEST(RoutingGraphTest, RejectsCycles) {
+    Graph graph;
+    auto a = graph.addBus();
+    auto b = graph.addBus();
+    auto c = graph.addBus();
+
+    ASSERT_TRUE(graph.setBusOutput(a, b));
+    ASSERT_TRUE(graph.setBusOutput(b, c));
+
+    EXPECT_FALSE(graph.setBusOutput(c, a));
+    EXPECT_FALSE(graph.setBusOutput(a, a));
+    EXPECT_EQ(graph.getBusOutput(c), kMasterBus);
+}
+
+TEST(RoutingGraphTest, RejectsOutputsThatAreNotLive) {
+    Graph graph;
+    auto bus = graph.addBus();
+
+    EXPECT_FALSE(graph.setTrackOutput(0, bus + 1));
+    EXPECT_FALSE(graph.setTrackOutput(kTracks, bus));
+    EXPECT_FALSE(graph.setBusOutput(bus, kMaxBuses));
+    EXPECT_TRUE(graph.setTrackOutput(0, bus));
+    EXPECT_EQ(graph.getTrackOutput(0), bus);
+}
+
+TEST(RoutingGraphTest, RemovingABusPassesItsInputsOn) {
+    Graph graph;
+    auto inner = graph.addBus();
+    auto removed = graph.addBus();
+    auto outer = graph.addBus();
+
+    graph.setBusOutput(inner, removed);
+    graph.setBusOutput(removed, outer);
+    graph.setTrackOutput(3, removed);
+
+    graph.removeBus(removed);
+
+    EXPECT_FALSE(graph.isBusLive(removed));
+    EXPECT_EQ(graph.getBusOutput(inner), outer);
+    EXPECT_EQ(graph.getTrackOutput(3), outer);
+    EXPECT_EQ(getStages(graph), std::vector<std::vector<int32_t>>({ { inner }, { outer } }));
+
+    // Its index can be taken again
+    EXPECT_EQ(graph.addBus(), removed);
+}
+
+TEST(RoutingGraphTest, RunsOutOfBuses) {
+    Graph graph;
+
+    for (int32_t i = 0; i < kMaxBuses; i++) {
+        EXPECT_EQ(graph.addBus(), i);
+    }
+
+    EXPECT_EQ(graph.addBus(), -1);
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "SendEffects.h"
+
+static constexpr int32_t kSampleRate = 48000;
+static constexpr int32_t kChannels = 2;
+
+static std::vector<float> makeSine(float hz, int32_t numFrames) {
+    std::vector<float> data(numFrames * kChannels);
+
+    for (int32_t frame = 0; frame < numFrames; frame++) {
+        auto sample = std::sin(2.0f * float(M_PI) * hz * frame / kSampleRate);
+        data[frame * kChannels] = sample;
+        data[frame * kChannels + 1] = sample;
+    }
+
+    return data;
+}
+
+static float getPeak(const std::vector<float>& data, size_t fromSample) {
+    float peak = 0.0f;
+
+    for (auto i = fromSample; i < data.size(); i++) {
+        peak = std::max(peak, std::abs(data[i]));
+    }
+
+    return peak;
+}
+
+TEST(SendEffectsTest, DelayEchoesAfterItsTime) {
+    DelayEffect delay;
+    delay.prepare(kSampleRate);
+    delay.setParams(0.01f, 0.5f);
+
+    auto delayFrames = kSampleRate / 100;
+    std::vector<float> data(delayFrames * 3 * kChannels, 0.0f);
+    data[0] = 1.0f;
+
+    delay.process(data.data(), delayFrames * 3, kChannels);
+
+    EXPECT_FLOAT_EQ(data[0], 0.0f);
+    EXPECT_FLOAT_EQ(data[delayFrames * kChannels], 1.0f);
+    EXPECT_FLOAT_EQ(data[delayFrames * 2 * kChannels], 0.5f);
+    // The right channel had no input
+    EXPECT_FLOAT_EQ(data[delayFrames * kChannels + 1], 0.0f);
+}
+
+TEST(SendEffectsTest, FlatEqPassesInputThrough) {
+    EqEffect eq;
+    eq.prepare(kSampleRate);
+    eq.setParams(0.0f, 0.0f, 0.0f);
+
+    auto input = makeSine(440.0f, 1024);
+    auto data = input;
+    eq.process(data.data(), 1024, kChannels);
+
+    for (size_t i = 0; i < data.size(); i++) {
+        EXPECT_NEAR(data[i], input[i], 1e-5f);
+    }
+}
+
+TEST(SendEffectsTest, EqShelvesBoostTheirOwnBand) {
+    auto measureGain = [](float hz, float lowDb, float highDb) {
+        EqEffect eq;
+        eq.prepare(kSampleRate);
+        eq.setParams(lowDb, 0.0f, highDb);
+
+        auto data = makeSine(hz, kSampleRate / 4);
+        eq.process(data.data(), kSampleRate / 4, kChannels);
+
+        // Past the filters' settling time
+        return 20.0f * std::log10(getPeak(data, data.size() / 2));
+    };
+
+    EXPECT_NEAR(measureGain(50.0f, 12.0f, 0.0f), 12.0f, 0.5f);
+    EXPECT_NEAR(measureGain(12000.0f, 12.0f, 0.0f), 0.0f, 0.5f);
+    EXPECT_NEAR(measureGain(12000.0f, 0.0f, -12.0f), -12.0f, 0.5f);
+    EXPECT_NEAR(measureGain(50.0f, 0.0f, -12.0f), 0.0f, 0.5f);
+}
+
+TEST(SendEffectsTest, ReverbTailDecaysWithRoomSize) {
+    auto measureTail = [](float roomSize) {
+        ReverbEffect reverb;
+        reverb.prepare(kSampleRate);
+        reverb.setParams(roomSize, 0.2f);
+
+        std::vector<float> data(kSampleRate * kChannels, 0.0f);
+        data[0] = 1.0f;
+        data[1] = 1.0f;
+        reverb.process(data.data(), kSampleRate, kChannels);
+
+        EXPECT_FLOAT_EQ(data[0], 0.0f); // Nothing comes out before the shortest line
+        for (auto sample : data) {
+            EXPECT_TRUE(std::isfinite(sample));
+        }
+
+        // The last tenth of a second, a second after the impulse
+        return getPeak(data, data.size() - kSampleRate / 10 * kChannels);
+    };
+
+    auto smallTail = measureTail(0.0f);
+    auto largeTail = measureTail(1.0f);
+
+    EXPECT_LT(smallTail, 1e-3f);
+    EXPECT_GT(largeTail, smallTail * 10.0f);
+}
+
+TEST(SendEffectsTest, ClearsChannelsPastStereo) {
+    ReverbEffect reverb;
+    reverb.prepare(kSampleRate);
+
+    std::vector<float> data(256 * 4, 1.0f);
+    reverb.process(data.data(), 256, 4);
+
+    for (int32_t frame = 0; frame < 256; frame++) {
+        EXPECT_EQ(data[frame * 4 + 2], 0.0f);
+        EXPECT_EQ(data[frame * 4 + 3], 0.0f);
+    }
+}
+
+TEST(SendEffectsTest, ResetSilencesTheTail) {
+    DelayEffect delay;
+    delay.prepare(kSampleRate);
+    delay.setParams(0.001f, 0.9f);
+
+    std::vector<float> data(1024 * kChannels, 1.0f);
+    delay.process(data.data(), 1024, kChannels);
+
+    delay.reset();
+    std::fill(data.begin(), data.end(), 0.0f);
+    delay.process(data.data(), 1024, kChannels);
+
+    EXPECT_EQ(getPeak(data, 0), 0.0f);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "Seqlock.h"
+
+struct Snapshot {
+    uint64_t time;
+    uint32_t values[61]; // Not a whole number of words
+};
+
+TEST(SeqlockTest, ReadsWhatWasWritten) {
+    Seqlock<Snapshot> seqlock;
+    Snapshot snapshot = {};
+
+    seqlock.read(snapshot);
+    EXPECT_EQ(snapshot.time, 0);
+
+    snapshot.time = 42;
+    snapshot.values[60] = 7;
+    seqlock.write(snapshot);
+
+    Snapshot read;
+    seqlock.read(read);
+    EXPECT_EQ(read.time, 42);
+    EXPECT_EQ(read.values[60], 7);
+}
+
+TEST(SeqlockTest, ReaderNeverSeesTornWrites) {
+    Seqlock<Snapshot> seqlock;
+    std::atomic<bool> isDone { false };
+
+    std::thread writer([&]() {
+        Snapshot snapshot;
+
+        for (uint32_t i = 1; i <= 200000; i++) {
+            snapshot.time = i;
+            for (auto& value : snapshot.values) {
+                value = i;
+            }
+            seqlock.write(snapshot);
+        }
+
+        isDone.store(true);
+    });
+
+    int32_t tornCount = 0;
+    uint64_t lastTime = 0;
+
+    while (!isDone.load()) {
+        Snapshot snapshot;
+        seqlock.read(snapshot);
+
+        for (auto value : snapshot.values) {
+            if (value != snapshot.time) tornCount++;
+        }
+        if (snapshot.time < lastTime) tornCount++;
+        lastTime = snapshot.time;
+    }
+
+    writer.join();
+
+    EXPECT_EQ(tornCount, 0);
+}
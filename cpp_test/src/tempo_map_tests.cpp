@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "TempoMap.h"
+
+TEST(TempoMapTest, ConvertsConstantTempo) {
+    TempoMap map;
+    map.setOrigin(1000, 48000);
+    map.setTempo(0, 120);
+
+    // Half a second per beat
+    EXPECT_EQ(map.getFrame(0), 1000);
+    EXPECT_EQ(map.getFrame(TICKS_PER_BEAT), 1000 + 24000);
+    EXPECT_EQ(map.getFirstTickAtOrAfter(0), 0);
+    EXPECT_EQ(map.getFirstTickAtOrAfter(1000 + 24000), TICKS_PER_BEAT);
+
+    // Doubling the tempo from beat 1 halves the length of later beats, but not earlier ones
+    map.setTempo(TICKS_PER_BEAT, 240);
+    EXPECT_EQ(map.getFrame(TICKS_PER_BEAT), 1000 + 24000);
+    EXPECT_EQ(map.getFrame(2 * TICKS_PER_BEAT), 1000 + 36000);
+    EXPECT_EQ(map.getSegmentsCount(), 2);
+
+    // Setting the tempo at the same tick again replaces the change
+    map.setTempo(TICKS_PER_BEAT, 60);
+    EXPECT_EQ(map.getFrame(2 * TICKS_PER_BEAT), 1000 + 72000);
+    EXPECT_EQ(map.getSegmentsCount(), 2);
+}
+
+TEST(TempoMapTest, ConvertsLinearRamp) {
+    TempoMap map;
+    map.setOrigin(0, 48000);
+    map.setTempo(0, 120);
+    map.rampTempo(TICKS_PER_BEAT, 2 * TICKS_PER_BEAT, 240);
+
+    EXPECT_DOUBLE_EQ(map.getBpm(TICKS_PER_BEAT + TICKS_PER_BEAT / 2), 180);
+    EXPECT_DOUBLE_EQ(map.getBpm(3 * TICKS_PER_BEAT), 240);
+
+    // A beat ramping from 120 to 240 bpm lasts ln(2) / (240 - 120) minutes
+    auto rampFrames = 48000 * 60 * std::log(2.0) / 120;
+    EXPECT_EQ(map.getFrame(2 * TICKS_PER_BEAT), 24000 + std::llround(rampFrames));
+    EXPECT_EQ(map.getFrame(3 * TICKS_PER_BEAT), 24000 + std::llround(rampFrames) + 12000);
+
+    // Cutting the ramp short keeps the frames before the cut where they were
+    auto cutFrame = map.getFrame(TICKS_PER_BEAT + 100);
+    map.setTempo(TICKS_PER_BEAT + 100, 90);
+    EXPECT_EQ(map.getFrame(TICKS_PER_BEAT + 100), cutFrame);
+    EXPECT_DOUBLE_EQ(map.getBpm(TICKS_PER_BEAT + 200), 90);
+}
+
+TEST(TempoMapTest, FindsFirstTickAtOrAfterFrame) {
+    TempoMap map;
+    map.setOrigin(500, 44100);
+    map.setTempo(0, 97);
+    map.rampTempo(1000, 5000, 173);
+
+    for (position_frame_t frame = 0; frame < 100000; frame += 37) {
+        auto tick = map.getFirstTickAtOrAfter(frame);
+
+        EXPECT_GE(map.getFrame(tick), frame);
+        if (tick > 0) {
+            EXPECT_LT(map.getFrame(tick - 1), frame);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "TrackLoop.h"
+
+static SchedulerEvent makeEvent(position_frame_t frame, uint8_t noteNumber) {
+    SchedulerEvent event = {};
+    event.frame = frame;
+    event.type = MIDI_EVENT;
+    event.data[1] = noteNumber;
+    return event;
+}
+
+static std::vector<position_frame_t> collectFrames(LoopCursor cursor, position_frame_t endFrame) {
+    std::vector<position_frame_t> frames;
+    SchedulerEvent event;
+
+    while (cursor.peek(event) && event.frame < endFrame) {
+        frames.push_back(event.frame);
+        cursor.removeTop();
+    }
+
+    return frames;
+}
+
+TEST(TrackLoopTest, RepeatsEventsFromStartFrame) {
+    TrackLoop loop;
+    SchedulerEvent events[] = { makeEvent(0, 60), makeEvent(50, 62), makeEvent(100, 60) };
+
+    EXPECT_EQ(loop.set(1000, 100, events, 3), 3);
+
+    auto pattern = loop.acquire();
+    ASSERT_NE(pattern, nullptr);
+
+    // Before the loop starts, the first iteration plays from its beginning
+    EXPECT_EQ(collectFrames(LoopCursor(pattern, 0), 1260),
+              std::vector<position_frame_t>({ 1000, 1050, 1100, 1100, 1150, 1200, 1200, 1250 }));
+
+    // Starting exactly on an iteration boundary still plays the previous iteration's loop end
+    EXPECT_EQ(collectFrames(LoopCursor(pattern, 1100), 1160),
+              std::vector<position_frame_t>({ 1100, 1100, 1150 }));
+
+    // Starting mid-iteration skips events that already played
+    EXPECT_EQ(collectFrames(LoopCursor(pattern, 1251), 1310),
+              std::vector<position_frame_t>({ 1300, 1300 }));
+
+    loop.release();
+}
+
+TEST(TrackLoopTest, ReplacesAndClearsPattern) {
+    TrackLoop loop;
+    SchedulerEvent events[] = { makeEvent(10, 60), makeEvent(20, 62), makeEvent(500, 64) };
+
+    EXPECT_EQ(loop.acquire(), nullptr);
+
+    // Events past the loop end are dropped
+    EXPECT_EQ(loop.set(0, 100, events, 3), 2);
+    EXPECT_EQ(loop.acquire()->eventsCount, 2);
+    loop.release();
+
+    EXPECT_EQ(loop.set(0, 100, events, 1), 1);
+    EXPECT_EQ(loop.acquire()->eventsCount, 1);
+    loop.release();
+
+    loop.clear();
+    EXPECT_EQ(loop.acquire(), nullptr);
+
+    EXPECT_EQ(loop.set(0, 0, events, 1), 0);
+    EXPECT_EQ(loop.acquire(), nullptr);
+}
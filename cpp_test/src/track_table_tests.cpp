@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "TrackTable.h"
+
+TEST(TrackTableTest, ReusesLowestSlotWithNewGeneration) {
+    TrackTable<4> tracks;
+
+    auto track0 = tracks.add();
+    auto track1 = tracks.add();
+    auto track2 = tracks.add();
+
+    EXPECT_EQ(track0, 0);
+    EXPECT_EQ(track1, 1);
+    EXPECT_EQ(track2, 2);
+
+    EXPECT_TRUE(tracks.remove(track1));
+    EXPECT_FALSE(tracks.isLive(track1));
+    EXPECT_FALSE(tracks.remove(track1));
+
+    auto reusedTrack = tracks.add();
+    EXPECT_EQ(trackSlot(reusedTrack), 1);
+    EXPECT_NE(reusedTrack, track1);
+    EXPECT_TRUE(tracks.isLive(reusedTrack));
+    EXPECT_FALSE(tracks.isLive(track1));
+
+    EXPECT_NE(tracks.add(), -1);
+    EXPECT_EQ(tracks.add(), -1);
+    EXPECT_FALSE(tracks.isLive(-1));
+    EXPECT_FALSE(tracks.isLive(7));
+}
+
+TEST(TrackTableTest, LiveListStaysDense) {
+    TrackTable<8> tracks;
+    track_index_t ids[8];
+
+    for (int32_t i = 0; i < 8; i++) {
+        ids[i] = tracks.add();
+    }
+
+    tracks.remove(ids[0]);
+    tracks.remove(ids[5]);
+    tracks.remove(ids[3]);
+
+    auto& live = tracks.acquireLive();
+    ASSERT_EQ(live.count, 5);
+
+    bool seen[8] = {};
+    for (int32_t i = 0; i < live.count; i++) {
+        auto trackIndex = live.tracks[i];
+
+        EXPECT_TRUE(tracks.isLive(trackIndex));
+        EXPECT_FALSE(seen[trackSlot(trackIndex)]);
+        seen[trackSlot(trackIndex)] = true;
+    }
+
+    tracks.releaseLive();
+
+    EXPECT_FALSE(seen[0]);
+    EXPECT_FALSE(seen[3]);
+    EXPECT_FALSE(seen[5]);
+}
+
+// Removals move the last track into the gap, so a reader of a list that changed under it could
+// miss a track that never left.
+TEST(TrackTableTest, ReaderNeverMissesATrackThatStaysLive) {
+    TrackTable<16> tracks;
+    track_index_t stayingIds[4];
+    std::atomic<bool> isDone { false };
+
+    for (auto& id : stayingIds) {
+        id = tracks.add();
+    }
+
+    std::thread writer([&]() {
+        track_index_t churnIds[8];
+
+        for (int32_t round = 0; round < 20000; round++) {
+            for (auto& id : churnIds) {
+                id = tracks.add();
+            }
+            // Remove from the front, so the tracks at the end keep being moved
+            for (auto id : churnIds) {
+                tracks.remove(id);
+            }
+        }
+
+        isDone.store(true);
+    });
+
+    int32_t missedCount = 0;
+    int32_t duplicateCount = 0;
+
+    while (!isDone.load()) {
+        int32_t seenCounts[4] = {};
+        auto& live = tracks.acquireLive();
+
+        for (int32_t i = 0; i < live.count; i++) {
+            for (int32_t j = 0; j < 4; j++) {
+                if (live.tracks[i] == stayingIds[j]) seenCounts[j]++;
+            }
+        }
+
+        tracks.releaseLive();
+
+        for (auto seenCount : seenCounts) {
+            if (seenCount == 0) missedCount++;
+            if (seenCount > 1) duplicateCount++;
+        }
+    }
+
+    writer.join();
+
+    EXPECT_EQ(missedCount, 0);
+    EXPECT_EQ(duplicateCount, 0);
+}
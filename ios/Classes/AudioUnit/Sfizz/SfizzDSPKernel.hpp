@@ -10,6 +10,7 @@ A DSPKernel subclass implementing the realtime signal processing portion of the
 #ifdef __cplusplus
 #import "DSPKernel.hpp"
 #import "SfizzSamplerInstrument.h"
+#import <algorithm>
 #import <vector>
 #import <iostream>
 
@@ -54,25 +55,15 @@ public:
     }
 
     void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override {
-        if (channelCount == 1) {
-            // Mono
-            float* outBuffer = (float*)outBufferListPtr->mBuffers[0].mData + bufferOffset;
-            
-            mInstrument->renderAudio(outBuffer, frameCount);
-        } else {
-            // Stereo
-            float interlacedBuffer[frameCount * 2];
-            mInstrument->renderAudio(interlacedBuffer, frameCount);
-            
-            float* leftOutBuffer = (float*)outBufferListPtr->mBuffers[0].mData + bufferOffset;
-            float* rightOutBuffer = (float*)outBufferListPtr->mBuffers[1].mData + bufferOffset;
-            
-            // De-interlace
-            for (int i = 0; i < frameCount; i++) {
-                leftOutBuffer[i] = interlacedBuffer[i * 2];
-                rightOutBuffer[i] = interlacedBuffer[(i * 2) + 1];
-            }
+        // The output buses are planar, so sfizz renders straight into them
+        float* channelData[2];
+        auto outputChannelCount = std::min(channelCount, 2);
+
+        for (int channel = 0; channel < outputChannelCount; channel++) {
+            channelData[channel] = (float*)outBufferListPtr->mBuffers[channel].mData + bufferOffset;
         }
+
+        mInstrument->renderAudioPlanar(channelData, outputChannelCount, frameCount);
     }
     
     void handleMIDIEvent(AUMIDIEvent const& midiEvent) override {
@@ -34,32 +34,42 @@ void callbackToDartInt32(Dart_Port callback_port, int32_t value) {
     }
 }
 
-void callbackToDartInt32Array(Dart_Port callbackPort, int length, int32_t* values) {
+void callbackToDartDouble(Dart_Port callback_port, double value) {
     if (dartPostCObject == NULL) return;
-
-    Dart_CObject *valueObjects[length];
-    int i;
-    for (i = 0; i < length; ++i) {
-        auto valueObject = new Dart_CObject;
-        valueObject->type = Dart_CObject_kInt32;
-        valueObject->value.as_int32 = values[i];
-
-        valueObjects[i] = valueObject;
+    
+    Dart_CObject dart_object;
+    dart_object.type = Dart_CObject_kDouble;
+    dart_object.value.as_double = value;
+    
+    bool result = dartPostCObject(callback_port, &dart_object);
+    if (!result) {
+        printf("call from native to Dart failed, result was: %d\n", result);
     }
+}
+
+// Arrays of numbers are posted as typed data, which Dart copies in one go, instead of as an array
+// of objects.
+static void callbackToDartTypedData(Dart_Port callbackPort, Dart_TypedData_Type type, intptr_t length, void* values) {
+    if (dartPostCObject == NULL) return;
 
     Dart_CObject dart_object;
-    dart_object.type = Dart_CObject_kArray;
-    dart_object.value.as_array.length = length;
-    dart_object.value.as_array.values = valueObjects;
+    dart_object.type = Dart_CObject_kTypedData;
+    dart_object.value.as_typed_data.type = type;
+    dart_object.value.as_typed_data.length = length;
+    dart_object.value.as_typed_data.values = (int8_t*)values;
 
     bool result = dartPostCObject(callbackPort, &dart_object);
     if (!result) {
         printf("call from native to Dart failed, result was: %d\n", result);
     }
+}
 
-    for (i = 0; i < length; i++) {
-        delete valueObjects[i];
-    }
+void callbackToDartInt32Array(Dart_Port callbackPort, int length, int32_t* values) {
+    callbackToDartTypedData(callbackPort, Dart_TypedData_kInt32, length, values);
+}
+
+void callbackToDartUint32Array(Dart_Port callbackPort, int length, uint32_t* values) {
+    callbackToDartTypedData(callbackPort, Dart_TypedData_kUint32, length, values);
 }
 
 void callbackToDartStrArray(Dart_Port callbackPort, int length, char** values) {
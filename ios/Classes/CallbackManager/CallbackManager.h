@@ -1,6 +1,7 @@
 #ifndef CallbackManager_h
 #define CallbackManager_h
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
 
@@ -91,7 +92,9 @@ extern "C" {
 
     void callbackToDartBool(Dart_Port callbackPort, bool value);
     void callbackToDartInt32(Dart_Port callbackPort, int32_t value);
+    void callbackToDartDouble(Dart_Port callbackPort, double value);
     void callbackToDartInt32Array(Dart_Port callbackPort, int length, int32_t* value);
+    void callbackToDartUint32Array(Dart_Port callbackPort, int length, uint32_t* values);
     void callbackToDartStrArray(Dart_Port callbackPort, int length, char** values);
 #ifdef __cplusplus
 }
@@ -29,7 +29,7 @@ public class CocoaEngine {
     deinit {
         SchedulerPause(self.scheduler)
         engine.stop()
-        scheduler.deallocate()
+        DestroyScheduler(self.scheduler)
     }
     
     func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, completion: @escaping (track_index_t) -> Void) {
@@ -153,6 +153,10 @@ public class CocoaEngine {
         do {
             SchedulerPlay(self.scheduler)
             try self.engine.start()
+
+            let session = AVAudioSession.sharedInstance()
+            let latency = (session.outputLatency + session.ioBufferDuration) * self.outputFormat.sampleRate
+            SchedulerSetOutputLatencyFrames(self.scheduler, UInt32(max(latency, 0)))
         } catch {
             // ignore
         }
@@ -193,7 +197,7 @@ public class CocoaEngine {
         let auOutputFormat = avAudioUnit.outputFormat(forBus: 0)
         
         self.engine.attach(avAudioUnit)
-        self.engine.connect(avAudioUnit, to: self.mixer!, fromBus: 0, toBus: AVAudioNodeBus(trackIndex), format: auOutputFormat)
+        self.engine.connect(avAudioUnit, to: self.mixer!, fromBus: 0, toBus: AVAudioNodeBus(trackSlot(trackIndex)), format: auOutputFormat)
     }
     
     func disconnect(avAudioUnit: AVAudioUnit) {
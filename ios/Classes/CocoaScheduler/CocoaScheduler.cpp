@@ -1,6 +1,19 @@
 #include "CocoaScheduler.h"
+#include <mach/mach_time.h>
 #include <memory>
 
+// Converts a render timestamp's host time to the clock BaseScheduler::getHostTimeUs reads. On
+// Apple platforms steady_clock counts the same uptime as mach_absolute_time.
+static uint64_t hostTimeToUs(UInt64 hostTime) {
+    static const mach_timebase_info_data_t timebase = [] {
+        mach_timebase_info_data_t info;
+        mach_timebase_info(&info);
+        return info;
+    }();
+
+    return hostTime * timebase.numer / timebase.denom / 1000;
+}
+
 OSStatus triggerMidiEvents(
     void* _Nonnull inRefCon,
     AudioUnitRenderActionFlags* _Nonnull ioActionFlags,
@@ -11,12 +24,13 @@ OSStatus triggerMidiEvents(
 ) {
     if (*ioActionFlags != kAudioUnitRenderAction_PreRender) return noErr;
     
-    auto pair = (std::pair<track_index_t, CocoaScheduler*>*)inRefCon;
-    auto trackIndex = pair->first;
-    auto scheduler = pair->second;
+    auto refCon = (InRefCon*)inRefCon;
+    auto trackIndex = refCon->trackIndex;
+    auto scheduler = refCon->scheduler;
     auto scaledFrameCount = scheduler->scaleFrames(trackIndex, inNumberFrames, true);
+    auto hostTimeUs = (inTimeStamp->mFlags & kAudioTimeStampHostTimeValid) ? hostTimeToUs(inTimeStamp->mHostTime) : 0;
 
-    scheduler->handleFrames(trackIndex, scaledFrameCount);
+    scheduler->handleFrames(trackIndex, scaledFrameCount, hostTimeUs);
     
     return noErr;
 }
@@ -27,30 +41,38 @@ CocoaScheduler::CocoaScheduler(AudioUnit _Nonnull mixerAudioUnit, double sampleR
 }
 
 CocoaScheduler::~CocoaScheduler() {
-    for (auto pair : mInRefConMap) {
-        auto audioUnit = mAudioUnitMap[pair.first];
-        
-        AudioUnitRemoveRenderNotify(audioUnit, triggerMidiEvents, &pair);
+    for (int32_t slot = 0; slot < MAX_TRACKS; slot++) {
+        if (mAudioUnits[slot] == nullptr) continue;
+
+        AudioUnitRemoveRenderNotify(mAudioUnits[slot], triggerMidiEvents, &mInRefCons[slot]);
     }
 }
 
 void CocoaScheduler::setTrackAudioUnit(track_index_t trackIndex, AudioUnit _Nonnull audioUnit) {
-    mSampleRateMap[trackIndex] = getSampleRate(audioUnit);
-    mInRefConMap[trackIndex] = this;
-    mAudioUnitMap[trackIndex] = audioUnit;
-    auto inRefCon = mInRefConMap.find(trackIndex);
-    AudioUnitAddRenderNotify(audioUnit, triggerMidiEvents, &*inRefCon);
+    if (!isTrackLive(trackIndex)) return;
+
+    auto slot = trackSlot(trackIndex);
+    mSampleRates[slot] = getSampleRate(audioUnit);
+    mInRefCons[slot] = { this, trackIndex };
+    mAudioUnits[slot] = audioUnit;
+    AudioUnitAddRenderNotify(audioUnit, triggerMidiEvents, &mInRefCons[slot]);
 }
 
 void CocoaScheduler::onRemoveTrack(track_index_t trackIndex) {
-    auto inRefCon = mInRefConMap.find(trackIndex);
-    AudioUnitRemoveRenderNotify(mAudioUnitMap[trackIndex], triggerMidiEvents, &*inRefCon);
-    mInRefConMap.erase(trackIndex);
-    mAudioUnitMap.erase(trackIndex);
+    auto slot = trackSlot(trackIndex);
+    if (mAudioUnits[slot] == nullptr) return;
+
+    AudioUnitRemoveRenderNotify(mAudioUnits[slot], triggerMidiEvents, &mInRefCons[slot]);
+    mAudioUnits[slot] = nullptr;
 }
 
 void CocoaScheduler::onResetTrack(track_index_t trackIndex) {
-    AudioUnitReset(mAudioUnitMap[trackIndex], kAudioUnitScope_Global, 0);
+    if (!isTrackLive(trackIndex)) return;
+
+    auto audioUnit = mAudioUnits[trackSlot(trackIndex)];
+    if (audioUnit == nullptr) return;
+
+    AudioUnitReset(audioUnit, kAudioUnitScope_Global, 0);
 }
 
 void CocoaScheduler::handleRenderAudioRange(track_index_t trackIndex, uint32_t offsetFrame, uint32_t numFramesToRender) {
@@ -58,11 +80,13 @@ void CocoaScheduler::handleRenderAudioRange(track_index_t trackIndex, uint32_t o
 };
 
 void CocoaScheduler::handleEvent(track_index_t trackIndex, SchedulerEvent event, UInt32 offsetFrame) {
-    AudioUnit trackAU = mAudioUnitMap[trackIndex];
-    auto scaledOffsetFrame = scaleFrames(trackIndex, offsetFrame, false);
-    
+    if (!isTrackLive(trackIndex)) return;
+
+    AudioUnit trackAU = mAudioUnits[trackSlot(trackIndex)];
     if (trackAU == nullptr) return;
 
+    auto scaledOffsetFrame = scaleFrames(trackIndex, offsetFrame, false);
+
     if (event.type == VOLUME_EVENT) {
         auto volumeEvent = VolumeEventData(event.data);
         
@@ -70,7 +94,7 @@ void CocoaScheduler::handleEvent(track_index_t trackIndex, SchedulerEvent event,
         AudioUnitSetParameter(mMixerAudioUnit,
                               kMultiChannelMixerParam_Volume,
                               kAudioUnitScope_Input,
-                              trackIndex, // bus ID
+                              trackSlot(trackIndex), // bus ID
                               volumeEvent.volume,
                               scaledOffsetFrame);
     } else if (event.type == MIDI_EVENT) {
@@ -82,11 +106,13 @@ void CocoaScheduler::handleEvent(track_index_t trackIndex, SchedulerEvent event,
 }
 
 float CocoaScheduler::getTrackVolume(track_index_t trackIndex) {
+    if (!isTrackLive(trackIndex)) return 0.0;
+
     float volume;
     auto osStatus = AudioUnitGetParameter(mMixerAudioUnit,
                                           kMultiChannelMixerParam_Volume,
                                           kAudioUnitScope_Input,
-                                          trackIndex, // bus ID
+                                          trackSlot(trackIndex), // bus ID
                                           &volume);
     
     if (osStatus == noErr) {
@@ -97,7 +123,7 @@ float CocoaScheduler::getTrackVolume(track_index_t trackIndex) {
 }
 
 int CocoaScheduler::scaleFrames(track_index_t trackIndex, UInt32 inNumberFrames, bool isToDeviceFrames) {
-    auto trackSampleRate = mSampleRateMap[trackIndex];
+    auto trackSampleRate = mSampleRates[trackSlot(trackIndex)];
     int scaledFrames;
 
     if (trackSampleRate == mSampleRate) {
@@ -153,18 +179,74 @@ UInt32 SchedulerGetBufferAvailableCount(const void* scheduler, track_index_t tra
     return ((CocoaScheduler*)scheduler)->getBufferAvailableCount(trackIndex);
 }
 
+void SchedulerGetBufferAvailableCounts(const void* scheduler, const track_index_t* trackIndices, UInt32 tracksCount, UInt32* availableCounts) {
+    ((CocoaScheduler*)scheduler)->getBufferAvailableCounts(trackIndices, tracksCount, availableCounts);
+}
+
 void SchedulerHandleEventsNow(const void* scheduler, track_index_t trackIndex, const SchedulerEvent* events, UInt32 toAddCount) {
     return ((CocoaScheduler*)scheduler)->handleEventsNow(trackIndex, &events[0], toAddCount);
 }
 
+UInt32 SchedulerGetEventRing(const void* scheduler, track_index_t trackIndex, SchedulerEvent** events, UInt32** readPosition, UInt32** writePosition) {
+    return ((CocoaScheduler*)scheduler)->getEventRing(trackIndex, events, readPosition, writePosition);
+}
+
+void SchedulerPublishEventRings(const void* scheduler, const track_index_t* trackIndices, const UInt32* writePositions, UInt32 tracksCount) {
+    ((CocoaScheduler*)scheduler)->publishEventRings(trackIndices, writePositions, tracksCount);
+}
+
+UInt32 SchedulerAddRawEvents(const void* scheduler, track_index_t trackIndex, const UInt8* eventData, UInt32 eventsCount) {
+    return ((CocoaScheduler*)scheduler)->scheduleRawEvents(trackIndex, eventData, eventsCount);
+}
+
 UInt32 SchedulerAddEvents(const void* scheduler, track_index_t trackIndex, const SchedulerEvent* events, UInt32 toAddCount) {
     return ((CocoaScheduler*)scheduler)->scheduleEvents(trackIndex, &events[0], toAddCount);
 }
 
+UInt32 SchedulerAddEventsMulti(const void* scheduler, const UInt8* eventData, UInt32 eventDataSize, UInt32 runsCount, UInt32* acceptedCounts) {
+    return ((CocoaScheduler*)scheduler)->scheduleEventsMulti(eventData, eventDataSize, runsCount, acceptedCounts);
+}
+
 void SchedulerClearEvents(const void* scheduler, track_index_t trackIndex, position_frame_t fromFrame) {
     return ((CocoaScheduler*)scheduler)->clearEvents(trackIndex, fromFrame);
 }
 
+UInt32 SchedulerInsertEvents(const void* scheduler, track_index_t trackIndex, const SchedulerEvent* events, UInt32 eventsCount, UInt32* ids) {
+    return ((CocoaScheduler*)scheduler)->insertEvents(trackIndex, &events[0], eventsCount, ids);
+}
+
+UInt32 SchedulerRemoveEvents(const void* scheduler, track_index_t trackIndex, const UInt32* ids, UInt32 idsCount) {
+    return ((CocoaScheduler*)scheduler)->removeEvents(trackIndex, ids, idsCount);
+}
+
+UInt32 SchedulerEraseEvents(const void* scheduler, track_index_t trackIndex, position_frame_t fromFrame, position_frame_t toFrame) {
+    return ((CocoaScheduler*)scheduler)->eraseEvents(trackIndex, fromFrame, toFrame);
+}
+
+UInt32 SchedulerSetTrackLoop(const void* scheduler, track_index_t trackIndex, position_frame_t loopStartFrame, UInt32 loopLengthFrames, const SchedulerEvent* events, UInt32 eventsCount) {
+    return ((CocoaScheduler*)scheduler)->setTrackLoop(trackIndex, loopStartFrame, loopLengthFrames, &events[0], eventsCount);
+}
+
+void SchedulerClearTrackLoop(const void* scheduler, track_index_t trackIndex) {
+    return ((CocoaScheduler*)scheduler)->clearTrackLoop(trackIndex);
+}
+
+bool SchedulerSetTickTimebase(const void* scheduler, position_frame_t originFrame, UInt32 sampleRate) {
+    return ((CocoaScheduler*)scheduler)->setTickTimebase(originFrame, sampleRate);
+}
+
+bool SchedulerSetFrameTimebase(const void* scheduler) {
+    return ((CocoaScheduler*)scheduler)->setFrameTimebase();
+}
+
+bool SchedulerSetTempo(const void* scheduler, UInt32 tick, Float32 bpm) {
+    return ((CocoaScheduler*)scheduler)->setTempo(tick, bpm);
+}
+
+bool SchedulerRampTempo(const void* scheduler, UInt32 startTick, UInt32 endTick, Float32 endBpm) {
+    return ((CocoaScheduler*)scheduler)->rampTempo(startTick, endTick, endBpm);
+}
+
 void SchedulerPlay(const void* scheduler) {
     return ((CocoaScheduler*)scheduler)->play();
 }
@@ -185,6 +267,22 @@ UInt64 SchedulerGetLastRenderTimeUs(const void* scheduler) {
     return ((CocoaScheduler*)scheduler)->getLastRenderTimeUs();
 }
 
+void SchedulerGetTransportSnapshot(const void* scheduler, void* snapshot) {
+    ((CocoaScheduler*)scheduler)->getTransportSnapshot((TransportSnapshot*)snapshot);
+}
+
+void SchedulerSetOutputLatencyFrames(const void* scheduler, UInt32 outputLatencyFrames) {
+    ((CocoaScheduler*)scheduler)->setOutputLatencyFrames(outputLatencyFrames);
+}
+
+void SchedulerSetNotificationPort(const void* scheduler, Dart_Port notificationPort) {
+    ((CocoaScheduler*)scheduler)->setNotificationPort(notificationPort);
+}
+
+void SchedulerSetBufferLowWatermark(const void* scheduler, UInt32 bufferLowWatermark) {
+    ((CocoaScheduler*)scheduler)->setBufferLowWatermark(bufferLowWatermark);
+}
+
 Float32 SchedulerGetTrackVolume(const void* scheduler, track_index_t trackIndex) {
     return ((CocoaScheduler*)scheduler)->getTrackVolume(trackIndex);
 }
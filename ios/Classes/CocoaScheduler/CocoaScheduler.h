@@ -9,8 +9,18 @@
 const int MAX_TRACKS = 128;
 
 #ifdef __cplusplus
+#include <array>
 #include <thread>
 
+static_assert(MAX_TRACKS == kMaxTrackSlots, "CocoaScheduler's track arrays must match the track table");
+
+class CocoaScheduler;
+
+struct InRefCon {
+    CocoaScheduler* _Nullable scheduler;
+    track_index_t trackIndex;
+};
+
 class CocoaScheduler : public BaseScheduler {
 public:
     CocoaScheduler(AudioUnit _Nonnull mixerAudioUnit, double sampleRate);
@@ -27,18 +37,15 @@ public:
 private:
     double getSampleRate(AudioUnit _Nonnull audioUnit);
     double mSampleRate;
-    std::unordered_map<track_index_t, AudioUnit _Nonnull> mAudioUnitMap = {};
-    std::unordered_map<track_index_t, double> mSampleRateMap = {};
-    
-    // Pairs from this map will be used as the "inRefCon" variable for AudioUnitAddRenderNotify.
-    std::unordered_map<track_index_t, CocoaScheduler* _Nonnull> mInRefConMap = {};
 
-    AudioUnit _Nonnull mMixerAudioUnit;
-};
+    // Indexed by trackSlot()
+    std::array<AudioUnit _Nullable, MAX_TRACKS> mAudioUnits = {};
+    std::array<double, MAX_TRACKS> mSampleRates = {};
 
-struct InRefCon {
-    CocoaScheduler* _Nonnull scheduler;
-    track_index_t trackIndex;
+    // Entries from this array will be used as the "inRefCon" variable for AudioUnitAddRenderNotify.
+    std::array<InRefCon, MAX_TRACKS> mInRefCons = {};
+
+    AudioUnit _Nonnull mMixerAudioUnit;
 };
 #endif
 
@@ -52,14 +59,32 @@ SInt32 SchedulerAddTrack(const void* _Nonnull engine);
 void SchedulerSetTrackAudioUnit(const void* _Nonnull engine, track_index_t trackIndex, AudioUnit _Nonnull audioUnit);
 void SchedulerRemoveTrack(const void* _Nonnull engine, track_index_t trackIndex);
 UInt32 SchedulerGetBufferAvailableCount(const void* _Nonnull scheduler, track_index_t trackIndex);
+void SchedulerGetBufferAvailableCounts(const void* _Nonnull scheduler, const track_index_t* _Nonnull trackIndices, UInt32 tracksCount, UInt32* _Nonnull availableCounts);
+UInt32 SchedulerGetEventRing(const void* _Nonnull scheduler, track_index_t trackIndex, struct SchedulerEvent* _Nullable * _Nonnull events, UInt32* _Nullable * _Nonnull readPosition, UInt32* _Nullable * _Nonnull writePosition);
+void SchedulerPublishEventRings(const void* _Nonnull scheduler, const track_index_t* _Nonnull trackIndices, const UInt32* _Nonnull writePositions, UInt32 tracksCount);
+UInt32 SchedulerAddRawEvents(const void* _Nonnull engine, track_index_t trackIndex, const UInt8* _Nonnull eventData, UInt32 eventsCount);
 void SchedulerHandleEventsNow(const void* _Nonnull engine, track_index_t trackIndex, const struct SchedulerEvent* _Nonnull events, UInt32 eventsCount);
 UInt32 SchedulerAddEvents(const void* _Nonnull engine, track_index_t trackIndex, const struct SchedulerEvent* _Nonnull events, UInt32 eventsCount);
+UInt32 SchedulerAddEventsMulti(const void* _Nonnull engine, const UInt8* _Nonnull eventData, UInt32 eventDataSize, UInt32 runsCount, UInt32* _Nonnull acceptedCounts);
 void SchedulerClearEvents(const void* _Nonnull engine, track_index_t trackIndex, position_frame_t fromFrame);
+UInt32 SchedulerInsertEvents(const void* _Nonnull engine, track_index_t trackIndex, const struct SchedulerEvent* _Nonnull events, UInt32 eventsCount, UInt32* _Nullable ids);
+UInt32 SchedulerRemoveEvents(const void* _Nonnull engine, track_index_t trackIndex, const UInt32* _Nonnull ids, UInt32 idsCount);
+UInt32 SchedulerEraseEvents(const void* _Nonnull engine, track_index_t trackIndex, position_frame_t fromFrame, position_frame_t toFrame);
+UInt32 SchedulerSetTrackLoop(const void* _Nonnull engine, track_index_t trackIndex, position_frame_t loopStartFrame, UInt32 loopLengthFrames, const struct SchedulerEvent* _Nonnull events, UInt32 eventsCount);
+void SchedulerClearTrackLoop(const void* _Nonnull engine, track_index_t trackIndex);
+bool SchedulerSetTickTimebase(const void* _Nonnull engine, position_frame_t originFrame, UInt32 sampleRate);
+bool SchedulerSetFrameTimebase(const void* _Nonnull engine);
+bool SchedulerSetTempo(const void* _Nonnull engine, UInt32 tick, Float32 bpm);
+bool SchedulerRampTempo(const void* _Nonnull engine, UInt32 startTick, UInt32 endTick, Float32 endBpm);
 void SchedulerPlay(const void* _Nonnull engine);
 void SchedulerPause(const void* _Nonnull engine);
 void SchedulerResetTrack(const void* _Nonnull engine, track_index_t trackIndex);
 UInt32 SchedulerGetPosition(const void* _Nonnull engine);
 UInt64 SchedulerGetLastRenderTimeUs(const void* _Nonnull engine);
+void SchedulerGetTransportSnapshot(const void* _Nonnull engine, void* _Nonnull snapshot);
+void SchedulerSetOutputLatencyFrames(const void* _Nonnull engine, UInt32 outputLatencyFrames);
+void SchedulerSetNotificationPort(const void* _Nonnull engine, Dart_Port notificationPort);
+void SchedulerSetBufferLowWatermark(const void* _Nonnull engine, UInt32 bufferLowWatermark);
 Float32 SchedulerGetTrackVolume(const void* _Nonnull engine, track_index_t trackIndex);
 #ifdef __cplusplus
 }
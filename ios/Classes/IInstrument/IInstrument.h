@@ -21,6 +21,31 @@
 #include <cstdint>
 #include "IRenderableAudio.h"
 
+// Which voice makes way when a note would take an instrument over its voice limit.
+enum VoiceStealPolicy {
+    STEAL_OLDEST = 0,
+    STEAL_QUIETEST = 1,
+    STEAL_SAME_NOTE = 2, // The same note if it's still sounding, otherwise the oldest
+};
+
+// How much an instrument gives up to save CPU when the engine is close to missing its deadline.
+// Each tier keeps the savings of the ones before it.
+enum QualityTier {
+    QUALITY_FULL = 0,
+    QUALITY_REDUCED_INTERPOLATION = 1, // Cheaper sample interpolation and oscillators
+    QUALITY_REDUCED_VOICES = 2,        // Half the voices, and quiet release tails are cut
+    QUALITY_MINIMAL = 3,               // A quarter of the voices and the cheapest interpolation
+};
+
+// The voice limit an instrument with maxVoices voices keeps to at a tier. Always at least 1.
+inline int32_t getTierVoiceLimit(int32_t maxVoices, QualityTier tier) {
+    auto limit = tier >= QUALITY_MINIMAL ? maxVoices / 4 : tier >= QUALITY_REDUCED_VOICES ? maxVoices / 2 : maxVoices;
+    return limit > 1 ? limit : 1;
+}
+
+// Release tails quieter than this (about -50 dB) are cut from QUALITY_REDUCED_VOICES down.
+constexpr float kInaudibleTailLevel = 0.003f;
+
 class IInstrument: public IRenderableAudio {
 
 public:
@@ -30,6 +55,18 @@ public:
     // reset() should reset any state. It does not need to shut off all the MIDI notes, since
     // BaseScheduler handles that.
     virtual void reset() = 0;
+
+    // A temporary limit on top of the instrument's own voice limit, from the engine's voice budget.
+    // Called on the render thread, so it must only store the cap; it takes effect on the next note.
+    virtual void setVoiceCap(int32_t /* voiceCap */) {}
+
+    // Called on the render thread when the engine's load changes the tier, so it must only apply
+    // changes that don't allocate or reload anything.
+    virtual void setQualityTier(QualityTier /* tier */) {}
+
+    // True when rendering would only produce silence: no voices are sounding and no effect tail is
+    // left. The mixer skips idle tracks until an event wakes them. Called on the render thread.
+    virtual bool isIdle() { return false; }
 };
 
 #endif
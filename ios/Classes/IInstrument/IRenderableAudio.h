@@ -26,6 +26,14 @@ class IRenderableAudio {
 public:
     virtual ~IRenderableAudio() = default;
     virtual void renderAudio(float *audioData, int32_t numFrames) = 0;
+
+    // Sources whose synth renders each channel separately can render straight into the caller's
+    // channel buffers instead of interleaving first. Callers check this once, when the source is
+    // added, and then always use the same entry point.
+    virtual bool canRenderPlanar() { return false; }
+
+    // channelData holds channelCount buffers of at least numFrames samples, all overwritten.
+    virtual void renderAudioPlanar(float ** /* channelData */, int32_t /* channelCount */, int32_t /* numFrames */) {}
 };
 
 #endif
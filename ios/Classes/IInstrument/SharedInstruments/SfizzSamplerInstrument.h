@@ -2,13 +2,46 @@
 #define SFIZZ_SAMPLER_INSTRUMENT_H
 
 #ifdef __cplusplus
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include "ChannelKernel.h"
 #include "IInstrument.h"
 #include "sfizz.hpp"
 
+// How a track trades memory against CPU. -1 leaves an option as it is. Remember to keep
+// lib/models/sfizz_config.dart in sync.
+struct SfizzConfig {
+    int32_t preloadSize;        // Frames of each sample held in memory; the rest streams from disk
+    int32_t oversamplingFactor; // 1, 2, 4 or 8. Multiplies preload memory and sample CPU
+    int32_t sampleQuality;      // 0 to 10, for live playback. Higher costs more CPU per voice
+    int32_t oscillatorQuality;  // 0 to 3, for live playback. Higher costs more CPU per voice
+    int32_t maxVoices;          // Polyphony, preallocated by sfizz. Each voice costs CPU while it plays
+    int32_t stealPolicy;        // A VoiceStealPolicy, used when the engine's voice budget caps the track
+};
+
+struct SfizzStats {
+    uint64_t preloadBytes;        // Estimated memory held by preloaded sample heads
+    SfizzConfig config;           // The options in effect
+    uint32_t preloadedFilesCount;
+    uint32_t activeVoicesCount;
+    uint32_t renderMeanUs;        // Filled in by the engine, from the track's render timing
+    uint32_t renderP99Us;
+};
+
+static_assert(sizeof(SfizzStats) == 48, "Keep SFIZZ_STATS_SIZE in lib/constants.dart in sync");
+
 class SfizzSamplerInstrument : public IInstrument {
 public:
     SfizzSamplerInstrument() {
         mSampler = std::make_unique<sfz::Sfizz>();
+        mSampleQuality = mSampler->getSampleQuality(sfz::Sfizz::ProcessLive);
+        mOscillatorQuality = mSampler->getOscillatorQuality(sfz::Sfizz::ProcessLive);
+        allocateScratch(kDefaultScratchFrames);
     }
 
     bool setOutputFormat(int32_t sampleRate, bool isStereo) override {
@@ -18,11 +51,69 @@ public:
         return true;
     }
 
+    // Allocates, so call it before the instrument is rendering.
     void setSamplesPerBlock(int samplesPerBlock) {
         mSampler->setSamplesPerBlock(samplesPerBlock);
+        allocateScratch(samplesPerBlock);
+    }
+
+    // Preload size and oversampling reload every sample's head, so they are cheapest to set before
+    // the SFZ is loaded. sfizz holds off rendering while it reloads, so this may be called from any
+    // thread; calls and loads on the same instrument take turns. The qualities are handed to the
+    // render thread, which applies them before its next block. Returns false if an option was
+    // invalid; the valid ones are still applied.
+    bool applyConfig(const SfizzConfig& config) {
+        std::lock_guard<std::mutex> lock(mLoadMutex);
+        auto isValid = true;
+
+        if (config.preloadSize > 0) {
+            mSampler->setPreloadSize(static_cast<uint32_t>(config.preloadSize));
+        }
+        if (config.oversamplingFactor > 0) {
+            isValid = mSampler->setOversamplingFactor(config.oversamplingFactor) && isValid;
+        }
+        // Freewheeling quality is left alone, so offline renders keep sfizz's higher default
+        if (config.sampleQuality >= 0) {
+            mSampleQuality.store(config.sampleQuality, std::memory_order_relaxed);
+        }
+        if (config.oscillatorQuality >= 0) {
+            mOscillatorQuality.store(config.oscillatorQuality, std::memory_order_relaxed);
+        }
+        mIsLiveQualityPending.store(true, std::memory_order_release);
+        if (config.maxVoices > 0) {
+            mSampler->setNumVoices(config.maxVoices);
+        }
+        if (config.stealPolicy >= STEAL_OLDEST && config.stealPolicy <= STEAL_SAME_NOTE) {
+            mStealPolicy.store(static_cast<VoiceStealPolicy>(config.stealPolicy), std::memory_order_relaxed);
+        }
+
+        return isValid;
+    }
+
+    SfizzConfig getConfig() {
+        return {
+            static_cast<int32_t>(mSampler->getPreloadSize()),
+            mSampler->getOversamplingFactor(),
+            mSampleQuality.load(std::memory_order_relaxed),
+            mOscillatorQuality.load(std::memory_order_relaxed),
+            mSampler->getNumVoices(),
+            mStealPolicy.load(std::memory_order_relaxed),
+        };
+    }
+
+    void getStats(SfizzStats& stats) {
+        stats = {};
+        stats.config = getConfig();
+        stats.preloadedFilesCount = static_cast<uint32_t>(mSampler->getNumPreloadedSamples());
+        stats.activeVoicesCount = static_cast<uint32_t>(mSampler->getNumActiveVoices());
+
+        // sfizz keeps preloaded heads as oversampled stereo floats
+        stats.preloadBytes = static_cast<uint64_t>(stats.preloadedFilesCount) * stats.config.preloadSize
+            * stats.config.oversamplingFactor * 2 * sizeof(float);
     }
 
     bool loadSfzString(const char* sampleRoot, const char* sfzString, const char* tuningString) {
+        std::lock_guard<std::mutex> lock(mLoadMutex);
         auto loadResult = mSampler->loadSfzString(sampleRoot, sfzString);
         auto loadTuningResult = true;
 
@@ -34,6 +125,7 @@ public:
     }
 
     bool loadSfzFile(const char* path, const char* tuningPath) {
+        std::lock_guard<std::mutex> lock(mLoadMutex);
         auto loadResult = mSampler->loadSfzFile(path);
         auto loadTuningResult = true;
 
@@ -44,28 +136,51 @@ public:
         return loadResult && loadTuningResult && mSampler->getNumRegions();
     }
 
+    // sfizz renders planar stereo and clears its buffers itself.
     void renderAudio(float *audioData, int32_t numFrames) override {
-        float leftBuffer[numFrames];
-        float rightBuffer[numFrames];
-        float* buffers[2];
+        applyPendingLiveQuality();
 
-        buffers[0] = leftBuffer;
-        buffers[1] = rightBuffer;
+        for (int32_t offset = 0; offset < numFrames; offset += mScratchFrames) {
+            auto framesToRender = std::min(mScratchFrames, numFrames - offset);
+            float* buffers[2] = { mScratch.get(), mScratch.get() + mScratchFrames };
 
-        for (int f = 0; f < numFrames; f++) {
-            leftBuffer[f] = 0.;
-            rightBuffer[f] = 0.;
-        }
+            mSampler->renderBlock(buffers, framesToRender);
 
-        mSampler->renderBlock(buffers, numFrames);
+            handleTail(buffers, framesToRender);
 
-        for (int f = 0; f < numFrames; f++) {
             if (mIsStereo) {
-                for (int c = 0; c < 2; c++) {
-                    audioData[f * 2 + c] = buffers[c][f];
-                }
+                ChannelKernel::interleave(buffers[0], buffers[1], audioData + offset * 2, framesToRender);
+            } else {
+                ChannelKernel::downmix(buffers[0], buffers[1], audioData + offset, framesToRender);
+            }
+        }
+    }
+
+    bool canRenderPlanar() override {
+        return true;
+    }
+
+    void renderAudioPlanar(float **channelData, int32_t channelCount, int32_t numFrames) override {
+        for (int32_t channel = 2; channel < channelCount; channel++) {
+            memset(channelData[channel], 0, sizeof(float) * numFrames);
+        }
+
+        applyPendingLiveQuality();
+
+        for (int32_t offset = 0; offset < numFrames; offset += mScratchFrames) {
+            auto framesToRender = std::min(mScratchFrames, numFrames - offset);
+            auto left = channelData[0] + offset;
+
+            if (channelCount >= 2) {
+                float* buffers[2] = { left, channelData[1] + offset };
+                mSampler->renderBlock(buffers, framesToRender);
+                handleTail(buffers, framesToRender);
             } else {
-                audioData[f] = (buffers[0][f] + buffers[1][f]) / 2;
+                // Mono: render the right channel into scratch and fold it into the left
+                float* buffers[2] = { left, mScratch.get() };
+                mSampler->renderBlock(buffers, framesToRender);
+                handleTail(buffers, framesToRender);
+                ChannelKernel::downmix(left, buffers[1], left, framesToRender);
             }
         }
     }
@@ -73,11 +188,16 @@ public:
     void handleMidiEvent(uint8_t status, uint8_t data1, uint8_t data2) override {
         auto statusCode = status >> 4;
 
-        if (statusCode == 0x9) {
+        if (statusCode == 0x9 && data2 > 0) {
             // Note On
+            makeRoomForNote(data1);
+            if (mNoteStamps[data1] == 0) mHeldNoteCount++;
+            mNoteStamps[data1] = ++mNextNoteStamp;
+            mNoteVelocities[data1] = data2;
             mSampler->noteOn(0, data1, data2);
-        } else if (statusCode == 0x8) {
+        } else if (statusCode == 0x8 || statusCode == 0x9) {
             // Note Off
+            releaseNote(data1);
             mSampler->noteOff(0, data1, data2);
         } else if (statusCode == 0xB) {
             // CC
@@ -93,9 +213,153 @@ public:
     void reset() override {
     }
 
+    // sfizz's effect buses can ring on after the last voice ends, so wait for the output to fall
+    // silent too.
+    bool isIdle() override {
+        return mIsTailSilent && mSampler->getNumActiveVoices() == 0;
+    }
+
+    void setVoiceCap(int32_t voiceCap) override {
+        mVoiceCap = voiceCap;
+    }
+
+    // Oversampling isn't stepped down, since changing it reloads every sample while the engine is
+    // already short of time.
+    void setQualityTier(QualityTier tier) override {
+        mQualityTier = tier;
+        applyLiveQuality();
+    }
+
 private:
+    static constexpr int32_t kDefaultScratchFrames = 1024;
+    static constexpr float kSilenceLevel = 0.00001f; // -100 dB
+
+    // Blocks are rendered in chunks of this size, since sfizz can't render more than
+    // samplesPerBlock frames at once.
+    void allocateScratch(int32_t frames) {
+        if (frames <= 0 || frames == mScratchFrames) return;
+
+        mScratch = std::make_unique<float[]>(frames * 2);
+        mScratchFrames = frames;
+    }
+
+    // Render thread only, so sfizz's live qualities only ever have one writer.
+    void applyPendingLiveQuality() {
+        if (mIsLiveQualityPending.exchange(false, std::memory_order_acquire)) {
+            applyLiveQuality();
+        }
+    }
+
+    // The configured qualities, lowered by the quality tier. Setting them only stores a value in
+    // sfizz, so this is safe on the render thread.
+    void applyLiveQuality() {
+        auto sampleQuality = mSampleQuality.load(std::memory_order_relaxed);
+        auto oscillatorQuality = mOscillatorQuality.load(std::memory_order_relaxed);
+
+        if (mQualityTier >= QUALITY_MINIMAL) {
+            sampleQuality = 0;
+            oscillatorQuality = 0;
+        } else if (mQualityTier >= QUALITY_REDUCED_INTERPOLATION) {
+            sampleQuality = std::min(sampleQuality, 1);
+            oscillatorQuality = std::min(oscillatorQuality, 0);
+        }
+
+        mSampler->setSampleQuality(sfz::Sfizz::ProcessLive, sampleQuality);
+        mSampler->setOscillatorQuality(sfz::Sfizz::ProcessLive, oscillatorQuality);
+    }
+
+    // Called after each render, to cut or measure what's left once the voices stop.
+    void handleTail(float* const* buffers, int32_t numFrames) {
+        cutInaudibleTail(buffers, numFrames);
+
+        mIsTailSilent = mSampler->getNumActiveVoices() == 0
+            && getPeak(buffers[0], numFrames) < kSilenceLevel
+            && getPeak(buffers[1], numFrames) < kSilenceLevel;
+    }
+
+    static float getPeak(const float* samples, int32_t numFrames) {
+        float peak = 0.0f;
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            peak = std::max(peak, std::abs(samples[frame]));
+        }
+
+        return peak;
+    }
+
+    // With no notes held, silences what's left of the release tails once they're inaudible. Not
+    // checked at full quality, where every tail plays out.
+    void cutInaudibleTail(float* const* buffers, int32_t numFrames) {
+        if (mQualityTier < QUALITY_REDUCED_VOICES || mHeldNoteCount > 0) return;
+        if (mSampler->getNumActiveVoices() == 0) return;
+
+        if (getPeak(buffers[0], numFrames) >= kInaudibleTailLevel) return;
+        if (getPeak(buffers[1], numFrames) >= kInaudibleTailLevel) return;
+
+        mSampler->allSoundOff();
+    }
+
+    void releaseNote(uint8_t key) {
+        if (mNoteStamps[key] == 0) return;
+
+        mNoteStamps[key] = 0;
+        mHeldNoteCount--;
+    }
+
+    // sfizz steals voices itself once all of its preallocated ones are playing. Below that, while
+    // the engine's voice budget or the quality tier caps the track, release a held note so the new
+    // one fits. sfizz doesn't expose voice levels, so velocity stands in for loudness.
+    void makeRoomForNote(uint8_t key) {
+        auto numVoices = mSampler->getNumVoices();
+        auto voiceLimit = std::min(mVoiceCap, getTierVoiceLimit(numVoices, mQualityTier));
+        if (voiceLimit >= numVoices || mSampler->getNumActiveVoices() < voiceLimit) return;
+
+        auto stealPolicy = mStealPolicy.load(std::memory_order_relaxed);
+        int32_t victim = -1;
+
+        if (stealPolicy == STEAL_SAME_NOTE && mNoteStamps[key] != 0) {
+            victim = key;
+        } else {
+            for (int32_t note = 0; note < 128; note++) {
+                if (mNoteStamps[note] == 0) continue;
+
+                auto isBetter = victim == -1
+                    || (stealPolicy == STEAL_QUIETEST
+                        ? mNoteVelocities[note] < mNoteVelocities[victim]
+                        : mNoteStamps[note] < mNoteStamps[victim]);
+                if (isBetter) victim = note;
+            }
+        }
+
+        if (victim == -1) return;
+
+        releaseNote(victim);
+        mSampler->noteOff(0, victim, 0);
+    }
+
     bool mIsStereo;
     std::unique_ptr<sfz::Sfizz> mSampler;
+    std::unique_ptr<float[]> mScratch; // Two channels of mScratchFrames
+    int32_t mScratchFrames = 0;
+
+    std::mutex mLoadMutex; // Held while loading or reconfiguring
+
+    // Set from the control thread and read by the render thread
+    std::atomic<int32_t> mSampleQuality { 0 };
+    std::atomic<int32_t> mOscillatorQuality { 0 };
+    std::atomic<bool> mIsLiveQualityPending { false };
+    std::atomic<VoiceStealPolicy> mStealPolicy { STEAL_OLDEST };
+
+    // Render thread only
+    QualityTier mQualityTier = QUALITY_FULL;
+
+    int32_t mVoiceCap = INT32_MAX;
+    int32_t mHeldNoteCount = 0;
+    bool mIsTailSilent = true;
+    // Held notes, in the order they started. 0 means the note isn't held.
+    uint32_t mNoteStamps[128] = {};
+    uint8_t mNoteVelocities[128] = {};
+    uint32_t mNextNoteStamp = 0;
 };
 
 #endif
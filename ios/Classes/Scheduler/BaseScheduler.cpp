@@ -1,26 +1,52 @@
 #include "BaseScheduler.h"
 
-#include <limits>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
 #include "SchedulerEvent.h"
 
+// The audio thread can't wake the dispatcher without risking a lock, so it polls
+static constexpr auto kNotificationPollInterval = std::chrono::milliseconds(10);
+
+BaseScheduler::BaseScheduler() {
+    for (auto& renderingTrack : mRenderingTracks) {
+        renderingTrack.store(-1, std::memory_order_relaxed);
+    }
+}
+
+BaseScheduler::~BaseScheduler() {
+    stopNotificationDispatcher();
+}
+
 track_index_t BaseScheduler::addTrack() {
-    auto maxTracks = std::numeric_limits<track_index_t>::max();
-    
-    for (track_index_t trackIndex = 0; trackIndex < maxTracks; trackIndex++) {
-        if (mBufferMap[trackIndex] == nullptr) {
-            auto buffer = std::make_shared<Buffer<>>();
-            
-            mBufferMap[trackIndex] = buffer;
-            
-            return trackIndex;
-        }
+    auto trackIndex = mTracks.add();
+    if (trackIndex == -1) return -1;
+
+    auto slot = trackSlot(trackIndex);
+    auto& buffer = mBuffers[slot];
+    if (buffer == nullptr) {
+        // The buffer goes last, since renderTrackFrames takes a buffer to mean the rest are there
+        mLoops[slot] = std::make_unique<TrackLoop>();
+        mEventStores[slot] = std::make_unique<EventStore>();
+        buffer = std::make_unique<Buffer<>>();
+    } else {
+        buffer->clear();
+        mLoops[slot]->clear();
+        mEventStores[slot]->clear();
     }
-    
-    return -1;
+
+    return trackIndex;
 }
 
 void BaseScheduler::removeTrack(track_index_t trackIndex) {
-    mBufferMap.erase(trackIndex);
+    if (!mTracks.remove(trackIndex)) return;
+
+    // Stop waiting for this track before advancing the position
+    auto renderingTrack = trackIndex;
+    if (mRenderingTracks[trackSlot(trackIndex)].compare_exchange_strong(renderingTrack, -1)) {
+        mRenderingTrackCount.fetch_sub(1);
+    }
 
     onRemoveTrack(trackIndex);
 }
@@ -29,21 +55,208 @@ void BaseScheduler::handleEventsNow(track_index_t trackIndex, const SchedulerEve
     for (uint32_t i = 0; i < eventsCount; i++) {
         handleEvent(trackIndex, events[i], 0);
     }
+
+    noteActivity();
 }
 
 uint32_t BaseScheduler::scheduleEvents(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount) {
     // Events must come after anything already in the buffer and be sorted by frame, ascending.
-    return mBufferMap[trackIndex]->add(events, eventsCount);
+    auto buffer = getBuffer(trackIndex);
+    if (buffer == nullptr) return 0;
+
+    auto addedCount = buffer->add(events, eventsCount);
+    noteActivity();
+
+    return addedCount;
 };
 
+uint32_t BaseScheduler::scheduleRawEvents(track_index_t trackIndex, const uint8_t* rawEvents, uint32_t eventsCount) {
+    auto buffer = getBuffer(trackIndex);
+    if (buffer == nullptr) return 0;
+
+    auto addedCount = buffer->addRaw(rawEvents, eventsCount);
+    noteActivity();
+
+    return addedCount;
+}
+
+uint32_t BaseScheduler::scheduleEventsMulti(const uint8_t* rawData, uint32_t rawDataSize, uint32_t runsCount, uint32_t* acceptedCounts) {
+    constexpr uint32_t kRunHeaderSize = sizeof(int32_t) + sizeof(uint32_t);
+    uint32_t offset = 0;
+    uint32_t totalAcceptedCount = 0;
+
+    for (uint32_t run = 0; run < runsCount; run++) {
+        acceptedCounts[run] = 0;
+        if (rawDataSize - offset < kRunHeaderSize) continue;
+
+        track_index_t trackIndex;
+        uint32_t eventsCount;
+        memcpy(&trackIndex, rawData + offset, sizeof(int32_t));
+        memcpy(&eventsCount, rawData + offset + sizeof(int32_t), sizeof(uint32_t));
+        offset += kRunHeaderSize;
+
+        eventsCount = std::min(eventsCount, static_cast<uint32_t>((rawDataSize - offset) / sizeof(SchedulerEvent)));
+        acceptedCounts[run] = scheduleRawEvents(trackIndex, rawData + offset, eventsCount);
+        totalAcceptedCount += acceptedCounts[run];
+        offset += eventsCount * sizeof(SchedulerEvent);
+    }
+
+    return totalAcceptedCount;
+}
+
+uint32_t BaseScheduler::getEventRing(track_index_t trackIndex, SchedulerEvent** events, uint32_t** readPosition, uint32_t** writePosition) {
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+                  "The ring positions are shared as plain uint32_t");
+
+    auto buffer = getBuffer(trackIndex);
+    if (buffer == nullptr) return 0;
+
+    *events = buffer->getEvents();
+    *readPosition = reinterpret_cast<uint32_t*>(buffer->getReadPosition());
+    *writePosition = reinterpret_cast<uint32_t*>(buffer->getWritePosition());
+    return Buffer<>::kCapacity;
+}
+
+void BaseScheduler::publishEventRings(const track_index_t* trackIndices, const uint32_t* writePositions, uint32_t tracksCount) {
+    for (uint32_t i = 0; i < tracksCount; i++) {
+        auto buffer = getBuffer(trackIndices[i]);
+        if (buffer == nullptr) continue;
+
+        buffer->publishWritePosition(writePositions[i]);
+    }
+
+    noteActivity();
+}
+
 void BaseScheduler::clearEvents(track_index_t trackIndex, position_frame_t fromFrame) {
-    mBufferMap[trackIndex]->clearAfter(fromFrame);
+    auto buffer = getBuffer(trackIndex);
+    if (buffer == nullptr) return;
+
+    buffer->clearAfter(fromFrame);
 };
 
+uint32_t BaseScheduler::insertEvents(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount, event_id_t* ids) {
+    if (!mTracks.isLive(trackIndex)) return 0;
+
+    mEventStores[trackSlot(trackIndex)]->insert(events, eventsCount, ids);
+    noteActivity();
+    return eventsCount;
+}
+
+uint32_t BaseScheduler::removeEvents(track_index_t trackIndex, const event_id_t* ids, uint32_t idsCount) {
+    if (!mTracks.isLive(trackIndex)) return 0;
+
+    return mEventStores[trackSlot(trackIndex)]->remove(ids, idsCount);
+}
+
+uint32_t BaseScheduler::eraseEvents(track_index_t trackIndex, position_frame_t fromFrame, position_frame_t toFrame) {
+    if (!mTracks.isLive(trackIndex)) return 0;
+
+    return mEventStores[trackSlot(trackIndex)]->erase(fromFrame, toFrame);
+}
+
+uint32_t BaseScheduler::setTrackLoop(track_index_t trackIndex, position_frame_t loopStartFrame, uint32_t loopLengthFrames, const SchedulerEvent* events, uint32_t eventsCount) {
+    if (!mTracks.isLive(trackIndex)) return 0;
+
+    auto acceptedCount = mLoops[trackSlot(trackIndex)]->set(loopStartFrame, loopLengthFrames, events, eventsCount);
+    noteActivity();
+
+    return acceptedCount;
+}
+
+void BaseScheduler::clearTrackLoop(track_index_t trackIndex) {
+    if (!mTracks.isLive(trackIndex)) return;
+
+    mLoops[trackSlot(trackIndex)]->clear();
+}
+
+bool BaseScheduler::setTickTimebase(position_frame_t originFrame, uint32_t sampleRate) {
+    return queueTempoMessage(TEMPO_TICK_TIMEBASE, originFrame, &sampleRate, sizeof(sampleRate));
+}
+
+bool BaseScheduler::setFrameTimebase() {
+    return queueTempoMessage(TEMPO_FRAME_TIMEBASE, 0, nullptr, 0);
+}
+
+bool BaseScheduler::setTempo(position_tick_t tick, float bpm) {
+    return queueTempoMessage(TEMPO_SET, tick, &bpm, sizeof(bpm));
+}
+
+bool BaseScheduler::rampTempo(position_tick_t startTick, position_tick_t endTick, float endBpm) {
+    uint8_t data[sizeof(float) + sizeof(position_tick_t)];
+    memcpy(data, &endBpm, sizeof(float));
+    memcpy(data + sizeof(float), &endTick, sizeof(position_tick_t));
+
+    return queueTempoMessage(TEMPO_RAMP, startTick, data, sizeof(data));
+}
+
+bool BaseScheduler::queueTempoMessage(uint32_t type, uint32_t frame, const void* data, size_t dataSize) {
+    SchedulerEvent message = {};
+    message.frame = frame;
+    message.type = type;
+    memcpy(message.data, data, std::min(dataSize, sizeof(message.data)));
+
+    auto isQueued = mTempoMessages.add(&message, 1) == 1;
+    noteActivity();
+
+    return isQueued;
+}
+
+void BaseScheduler::applyTempoMessages() {
+    SchedulerEvent message;
+
+    while (mTempoMessages.peek(message)) {
+        float bpm;
+        uint32_t value;
+        memcpy(&bpm, message.data, sizeof(float));
+        memcpy(&value, message.data + sizeof(float), sizeof(uint32_t));
+
+        auto tick = message.frame == kTempoTickNow
+            ? mTempoMap.getFirstTickAtOrAfter(mPositionFrames)
+            : message.frame;
+
+        switch (message.type) {
+            case TEMPO_SET:
+                mTempoMap.setTempo(tick, bpm);
+                break;
+            case TEMPO_RAMP:
+                mTempoMap.rampTempo(tick, value, bpm);
+                break;
+            case TEMPO_TICK_TIMEBASE:
+                memcpy(&value, message.data, sizeof(uint32_t));
+                mTempoMap.setOrigin(message.frame, value);
+                mIsTickTimebase = true;
+                resetEventStoreReads();
+                break;
+            case TEMPO_FRAME_TIMEBASE:
+                mIsTickTimebase = false;
+                resetEventStoreReads();
+                break;
+        }
+
+        mTempoMessages.removeTop();
+    }
+}
+
+void BaseScheduler::resetEventStoreReads() {
+    auto& live = mTracks.acquireLive();
+
+    for (int32_t i = 0; i < live.count; i++) {
+        auto trackIndex = live.tracks[i];
+
+        if (getBuffer(trackIndex) != nullptr) {
+            mEventStores[trackSlot(trackIndex)]->resetReadPosition();
+        }
+    }
+
+    mTracks.releaseLive();
+}
+
 void BaseScheduler::play() {
     if (mIsPlaying) return;
 
     mIsPlaying = true;
+    noteActivity();
 };
 
 void BaseScheduler::pause() {
@@ -52,6 +265,10 @@ void BaseScheduler::pause() {
     mIsPlaying = false;
 };
 
+bool BaseScheduler::getIsPlaying() {
+    return mIsPlaying;
+}
+
 void BaseScheduler::resetTrack(track_index_t trackIndex) {
     SchedulerEvent events[128];
     for (uint8_t noteNumber = 0; noteNumber < 128; noteNumber++) {
@@ -67,7 +284,16 @@ void BaseScheduler::resetTrack(track_index_t trackIndex) {
 }
 
 uint32_t BaseScheduler::getBufferAvailableCount(track_index_t trackIndex) {
-    return mBufferMap[trackIndex]->availableCount();
+    auto buffer = getBuffer(trackIndex);
+    if (buffer == nullptr) return 0;
+
+    return buffer->availableCount();
+}
+
+void BaseScheduler::getBufferAvailableCounts(const track_index_t* trackIndices, uint32_t tracksCount, uint32_t* availableCounts) {
+    for (uint32_t i = 0; i < tracksCount; i++) {
+        availableCounts[i] = getBufferAvailableCount(trackIndices[i]);
+    }
 }
 
 position_frame_t BaseScheduler::getPosition() {
@@ -75,30 +301,182 @@ position_frame_t BaseScheduler::getPosition() {
 }
 
 uint64_t BaseScheduler::getLastRenderTimeUs() {
+    TransportSnapshot snapshot;
+    getTransportSnapshot(&snapshot);
+
     timeval t;
     gettimeofday(&t, NULL);
-    return t.tv_sec*uint64_t(1000000) + uint64_t(t.tv_usec);
+    auto nowUs = t.tv_sec*uint64_t(1000000) + uint64_t(t.tv_usec);
+    if (snapshot.hostTimeUs == 0) return nowUs;
+
+    // Shift the monotonic render time onto the wall clock
+    return nowUs - (snapshot.readTimeUs - std::min(snapshot.hostTimeUs, snapshot.readTimeUs));
+}
+
+void BaseScheduler::getTransportSnapshot(TransportSnapshot* snapshot) {
+    mTransport.read(*snapshot);
+    snapshot->readTimeUs = getHostTimeUs();
+}
+
+void BaseScheduler::setOutputLatencyFrames(uint32_t outputLatencyFrames) {
+    mOutputLatencyFrames.store(outputLatencyFrames, std::memory_order_relaxed);
+}
+
+uint64_t BaseScheduler::getHostTimeUs() {
+    auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count();
+}
+
+void BaseScheduler::publishTransportSnapshot(uint64_t hostTimeUs, uint32_t blockFrames) {
+    auto& snapshot = mPendingTransport;
+    auto& live = mTracks.acquireLive();
+    uint32_t tracksCount = 0;
+
+    for (int32_t i = 0; i < live.count; i++) {
+        auto trackIndex = live.tracks[i];
+        auto buffer = getBuffer(trackIndex);
+        if (buffer == nullptr) continue;
+
+        snapshot.tracks[tracksCount++] = { trackIndex, buffer->count() };
+    }
+
+    mTracks.releaseLive();
+
+    snapshot.hostTimeUs = hostTimeUs;
+    snapshot.readTimeUs = 0;
+    snapshot.positionFrame = mPositionFrames;
+    snapshot.blockFrames = blockFrames;
+    snapshot.outputLatencyFrames = mOutputLatencyFrames.load(std::memory_order_relaxed);
+    snapshot.isPlaying = mIsPlaying;
+    snapshot.tracksCount = tracksCount;
+
+    mTransport.write(snapshot);
+}
+
+bool BaseScheduler::hasPendingEvents() {
+    auto fromTime = mIsTickTimebase ? mTempoMap.getFirstTickAtOrAfter(mPositionFrames) : mPositionFrames;
+
+    auto isTrackPending = [&](track_index_t trackIndex) {
+        auto buffer = getBuffer(trackIndex);
+        if (buffer == nullptr) return false;
+        if (buffer->count() > 0) return true;
+
+        auto slot = trackSlot(trackIndex);
+        auto loop = mLoops[slot].get();
+        auto hasLoop = loop->acquire() != nullptr;
+        loop->release();
+        if (hasLoop) return true;
+
+        auto eventStore = mEventStores[slot].get();
+        SchedulerEvent storeEvent;
+        eventStore->beginRead(fromTime);
+        auto hasStoreEvent = eventStore->peek(storeEvent);
+        eventStore->endRead();
+        return hasStoreEvent;
+    };
+
+    auto& live = mTracks.acquireLive();
+    auto hasPending = false;
+
+    for (int32_t i = 0; i < live.count && !hasPending; i++) {
+        hasPending = isTrackPending(live.tracks[i]);
+    }
+
+    mTracks.releaseLive();
+    return hasPending;
 }
 
-void BaseScheduler::handleFrames(track_index_t trackIndex, uint32_t numFramesToRender) {
+void BaseScheduler::handleFrames(track_index_t trackIndex, uint32_t numFramesToRender, uint64_t hostTimeUs) {
     if (!mIsPlaying) return;
-    
-    auto buffer = mBufferMap[trackIndex];
-    auto originalPositionFrames = mPositionFrames; // so we can check if setPosition was called
-    auto startFrame = mPositionFrames;
+
+    // Tracks render one after another, so only change the tempo map before the first of a block
+    if (mRenderedCount == 0) {
+        applyTempoMessages();
+        mBlockHostTimeUs = hostTimeUs != 0 ? hostTimeUs : getHostTimeUs();
+    }
+
+    auto startFrame = mPositionFrames; // so we can check if setPosition was called
+
+    renderTrackFrames(trackIndex, startFrame, numFramesToRender);
+    if (!mTracks.isLive(trackIndex)) return;
+
+    // Only tracks that have rendered at least once hold back the position, so a track that has been
+    // added but isn't connected to the output yet doesn't stall playback.
+    auto slot = trackSlot(trackIndex);
+    if (mRenderingTracks[slot].load(std::memory_order_relaxed) != trackIndex) {
+        mRenderingTracks[slot].store(trackIndex, std::memory_order_relaxed);
+        mRenderingTrackCount.fetch_add(1);
+    }
+
+    if (mRenderedBlock[slot] != mCurrentBlock) {
+        mRenderedBlock[slot] = mCurrentBlock;
+        mRenderedCount++;
+    }
+
+    if (mRenderedCount >= mRenderingTrackCount.load()) {
+        advancePosition(startFrame, numFramesToRender);
+        publishTransportSnapshot(mBlockHostTimeUs, numFramesToRender);
+
+        mCurrentBlock++;
+        mRenderedCount = 0;
+    }
+}
+
+void BaseScheduler::renderTrackFrames(track_index_t trackIndex, position_frame_t startFrame, uint32_t numFramesToRender) {
+    auto buffer = getBuffer(trackIndex);
+    if (buffer == nullptr) {
+        handleRenderAudioRange(trackIndex, 0, numFramesToRender);
+        return;
+    }
+
+    // Event times are either frames or ticks. Ticks are converted to frames as each event comes up,
+    // so the buffered events don't depend on the tempo.
+    auto isTickTimebase = mIsTickTimebase;
+    auto startTime = isTickTimebase ? mTempoMap.getFirstTickAtOrAfter(startFrame) : startFrame;
+    auto slot = trackSlot(trackIndex);
+    auto loop = mLoops[slot].get();
+    auto loopPattern = loop->acquire();
+    auto loopCursor = LoopCursor(loopPattern, startTime);
     auto lastFrameRendered = startFrame;
     uint32_t framesRendered = 0;
 
-    SchedulerEvent nextEvent;
+    // Stored events that haven't been read yet can be late by as much as buffered ones
+    auto eventStore = mEventStores[slot].get();
+    auto lateFrame = startFrame > 1024 ? startFrame - 1024 : 0;
+    eventStore->beginRead(isTickTimebase ? mTempoMap.getFirstTickAtOrAfter(lateFrame) : lateFrame);
+
+    SchedulerEvent bufferEvent;
+    SchedulerEvent storeEvent;
+    SchedulerEvent loopEvent;
+
+    while (true) {
+        auto hasBufferEvent = buffer->peek(bufferEvent);
+        auto hasStoreEvent = eventStore->peek(storeEvent);
+        auto hasLoopEvent = loopCursor.peek(loopEvent);
 
-    while (buffer->peek(nextEvent)) {
-        auto eventFrame = nextEvent.frame;
+        if (!hasBufferEvent && !hasStoreEvent && !hasLoopEvent) break;
+
+        // Merge the sources by time. On a tie the buffer goes first, then the store, then the loop.
+        // Loop events never start before startFrame.
+        auto source = hasBufferEvent ? BUFFER_SOURCE : (hasStoreEvent ? STORE_SOURCE : LOOP_SOURCE);
+        auto nextEvent = hasBufferEvent ? bufferEvent : (hasStoreEvent ? storeEvent : loopEvent);
+
+        if (hasStoreEvent && storeEvent.frame < nextEvent.frame) {
+            source = STORE_SOURCE;
+            nextEvent = storeEvent;
+        }
+        if (hasLoopEvent && loopEvent.frame < nextEvent.frame) {
+            source = LOOP_SOURCE;
+            nextEvent = loopEvent;
+        }
+
+        auto eventFrame = isTickTimebase ? mTempoMap.getFrame(nextEvent.frame) : nextEvent.frame;
         
         if (eventFrame < startFrame) {
             // Skip events that are more than 1024 frames the past
             if (eventFrame + 1024 < startFrame) {
                 // printf("Track %i: Skipping event with frame %i, which is less than start frame %i\n", trackIndex, eventFrame, startFrame);
-                buffer->removeTop();
+                removeSourceTop(source, buffer, eventStore, loopCursor);
                 continue;
             } else {
                 // printf("Track %i: Accepting late event with frame %i, which is less than start frame %i\n", trackIndex, eventFrame, startFrame);
@@ -116,34 +494,153 @@ void BaseScheduler::handleFrames(track_index_t trackIndex, uint32_t numFramesToR
         framesRendered += (eventFrame - lastFrameRendered);
         lastFrameRendered = eventFrame;
         
-        handleEvent(trackIndex, nextEvent, framesRendered);
-        buffer->removeTop();
+        if (nextEvent.type == MARKER_EVENT) {
+            uint32_t markerId;
+            memcpy(&markerId, nextEvent.data, sizeof(markerId));
+            mTrackNotifications[slot].push({ NOTIFICATION_MARKER, trackIndex, eventFrame, markerId });
+        } else {
+            handleEvent(trackIndex, nextEvent, framesRendered);
+        }
+        removeSourceTop(source, buffer, eventStore, loopCursor);
     }
-    
+
+    auto endFrame = startFrame + numFramesToRender;
+    notifyLoopWrap(trackIndex, loopPattern, startTime, isTickTimebase ? mTempoMap.getFirstTickAtOrAfter(endFrame) : endFrame);
+    notifyBufferLevel(trackIndex, buffer, startFrame);
+
+    eventStore->endRead();
+    loop->release();
     handleRenderAudioRange(trackIndex, framesRendered, numFramesToRender - framesRendered);
-    
+}
 
-    mHasRenderedMap[trackIndex] = true;
-    bool allTracksHaveRendered = true;
-    
-    for (auto pair : mHasRenderedMap) {
-        if (pair.second == false) {
-            allTracksHaveRendered = false;
-            break;
+// Notifies when an iteration of the loop starts in [startTime, endTime). Loops are assumed to be
+// longer than a block, so only the first start is reported.
+void BaseScheduler::notifyLoopWrap(track_index_t trackIndex, const LoopPattern* pattern, uint32_t startTime, uint32_t endTime) {
+    if (pattern == nullptr) return;
+
+    auto firstWrapTime = pattern->startFrame + pattern->lengthFrames;
+    uint32_t iteration = 1;
+    if (startTime > firstWrapTime) {
+        iteration = (startTime - pattern->startFrame + pattern->lengthFrames - 1) / pattern->lengthFrames;
+    }
+
+    auto wrapTime = pattern->startFrame + iteration * pattern->lengthFrames;
+    if (wrapTime < startTime || wrapTime >= endTime) return;
+
+    auto wrapFrame = mIsTickTimebase ? mTempoMap.getFrame(wrapTime) : wrapTime;
+    mTrackNotifications[trackSlot(trackIndex)].push({ NOTIFICATION_LOOP_WRAPPED, trackIndex, wrapFrame, iteration });
+}
+
+// Notifies once each time the buffer drops below the watermark.
+void BaseScheduler::notifyBufferLevel(track_index_t trackIndex, Buffer<>* buffer, position_frame_t frame) {
+    auto watermark = mBufferLowWatermark.load(std::memory_order_relaxed);
+    auto slot = trackSlot(trackIndex);
+    auto bufferedCount = buffer->count();
+
+    if (bufferedCount >= watermark) {
+        mIsBufferLow[slot] = false;
+    } else if (!mIsBufferLow[slot]) {
+        mIsBufferLow[slot] = true;
+        mTrackNotifications[slot].push({ NOTIFICATION_BUFFER_LOW, trackIndex, frame, bufferedCount });
+    }
+}
+
+void BaseScheduler::setNotificationPort(Dart_Port notificationPort) {
+    stopNotificationDispatcher();
+    if (notificationPort == 0) return;
+
+    mIsNotificationThreadStopping = false;
+    mNotificationThread = std::thread(&BaseScheduler::runNotificationDispatcher, this, notificationPort);
+}
+
+void BaseScheduler::setBufferLowWatermark(uint32_t bufferLowWatermark) {
+    mBufferLowWatermark.store(bufferLowWatermark, std::memory_order_relaxed);
+}
+
+void BaseScheduler::reportUnderrun(uint32_t underrunCount) {
+    mEngineNotifications.push({ NOTIFICATION_UNDERRUN, -1, mPositionFrames, underrunCount });
+}
+
+void BaseScheduler::reportQualityTier(uint32_t qualityTier) {
+    mEngineNotifications.push({ NOTIFICATION_QUALITY_CHANGED, -1, mPositionFrames, qualityTier });
+}
+
+void BaseScheduler::runNotificationDispatcher(Dart_Port notificationPort) {
+    std::vector<uint32_t> values;
+    std::unique_lock<std::mutex> lock(mNotificationMutex);
+
+    while (!mIsNotificationThreadStopping) {
+        mNotificationCondition.wait_for(lock, kNotificationPollInterval);
+        lock.unlock();
+
+        values.clear();
+        drainNotifications(values);
+        if (!values.empty()) {
+            callbackToDartUint32Array(notificationPort, static_cast<int>(values.size()), values.data());
         }
+
+        lock.lock();
     }
-    
-    if (allTracksHaveRendered) {
-        // Don't update the position if setPosition was called during this function
-        if (mPositionFrames == originalPositionFrames) {
-            mPositionFrames = startFrame + numFramesToRender;
-            // printf("Track %i: Updated position to %i\n", trackIndex, mPositionFrames);
-        // } else {
-            // printf("Track %i: Not updating position since it changed during render\n", trackIndex);
+}
+
+// Appends every queued notification as four values. They come grouped by queue, not by frame.
+void BaseScheduler::drainNotifications(std::vector<uint32_t>& values) {
+    auto drain = [&](NotificationQueue<>& queue) {
+        Notification notification;
+
+        while (queue.pop(notification)) {
+            values.insert(values.end(), { notification.type, static_cast<uint32_t>(notification.trackIndex), notification.frame, notification.value });
         }
-        
-        for (auto pair : mHasRenderedMap) {
-            mHasRenderedMap[pair.first] = false;
+
+        auto droppedCount = queue.takeDroppedCount();
+        if (droppedCount > 0) {
+            values.insert(values.end(), { NOTIFICATION_DROPPED, static_cast<uint32_t>(-1), 0, droppedCount });
         }
+    };
+
+    for (auto& queue : mTrackNotifications) {
+        drain(queue);
+    }
+    drain(mEngineNotifications);
+}
+
+void BaseScheduler::stopNotificationDispatcher() {
+    if (!mNotificationThread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mNotificationMutex);
+        mIsNotificationThreadStopping = true;
+    }
+    mNotificationCondition.notify_one();
+    mNotificationThread.join();
+}
+
+void BaseScheduler::removeSourceTop(EventSource source, Buffer<>* buffer, EventStore* eventStore, LoopCursor& loopCursor) {
+    switch (source) {
+        case BUFFER_SOURCE:
+            buffer->removeTop();
+            break;
+        case STORE_SOURCE:
+            eventStore->removeTop();
+            break;
+        case LOOP_SOURCE:
+            loopCursor.removeTop();
+            break;
+    }
+}
+
+Buffer<>* BaseScheduler::getBuffer(track_index_t trackIndex) {
+    if (!mTracks.isLive(trackIndex)) return nullptr;
+
+    return mBuffers[trackSlot(trackIndex)].get();
+}
+
+void BaseScheduler::advancePosition(position_frame_t startFrame, uint32_t numFramesRendered) {
+    // Don't update the position if setPosition was called during the render
+    if (mPositionFrames == startFrame) {
+        mPositionFrames = startFrame + numFramesRendered;
+        // printf("Updated position to %i\n", mPositionFrames);
+    // } else {
+        // printf("Not updating position since it changed during render\n");
     }
 }
@@ -1,44 +1,227 @@
 #ifndef BaseScheduler_h
 #define BaseScheduler_h
 #include <stdint.h>
-
-typedef int32_t track_index_t;
+#include "TrackTable.h"
 
 #ifdef __cplusplus
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
 #include <sys/time.h>
+#include <thread>
+#include <vector>
 #include <Buffer.h>
 #include <CallbackManager.h>
 #include <SchedulerEvent.h>
+#include "EventStore.h"
+#include "NotificationQueue.h"
+#include "Seqlock.h"
+#include "TempoMap.h"
+#include "TrackLoop.h"
+
+constexpr int32_t kMaxTrackSlots = 128;
+
+// Messages that change how event times map to frames. They reach the audio thread through a
+// Buffer, so they are applied in order and only between blocks.
+enum TempoMessageType {
+    TEMPO_SET = 0,              // frame: tick, data: float bpm
+    TEMPO_RAMP = 1,             // frame: start tick, data: float end bpm, uint32 end tick
+    TEMPO_TICK_TIMEBASE = 2,    // frame: origin frame, data: uint32 sample rate
+    TEMPO_FRAME_TIMEBASE = 3,
+};
+
+// A track's buffer fill level, as of the last block.
+struct TrackBufferLevel {
+    track_index_t trackIndex;
+    uint32_t bufferedCount; // Events scheduled but not yet played
+};
+
+// The transport as of the last rendered block. The audio thread publishes one every block, so the
+// position and the time it was rendered at always belong together. The layout is read by Dart.
+struct TransportSnapshot {
+    uint64_t hostTimeUs; // Monotonic time the block was rendered at, on the getHostTimeUs() clock
+    uint64_t readTimeUs; // Monotonic time the snapshot was read, filled in by getTransportSnapshot
+    position_frame_t positionFrame; // The position after the block
+    uint32_t blockFrames;
+    uint32_t outputLatencyFrames;
+    uint32_t isPlaying;
+    uint32_t tracksCount;
+    uint32_t padding;
+    TrackBufferLevel tracks[kMaxTrackSlots];
+};
+
+static_assert(sizeof(TransportSnapshot) == 40 + kMaxTrackSlots * sizeof(TrackBufferLevel), "Dart reads TransportSnapshot by offset");
+
+#define METER_CHANNELS 2
+
+// Peak and RMS levels of one track over the last meter window, after its level and pan. Mono
+// output is reported on both channels.
+struct TrackMeter {
+    track_index_t trackIndex;
+    float peaks[METER_CHANNELS];
+    float rms[METER_CHANNELS];
+};
+
+// Levels of every track mixed in the last meter window, and of the mix. The layout is read by Dart.
+struct MeterLevels {
+    uint32_t windowFrames;
+    uint32_t tracksCount;
+    float masterPeaks[METER_CHANNELS];
+    float masterRms[METER_CHANNELS];
+    TrackMeter tracks[kMaxTrackSlots];
+};
+
+static_assert(sizeof(MeterLevels) == 24 + kMaxTrackSlots * 20, "Dart reads MeterLevels by offset");
 
 class BaseScheduler {
 public:
+    BaseScheduler();
+    ~BaseScheduler();
+
     track_index_t addTrack();
     void removeTrack(track_index_t trackIndex);
     virtual void onRemoveTrack(track_index_t trackIndex) = 0; // Will be called at the end of removeTrack.
 
     void handleEventsNow(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount);
     uint32_t scheduleEvents(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount);
+    // Schedules raw event data, as Dart lays it out, copying it straight into the buffer.
+    uint32_t scheduleRawEvents(track_index_t trackIndex, const uint8_t* rawEvents, uint32_t eventsCount);
+    // Schedules events for several tracks in one pass. rawData holds runsCount runs, each an int32
+    // track index and a uint32 events count followed by that many raw events, in the layout
+    // rawEventDataToEvents reads. Writes the number of events each run's buffer accepted to
+    // acceptedCounts. Returns the total accepted.
+    uint32_t scheduleEventsMulti(const uint8_t* rawData, uint32_t rawDataSize, uint32_t runsCount, uint32_t* acceptedCounts);
     void clearEvents(track_index_t trackIndex, position_frame_t fromFrame);
+    // Adds events to the track's event store, which plays them alongside the buffer. Unlike
+    // scheduleEvents, the events can be in any order and can later be removed individually by the
+    // ids written to ids, or by time range. Returns the number of events added.
+    uint32_t insertEvents(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount, event_id_t* ids);
+    uint32_t removeEvents(track_index_t trackIndex, const event_id_t* ids, uint32_t idsCount);
+    // Removes stored events from fromFrame up to but not including toFrame.
+    uint32_t eraseEvents(track_index_t trackIndex, position_frame_t fromFrame, position_frame_t toFrame);
+    // Repeats the events every loopLengthFrames, starting at loopStartFrame, alongside the events
+    // in the track's buffer. Event frames are relative to the start of the loop. Replaces any loop
+    // already set on the track. Returns the number of events accepted.
+    uint32_t setTrackLoop(track_index_t trackIndex, position_frame_t loopStartFrame, uint32_t loopLengthFrames, const SchedulerEvent* events, uint32_t eventsCount);
+    void clearTrackLoop(track_index_t trackIndex);
+    // From the next block, event times (including clearEvents and loops) are ticks on the tempo
+    // map, with tick 0 on originFrame, and tempo changes don't need the events to be rescheduled.
+    // Each of these queues a message for the audio thread and returns false if the queue is full.
+    bool setTickTimebase(position_frame_t originFrame, uint32_t sampleRate);
+    bool setFrameTimebase();
+    // tick can be kTempoTickNow, for the playhead position when the change is applied.
+    bool setTempo(position_tick_t tick, float bpm);
+    bool rampTempo(position_tick_t startTick, position_tick_t endTick, float endBpm);
     void play();
     void pause();
+    bool getIsPlaying();
     void resetTrack(track_index_t trackIndex);
     virtual void onResetTrack(track_index_t trackIndex) = 0;
 
-    void handleFrames(track_index_t trackIndex, uint32_t numFramesToRender);
+    // Renders one track and advances the position once every track has rendered this block.
+    // hostTimeUs is when the block was rendered, on the getHostTimeUs() clock, or 0 for now.
+    void handleFrames(track_index_t trackIndex, uint32_t numFramesToRender, uint64_t hostTimeUs = 0);
+    // Renders one track's frames and handles its events, without touching the shared position.
+    // Calls for different tracks may run concurrently.
+    void renderTrackFrames(track_index_t trackIndex, position_frame_t startFrame, uint32_t numFramesToRender);
     virtual void handleRenderAudioRange(track_index_t trackIndex, uint32_t offsetFrame, uint32_t numFramesToRender) = 0;
     virtual void handleEvent(track_index_t trackIndex, SchedulerEvent event, position_frame_t offsetFrame) = 0;
 
+    // Shares a track's event buffer, so Dart can write events into it in place. Returns the ring's
+    // capacity, or 0 for an invalid track. The ring stays valid until the track is removed. The
+    // writer fills slots from the write position on, up to the read position, and then publishes
+    // the new write position with publishEventRings, which stores it with release ordering.
+    uint32_t getEventRing(track_index_t trackIndex, SchedulerEvent** events, uint32_t** readPosition, uint32_t** writePosition);
+    void publishEventRings(const track_index_t* trackIndices, const uint32_t* writePositions, uint32_t tracksCount);
     uint32_t getBufferAvailableCount(track_index_t trackIndex);
+    void getBufferAvailableCounts(const track_index_t* trackIndices, uint32_t tracksCount, uint32_t* availableCounts);
     position_frame_t getPosition();
+    // Wall-clock time of the last render. Prefer getTransportSnapshot, which pairs it with the
+    // position it rendered.
     uint64_t getLastRenderTimeUs();
+    // Copies the latest transport snapshot, without blocking the audio thread.
+    void getTransportSnapshot(TransportSnapshot* snapshot);
+    // The delay from rendering a frame to hearing it, reported in transport snapshots.
+    void setOutputLatencyFrames(uint32_t outputLatencyFrames);
+    static uint64_t getHostTimeUs();
+
+    // Posts notifications to a Dart port in batches, each a Uint32List of four values per
+    // notification, laid out like Notification. A port of 0 stops posting.
+    void setNotificationPort(Dart_Port notificationPort);
+    // Posts NOTIFICATION_BUFFER_LOW when a track's buffer drops below this many events. 0 turns it off.
+    void setBufferLowWatermark(uint32_t bufferLowWatermark);
+    // Audio thread only.
+    void reportUnderrun(uint32_t underrunCount);
+    // Audio thread only.
+    void reportQualityTier(uint32_t qualityTier);
+    // Bumped by every call that could give the audio thread something to play, so an engine that
+    // has stopped rendering can tell when to start again.
+    uint32_t getActivityCount() { return mActivityCount.load(std::memory_order_acquire); }
+    bool isTrackLive(track_index_t trackIndex) { return mTracks.isLive(trackIndex); }
 protected:
-    std::unordered_map<track_index_t, std::shared_ptr<Buffer<>>> mBufferMap = {};
-    std::unordered_map<track_index_t, bool> mHasRenderedMap = {};
+    void advancePosition(position_frame_t startFrame, uint32_t numFramesRendered);
+    Buffer<>* getBuffer(track_index_t trackIndex);
+    // Audio thread only, before rendering a block.
+    void applyTempoMessages();
+    // Audio thread only, once per block after it has rendered.
+    void publishTransportSnapshot(uint64_t hostTimeUs, uint32_t blockFrames);
+    // Audio thread only. Whether any track has buffered or stored events still to play, or a loop.
+    bool hasPendingEvents();
+
+    TrackTable<kMaxTrackSlots> mTracks;
+    // Indexed by trackSlot(). Buffers are allocated the first time a slot is used and then reused.
+    std::array<std::unique_ptr<Buffer<>>, kMaxTrackSlots> mBuffers;
+    std::array<std::unique_ptr<TrackLoop>, kMaxTrackSlots> mLoops;
+    std::array<std::unique_ptr<EventStore>, kMaxTrackSlots> mEventStores;
 private:
+    enum EventSource { BUFFER_SOURCE, STORE_SOURCE, LOOP_SOURCE };
+
+    void removeSourceTop(EventSource source, Buffer<>* buffer, EventStore* eventStore, LoopCursor& loopCursor);
+    void resetEventStoreReads();
+    bool queueTempoMessage(uint32_t type, uint32_t frame, const void* data, size_t dataSize);
+    void notifyLoopWrap(track_index_t trackIndex, const LoopPattern* pattern, uint32_t startTime, uint32_t endTime);
+    void notifyBufferLevel(track_index_t trackIndex, Buffer<>* buffer, position_frame_t frame);
+    void runNotificationDispatcher(Dart_Port notificationPort);
+    void drainNotifications(std::vector<uint32_t>& values);
+    void stopNotificationDispatcher();
+    void noteActivity() { mActivityCount.fetch_add(1, std::memory_order_release); }
+
+    // Only touched by the audio thread
+    TempoMap mTempoMap;
+    bool mIsTickTimebase = false;
+    Buffer<64> mTempoMessages;
+
+    // Used by handleFrames to tell when every track has rendered the current block
+    std::array<std::atomic<track_index_t>, kMaxTrackSlots> mRenderingTracks;
+    std::atomic<int32_t> mRenderingTrackCount { 0 };
+    std::array<uint32_t, kMaxTrackSlots> mRenderedBlock = {};
+    uint32_t mCurrentBlock = 1;
+    int32_t mRenderedCount = 0;
+
+    uint64_t mBlockHostTimeUs = 0;
+
     bool mIsPlaying = false;
     position_frame_t mPositionFrames = 0;
+
+    Seqlock<TransportSnapshot> mTransport;
+    TransportSnapshot mPendingTransport = {}; // Built by the audio thread before publishing
+    std::atomic<uint32_t> mOutputLatencyFrames { 0 };
+
+    // Each track's queue is only pushed to while the track renders, and the engine's only from the
+    // audio callback, so every queue has a single producer even when tracks render in parallel.
+    std::array<NotificationQueue<>, kMaxTrackSlots> mTrackNotifications;
+    NotificationQueue<> mEngineNotifications;
+    std::array<bool, kMaxTrackSlots> mIsBufferLow = {}; // Only touched while the track renders
+    std::atomic<uint32_t> mBufferLowWatermark { 0 };
+
+    std::atomic<uint32_t> mActivityCount { 0 };
+
+    std::thread mNotificationThread;
+    std::mutex mNotificationMutex;
+    std::condition_variable mNotificationCondition;
+    bool mIsNotificationThreadStopping = false;
 };
 
 #endif
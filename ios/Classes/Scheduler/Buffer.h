@@ -3,7 +3,9 @@
 
 #ifdef __cplusplus
 #include "SchedulerEvent.h"
+#include <algorithm>
 #include <atomic>
+#include <cstring>
 
 template <
     uint32_t BUFFER_SIZE = 1024,
@@ -11,6 +13,9 @@ template <
 >
 class Buffer {
 public:
+    static_assert(sizeof(SchedulerEvent) == 16, "Raw event data (SCHEDULER_EVENT_SIZE in Dart) must match SchedulerEvent");
+    static constexpr buffer_index_t kCapacity = BUFFER_SIZE;
+
     buffer_index_t add(const SchedulerEvent* eventsToAdd, buffer_index_t toAddCount) {
         if (toAddCount == 0) return 0;
         buffer_index_t existingEventsCount = count();
@@ -32,6 +37,32 @@ public:
 
         return maxEventsToAdd;
     }
+
+    // Adds events straight from raw event data, which has SchedulerEvent's layout, with one copy.
+    buffer_index_t addRaw(const uint8_t* rawEvents, buffer_index_t toAddCount) {
+        auto maxEventsToAdd = std::min(toAddCount, availableCount());
+        if (maxEventsToAdd == 0) return 0;
+
+        auto writePosition = mWritePosition.load();
+        auto firstCount = std::min<uint32_t>(maxEventsToAdd, BUFFER_SIZE - mask(writePosition));
+
+        memcpy(&mEvents[mask(writePosition)], rawEvents, firstCount * sizeof(SchedulerEvent));
+        memcpy(&mEvents[0], rawEvents + firstCount * sizeof(SchedulerEvent), (maxEventsToAdd - firstCount) * sizeof(SchedulerEvent));
+        mWritePosition.store(writePosition + maxEventsToAdd);
+
+        return maxEventsToAdd;
+    }
+
+    // The ring's memory, for a writer outside C++ to fill in place. It writes events from the write
+    // position on, masked by BUFFER_SIZE, without passing the read position, then publishes the new
+    // write position with publishWritePosition().
+    SchedulerEvent* getEvents() { return mEvents; }
+    std::atomic<buffer_index_t>* getReadPosition() { return &mReadPosition; }
+    std::atomic<buffer_index_t>* getWritePosition() { return &mWritePosition; }
+
+    void publishWritePosition(buffer_index_t writePosition) {
+        mWritePosition.store(writePosition, std::memory_order_release);
+    }
     
     void clearAfter(position_frame_t frame) {
         buffer_index_t existingEventsCount = count();
@@ -0,0 +1,70 @@
+#ifndef ChannelKernel_h
+#define ChannelKernel_h
+
+#include <cstdint>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Converts between planar stereo and the layouts instruments are asked for, four frames at a time,
+ * for instruments whose synth renders planar but are asked for interleaved or mono output.
+ */
+namespace ChannelKernel {
+
+inline void interleave(const float* left, const float* right, float* output, int32_t numFrames) {
+    int32_t frame = 0;
+
+#if defined(__SSE__)
+    for (; frame + 4 <= numFrames; frame += 4) {
+        auto l = _mm_loadu_ps(left + frame);
+        auto r = _mm_loadu_ps(right + frame);
+
+        _mm_storeu_ps(output + frame * 2, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(output + frame * 2 + 4, _mm_unpackhi_ps(l, r));
+    }
+#elif defined(__ARM_NEON)
+    for (; frame + 4 <= numFrames; frame += 4) {
+        float32x4x2_t frames = { { vld1q_f32(left + frame), vld1q_f32(right + frame) } };
+
+        vst2q_f32(output + frame * 2, frames);
+    }
+#endif
+
+    for (; frame < numFrames; frame++) {
+        output[frame * 2] = left[frame];
+        output[frame * 2 + 1] = right[frame];
+    }
+}
+
+// output may be left or right.
+inline void downmix(const float* left, const float* right, float* output, int32_t numFrames) {
+    int32_t frame = 0;
+
+#if defined(__SSE__)
+    auto half = _mm_set1_ps(0.5f);
+
+    for (; frame + 4 <= numFrames; frame += 4) {
+        auto sum = _mm_add_ps(_mm_loadu_ps(left + frame), _mm_loadu_ps(right + frame));
+
+        _mm_storeu_ps(output + frame, _mm_mul_ps(sum, half));
+    }
+#elif defined(__ARM_NEON)
+    for (; frame + 4 <= numFrames; frame += 4) {
+        auto sum = vaddq_f32(vld1q_f32(left + frame), vld1q_f32(right + frame));
+
+        vst1q_f32(output + frame, vmulq_n_f32(sum, 0.5f));
+    }
+#endif
+
+    for (; frame < numFrames; frame++) {
+        output[frame] = (left[frame] + right[frame]) * 0.5f;
+    }
+}
+
+}
+
+#endif /* ChannelKernel_h */
@@ -0,0 +1,338 @@
+#ifndef EventStore_h
+#define EventStore_h
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "SchedulerEvent.h"
+
+typedef uint32_t event_id_t;
+
+/**
+ * A track's events, kept sorted by time, that can be edited anywhere while they play. Unlike
+ * Buffer, events don't have to arrive in order and stay put once they've played, so one note can be
+ * moved or deleted without rescheduling the rest of the track.
+ *
+ * Events are held in a treap ordered by (time, id). Edits copy the O(log n) nodes on the path they
+ * change and publish the new root atomically, so the audio thread always reads a consistent
+ * version without waiting. Nodes that the audio thread might still be reading are freed once it has
+ * moved on to a newer version.
+ *
+ * insert(), remove(), erase() and clear() must be called from a single non-realtime thread. The
+ * read functions must be called from a single realtime thread.
+ */
+class EventStore {
+public:
+    EventStore() {}
+    EventStore(const EventStore&) = delete;
+    EventStore& operator=(const EventStore&) = delete;
+
+    ~EventStore() {
+        freeTree(mWriterRoot);
+        for (auto& retired : mRetired) {
+            delete retired.second;
+        }
+        for (auto node : mRetiring) {
+            delete node;
+        }
+    }
+
+    // Adds events in any order. Events at the same time play in the order they were added. Writes
+    // each event's id to ids, if it isn't null.
+    void insert(const SchedulerEvent* events, uint32_t eventsCount, event_id_t* ids) {
+        for (uint32_t i = 0; i < eventsCount; i++) {
+            auto id = mNextId++;
+            auto node = new Node { events[i], id, hashId(id), 1, mVersion, nullptr, nullptr };
+            Node* before;
+            Node* after;
+
+            split(mWriterRoot, { events[i].frame, id }, before, after);
+            mWriterRoot = merge(merge(before, node), after);
+            mEventTimes[id] = events[i].frame;
+
+            if (ids != nullptr) ids[i] = id;
+        }
+
+        publish();
+    }
+
+    // Returns the number of ids that were found and removed.
+    uint32_t remove(const event_id_t* ids, uint32_t idsCount) {
+        uint32_t removedCount = 0;
+
+        for (uint32_t i = 0; i < idsCount; i++) {
+            auto time = mEventTimes.find(ids[i]);
+            if (time == mEventTimes.end()) continue;
+
+            Key key = { time->second, ids[i] };
+            Node* before;
+            Node* rest;
+            Node* removed;
+            Node* after;
+
+            split(mWriterRoot, key, before, rest);
+            split(rest, { key.time, key.id + 1 }, removed, after);
+            mWriterRoot = merge(before, after);
+            retireTree(removed);
+            removedCount++;
+        }
+
+        publish();
+        return removedCount;
+    }
+
+    // Removes every event from fromTime up to but not including toTime. Returns how many there were.
+    uint32_t erase(position_frame_t fromTime, position_frame_t toTime) {
+        if (toTime <= fromTime) return 0;
+
+        Node* before;
+        Node* rest;
+        Node* erased;
+        Node* after;
+
+        split(mWriterRoot, { fromTime, 0 }, before, rest);
+        split(rest, { toTime, 0 }, erased, after);
+        mWriterRoot = merge(before, after);
+
+        auto erasedCount = size(erased);
+        retireTree(erased);
+        publish();
+
+        return erasedCount;
+    }
+
+    void clear() {
+        retireTree(mWriterRoot);
+        mWriterRoot = nullptr;
+        publish();
+    }
+
+    uint32_t count() const {
+        return size(mWriterRoot);
+    }
+
+    // Audio thread only. Starts reading the newest version, from the first event at or after
+    // fromTime that hasn't been read yet. Must be followed by endRead().
+    void beginRead(position_frame_t fromTime) {
+        mReadingEpoch.store(mEpoch.load());
+        mReadRoot = mRoot.load();
+
+        Key fromKey = { fromTime, 0 };
+        if (mHasReadKey && !(mReadKey < fromKey)) {
+            mReadNext = findFirstAfter(mReadKey);
+        } else {
+            mReadNext = findFirstAtOrAfter(fromKey);
+        }
+    }
+
+    bool peek(SchedulerEvent& event) const {
+        if (mReadNext == nullptr) return false;
+
+        event = mReadNext->event;
+        return true;
+    }
+
+    void removeTop() {
+        if (mReadNext == nullptr) return;
+
+        mReadKey = mReadNext->key();
+        mHasReadKey = true;
+        mReadNext = findFirstAfter(mReadKey);
+    }
+
+    void endRead() {
+        mReadRoot = nullptr;
+        mReadNext = nullptr;
+        mReadingEpoch.store(kNotReading);
+    }
+
+    // Audio thread only. Forgets which events have been read, for when event times have changed
+    // meaning.
+    void resetReadPosition() {
+        mHasReadKey = false;
+    }
+
+private:
+    struct Key {
+        position_frame_t time;
+        event_id_t id;
+
+        bool operator<(const Key& other) const {
+            return time < other.time || (time == other.time && id < other.id);
+        }
+    };
+
+    struct Node {
+        SchedulerEvent event;
+        event_id_t id;
+        uint32_t priority;
+        uint32_t size;
+        uint64_t version; // The version this node was created for. Only unpublished nodes can change.
+        Node* left;
+        Node* right;
+
+        Key key() const { return { event.frame, id }; }
+    };
+
+    static constexpr uint64_t kNotReading = UINT64_MAX;
+
+    static uint32_t hashId(event_id_t id) {
+        uint32_t x = id * 0x9E3779B9u;
+        x ^= x >> 16;
+        x *= 0x85EBCA6Bu;
+        x ^= x >> 13;
+        return x;
+    }
+
+    static uint32_t size(const Node* node) {
+        return node == nullptr ? 0 : node->size;
+    }
+
+    static void update(Node* node) {
+        node->size = 1 + size(node->left) + size(node->right);
+    }
+
+    // Returns a node that can be changed in this version, copying it if it has been published.
+    Node* own(Node* node) {
+        if (node->version == mVersion) return node;
+
+        auto copy = new Node(*node);
+        copy->version = mVersion;
+        mRetiring.push_back(node);
+        return copy;
+    }
+
+    // Splits into the nodes before key and the nodes at or after it.
+    void split(Node* node, Key key, Node*& before, Node*& after) {
+        if (node == nullptr) {
+            before = nullptr;
+            after = nullptr;
+        } else if (node->key() < key) {
+            node = own(node);
+            split(node->right, key, node->right, after);
+            update(node);
+            before = node;
+        } else {
+            node = own(node);
+            split(node->left, key, before, node->left);
+            update(node);
+            after = node;
+        }
+    }
+
+    // Every node in before must come before every node in after.
+    Node* merge(Node* before, Node* after) {
+        if (before == nullptr) return after;
+        if (after == nullptr) return before;
+
+        if (before->priority > after->priority) {
+            before = own(before);
+            before->right = merge(before->right, after);
+            update(before);
+            return before;
+        } else {
+            after = own(after);
+            after->left = merge(before, after->left);
+            update(after);
+            return after;
+        }
+    }
+
+    // Drops a subtree that's no longer reachable from the writer's root.
+    void retireTree(Node* node) {
+        if (node == nullptr) return;
+
+        retireTree(node->left);
+        retireTree(node->right);
+        mEventTimes.erase(node->id);
+
+        if (node->version == mVersion) {
+            delete node;
+        } else {
+            mRetiring.push_back(node);
+        }
+    }
+
+    void freeTree(Node* node) {
+        if (node == nullptr) return;
+
+        freeTree(node->left);
+        freeTree(node->right);
+        delete node;
+    }
+
+    void publish() {
+        mRoot.store(mWriterRoot);
+        // Once the epoch has moved on, a reader that starts can only see the new root
+        auto epoch = mEpoch.fetch_add(1);
+        mVersion++;
+
+        for (auto node : mRetiring) {
+            mRetired.emplace_back(epoch, node);
+        }
+        mRetiring.clear();
+
+        // Free what the reader can no longer reach. It reads from a root at least as new as the
+        // epoch it announced.
+        auto readingEpoch = mReadingEpoch.load();
+        size_t freedCount = 0;
+
+        while (freedCount < mRetired.size() && mRetired[freedCount].first < readingEpoch) {
+            delete mRetired[freedCount].second;
+            freedCount++;
+        }
+        mRetired.erase(mRetired.begin(), mRetired.begin() + freedCount);
+    }
+
+    const Node* findFirstAtOrAfter(Key key) const {
+        const Node* found = nullptr;
+
+        for (auto node = mReadRoot; node != nullptr;) {
+            if (node->key() < key) {
+                node = node->right;
+            } else {
+                found = node;
+                node = node->left;
+            }
+        }
+
+        return found;
+    }
+
+    const Node* findFirstAfter(Key key) const {
+        const Node* found = nullptr;
+
+        for (auto node = mReadRoot; node != nullptr;) {
+            if (key < node->key()) {
+                found = node;
+                node = node->left;
+            } else {
+                node = node->right;
+            }
+        }
+
+        return found;
+    }
+
+    std::atomic<Node*> mRoot { nullptr };
+    std::atomic<uint64_t> mEpoch { 0 };
+    std::atomic<uint64_t> mReadingEpoch { kNotReading };
+
+    // Writer state
+    Node* mWriterRoot = nullptr;
+    uint64_t mVersion = 1;
+    event_id_t mNextId = 0;
+    std::unordered_map<event_id_t, position_frame_t> mEventTimes;
+    std::vector<Node*> mRetiring; // Replaced in the version being built
+    std::vector<std::pair<uint64_t, Node*>> mRetired; // Tagged with the epoch they were replaced in
+
+    // Reader state
+    const Node* mReadRoot = nullptr;
+    const Node* mReadNext = nullptr;
+    Key mReadKey = { 0, 0 };
+    bool mHasReadKey = false;
+};
+
+#endif /* EventStore_h */
@@ -0,0 +1,76 @@
+#ifndef NotificationQueue_h
+#define NotificationQueue_h
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "SchedulerEvent.h"
+#include "TrackTable.h"
+
+#define NOTIFICATION_QUEUE_SIZE 64
+
+// Things the audio thread tells Dart about. Remember to keep lib/models/notifications.dart in sync.
+enum NotificationType {
+    NOTIFICATION_MARKER = 0,          // value: marker id
+    NOTIFICATION_LOOP_WRAPPED = 1,    // value: iteration that started
+    NOTIFICATION_BUFFER_LOW = 2,      // value: events left in the buffer
+    NOTIFICATION_UNDERRUN = 3,        // value: underruns since the last one reported
+    NOTIFICATION_DROPPED = 4,         // value: notifications lost because the queue was full
+    NOTIFICATION_QUALITY_CHANGED = 5, // value: the quality tier the engine moved to
+};
+
+// Posted to Dart as four uint32s. trackIndex is -1 for notifications about the whole engine.
+struct Notification {
+    uint32_t type;
+    track_index_t trackIndex;
+    position_frame_t frame;
+    uint32_t value;
+};
+
+/**
+ * A fixed-size single producer, single consumer queue of notifications. push() never blocks or
+ * allocates, so the audio thread can call it. When the queue is full the notification is dropped
+ * and counted instead.
+ */
+template <uint32_t CAPACITY = NOTIFICATION_QUEUE_SIZE>
+class NotificationQueue {
+public:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of 2");
+
+    // Producer only.
+    bool push(const Notification& notification) {
+        auto writePosition = mWritePosition.load(std::memory_order_relaxed);
+
+        if (writePosition - mReadPosition.load(std::memory_order_acquire) == CAPACITY) {
+            mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        mNotifications[writePosition & (CAPACITY - 1)] = notification;
+        mWritePosition.store(writePosition + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only.
+    bool pop(Notification& notification) {
+        auto readPosition = mReadPosition.load(std::memory_order_relaxed);
+        if (readPosition == mWritePosition.load(std::memory_order_acquire)) return false;
+
+        notification = mNotifications[readPosition & (CAPACITY - 1)];
+        mReadPosition.store(readPosition + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns how many notifications were dropped since the last call.
+    uint32_t takeDroppedCount() {
+        return mDroppedCount.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<Notification, CAPACITY> mNotifications;
+    std::atomic<uint32_t> mWritePosition { 0 };
+    std::atomic<uint32_t> mReadPosition { 0 };
+    std::atomic<uint32_t> mDroppedCount { 0 };
+};
+
+#endif /* NotificationQueue_h */
@@ -15,6 +15,11 @@ VolumeEventData::VolumeEventData(uint8_t* data) {
     this->volume = *(float*)data;
 }
 
+SendEventData::SendEventData(uint8_t* data) {
+    this->level = *(float*)data;
+    this->sendBus = *(uint32_t*)(data + sizeof(float));
+}
+
 void rawEventDataToEvents(const uint8_t* rawEventData, uint32_t eventsCount, struct SchedulerEvent* events) {
     for (int32_t i = 0; i < eventsCount; i++) {
         const uint8_t* nextEventPtr = rawEventData + (i * sizeof(SchedulerEvent));
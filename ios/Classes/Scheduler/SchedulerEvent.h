@@ -1,5 +1,6 @@
 #ifndef SchedulerEvent_h
 #define SchedulerEvent_h
+#include <stdint.h>
 
 typedef uint32_t position_frame_t;
 
@@ -14,6 +15,8 @@ struct SchedulerEvent {
 enum EventType {
     MIDI_EVENT = 0,
     VOLUME_EVENT = 1,
+    MARKER_EVENT = 2, // data: uint32 marker id. Isn't handled by the track, only reported to Dart.
+    SEND_EVENT = 3, // data: float level, then uint32 send bus. Only Android has send buses.
 };
 
 #ifdef __cplusplus
@@ -33,6 +36,14 @@ public:
     
     float volume;
 };
+
+class SendEventData {
+public:
+    SendEventData(uint8_t* data);
+
+    float level;
+    uint32_t sendBus;
+};
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,75 @@
+#ifndef Seqlock_h
+#define Seqlock_h
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+/**
+ * Publishes a plain struct from one thread to any number of readers without blocking the writer.
+ * The writer bumps a sequence number to odd, writes, then bumps it to even. A reader copies the
+ * struct and retries if the sequence was odd or changed while it copied, so it never sees a mix of
+ * two writes.
+ *
+ * The struct is held as relaxed atomic words, so the racing copies are well defined.
+ *
+ * write() must be called from a single thread, usually the audio thread. It never waits.
+ */
+template <typename T>
+class Seqlock {
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock values are copied bytewise");
+
+    Seqlock() {
+        for (auto& word : mWords) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void write(const T& value) {
+        uint64_t words[kWordsCount] = {};
+        memcpy(words, &value, sizeof(T));
+
+        auto sequence = mSequence.load(std::memory_order_relaxed);
+        mSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < kWordsCount; i++) {
+            mWords[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        mSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void read(T& value) const {
+        uint64_t words[kWordsCount];
+
+        while (true) {
+            auto startSequence = mSequence.load(std::memory_order_acquire);
+
+            if ((startSequence & 1) == 0) {
+                for (size_t i = 0; i < kWordsCount; i++) {
+                    words[i] = mWords[i].load(std::memory_order_relaxed);
+                }
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (mSequence.load(std::memory_order_relaxed) == startSequence) break;
+            }
+
+            std::this_thread::yield();
+        }
+
+        memcpy(&value, words, sizeof(T));
+    }
+
+private:
+    static constexpr size_t kWordsCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> mSequence { 0 };
+    std::array<std::atomic<uint64_t>, kWordsCount> mWords;
+};
+
+#endif /* Seqlock_h */
@@ -0,0 +1,197 @@
+#ifndef TempoMap_h
+#define TempoMap_h
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include "SchedulerEvent.h"
+
+typedef uint32_t position_tick_t;
+
+#define TICKS_PER_BEAT 960
+#define TEMPO_MAP_MAX_SEGMENTS 256
+
+// Stands in for a tick in tempo changes, meaning wherever the playhead is when the change is applied
+constexpr position_tick_t kTempoTickNow = UINT32_MAX;
+
+// A span of the tempo map. A ramp runs linearly in ticks from startBpm to endBpm, ending where the
+// next segment starts. The last segment always holds startBpm.
+struct TempoSegment {
+    position_tick_t startTick;
+    double startBpm;
+    double endBpm;
+    double startFrame; // Frames from the origin to startTick
+};
+
+/**
+ * Converts between musical ticks and engine frames. Tick 0 plays at the origin frame.
+ *
+ * Not thread safe. The scheduler owns one on the audio thread and applies changes to it between
+ * blocks, so tracks rendering the same block always see the same map.
+ */
+class TempoMap {
+public:
+    TempoMap() {
+        mSegments[0] = { 0, 120.0, 120.0, 0.0 };
+        mSegmentsCount = 1;
+    }
+
+    void setOrigin(position_frame_t originFrame, double sampleRate) {
+        mOriginFrame = originFrame;
+
+        if (sampleRate > 0 && sampleRate != mSampleRate) {
+            mSampleRate = sampleRate;
+            updateSegmentFrames(0);
+        }
+    }
+
+    position_frame_t getOriginFrame() const { return mOriginFrame; }
+
+    // Holds bpm from tick onwards, replacing anything already mapped from there.
+    bool setTempo(position_tick_t tick, double bpm) {
+        if (bpm <= 0) return false;
+
+        truncate(tick);
+        return append(tick, bpm, bpm);
+    }
+
+    // Ramps from the current tempo at startTick to endBpm at endTick, then holds endBpm.
+    bool rampTempo(position_tick_t startTick, position_tick_t endTick, double endBpm) {
+        if (endBpm <= 0) return false;
+        if (endTick <= startTick) return setTempo(startTick, endBpm);
+
+        auto startBpm = getBpm(startTick);
+
+        truncate(startTick);
+        return append(startTick, startBpm, endBpm) && append(endTick, endBpm, endBpm);
+    }
+
+    double getBpm(position_tick_t tick) const {
+        auto index = findSegmentByTick(tick);
+        auto& segment = mSegments[index];
+        if (index == mSegmentsCount - 1) return segment.startBpm;
+
+        auto length = double(mSegments[index + 1].startTick - segment.startTick);
+        return segment.startBpm + (segment.endBpm - segment.startBpm) * (tick - segment.startTick) / length;
+    }
+
+    // The engine frame a tick plays on, rounded to the nearest frame.
+    position_frame_t getFrame(position_tick_t tick) const {
+        auto index = findSegmentByTick(tick);
+        auto& segment = mSegments[index];
+        auto frames = segment.startFrame + getSegmentFrames(index, tick - segment.startTick);
+
+        return mOriginFrame + static_cast<position_frame_t>(std::llround(frames));
+    }
+
+    // The first tick that plays on or after an engine frame.
+    position_tick_t getFirstTickAtOrAfter(position_frame_t frame) const {
+        if (frame <= mOriginFrame) return 0;
+
+        auto frames = double(frame - mOriginFrame);
+        auto index = findSegmentByFrame(frames);
+        auto& segment = mSegments[index];
+        auto ticks = segment.startTick + getSegmentTicks(index, frames - segment.startFrame);
+        auto tick = static_cast<position_tick_t>(std::min(std::ceil(ticks), double(kTempoTickNow - 1)));
+
+        // getFrame rounds, so step past any tick that rounds to either side of frame
+        while (tick > 0 && getFrame(tick - 1) >= frame) tick--;
+        while (getFrame(tick) < frame) tick++;
+
+        return tick;
+    }
+
+    int32_t getSegmentsCount() const { return mSegmentsCount; }
+
+private:
+    // Frames per tick at 1 bpm
+    double getFrameScale() const {
+        return mSampleRate * 60.0 / TICKS_PER_BEAT;
+    }
+
+    // Tempo change per tick, 0 for the last segment and constant segments
+    double getSlope(int32_t index) const {
+        if (index >= mSegmentsCount - 1) return 0.0;
+
+        auto& segment = mSegments[index];
+        auto length = double(mSegments[index + 1].startTick - segment.startTick);
+        return (segment.endBpm - segment.startBpm) / length;
+    }
+
+    // Frames from the start of a segment to ticks into it. On a ramp the bpm at tick x is
+    // b0 + k * x, so the time is the integral of 1 / (b0 + k * x).
+    double getSegmentFrames(int32_t index, double ticks) const {
+        auto startBpm = mSegments[index].startBpm;
+        auto slope = getSlope(index);
+
+        if (slope == 0.0) return getFrameScale() * ticks / startBpm;
+        return getFrameScale() * std::log1p(slope * ticks / startBpm) / slope;
+    }
+
+    // The inverse of getSegmentFrames.
+    double getSegmentTicks(int32_t index, double frames) const {
+        auto startBpm = mSegments[index].startBpm;
+        auto slope = getSlope(index);
+
+        if (slope == 0.0) return frames * startBpm / getFrameScale();
+        return startBpm * std::expm1(frames * slope / getFrameScale()) / slope;
+    }
+
+    int32_t findSegmentByTick(position_tick_t tick) const {
+        auto begin = mSegments.begin();
+        auto next = std::upper_bound(begin + 1, begin + mSegmentsCount, tick, [](position_tick_t tick, const TempoSegment& segment) {
+            return tick < segment.startTick;
+        });
+
+        return static_cast<int32_t>(next - begin) - 1;
+    }
+
+    int32_t findSegmentByFrame(double frames) const {
+        auto begin = mSegments.begin();
+        auto next = std::upper_bound(begin + 1, begin + mSegmentsCount, frames, [](double frames, const TempoSegment& segment) {
+            return frames < segment.startFrame;
+        });
+
+        return static_cast<int32_t>(next - begin) - 1;
+    }
+
+    // Drops everything from tick on. A ramp that spans tick is cut short at the tempo it had
+    // reached there, so the frames of earlier ticks don't move.
+    void truncate(position_tick_t tick) {
+        auto index = findSegmentByTick(tick);
+        auto& segment = mSegments[index];
+
+        if (segment.startTick == tick) {
+            mSegmentsCount = index;
+        } else {
+            segment.endBpm = getBpm(tick);
+            mSegmentsCount = index + 1;
+        }
+    }
+
+    bool append(position_tick_t tick, double startBpm, double endBpm) {
+        if (mSegmentsCount == TEMPO_MAP_MAX_SEGMENTS) return false;
+
+        mSegments[mSegmentsCount++] = { tick, startBpm, endBpm, 0.0 };
+        updateSegmentFrames(mSegmentsCount - 1);
+        return true;
+    }
+
+    void updateSegmentFrames(int32_t fromIndex) {
+        mSegments[0].startFrame = 0.0;
+
+        for (int32_t i = std::max(fromIndex, 1); i < mSegmentsCount; i++) {
+            auto& previous = mSegments[i - 1];
+
+            mSegments[i].startFrame = previous.startFrame + getSegmentFrames(i - 1, mSegments[i].startTick - previous.startTick);
+        }
+    }
+
+    std::array<TempoSegment, TEMPO_MAP_MAX_SEGMENTS> mSegments;
+    int32_t mSegmentsCount = 0;
+    position_frame_t mOriginFrame = 0;
+    double mSampleRate = 44100.0;
+};
+
+#endif /* TempoMap_h */
@@ -0,0 +1,162 @@
+#ifndef TrackLoop_h
+#define TrackLoop_h
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+#include "SchedulerEvent.h"
+
+#define LOOP_MAX_EVENTS 1024
+
+// The events of one loop iteration. Event frames are relative to the start of the iteration, from 0
+// up to and including lengthFrames, so an event on the loop end (usually a note off) plays at the
+// end of every iteration.
+struct LoopPattern {
+    position_frame_t startFrame; // Engine frame where the first iteration starts
+    uint32_t lengthFrames;
+    uint32_t eventsCount;
+    std::array<SchedulerEvent, LOOP_MAX_EVENTS> events;
+};
+
+/**
+ * A track's loop, repeated by the audio thread from its start frame onwards without any further
+ * input from the Dart side.
+ *
+ * The pattern is double-buffered. set() fills the bank the audio thread isn't using and then
+ * publishes it, so a pattern can be replaced while it plays. set() and clear() must be called from
+ * a single non-realtime thread.
+ */
+class TrackLoop {
+public:
+    // Events must be sorted by frame. Returns the number of events accepted.
+    uint32_t set(position_frame_t startFrame, uint32_t lengthFrames, const SchedulerEvent* events, uint32_t eventsCount) {
+        if (lengthFrames == 0) {
+            clear();
+            return 0;
+        }
+
+        auto bank = 1 - std::max(mActiveBank.load(std::memory_order_relaxed), 0);
+
+        // The audio thread may still be reading this bank if it was published just before the last
+        // set(). That lasts at most one render call.
+        while (mReadingBank.load(std::memory_order_seq_cst) == bank) {
+            std::this_thread::yield();
+        }
+
+        auto& pattern = mBanks[bank];
+        uint32_t acceptedCount = 0;
+
+        for (uint32_t i = 0; i < eventsCount && acceptedCount < LOOP_MAX_EVENTS; i++) {
+            if (events[i].frame > lengthFrames) break;
+
+            pattern.events[acceptedCount++] = events[i];
+        }
+
+        pattern.startFrame = startFrame;
+        pattern.lengthFrames = lengthFrames;
+        pattern.eventsCount = acceptedCount;
+        mActiveBank.store(bank, std::memory_order_seq_cst);
+
+        return acceptedCount;
+    }
+
+    void clear() {
+        mActiveBank.store(-1, std::memory_order_release);
+    }
+
+    // Audio thread only. Returns the pattern to play, or nullptr if there is no loop. Must be
+    // followed by release() once the render call is done with it.
+    const LoopPattern* acquire() {
+        while (true) {
+            auto bank = mActiveBank.load(std::memory_order_acquire);
+            if (bank < 0) return nullptr;
+
+            mReadingBank.store(bank, std::memory_order_seq_cst);
+
+            // Re-check, in case set() started overwriting the bank before it saw mReadingBank
+            if (mActiveBank.load(std::memory_order_seq_cst) == bank) {
+                return &mBanks[bank];
+            }
+        }
+    }
+
+    void release() {
+        mReadingBank.store(-1, std::memory_order_release);
+    }
+
+private:
+    std::array<LoopPattern, 2> mBanks;
+    std::atomic<int32_t> mActiveBank { -1 };
+    std::atomic<int32_t> mReadingBank { -1 };
+};
+
+/**
+ * Walks a loop pattern's events in engine frame order, starting from a given frame.
+ */
+class LoopCursor {
+public:
+    LoopCursor() {}
+
+    LoopCursor(const LoopPattern* pattern, position_frame_t fromFrame) : mPattern(pattern) {
+        if (pattern == nullptr || pattern->eventsCount == 0) {
+            mPattern = nullptr;
+            return;
+        }
+
+        auto startFrame = pattern->startFrame;
+        auto lengthFrames = pattern->lengthFrames;
+        uint32_t offsetFrame = 0;
+        mIterationStartFrame = startFrame;
+
+        if (fromFrame > startFrame) {
+            // fromFrame may fall exactly on an iteration boundary, where the previous iteration's
+            // loop end events are still due, so round down to the iteration it ends
+            auto iteration = (fromFrame - startFrame - 1) / lengthFrames;
+
+            mIterationStartFrame = startFrame + iteration * lengthFrames;
+            offsetFrame = fromFrame - mIterationStartFrame;
+        }
+
+        auto begin = pattern->events.begin();
+        auto end = begin + pattern->eventsCount;
+        auto next = std::lower_bound(begin, end, offsetFrame, [](const SchedulerEvent& event, uint32_t frame) {
+            return event.frame < frame;
+        });
+
+        mEventIndex = static_cast<uint32_t>(next - begin);
+        if (mEventIndex == pattern->eventsCount) {
+            nextIteration();
+        }
+    }
+
+    // Gets the next event, with its frame converted to an engine frame.
+    bool peek(SchedulerEvent& event) {
+        if (mPattern == nullptr) return false;
+
+        event = mPattern->events[mEventIndex];
+        event.frame += mIterationStartFrame;
+        return true;
+    }
+
+    void removeTop() {
+        if (mPattern == nullptr) return;
+
+        mEventIndex++;
+        if (mEventIndex == mPattern->eventsCount) {
+            nextIteration();
+        }
+    }
+
+private:
+    void nextIteration() {
+        mEventIndex = 0;
+        mIterationStartFrame += mPattern->lengthFrames;
+    }
+
+    const LoopPattern* mPattern = nullptr;
+    position_frame_t mIterationStartFrame = 0;
+    uint32_t mEventIndex = 0;
+};
+
+#endif /* TrackLoop_h */
@@ -0,0 +1,156 @@
+#ifndef TrackTable_h
+#define TrackTable_h
+
+#include <stdint.h>
+
+typedef int32_t track_index_t;
+
+// A track id holds the slot it occupies in its low bits and the slot's generation above them. The
+// generation is bumped every time the slot is reused, so an id that outlives its track won't
+// address whichever track takes the slot next.
+#define TRACK_SLOT_BITS 8
+#define TRACK_GENERATION_MASK 0x7FFFFF
+
+static inline int32_t trackSlot(track_index_t trackIndex) {
+    return trackIndex & ((1 << TRACK_SLOT_BITS) - 1);
+}
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+
+template <int32_t maxTracks>
+struct LiveTracks {
+    int32_t count;
+    std::array<track_index_t, maxTracks> tracks; // The first count are live, in no particular order
+};
+
+/**
+ * Fixed-capacity registry of live track ids. Per-track state lives in plain arrays indexed by
+ * trackSlot(), owned by whoever uses the table, so looking a track up is an array access instead of
+ * a hash lookup.
+ *
+ * add() and remove() must be called from a single non-realtime thread. The render thread iterates
+ * the live tracks at the same time through acquireLive(), which hands it a list that doesn't change
+ * under it. The list is double-buffered like a track loop: each change fills the bank the render
+ * thread isn't reading and then publishes it, waiting at most one iteration if the render thread
+ * is still reading the bank it wants. A list acquired before a removal can still hold the removed
+ * track, which fails isLive() from then on, but no track that stays live is ever missed.
+ */
+template <int32_t maxTracks>
+class TrackTable {
+public:
+    static_assert(maxTracks <= (1 << TRACK_SLOT_BITS), "Too many tracks for TRACK_SLOT_BITS");
+
+    TrackTable() {
+        publish();
+    }
+
+    // Takes the lowest free slot. Returns the new track's id, or -1 if the table is full.
+    track_index_t add() {
+        for (int32_t slot = 0; slot < maxTracks; slot++) {
+            auto& entry = mEntries[slot];
+
+            if (entry.liveIndex < 0) {
+                auto trackIndex = (entry.generation << TRACK_SLOT_BITS) | slot;
+
+                entry.liveIndex = mLive.count;
+                mLive.tracks[mLive.count++] = trackIndex;
+                entry.trackIndex.store(trackIndex, std::memory_order_release);
+                publish();
+
+                return trackIndex;
+            }
+        }
+
+        return -1;
+    }
+
+    // Returns false if the id is stale or was never added.
+    bool remove(track_index_t trackIndex) {
+        if (!isLive(trackIndex)) return false;
+
+        auto& entry = mEntries[trackSlot(trackIndex)];
+        auto liveIndex = entry.liveIndex;
+        auto lastLiveIndex = mLive.count - 1;
+
+        entry.trackIndex.store(-1, std::memory_order_release);
+        entry.liveIndex = -1;
+        entry.generation = (entry.generation + 1) & TRACK_GENERATION_MASK;
+
+        // Keep the live list dense by moving the last track into the gap
+        if (liveIndex != lastLiveIndex) {
+            auto lastTrackIndex = mLive.tracks[lastLiveIndex];
+
+            mLive.tracks[liveIndex] = lastTrackIndex;
+            mEntries[trackSlot(lastTrackIndex)].liveIndex = liveIndex;
+        }
+
+        mLive.count = lastLiveIndex;
+        publish();
+
+        return true;
+    }
+
+    bool isLive(track_index_t trackIndex) const {
+        if (trackIndex < 0) return false;
+
+        auto slot = trackSlot(trackIndex);
+        if (slot >= maxTracks) return false;
+
+        return mEntries[slot].trackIndex.load(std::memory_order_acquire) == trackIndex;
+    }
+
+    // Render thread only, and not nested. Must be followed by releaseLive() once the caller is done
+    // with the list.
+    const LiveTracks<maxTracks>& acquireLive() {
+        while (true) {
+            auto bank = mActiveBank.load(std::memory_order_acquire);
+
+            mReadingBank.store(bank, std::memory_order_seq_cst);
+
+            // Re-check, in case publish() started overwriting the bank before it saw mReadingBank
+            if (mActiveBank.load(std::memory_order_seq_cst) == bank) {
+                return mBanks[bank];
+            }
+        }
+    }
+
+    void releaseLive() {
+        mReadingBank.store(-1, std::memory_order_release);
+    }
+
+private:
+    struct Entry {
+        std::atomic<track_index_t> trackIndex { -1 };
+        // Writer only
+        int32_t liveIndex = -1;
+        int32_t generation = 0;
+    };
+
+    void publish() {
+        auto bank = 1 - mActiveBank.load(std::memory_order_relaxed);
+
+        while (mReadingBank.load(std::memory_order_seq_cst) == bank) {
+            std::this_thread::yield();
+        }
+
+        auto& live = mBanks[bank];
+        live.count = mLive.count;
+        std::copy(mLive.tracks.begin(), mLive.tracks.begin() + mLive.count, live.tracks.begin());
+
+        mActiveBank.store(bank, std::memory_order_seq_cst);
+    }
+
+    std::array<Entry, maxTracks> mEntries;
+    LiveTracks<maxTracks> mLive = {}; // As the writer last changed it
+
+    std::array<LiveTracks<maxTracks>, 2> mBanks = {};
+    std::atomic<int32_t> mActiveBank { 1 }; // The constructor publishes bank 0
+    std::atomic<int32_t> mReadingBank { -1 };
+};
+
+#endif
+#endif /* TrackTable_h */
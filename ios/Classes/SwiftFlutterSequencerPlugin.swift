@@ -75,22 +75,24 @@ func destroyEngine() {
     plugin.engine = nil
 }
 
+// AudioUnit instantiation already loads asynchronously on iOS, so loadId and priority are only used
+// by the Android loader pool. The SFZ config is only applied on Android for now.
 @_cdecl("add_track_sfz")
-func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, callbackPort: Dart_Port) {
+func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, config: UnsafeRawPointer?, loadId: UInt32, priority: Int32, callbackPort: Dart_Port) {
     plugin.engine!.addTrackSfz(sfzPath: sfzPath, tuningPath: tuningPath) { trackIndex in
         callbackToDartInt32(callbackPort, trackIndex)
     }
 }
 
 @_cdecl("add_track_sfz_string")
-func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, callbackPort: Dart_Port) {
+func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, config: UnsafeRawPointer?, loadId: UInt32, priority: Int32, callbackPort: Dart_Port) {
     plugin.engine!.addTrackSfzString(sampleRoot: sampleRoot, sfzString: sfzString, tuningString: tuningString) { trackIndex in
         callbackToDartInt32(callbackPort, trackIndex)
     }
 }
 
 @_cdecl("add_track_sf2")
-func addTrackSf2(path: UnsafePointer<CChar>, isAsset: Bool, presetIndex: Int32, callbackPort: Dart_Port) {
+func addTrackSf2(path: UnsafePointer<CChar>, isAsset: Bool, presetIndex: Int32, maxVoices: Int32, stealPolicy: Int32, loadId: UInt32, priority: Int32, callbackPort: Dart_Port) {
     plugin.engine!.addTrackSf2(sf2Path: String(cString: path), isAsset: isAsset, presetIndex: presetIndex) { trackIndex in
         callbackToDartInt32(callbackPort, trackIndex)
     }
@@ -126,11 +128,31 @@ func getLastRenderTimeUs() -> UInt64 {
     return SchedulerGetLastRenderTimeUs(plugin.engine!.scheduler)
 }
 
+@_cdecl("set_notification_port")
+func setNotificationPort(notificationPort: Dart_Port) {
+    SchedulerSetNotificationPort(plugin.engine!.scheduler, notificationPort)
+}
+
+@_cdecl("set_buffer_low_watermark")
+func setBufferLowWatermark(bufferLowWatermark: UInt32) {
+    SchedulerSetBufferLowWatermark(plugin.engine!.scheduler, bufferLowWatermark)
+}
+
+@_cdecl("get_transport_snapshot")
+func getTransportSnapshot(snapshot: UnsafeMutableRawPointer) {
+    SchedulerGetTransportSnapshot(plugin.engine!.scheduler, snapshot)
+}
+
 @_cdecl("get_buffer_available_count")
 func getBufferAvailableCount(trackIndex: track_index_t) -> UInt32 {
     return SchedulerGetBufferAvailableCount(plugin.engine!.scheduler, trackIndex)
 }
 
+@_cdecl("get_buffer_available_counts")
+func getBufferAvailableCounts(trackIndices: UnsafePointer<track_index_t>, tracksCount: UInt32, availableCounts: UnsafeMutablePointer<UInt32>) {
+    SchedulerGetBufferAvailableCounts(plugin.engine!.scheduler, trackIndices, tracksCount, availableCounts)
+}
+
 @_cdecl("handle_events_now")
 func handleEventsNow(trackIndex: track_index_t, eventData: UnsafePointer<UInt8>, eventsCount: UInt32) {
     let events = UnsafeMutablePointer<SchedulerEvent>.allocate(capacity: Int(eventsCount))
@@ -142,11 +164,22 @@ func handleEventsNow(trackIndex: track_index_t, eventData: UnsafePointer<UInt8>,
 
 @_cdecl("schedule_events")
 func scheduleEvents(trackIndex: track_index_t, eventData: UnsafePointer<UInt8>, eventsCount: UInt32) -> UInt32 {
-    let events = UnsafeMutablePointer<SchedulerEvent>.allocate(capacity: Int(eventsCount))
-    
-    rawEventDataToEvents(eventData, eventsCount, events)
-    
-    return SchedulerAddEvents(plugin.engine!.scheduler, trackIndex, UnsafePointer(events), eventsCount)
+    return SchedulerAddRawEvents(plugin.engine!.scheduler, trackIndex, eventData, eventsCount)
+}
+
+@_cdecl("get_event_ring")
+func getEventRing(trackIndex: track_index_t, events: UnsafeMutablePointer<UnsafeMutablePointer<SchedulerEvent>?>, readPosition: UnsafeMutablePointer<UnsafeMutablePointer<UInt32>?>, writePosition: UnsafeMutablePointer<UnsafeMutablePointer<UInt32>?>) -> UInt32 {
+    return SchedulerGetEventRing(plugin.engine!.scheduler, trackIndex, events, readPosition, writePosition)
+}
+
+@_cdecl("publish_event_rings")
+func publishEventRings(trackIndices: UnsafePointer<track_index_t>, writePositions: UnsafePointer<UInt32>, tracksCount: UInt32) {
+    SchedulerPublishEventRings(plugin.engine!.scheduler, trackIndices, writePositions, tracksCount)
+}
+
+@_cdecl("schedule_events_multi")
+func scheduleEventsMulti(eventData: UnsafePointer<UInt8>, eventDataSize: UInt32, runsCount: UInt32, acceptedCounts: UnsafeMutablePointer<UInt32>) -> UInt32 {
+    return SchedulerAddEventsMulti(plugin.engine!.scheduler, eventData, eventDataSize, runsCount, acceptedCounts)
 }
 
 @_cdecl("clear_events")
@@ -154,6 +187,61 @@ func clearEvents(trackIndex: track_index_t, fromFrame: position_frame_t) {
     SchedulerClearEvents(plugin.engine!.scheduler, trackIndex, fromFrame)
 }
 
+@_cdecl("insert_events")
+func insertEvents(trackIndex: track_index_t, eventData: UnsafePointer<UInt8>, eventsCount: UInt32, ids: UnsafeMutablePointer<UInt32>) -> UInt32 {
+    let events = UnsafeMutablePointer<SchedulerEvent>.allocate(capacity: Int(eventsCount))
+    defer { events.deallocate() }
+
+    rawEventDataToEvents(eventData, eventsCount, events)
+
+    return SchedulerInsertEvents(plugin.engine!.scheduler, trackIndex, UnsafePointer(events), eventsCount, ids)
+}
+
+@_cdecl("remove_events")
+func removeEvents(trackIndex: track_index_t, ids: UnsafePointer<UInt32>, idsCount: UInt32) -> UInt32 {
+    return SchedulerRemoveEvents(plugin.engine!.scheduler, trackIndex, ids, idsCount)
+}
+
+@_cdecl("erase_events")
+func eraseEvents(trackIndex: track_index_t, fromFrame: position_frame_t, toFrame: position_frame_t) -> UInt32 {
+    return SchedulerEraseEvents(plugin.engine!.scheduler, trackIndex, fromFrame, toFrame)
+}
+
+@_cdecl("set_track_loop")
+func setTrackLoop(trackIndex: track_index_t, loopStartFrame: position_frame_t, loopLengthFrames: UInt32, eventData: UnsafePointer<UInt8>, eventsCount: UInt32) -> UInt32 {
+    let events = UnsafeMutablePointer<SchedulerEvent>.allocate(capacity: Int(eventsCount))
+    defer { events.deallocate() }
+
+    rawEventDataToEvents(eventData, eventsCount, events)
+
+    return SchedulerSetTrackLoop(plugin.engine!.scheduler, trackIndex, loopStartFrame, loopLengthFrames, UnsafePointer(events), eventsCount)
+}
+
+@_cdecl("clear_track_loop")
+func clearTrackLoop(trackIndex: track_index_t) {
+    SchedulerClearTrackLoop(plugin.engine!.scheduler, trackIndex)
+}
+
+@_cdecl("set_tick_timebase")
+func setTickTimebase(originFrame: position_frame_t, sampleRate: UInt32) -> Bool {
+    return SchedulerSetTickTimebase(plugin.engine!.scheduler, originFrame, sampleRate)
+}
+
+@_cdecl("set_frame_timebase")
+func setFrameTimebase() -> Bool {
+    return SchedulerSetFrameTimebase(plugin.engine!.scheduler)
+}
+
+@_cdecl("set_tempo")
+func setTempo(tick: UInt32, bpm: Float32) -> Bool {
+    return SchedulerSetTempo(plugin.engine!.scheduler, tick, bpm)
+}
+
+@_cdecl("ramp_tempo")
+func rampTempo(startTick: UInt32, endTick: UInt32, endBpm: Float32) -> Bool {
+    return SchedulerRampTempo(plugin.engine!.scheduler, startTick, endTick, endBpm)
+}
+
 @_cdecl("engine_play")
 func enginePlay() {
     plugin.engine!.play()
@@ -4,12 +4,57 @@ const SECONDS_PER_US = 1 / 1000000;
 /// The size of the event buffer in the native backend
 const BUFFER_SIZE = 1024;
 
+/// The most events a track's loop range can hold for the native scheduler to
+/// repeat it. Keep in sync with LOOP_MAX_EVENTS in TrackLoop.h.
+const LOOP_MAX_EVENTS = 1024;
+
 /// Interval to "top off" each track's buffer, in milliseconds
 const TOP_OFF_PERIOD_MS = 1000;
 
+/// A track's buffer is topped off early when it drops below this many events.
+const BUFFER_LOW_WATERMARK = BUFFER_SIZE ~/ 4;
+
 /// "Lead frames" account for the fact that it may take some time to build the
 /// events and sync them with the native sequencer engine.
 const LEAD_FRAMES = 1024;
 
 /// The patch number to select from a sf2 file.
 const DEFAULT_PATCH_NUMBER = 0;
+
+/// Remember to keep SoundFontInstrument.h in sync with this value.
+const DEFAULT_SF2_MAX_VOICES = 64;
+
+/// Ticks per beat when the native scheduler is in its tick timebase. Keep in
+/// sync with TICKS_PER_BEAT in TempoMap.h.
+const TICKS_PER_BEAT = 960;
+
+/// Passed as the tick of a tempo change to apply it at the playhead.
+const TEMPO_TICK_NOW = 0xFFFFFFFF;
+
+/// The most tracks the native scheduler can hold. Keep in sync with
+/// kMaxTrackSlots in BaseScheduler.h.
+const MAX_TRACKS = 128;
+
+/// The size of the native TransportSnapshot: its fixed fields, then a track
+/// index and buffered count for each track.
+const TRANSPORT_SNAPSHOT_SIZE = 40 + MAX_TRACKS * 8;
+
+/// The size of the native MeterLevels: its fixed fields, then a track index
+/// and two peak and two RMS levels for each track.
+const METER_LEVELS_SIZE = 24 + MAX_TRACKS * 20;
+
+/// The size of the native SfizzStats: estimated preload bytes, the five
+/// config options, and four counters and timings.
+const SFIZZ_STATS_SIZE = 48;
+
+/// The most buses the Android mixer can route tracks through. Keep in sync
+/// with kMaxBuses in RoutingGraph.h.
+const MAX_BUSES = 16;
+
+/// The output that sends a track or bus straight to the mix.
+const MASTER_BUS = -1;
+
+/// Formats an offline render can write. Keep in sync with AudioFileFormat in
+/// AudioFileWriter.h.
+const AUDIO_FILE_FORMAT_WAV_FLOAT = 0;
+const AUDIO_FILE_FORMAT_RAW_FLOAT = 1;
@@ -1,6 +1,11 @@
 import 'dart:async';
+import 'dart:isolate';
+import 'dart:math';
+import 'dart:typed_data';
 
 import 'constants.dart';
+import 'models/instrument_load.dart';
+import 'models/notifications.dart';
 import 'native_bridge.dart';
 import 'sequence.dart';
 import 'track.dart';
@@ -25,7 +30,35 @@ class GlobalState {
   var isEngineReady = false;
   Timer? _topOffTimer;
   int lastTickInBuffer = 0;
+
+  // What the engine's tempo map holds since the last tempo change, so ticks
+  // can be worked out without asking the audio thread. Sequences that play
+  // at the same time share it.
+  var _tempoTick = 0;
+  var _tempoFrame = 0.0;
+  var _tempoBpm = 120.0;
   final onEngineReadyCallbacks = <Function()>[];
+  final _notificationPort = ReceivePort();
+  final _notificationsController =
+      StreamController<EngineNotification>.broadcast();
+
+  /// Notifications from the audio thread, such as markers being reached and
+  /// loops wrapping around. They arrive in batches, a few milliseconds after
+  /// they happen.
+  Stream<EngineNotification> get notifications =>
+      _notificationsController.stream;
+
+  /// The engine's current [QualityTier], as of the last
+  /// EngineNotification.QUALITY_CHANGED. Only Android steps down.
+  var qualityTier = QualityTier.FULL;
+
+  final _loadProgressPort = ReceivePort();
+  final _loadProgressController = StreamController<LoadProgress>.broadcast();
+
+  /// State changes of instrument loads, with how long each one waited and
+  /// took, for measuring how long a project takes to open. Only Android
+  /// reports them.
+  Stream<LoadProgress> get loadProgress => _loadProgressController.stream;
 
   /// Calls a function when the sequencer engine is ready. Trying to play the
   /// sequence won't do anything until the engine is ready.
@@ -75,10 +108,20 @@ class GlobalState {
 
     final shouldPlayEngine = !_getIsPlaying();
 
+    final startFrame = LEAD_FRAMES + NativeBridge.getPosition();
+
+    if (shouldPlayEngine) {
+      _startTickTimebase(startFrame, sequence.tempo);
+    } else {
+      // The engine has one tempo map, so join the sequences already playing
+      sequence.tempo = _tempoBpm;
+    }
+
     sequence.isPlaying = true;
-    sequence.engineStartFrame = LEAD_FRAMES +
-        NativeBridge.getPosition() -
-        sequence.beatToFrames(sequence.pauseBeat);
+    sequence.engineStartFrame =
+        startFrame - sequence.beatToFrames(sequence.pauseBeat);
+    sequence.engineStartTick = getTickAtFrame(startFrame) -
+        sequence.beatToTicks(sequence.pauseBeat);
 
     _syncAllBuffers();
 
@@ -107,6 +150,38 @@ class GlobalState {
     });
   }
 
+  /// {@macro flutter_sequencer_library_private}
+  /// Changes the tempo of every playing sequence from the playhead on, with
+  /// one change to the engine's tempo map. Events already scheduled move with
+  /// it, so nothing has to be scheduled again.
+  void setTempo(double bpm) {
+    if (sampleRate == null) return;
+
+    final pivotFrame = NativeBridge.getPosition();
+    final tick = getTickAtFrame(pivotFrame);
+
+    if (!NativeBridge.setTempo(bpm, tick: tick)) return;
+
+    _tempoFrame += (tick - _tempoTick) * _getFramesPerTick(_tempoBpm);
+    _tempoTick = tick;
+    _tempoBpm = bpm;
+
+    sequenceIdMap.values
+        .where((sequence) => sequence.isPlaying)
+        .forEach((sequence) => sequence.applyTempo(pivotFrame, bpm));
+  }
+
+  /// {@macro flutter_sequencer_library_private}
+  /// Gets the first engine tick that plays on or after an engine frame.
+  int getTickAtFrame(int frame) {
+    if (sampleRate == null) return 0;
+
+    final ticks =
+        _tempoTick + (frame - _tempoFrame) / _getFramesPerTick(_tempoBpm);
+
+    return max(ticks.ceil(), 0);
+  }
+
   /// {@macro flutter_sequencer_library_private}
   int usToFrames(int us) {
     if (sampleRate == null) return 0;
@@ -122,6 +197,15 @@ class GlobalState {
   void _setupEngine() async {
     sampleRate = await NativeBridge.doSetup();
     isEngineReady = true;
+
+    _notificationPort.listen(_handleNotifications);
+    NativeBridge.setNotificationPort(_notificationPort.sendPort);
+    NativeBridge.setBufferLowWatermark(BUFFER_LOW_WATERMARK);
+
+    _loadProgressPort.listen((message) => _loadProgressController
+        .add(LoadProgress.decode(message as Uint32List)));
+    NativeBridge.setLoadProgressPort(_loadProgressPort.sendPort);
+
     onEngineReadyCallbacks.forEach((callback) => callback());
 
     if (keepEngineRunning) {
@@ -129,6 +213,47 @@ class GlobalState {
     }
   }
 
+  void _handleNotifications(dynamic message) {
+    final notifications = EngineNotification.decodeBatch(message as Uint32List);
+    final lowTrackIndices = <int>{};
+
+    notifications.forEach((notification) {
+      if (notification.type == EngineNotification.BUFFER_LOW) {
+        lowTrackIndices.add(notification.trackIndex);
+      } else if (notification.type == EngineNotification.QUALITY_CHANGED) {
+        qualityTier = notification.value;
+      }
+
+      _notificationsController.add(notification);
+    });
+
+    // Refill the tracks that are running low without waiting for the timer
+    if (lowTrackIndices.isNotEmpty) {
+      final batch = ScheduleBatch();
+
+      _getAllTracks()
+          .where((track) => lowTrackIndices.contains(track.id))
+          .forEach((track) => track.topOffBuffer(null, batch));
+
+      batch.flush();
+    }
+  }
+
+  /// Makes the engine read event times as ticks from originFrame on, at a
+  /// single tempo.
+  void _startTickTimebase(int originFrame, double bpm) {
+    NativeBridge.setTickTimebase(originFrame, sampleRate!);
+    NativeBridge.setTempo(bpm, tick: 0);
+
+    _tempoTick = 0;
+    _tempoFrame = originFrame.toDouble();
+    _tempoBpm = bpm;
+  }
+
+  double _getFramesPerTick(double bpm) {
+    return sampleRate! * 60 / (bpm * TICKS_PER_BEAT);
+  }
+
   bool _getIsPlaying() {
     return sequenceIdMap.values.any((sequence) => sequence.isPlaying);
   }
@@ -165,16 +290,28 @@ class GlobalState {
   }
 
   /// Refills the underlying sequencer engine's event buffer to full capacity.
+  /// Every track's events go to the engine in one native call.
   void _topOffAllBuffers() {
-    _getAllTracks().forEach((track) {
-      track.topOffBuffer();
+    final tracks = _getAllTracks();
+    final availableCounts = NativeBridge.getBufferAvailableCounts(
+        tracks.map((track) => track.id).toList());
+    final batch = ScheduleBatch();
+
+    tracks.asMap().forEach((i, track) {
+      track.topOffBuffer(availableCounts[i], batch);
     });
+
+    batch.flush();
   }
 
   void _syncAllBuffers(
-      [int? absoluteStartFrame, int maxEventsToSync = BUFFER_SIZE]) {
+      [int? absoluteStartTick, int maxEventsToSync = BUFFER_SIZE]) {
+    final batch = ScheduleBatch();
+
     _getAllTracks().forEach((track) {
-      track.syncBuffer(absoluteStartFrame, maxEventsToSync);
+      track.syncBuffer(absoluteStartTick, maxEventsToSync, batch);
     });
+
+    batch.flush();
   }
 }
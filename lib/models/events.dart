@@ -1,5 +1,7 @@
 import 'dart:typed_data';
 
+import '../constants.dart';
+
 const SCHEDULER_EVENT_SIZE = 16;
 const SCHEDULER_EVENT_DATA_OFFSET = 8;
 const MIDI_STATUS_NOTE_ON = 144;
@@ -12,6 +14,8 @@ const MIDI_STATUS_NOTE_OFF = 128;
 abstract class SchedulerEvent {
   static const MIDI_EVENT = 0;
   static const VOLUME_EVENT = 1;
+  static const MARKER_EVENT = 2;
+  static const SEND_EVENT = 3;
 
   SchedulerEvent({
     required this.beat,
@@ -21,16 +25,26 @@ abstract class SchedulerEvent {
   double beat;
   final int type;
 
-  ByteData serializeBytes(int sampleRate, double tempo, int correctionFrames) {
+  /// The event's beat in ticks, TICKS_PER_BEAT per beat.
+  int get tick => (beat * TICKS_PER_BEAT).round();
+
+  ByteData serializeBytes(int correctionTicks) {
     final data = ByteData(SCHEDULER_EVENT_SIZE);
-    final us = ((1 / tempo) * beat * 60000000).round();
-    final frame = ((us * sampleRate) / 1000000).round() + correctionFrames;
 
-    data.setUint32(0, frame, Endian.host);
-    data.setUint32(4, type, Endian.host);
+    serializeInto(data, 0, correctionTicks);
 
     return data;
   }
+
+  /// Writes the event's SCHEDULER_EVENT_SIZE bytes into data at byteOffset,
+  /// which can be a view of native memory. The event is stamped with its
+  /// tick plus correctionTicks, for the native scheduler's tick timebase.
+  void serializeInto(ByteData data, int byteOffset, int correctionTicks) {
+    data.setUint32(byteOffset, tick + correctionTicks, Endian.host);
+    data.setUint32(byteOffset + 4, type, Endian.host);
+    data.setUint32(byteOffset + SCHEDULER_EVENT_DATA_OFFSET, 0);
+    data.setUint32(byteOffset + SCHEDULER_EVENT_DATA_OFFSET + 4, 0);
+  }
 }
 
 /// Describes an event that will trigger a MIDI event.
@@ -47,14 +61,13 @@ class MidiEvent extends SchedulerEvent {
   final int midiData2;
 
   @override
-  ByteData serializeBytes(int sampleRate, double tempo, int correctionFrames) {
-    final data = super.serializeBytes(sampleRate, tempo, correctionFrames);
-
-    data.setUint8(SCHEDULER_EVENT_DATA_OFFSET, midiStatus);
-    data.setUint8(SCHEDULER_EVENT_DATA_OFFSET + 1, midiData1);
-    data.setUint8(SCHEDULER_EVENT_DATA_OFFSET + 2, midiData2);
+  void serializeInto(ByteData data, int byteOffset, int correctionTicks) {
+    super.serializeInto(data, byteOffset, correctionTicks);
 
-    return data;
+    final dataOffset = byteOffset + SCHEDULER_EVENT_DATA_OFFSET;
+    data.setUint8(dataOffset, midiStatus);
+    data.setUint8(dataOffset + 1, midiData1);
+    data.setUint8(dataOffset + 2, midiData2);
   }
 
   static MidiEvent ofNoteOn({
@@ -141,11 +154,59 @@ class VolumeEvent extends SchedulerEvent {
   }
 
   @override
-  ByteData serializeBytes(int sampleRate, double beat, int correctionFrames) {
-    final data = super.serializeBytes(sampleRate, beat, correctionFrames);
+  void serializeInto(ByteData data, int byteOffset, int correctionTicks) {
+    super.serializeInto(data, byteOffset, correctionTicks);
 
-    data.setFloat32(SCHEDULER_EVENT_DATA_OFFSET, volume!, Endian.host);
+    data.setFloat32(
+        byteOffset + SCHEDULER_EVENT_DATA_OFFSET, volume!, Endian.host);
+  }
+}
 
-    return data;
+/// The shared effect buses a track can send to. Remember to keep
+/// SendEffects.h in sync with this.
+class SendBus {
+  static const REVERB = 0;
+  static const DELAY = 1;
+  static const EQ = 2;
+}
+
+/// Describes an event that changes how much of a track goes to one of the
+/// SendBus effects. Only Android has send buses; iOS ignores these events.
+class SendEvent extends SchedulerEvent {
+  SendEvent({
+    required double beat,
+    required this.sendBus,
+    required this.level,
+  }) : super(beat: beat, type: SchedulerEvent.SEND_EVENT);
+
+  final int sendBus;
+  final double level;
+
+  @override
+  void serializeInto(ByteData data, int byteOffset, int correctionTicks) {
+    super.serializeInto(data, byteOffset, correctionTicks);
+
+    data.setFloat32(
+        byteOffset + SCHEDULER_EVENT_DATA_OFFSET, level, Endian.host);
+    data.setUint32(
+        byteOffset + SCHEDULER_EVENT_DATA_OFFSET + 4, sendBus, Endian.host);
+  }
+}
+
+/// Describes an event that plays nothing, but posts an
+/// EngineNotification.MARKER notification with its id when it's reached.
+class MarkerEvent extends SchedulerEvent {
+  MarkerEvent({
+    required double beat,
+    required this.id,
+  }) : super(beat: beat, type: SchedulerEvent.MARKER_EVENT);
+
+  final int id;
+
+  @override
+  void serializeInto(ByteData data, int byteOffset, int correctionTicks) {
+    super.serializeInto(data, byteOffset, correctionTicks);
+
+    data.setUint32(byteOffset + SCHEDULER_EVENT_DATA_OFFSET, id, Endian.host);
   }
 }
@@ -1,4 +1,5 @@
 import '../constants.dart';
+import 'sfizz_config.dart';
 import 'sfz.dart';
 
 /// The base class for Instruments.
@@ -20,10 +21,17 @@ abstract class Instrument {
 /// in the SFZ file should be relative to the parent directory of path. To use
 /// an alternate tuning, set tuningPath to the path to a
 /// [Scala](http://www.huygens-fokker.org/scala/scl_format.html) tuning file.
+/// Set config to trade memory against CPU, e.g. to stream a big library from
+/// disk.
 class SfzInstrument extends Instrument {
   final String? tuningPath;
+  final SfizzConfig? config;
 
-  SfzInstrument({required String path, required bool isAsset, this.tuningPath})
+  SfzInstrument(
+      {required String path,
+      required bool isAsset,
+      this.tuningPath,
+      this.config})
       : super(path, isAsset);
 }
 
@@ -39,23 +47,32 @@ class RuntimeSfzInstrument extends Instrument {
 
   final Sfz sfz;
   final String? tuningString;
+  final SfizzConfig? config;
 
   RuntimeSfzInstrument(
       {required String id,
       required bool isAsset,
       required this.sampleRoot,
       required this.sfz,
-      this.tuningString})
+      this.tuningString,
+      this.config})
       : super(id, isAsset);
 }
 
 /// Describes an instrument in SF2 format. Will be played by the SoundFont
-/// player for the current platform.
+/// player for the current platform. On Android, maxVoices voices are
+/// allocated when it loads, and a note over the limit steals a voice by
+/// stealPolicy, one of the [VoiceStealPolicy] constants.
 class Sf2Instrument extends Instrument {
+  final int maxVoices;
+  final int stealPolicy;
+
   Sf2Instrument(
       {required String path,
       required bool isAsset,
-      int presetIndex = DEFAULT_PATCH_NUMBER})
+      int presetIndex = DEFAULT_PATCH_NUMBER,
+      this.maxVoices = DEFAULT_SF2_MAX_VOICES,
+      this.stealPolicy = VoiceStealPolicy.OLDEST})
       : super(path, isAsset, presetIndex: presetIndex);
 }
 
@@ -0,0 +1,56 @@
+import 'dart:typed_data';
+
+/// Remember to keep InstrumentLoader.h in sync with this file.
+
+/// A change in the state of an instrument load on the native loader pool.
+/// Only Android loads instruments through the pool, so these are never posted
+/// on iOS.
+class LoadProgress {
+  static const QUEUED = 0;
+  static const STARTED = 1;
+  static const FINISHED = 2;
+  static const FAILED = 3;
+  static const CANCELLED = 4;
+
+  const LoadProgress({
+    required this.loadId,
+    required this.state,
+    required this.trackIndex,
+    required this.waitUs,
+    required this.loadUs,
+    required this.pendingCount,
+  });
+
+  /// The id the load was submitted with.
+  final int loadId;
+
+  /// One of the constants above.
+  final int state;
+
+  /// The new track, or -1 until the load has finished.
+  final int trackIndex;
+
+  /// How long the load waited in the queue, once it has started.
+  final int waitUs;
+
+  /// How long the instrument took to load, once the load is over.
+  final int loadUs;
+
+  /// How many loads are queued or running after this change. Reports from
+  /// different worker threads can arrive slightly out of order.
+  final int pendingCount;
+
+  bool get isOver => state >= FINISHED;
+
+  /// Decodes a report posted by the native loader, six values per report.
+  static LoadProgress decode(Uint32List values) {
+    return LoadProgress(
+      loadId: values[0],
+      state: values[1],
+      trackIndex: values[2].toSigned(32),
+      waitUs: values[3],
+      loadUs: values[4],
+      pendingCount: values[5],
+    );
+  }
+}
@@ -0,0 +1,69 @@
+import 'dart:typed_data';
+
+/// Remember to keep NotificationQueue.h in sync with this file.
+
+/// How much render quality the engine gives up to keep up with the audio
+/// device. Only Android steps down, when callbacks run close to their
+/// deadline, and steps back up once there is headroom again. Remember to keep
+/// IInstrument.h in sync.
+class QualityTier {
+  static const FULL = 0;
+
+  /// Cheaper sample interpolation and oscillators.
+  static const REDUCED_INTERPOLATION = 1;
+
+  /// Half the voices, and quiet release tails are cut.
+  static const REDUCED_VOICES = 2;
+
+  /// A quarter of the voices and the cheapest interpolation.
+  static const MINIMAL = 3;
+}
+
+/// Something the audio thread reported, such as a marker being reached or a
+/// loop wrapping around.
+class EngineNotification {
+  static const MARKER = 0;
+  static const LOOP_WRAPPED = 1;
+  static const BUFFER_LOW = 2;
+  static const UNDERRUN = 3;
+  static const DROPPED = 4;
+  static const QUALITY_CHANGED = 5;
+
+  const EngineNotification({
+    required this.type,
+    required this.trackIndex,
+    required this.frame,
+    required this.value,
+  });
+
+  /// One of the constants above.
+  final int type;
+
+  /// The track it's about, or -1 for the whole engine.
+  final int trackIndex;
+
+  /// The engine frame it happened on.
+  final int frame;
+
+  /// Depends on the type: the marker id, the loop iteration that started, the
+  /// events left in the buffer, the number of underruns or dropped
+  /// notifications, or the [QualityTier] the engine moved to.
+  final int value;
+
+  /// Decodes a batch posted by the native dispatcher, four values per
+  /// notification.
+  static List<EngineNotification> decodeBatch(Uint32List values) {
+    final notifications = <EngineNotification>[];
+
+    for (var i = 0; i + 3 < values.length; i += 4) {
+      notifications.add(EngineNotification(
+        type: values[i],
+        trackIndex: values[i + 1].toSigned(32),
+        frame: values[i + 2],
+        value: values[i + 3],
+      ));
+    }
+
+    return notifications;
+  }
+}
@@ -0,0 +1,101 @@
+import 'dart:typed_data';
+
+/// Remember to keep SfizzSamplerInstrument.h and IInstrument.h in sync with
+/// this file.
+
+/// Which voice makes way when a note would take an instrument over its voice
+/// limit.
+class VoiceStealPolicy {
+  static const OLDEST = 0;
+  static const QUIETEST = 1;
+
+  /// The same note if it is still sounding, otherwise the oldest.
+  static const SAME_NOTE = 2;
+}
+
+/// How an SFZ track trades memory against CPU. Options left null keep their
+/// current value, which for a new track is sfizz's default. Only Android
+/// applies them for now.
+///
+/// For big libraries on low-end devices, a small preloadSize keeps memory
+/// down by streaming most of each sample from disk, and lower qualities and
+/// fewer voices keep the CPU down.
+class SfizzConfig {
+  const SfizzConfig({
+    this.preloadSize,
+    this.oversamplingFactor,
+    this.sampleQuality,
+    this.oscillatorQuality,
+    this.maxVoices,
+    this.stealPolicy,
+  });
+
+  /// Frames of each sample held in memory. The rest streams from disk as
+  /// notes play. Memory grows with this times the number of samples; too
+  /// small and fast passages may stream late.
+  final int? preloadSize;
+
+  /// 1, 2, 4 or 8. Improves high notes at the cost of multiplying preload
+  /// memory and the CPU spent reading samples.
+  final int? oversamplingFactor;
+
+  /// 0 to 10, the interpolation quality during live playback. Each step up
+  /// costs more CPU per playing voice, and no memory.
+  final int? sampleQuality;
+
+  /// 0 to 3, the quality of sfizz's oscillators during live playback. Each
+  /// step up costs more CPU per playing voice, and no memory.
+  final int? oscillatorQuality;
+
+  /// The most voices that can play at once. Caps the CPU a track can take,
+  /// at the cost of cutting off notes when it is reached.
+  final int? maxVoices;
+
+  /// One of the [VoiceStealPolicy] constants. sfizz doesn't report voice
+  /// levels, so QUIETEST steals the note played most softly.
+  final int? stealPolicy;
+
+  /// The values to pass to native code, with -1 for options left as they are.
+  List<int> toNative() {
+    return [
+      preloadSize ?? -1,
+      oversamplingFactor ?? -1,
+      sampleQuality ?? -1,
+      oscillatorQuality ?? -1,
+      maxVoices ?? -1,
+      stealPolicy ?? -1,
+    ];
+  }
+}
+
+/// The options an SFZ track is using, and what they cost.
+class SfizzStats {
+  SfizzStats.fromBytes(ByteData data)
+      : preloadBytes = data.getUint64(0, Endian.host),
+        config = SfizzConfig(
+          preloadSize: data.getInt32(8, Endian.host),
+          oversamplingFactor: data.getInt32(12, Endian.host),
+          sampleQuality: data.getInt32(16, Endian.host),
+          oscillatorQuality: data.getInt32(20, Endian.host),
+          maxVoices: data.getInt32(24, Endian.host),
+          stealPolicy: data.getInt32(28, Endian.host),
+        ),
+        preloadedFilesCount = data.getUint32(32, Endian.host),
+        activeVoicesCount = data.getUint32(36, Endian.host),
+        renderMeanUs = data.getUint32(40, Endian.host),
+        renderP99Us = data.getUint32(44, Endian.host);
+
+  /// An estimate of the memory held by preloaded sample data.
+  final int preloadBytes;
+
+  /// The options in effect. None of them are null.
+  final SfizzConfig config;
+
+  final int preloadedFilesCount;
+  final int activeVoicesCount;
+
+  /// How long the track takes to render a callback, on average and at the
+  /// 99th percentile.
+  final int renderMeanUs;
+  final int renderP99Us;
+}
@@ -1,10 +1,15 @@
 import 'dart:async';
 import 'dart:ffi';
 import 'dart:io';
+import 'dart:isolate';
+import 'dart:math';
+import 'dart:typed_data';
 import 'package:ffi/ffi.dart';
 import 'package:flutter/services.dart';
 
+import 'constants.dart';
 import 'models/events.dart';
+import 'models/sfizz_config.dart';
 import 'utils/isolate.dart';
 
 final DynamicLibrary nativeLib = Platform.isAndroid
@@ -26,17 +31,39 @@ final nDestroyEngine = nativeLib
     .lookupFunction<Void Function(), void Function()>('destroy_engine');
 
 final nAddTrackSf2 = nativeLib.lookupFunction<
-    Void Function(Pointer<Utf8>, Int8, Int32, Int64),
-    void Function(Pointer<Utf8>, int, int, int)>('add_track_sf2');
+    Void Function(
+        Pointer<Utf8>, Int8, Int32, Int32, Int32, Uint32, Int32, Int64),
+    void Function(
+        Pointer<Utf8>, int, int, int, int, int, int, int)>('add_track_sf2');
 
 final nAddTrackSfz = nativeLib.lookupFunction<
-    Void Function(Pointer<Utf8>, Pointer<Utf8>, Int64),
-    void Function(Pointer<Utf8>, Pointer<Utf8>, int)>('add_track_sfz');
+    Void Function(
+        Pointer<Utf8>, Pointer<Utf8>, Pointer<Int32>, Uint32, Int32, Int64),
+    void Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<Int32>, int, int,
+        int)>('add_track_sfz');
 
 final nAddTrackSfzString = nativeLib.lookupFunction<
-    Void Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<Utf8>, Int64),
-    void Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<Utf8>,
-        int)>('add_track_sfz_string');
+    Void Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<Utf8>, Pointer<Int32>,
+        Uint32, Int32, Int64),
+    void Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<Utf8>, Pointer<Int32>,
+        int, int, int)>('add_track_sfz_string');
+
+final nSetTrackSfzConfig = nativeLib.lookupFunction<
+    Void Function(Int32, Pointer<Int32>, Int64),
+    void Function(int, Pointer<Int32>, int)>('set_track_sfz_config');
+
+final nGetTrackSfzStats = nativeLib.lookupFunction<
+    Uint8 Function(Int32, Pointer<Uint8>),
+    int Function(int, Pointer<Uint8>)>('get_track_sfz_stats');
+
+final nSetLoadPriority = nativeLib.lookupFunction<Void Function(Uint32, Int32),
+    void Function(int, int)>('set_load_priority');
+
+final nCancelLoad = nativeLib
+    .lookupFunction<Void Function(Uint32), void Function(int)>('cancel_load');
+
+final nSetLoadProgressPort = nativeLib.lookupFunction<Void Function(Int64),
+    void Function(int)>('set_load_progress_port');
 
 final nRemoveTrack = nativeLib
     .lookupFunction<Void Function(Int32), void Function(int?)>('remove_track');
@@ -55,10 +82,91 @@ final nGetLastRenderTimeUs =
     nativeLib.lookupFunction<Uint64 Function(), int Function()>(
         'get_last_render_time_us');
 
+final nGetTransportSnapshot = nativeLib.lookupFunction<
+    Void Function(Pointer<Uint8>),
+    void Function(Pointer<Uint8>)>('get_transport_snapshot');
+
+final nSetNotificationPort = nativeLib.lookupFunction<Void Function(Int64),
+    void Function(int)>('set_notification_port');
+
+final nSetBufferLowWatermark = nativeLib.lookupFunction<Void Function(Uint32),
+    void Function(int)>('set_buffer_low_watermark');
+
+final nSetMeteringEnabled = nativeLib.lookupFunction<Void Function(Uint8),
+    void Function(int)>('set_metering_enabled');
+
+final nSetMeterWindowFrames = nativeLib.lookupFunction<Void Function(Uint32),
+    void Function(int)>('set_meter_window_frames');
+
+final nSetVoiceBudget = nativeLib.lookupFunction<Void Function(Int32),
+    void Function(int)>('set_voice_budget');
+
+final nGetTrackVoiceCap = nativeLib
+    .lookupFunction<Int32 Function(), int Function()>('get_track_voice_cap');
+
+final nSetQualityGovernorEnabled = nativeLib.lookupFunction<
+    Void Function(Uint8), void Function(int)>('set_quality_governor_enabled');
+
+final nGetQualityTier = nativeLib
+    .lookupFunction<Int32 Function(), int Function()>('get_quality_tier');
+
+final nGetTrackSend = nativeLib.lookupFunction<Float Function(Int32, Uint32),
+    double Function(int, int)>('get_track_send');
+
+final nSetSendReturnLevel = nativeLib.lookupFunction<
+    Void Function(Uint32, Float),
+    void Function(int, double)>('set_send_return_level');
+
+final nSetReverbParams = nativeLib.lookupFunction<Void Function(Float, Float),
+    void Function(double, double)>('set_reverb_params');
+
+final nSetDelayParams = nativeLib.lookupFunction<Void Function(Float, Float),
+    void Function(double, double)>('set_delay_params');
+
+final nSetEqParams = nativeLib.lookupFunction<
+    Void Function(Float, Float, Float),
+    void Function(double, double, double)>('set_eq_params');
+
+final nAddBus =
+    nativeLib.lookupFunction<Int32 Function(), int Function()>('add_bus');
+
+final nRemoveBus = nativeLib
+    .lookupFunction<Void Function(Int32), void Function(int)>('remove_bus');
+
+final nSetBusOutput = nativeLib.lookupFunction<Uint8 Function(Int32, Int32),
+    int Function(int, int)>('set_bus_output');
+
+final nSetTrackOutput = nativeLib.lookupFunction<Uint8 Function(Int32, Int32),
+    int Function(int, int)>('set_track_output');
+
+final nGetTrackOutput = nativeLib.lookupFunction<Int32 Function(Int32),
+    int Function(int)>('get_track_output');
+
+final nSetBusVolume = nativeLib.lookupFunction<Void Function(Int32, Float),
+    void Function(int, double)>('set_bus_volume');
+
+final nSetBusPan = nativeLib.lookupFunction<Void Function(Int32, Float),
+    void Function(int, double)>('set_bus_pan');
+
+final nSetIdleMode = nativeLib.lookupFunction<Void Function(Uint8, Uint8),
+    void Function(int, int)>('set_idle_mode');
+
+final nGetIsIdle = nativeLib
+    .lookupFunction<Uint8 Function(), int Function()>('get_is_idle');
+
+final nGetMeterLevels = nativeLib.lookupFunction<
+    Void Function(Pointer<Uint8>),
+    void Function(Pointer<Uint8>)>('get_meter_levels');
+
 final nGetBufferAvailableCount =
     nativeLib.lookupFunction<Uint32 Function(Int32), int Function(int?)>(
         'get_buffer_available_count');
 
+final nGetBufferAvailableCounts = nativeLib.lookupFunction<
+    Void Function(Pointer<Int32>, Uint32, Pointer<Uint32>),
+    void Function(
+        Pointer<Int32>, int, Pointer<Uint32>)>('get_buffer_available_counts');
+
 final nHandleEventsNow = nativeLib.lookupFunction<
     Uint32 Function(Int32?, Pointer<Uint8>?, Uint32),
     int Function(int?, Pointer<Uint8>?, int)>('handle_events_now');
@@ -67,15 +175,66 @@ final nScheduleEvents = nativeLib.lookupFunction<
     Uint32 Function(Int32?, Pointer<Uint8>?, Uint32),
     int Function(int?, Pointer<Uint8>?, int)>('schedule_events');
 
+final nGetEventRing = nativeLib.lookupFunction<
+    Uint32 Function(Int32, Pointer<Pointer<Uint8>>, Pointer<Pointer<Uint32>>,
+        Pointer<Pointer<Uint32>>),
+    int Function(int, Pointer<Pointer<Uint8>>, Pointer<Pointer<Uint32>>,
+        Pointer<Pointer<Uint32>>)>('get_event_ring');
+
+final nPublishEventRings = nativeLib.lookupFunction<
+    Void Function(Pointer<Int32>, Pointer<Uint32>, Uint32),
+    void Function(
+        Pointer<Int32>, Pointer<Uint32>, int)>('publish_event_rings');
+
 final nClearEvents = nativeLib.lookupFunction<Void Function(Int32, Uint32),
     void Function(int?, int?)>('clear_events');
 
+final nInsertEvents = nativeLib.lookupFunction<
+    Uint32 Function(Int32, Pointer<Uint8>, Uint32, Pointer<Uint32>),
+    int Function(int, Pointer<Uint8>, int, Pointer<Uint32>)>('insert_events');
+
+final nRemoveEvents = nativeLib.lookupFunction<
+    Uint32 Function(Int32, Pointer<Uint32>, Uint32),
+    int Function(int, Pointer<Uint32>, int)>('remove_events');
+
+final nEraseEvents = nativeLib.lookupFunction<
+    Uint32 Function(Int32, Uint32, Uint32),
+    int Function(int, int, int)>('erase_events');
+
+final nSetTrackLoop = nativeLib.lookupFunction<
+    Uint32 Function(Int32, Uint32, Uint32, Pointer<Uint8>?, Uint32),
+    int Function(int, int, int, Pointer<Uint8>?, int)>('set_track_loop');
+
+final nClearTrackLoop = nativeLib.lookupFunction<Void Function(Int32),
+    void Function(int)>('clear_track_loop');
+
+final nSetTickTimebase = nativeLib
+    .lookupFunction<Uint8 Function(Uint32, Uint32), int Function(int, int)>(
+        'set_tick_timebase');
+
+final nSetFrameTimebase = nativeLib
+    .lookupFunction<Uint8 Function(), int Function()>('set_frame_timebase');
+
+final nSetTempo = nativeLib.lookupFunction<Uint8 Function(Uint32, Float),
+    int Function(int, double)>('set_tempo');
+
+final nRampTempo = nativeLib.lookupFunction<
+    Uint8 Function(Uint32, Uint32, Float),
+    int Function(int, int, double)>('ramp_tempo');
+
 final nPlay =
     nativeLib.lookupFunction<Void Function(), void Function()>('engine_play');
 
 final nPause =
     nativeLib.lookupFunction<Void Function(), void Function()>('engine_pause');
 
+final nRenderOffline = nativeLib.lookupFunction<
+    Void Function(Pointer<Utf8>, Int32, Uint32, Int64),
+    void Function(Pointer<Utf8>, int, int, int)>('render_offline');
+
+final nCancelOfflineRender = nativeLib.lookupFunction<Void Function(),
+    void Function()>('cancel_offline_render');
+
 /// {@macro flutter_sequencer_library_private}
 /// This class encapsulates the boilerplate code needed to call into native code
 /// and get responses back. It should hide any implementation details from the
@@ -112,34 +271,129 @@ class NativeBridge {
     return audioUnitIds;
   }
 
-  static Future<int> addTrackSf2(
-      String filename, bool isAsset, int patchNumber) {
+  static var _nextLoadId = 1;
+
+  /// Returns a new id to submit an instrument load with, so it can be
+  /// reprioritized or cancelled while it is pending.
+  static int allocateLoadId() {
+    return _nextLoadId++;
+  }
+
+  /// On Android, instruments load on a fixed pool of native threads, highest
+  /// priority first. The future completes with -1 if the load fails or is
+  /// cancelled.
+  static Future<int> addTrackSf2(String filename, bool isAsset, int patchNumber,
+      {int maxVoices = DEFAULT_SF2_MAX_VOICES,
+      int stealPolicy = VoiceStealPolicy.OLDEST,
+      int? loadId,
+      int priority = 0}) {
     final filenameUtf8Ptr = filename.toNativeUtf8();
+    final id = loadId ?? allocateLoadId();
+
     return singleResponseFuture<int>((port) => nAddTrackSf2(
-        filenameUtf8Ptr, isAsset ? 1 : 0, patchNumber, port.nativePort));
+        filenameUtf8Ptr,
+        isAsset ? 1 : 0,
+        patchNumber,
+        maxVoices,
+        stealPolicy,
+        id,
+        priority,
+        port.nativePort));
   }
 
-  static Future<int> addTrackSfz(String sfzPath, String? tuningPath) {
+  // Native code copies the config before returning, so the caller frees it
+  // straight after the call.
+  static Pointer<Int32> _allocateSfizzConfig(SfizzConfig? config) {
+    if (config == null) return Pointer.fromAddress(0);
+
+    final values = config.toNative();
+    final nativeConfig = calloc<Int32>(values.length);
+    nativeConfig.asTypedList(values.length).setAll(0, values);
+
+    return nativeConfig;
+  }
+
+  static Future<int> addTrackSfz(String sfzPath, String? tuningPath,
+      {SfizzConfig? config, int? loadId, int priority = 0}) {
     final sfzPathUtf8Ptr = sfzPath.toNativeUtf8();
     final tuningPathUtf8Ptr =
         tuningPath?.toNativeUtf8() ?? Pointer.fromAddress(0);
+    final id = loadId ?? allocateLoadId();
 
-    return singleResponseFuture<int>((port) =>
-        nAddTrackSfz(sfzPathUtf8Ptr, tuningPathUtf8Ptr, port.nativePort));
+    return singleResponseFuture<int>((port) {
+      final nativeConfig = _allocateSfizzConfig(config);
+      nAddTrackSfz(sfzPathUtf8Ptr, tuningPathUtf8Ptr, nativeConfig, id,
+          priority, port.nativePort);
+      calloc.free(nativeConfig);
+    });
   }
 
   static Future<int> addTrackSfzString(
-      String sampleRoot, String sfzContent, String? tuningString) {
+      String sampleRoot, String sfzContent, String? tuningString,
+      {SfizzConfig? config, int? loadId, int priority = 0}) {
     final sampleRootUtf8Ptr = sampleRoot.toNativeUtf8();
     final sfzContentUtf8Ptr = sfzContent.toNativeUtf8();
     final tuningStringUtf8Ptr =
         tuningString?.toNativeUtf8() ?? Pointer.fromAddress(0);
+    final id = loadId ?? allocateLoadId();
 
-    return singleResponseFuture<int>((port) => nAddTrackSfzString(
-        sampleRootUtf8Ptr,
-        sfzContentUtf8Ptr,
-        tuningStringUtf8Ptr,
-        port.nativePort));
+    return singleResponseFuture<int>((port) {
+      final nativeConfig = _allocateSfizzConfig(config);
+      nAddTrackSfzString(sampleRootUtf8Ptr, sfzContentUtf8Ptr,
+          tuningStringUtf8Ptr, nativeConfig, id, priority, port.nativePort);
+      calloc.free(nativeConfig);
+    });
+  }
+
+  /// Changes an SFZ track's options on the loader pool, since some of them
+  /// reload sample data. Completes with false if the track isn't an SFZ track
+  /// or an option was invalid, or on iOS.
+  static Future<bool> setTrackSfzConfig(int trackIndex, SfizzConfig config) {
+    if (!Platform.isAndroid) return Future.value(false);
+
+    return singleResponseFuture<int>((port) {
+      final nativeConfig = _allocateSfizzConfig(config);
+      nSetTrackSfzConfig(trackIndex, nativeConfig, port.nativePort);
+      calloc.free(nativeConfig);
+    }).then((result) => result != -1);
+  }
+
+  static final _nativeSfizzStats = calloc<Uint8>(SFIZZ_STATS_SIZE);
+
+  /// Returns null if the track isn't an SFZ track, or on iOS.
+  static SfizzStats? getTrackSfzStats(int trackIndex) {
+    if (!Platform.isAndroid) return null;
+
+    if (nGetTrackSfzStats(trackIndex, _nativeSfizzStats) == 0) return null;
+
+    return SfizzStats.fromBytes(Uint8List.fromList(
+            _nativeSfizzStats.asTypedList(SFIZZ_STATS_SIZE))
+        .buffer
+        .asByteData());
+  }
+
+  /// Moves a queued load up or down. Does nothing once it has started, or on
+  /// iOS.
+  static void setLoadPriority(int loadId, int priority) {
+    if (!Platform.isAndroid) return;
+
+    nSetLoadPriority(loadId, priority);
+  }
+
+  /// Cancels a pending load. Its future completes with -1. Does nothing on
+  /// iOS.
+  static void cancelLoad(int loadId) {
+    if (!Platform.isAndroid) return;
+
+    nCancelLoad(loadId);
+  }
+
+  /// Starts posting load state changes to a port, as Uint32Lists that
+  /// LoadProgress.decode reads. Pass null to stop. Only Android reports them.
+  static void setLoadProgressPort(SendPort? port) {
+    if (!Platform.isAndroid) return;
+
+    nSetLoadProgressPort(port?.nativePort ?? 0);
   }
 
   static Future<int?> addTrackAudioUnit(String id) async {
@@ -153,6 +407,7 @@ class NativeBridge {
   }
 
   static void removeTrack(int trackIndex) {
+    EventRing.forget(trackIndex);
     nRemoveTrack(trackIndex);
   }
 
@@ -172,18 +427,238 @@ class NativeBridge {
     return nGetLastRenderTimeUs();
   }
 
+  static final _nativeTransportSnapshot =
+      calloc<Uint8>(TRANSPORT_SNAPSHOT_SIZE);
+
+  /// Starts posting engine notifications to a port, as Uint32List batches
+  /// that EngineNotification.decodeBatch reads. Pass null to stop.
+  static void setNotificationPort(SendPort? port) {
+    nSetNotificationPort(port?.nativePort ?? 0);
+  }
+
+  /// Sets how few events a track's buffer can hold before the engine posts
+  /// EngineNotification.BUFFER_LOW. 0 turns it off.
+  static void setBufferLowWatermark(int bufferLowWatermark) {
+    nSetBufferLowWatermark(bufferLowWatermark);
+  }
+
+  /// Turns on metering in the native mixer. Only Android meters; on iOS this
+  /// does nothing.
+  static void setMeteringEnabled(bool isEnabled) {
+    if (!Platform.isAndroid) return;
+
+    nSetMeteringEnabled(isEnabled ? 1 : 0);
+  }
+
+  /// Sets how many frames the levels are measured over before they are
+  /// published.
+  static void setMeterWindowFrames(int meterWindowFrames) {
+    if (!Platform.isAndroid) return;
+
+    nSetMeterWindowFrames(meterWindowFrames);
+  }
+
+  /// Shares this many voices between the playing tracks, fewer while the
+  /// audio thread is close to its deadline. Notes over a track's share steal
+  /// voices by its instrument's steal policy. 0 turns it off. Only Android
+  /// budgets voices; on iOS this does nothing.
+  static void setVoiceBudget(int voiceBudget) {
+    if (!Platform.isAndroid) return;
+
+    nSetVoiceBudget(voiceBudget);
+  }
+
+  /// The most voices each track was allowed in the last callback, or 0 with
+  /// no voice budget.
+  static int getTrackVoiceCap() {
+    if (!Platform.isAndroid) return 0;
+
+    return nGetTrackVoiceCap();
+  }
+
+  /// Turns the quality governor on or off. It is on by default, and steps
+  /// instruments down to cheaper quality tiers while the audio thread is
+  /// close to its deadline, posting EngineNotification.QUALITY_CHANGED each
+  /// time. Turning it off restores full quality. Only Android has one; on iOS
+  /// this does nothing.
+  static void setQualityGovernorEnabled(bool isEnabled) {
+    if (!Platform.isAndroid) return;
+
+    nSetQualityGovernorEnabled(isEnabled ? 1 : 0);
+  }
+
+  /// One of the QualityTier constants. Always QualityTier.FULL on iOS.
+  static int getQualityTier() {
+    if (!Platform.isAndroid) return 0;
+
+    return nGetQualityTier();
+  }
+
+  /// How much of a track goes to a SendBus. Always 0 on iOS, which has no
+  /// send buses.
+  static double getTrackSend(int trackIndex, int sendBus) {
+    if (!Platform.isAndroid) return 0;
+
+    return nGetTrackSend(trackIndex, sendBus);
+  }
+
+  /// The level a SendBus's effect is returned to the mix at. 1 by default.
+  static void setSendReturnLevel(int sendBus, double level) {
+    if (!Platform.isAndroid) return;
+
+    nSetSendReturnLevel(sendBus, level);
+  }
+
+  /// roomSize from 0 to 1 sets how long the shared reverb rings, damping from
+  /// 0 to 1 how much faster its highs die away.
+  static void setReverbParams(double roomSize, double damping) {
+    if (!Platform.isAndroid) return;
+
+    nSetReverbParams(roomSize, damping);
+  }
+
+  /// Sets the shared delay's time, up to 2 seconds, and how much of each
+  /// echo feeds the next, from 0 to 0.95.
+  static void setDelayParams(double delaySeconds, double feedback) {
+    if (!Platform.isAndroid) return;
+
+    nSetDelayParams(delaySeconds, feedback);
+  }
+
+  /// Sets the shared EQ's low shelf, mid peak and high shelf, in dB.
+  static void setEqParams(
+      double lowGainDb, double midGainDb, double highGainDb) {
+    if (!Platform.isAndroid) return;
+
+    nSetEqParams(lowGainDb, midGainDb, highGainDb);
+  }
+
+  /// Adds a bus that sums the tracks and buses sent to it, and sends the sum
+  /// to the master. Returns the bus, or -1 if there are already MAX_BUSES or
+  /// the platform has no buses; only Android does.
+  static int addBus() {
+    if (!Platform.isAndroid) return -1;
+
+    return nAddBus();
+  }
+
+  /// Whatever was sent to the bus is sent on to the bus's own output.
+  static void removeBus(int bus) {
+    if (!Platform.isAndroid) return;
+
+    nRemoveBus(bus);
+  }
+
+  /// Sends a bus to another bus, or to MASTER_BUS. Returns false if that
+  /// would feed the bus its own output.
+  static bool setBusOutput(int bus, int output) {
+    if (!Platform.isAndroid) return false;
+
+    return nSetBusOutput(bus, output) != 0;
+  }
+
+  /// Sends a track to a bus, or to MASTER_BUS.
+  static bool setTrackOutput(int trackIndex, int output) {
+    if (!Platform.isAndroid) return false;
+
+    return nSetTrackOutput(trackIndex, output) != 0;
+  }
+
+  static int getTrackOutput(int trackIndex) {
+    if (!Platform.isAndroid) return MASTER_BUS;
+
+    return nGetTrackOutput(trackIndex);
+  }
+
+  static void setBusVolume(int bus, double volume) {
+    if (!Platform.isAndroid) return;
+
+    nSetBusVolume(bus, volume);
+  }
+
+  /// Constant-power pan from -1 (left) to 1 (right).
+  static void setBusPan(int bus, double pan) {
+    if (!Platform.isAndroid) return;
+
+    nSetBusPan(bus, pan);
+  }
+
+  /// Turns idle mode on or off. It is on by default: once the transport is
+  /// stopped, or has nothing left to play, and every instrument has gone
+  /// quiet, the engine writes silence without rendering anything. With
+  /// releaseStream it also stops the audio stream after a few seconds idle,
+  /// which saves more power but makes the position lag behind until the next
+  /// call wakes it. Events, scheduling and play all wake the engine within a
+  /// buffer. Only Android has one; on iOS this does nothing.
+  static void setIdleMode(bool isEnabled, {bool releaseStream = false}) {
+    if (!Platform.isAndroid) return;
+
+    nSetIdleMode(isEnabled ? 1 : 0, releaseStream ? 1 : 0);
+  }
+
+  /// Whether the engine is idle. Always false on iOS.
+  static bool getIsIdle() {
+    if (!Platform.isAndroid) return false;
+
+    return nGetIsIdle() != 0;
+  }
+
+  static final _nativeMeterLevels = calloc<Uint8>(METER_LEVELS_SIZE);
+
+  /// Reads the levels of every track and of the mix in one call. Returns null
+  /// where metering isn't supported.
+  static MeterLevels? getMeterLevels() {
+    if (!Platform.isAndroid) return null;
+
+    nGetMeterLevels(_nativeMeterLevels);
+
+    return MeterLevels._(Uint8List.fromList(
+            _nativeMeterLevels.asTypedList(METER_LEVELS_SIZE))
+        .buffer
+        .asByteData());
+  }
+
+  /// Reads the transport as of the last rendered block in one call.
+  static TransportSnapshot getTransportSnapshot() {
+    nGetTransportSnapshot(_nativeTransportSnapshot);
+
+    return TransportSnapshot._(Uint8List.fromList(
+            _nativeTransportSnapshot.asTypedList(TRANSPORT_SNAPSHOT_SIZE))
+        .buffer
+        .asByteData());
+  }
+
   static int getBufferAvailableCount(int trackIndex) {
     return nGetBufferAvailableCount(trackIndex);
   }
 
-  static int handleEventsNow(int trackIndex, List<SchedulerEvent> events,
-      int sampleRate, double tempo) {
+  /// Gets the free space in several tracks' buffers with one native call.
+  static List<int> getBufferAvailableCounts(List<int> trackIndices) {
+    if (trackIndices.isEmpty) return [];
+
+    final nativeTrackIndices = calloc<Int32>(trackIndices.length);
+    final nativeCounts = calloc<Uint32>(trackIndices.length);
+    trackIndices.asMap().forEach((i, trackIndex) {
+      nativeTrackIndices[i] = trackIndex;
+    });
+
+    nGetBufferAvailableCounts(
+        nativeTrackIndices, trackIndices.length, nativeCounts);
+    final counts =
+        List<int>.generate(trackIndices.length, (i) => nativeCounts[i]);
+    calloc.free(nativeTrackIndices);
+    calloc.free(nativeCounts);
+
+    return counts;
+  }
+
+  static int handleEventsNow(int trackIndex, List<SchedulerEvent> events) {
     if (events.isEmpty) return 0;
 
     final Pointer<Uint8>? nativeArray =
         calloc<Uint8>(events.length * SCHEDULER_EVENT_SIZE);
     events.asMap().forEach((eventIndex, e) {
-      final byteData = e.serializeBytes(sampleRate, tempo, 0);
+      final byteData = e.serializeBytes(0);
       for (var byteIndex = 0; byteIndex < byteData.lengthInBytes; byteIndex++) {
         nativeArray![eventIndex * SCHEDULER_EVENT_SIZE + byteIndex] =
             byteData.getUint8(byteIndex);
@@ -193,14 +668,14 @@ class NativeBridge {
     return nHandleEventsNow(trackIndex, nativeArray, events.length);
   }
 
-  static int scheduleEvents(int trackIndex, List<SchedulerEvent> events,
-      int sampleRate, double tempo, int frameOffset) {
+  static int scheduleEvents(
+      int trackIndex, List<SchedulerEvent> events, int tickOffset) {
     if (events.isEmpty) return 0;
 
     final Pointer<Uint8>? nativeArray =
         calloc<Uint8>(events.length * SCHEDULER_EVENT_SIZE);
     events.asMap().forEach((eventIndex, e) {
-      final byteData = e.serializeBytes(sampleRate, tempo, frameOffset);
+      final byteData = e.serializeBytes(tickOffset);
       for (var byteIndex = 0; byteIndex < byteData.lengthInBytes; byteIndex++) {
         nativeArray![eventIndex * SCHEDULER_EVENT_SIZE + byteIndex] =
             byteData.getUint8(byteIndex);
@@ -214,6 +689,99 @@ class NativeBridge {
     nClearEvents(trackIndex, fromTick);
   }
 
+  /// Adds events to the track's native event store, in any order. Returns
+  /// an id for each event, which can be passed to removeEvents later.
+  static List<int> insertEvents(
+      int trackIndex, List<SchedulerEvent> events, int tickOffset) {
+    if (events.isEmpty) return [];
+
+    final nativeArray = calloc<Uint8>(events.length * SCHEDULER_EVENT_SIZE);
+    final nativeIds = calloc<Uint32>(events.length);
+    events.asMap().forEach((eventIndex, e) {
+      final byteData = e.serializeBytes(tickOffset);
+      for (var byteIndex = 0; byteIndex < byteData.lengthInBytes; byteIndex++) {
+        nativeArray[eventIndex * SCHEDULER_EVENT_SIZE + byteIndex] =
+            byteData.getUint8(byteIndex);
+      }
+    });
+
+    final insertedCount =
+        nInsertEvents(trackIndex, nativeArray, events.length, nativeIds);
+    final ids = List<int>.generate(insertedCount, (i) => nativeIds[i]);
+    calloc.free(nativeArray);
+    calloc.free(nativeIds);
+
+    return ids;
+  }
+
+  static int removeEvents(int trackIndex, List<int> ids) {
+    if (ids.isEmpty) return 0;
+
+    final nativeIds = calloc<Uint32>(ids.length);
+    ids.asMap().forEach((i, id) => nativeIds[i] = id);
+
+    final removedCount = nRemoveEvents(trackIndex, nativeIds, ids.length);
+    calloc.free(nativeIds);
+
+    return removedCount;
+  }
+
+  /// Removes the stored events from fromTick up to but not including toTick.
+  static int eraseEvents(int trackIndex, int fromTick, int toTick) {
+    return nEraseEvents(trackIndex, fromTick, toTick);
+  }
+
+  /// Hands a loop to the native scheduler, which repeats the events every
+  /// loopLengthTicks from loopStartTick on. tickOffset must make the event
+  /// ticks relative to the start of the loop.
+  static int setTrackLoop(int trackIndex, List<SchedulerEvent> events,
+      int tickOffset, int loopStartTick, int loopLengthTicks) {
+    final Pointer<Uint8> nativeArray =
+        calloc<Uint8>(max(events.length, 1) * SCHEDULER_EVENT_SIZE);
+    events.asMap().forEach((eventIndex, e) {
+      final byteData = e.serializeBytes(tickOffset);
+      for (var byteIndex = 0; byteIndex < byteData.lengthInBytes; byteIndex++) {
+        nativeArray[eventIndex * SCHEDULER_EVENT_SIZE + byteIndex] =
+            byteData.getUint8(byteIndex);
+      }
+    });
+
+    final eventsSyncedCount = nSetTrackLoop(trackIndex, loopStartTick,
+        loopLengthTicks, nativeArray, events.length);
+    calloc.free(nativeArray);
+
+    return eventsSyncedCount;
+  }
+
+  static void clearTrackLoop(int trackIndex) {
+    nClearTrackLoop(trackIndex);
+  }
+
+  /// From the next render on, the scheduler reads event times as ticks
+  /// (TICKS_PER_BEAT per beat) and converts them to frames with its own tempo
+  /// map. Tick 0 plays on originFrame. Returns false if the scheduler is
+  /// still busy with earlier tempo changes.
+  static bool setTickTimebase(int originFrame, int sampleRate) {
+    return nSetTickTimebase(originFrame, sampleRate) != 0;
+  }
+
+  /// Goes back to reading event times as frames.
+  static bool setFrameTimebase() {
+    return nSetFrameTimebase() != 0;
+  }
+
+  /// Holds the tempo from tick onwards. Events that are already scheduled in
+  /// ticks move with it. Leave out the tick to change the tempo wherever the
+  /// playhead is.
+  static bool setTempo(double bpm, {int tick = TEMPO_TICK_NOW}) {
+    return nSetTempo(tick, bpm) != 0;
+  }
+
+  /// Ramps linearly from the tempo at startTick to endBpm at endTick.
+  static bool rampTempo(int startTick, int endTick, double endBpm) {
+    return nRampTempo(startTick, endTick, endBpm) != 0;
+  }
+
   static void play() {
     nPlay();
   }
@@ -221,4 +789,292 @@ class NativeBridge {
   static void pause() {
     nPause();
   }
+
+  /// Renders numFrames from the current position to a file, as fast as
+  /// possible, with the output stopped until it's done. Completes with the
+  /// realtime factor that was reached, or -1 if the render failed or another
+  /// one is still running. While it runs, play and pause only choose whether
+  /// the transport plays afterwards. Always -1 on iOS.
+  static Future<double> renderOffline(String path, int numFrames,
+      {int format = AUDIO_FILE_FORMAT_WAV_FLOAT}) {
+    if (!Platform.isAndroid) return Future.value(-1.0);
+
+    return singleResponseFuture<double>((port) {
+      final pathUtf8Ptr = path.toNativeUtf8();
+      nRenderOffline(pathUtf8Ptr, format, numFrames, port.nativePort);
+      malloc.free(pathUtf8Ptr);
+    });
+  }
+
+  /// Stops a running offline render after the block it's on. Its future
+  /// completes with -1. Does nothing if no render is running.
+  static void cancelOfflineRender() {
+    if (!Platform.isAndroid) return;
+
+    nCancelOfflineRender();
+  }
+}
+
+class _ScheduleRun {
+  _ScheduleRun(this.trackIndex, this.events, this.tickOffset, this.onScheduled);
+
+  final int trackIndex;
+  final List<SchedulerEvent> events;
+  final int tickOffset;
+  final void Function(int acceptedCount)? onScheduled;
+}
+
+/// Peak and RMS levels of one channel pair, from 0 to 1 for a full-scale
+/// signal. Mono output has the same levels on both channels.
+class ChannelLevels {
+  const ChannelLevels(this.peaks, this.rms);
+
+  final List<double> peaks;
+  final List<double> rms;
+}
+
+/// The levels of every track mixed in the last meter window, after its volume
+/// and pan, and of the whole mix.
+class MeterLevels {
+  MeterLevels._(this._data);
+
+  final ByteData _data;
+
+  int get windowFrames => _data.getUint32(0, Endian.host);
+
+  ChannelLevels get master => _readLevels(8);
+
+  /// Returns null if the track wasn't mixed in the last window.
+  ChannelLevels? getTrack(int trackIndex) {
+    final tracksCount = _data.getUint32(4, Endian.host);
+
+    for (var i = 0; i < tracksCount; i++) {
+      final offset = 24 + i * 20;
+
+      if (_data.getInt32(offset, Endian.host) == trackIndex) {
+        return _readLevels(offset + 4);
+      }
+    }
+
+    return null;
+  }
+
+  ChannelLevels _readLevels(int offset) {
+    return ChannelLevels([
+      _data.getFloat32(offset, Endian.host),
+      _data.getFloat32(offset + 4, Endian.host),
+    ], [
+      _data.getFloat32(offset + 8, Endian.host),
+      _data.getFloat32(offset + 12, Endian.host),
+    ]);
+  }
+}
+
+/// {@macro flutter_sequencer_library_private}
+/// The transport as of the last block the audio thread rendered. The position
+/// and the time it was rendered at are published together, so they always
+/// match.
+class TransportSnapshot {
+  TransportSnapshot._(this._data);
+
+  final ByteData _data;
+
+  /// When the block was rendered, in microseconds on the native monotonic
+  /// clock. 0 if nothing has been rendered yet.
+  int get hostTimeUs => _data.getUint64(0, Endian.host);
+
+  /// When this snapshot was read, on the same clock as [hostTimeUs].
+  int get readTimeUs => _data.getUint64(8, Endian.host);
+
+  /// The position after the block.
+  int get positionFrame => _data.getUint32(16, Endian.host);
+
+  int get blockFrames => _data.getUint32(20, Endian.host);
+
+  /// How long a rendered frame takes to reach the speaker.
+  int get outputLatencyFrames => _data.getUint32(24, Endian.host);
+
+  bool get isPlaying => _data.getUint32(28, Endian.host) != 0;
+
+  int get _tracksCount => _data.getUint32(32, Endian.host);
+
+  /// Frames played since the block was rendered, estimated from the time
+  /// that has passed. Never more than a block, in case rendering has stopped.
+  int getFramesSinceRender(int sampleRate) {
+    if (hostTimeUs == 0) return 0;
+
+    final elapsedUs = max(0, readTimeUs - hostTimeUs);
+    final frames = (elapsedUs * SECONDS_PER_US * sampleRate).round();
+
+    return min(frames, blockFrames);
+  }
+
+  /// The number of events scheduled on a track that haven't played yet, or
+  /// null if the track wasn't rendered in the block.
+  int? getBufferedCount(int trackIndex) {
+    for (var i = 0; i < _tracksCount; i++) {
+      final offset = 40 + i * 8;
+
+      if (_data.getInt32(offset, Endian.host) == trackIndex) {
+        return _data.getUint32(offset + 4, Endian.host);
+      }
+    }
+
+    return null;
+  }
+}
+
+/// {@macro flutter_sequencer_library_private}
+/// A track's native event buffer, mapped into Dart so events can be written
+/// into it in place. Only this isolate writes to it. The audio thread only
+/// sees new events once their write position is published.
+class EventRing {
+  EventRing._(this.trackIndex, this.events, this.readPosition,
+      this.writePosition, this.capacity)
+      : eventBytes = events.asTypedList(capacity * SCHEDULER_EVENT_SIZE)
+            .buffer
+            .asByteData();
+
+  static final _rings = <int, EventRing>{};
+
+  /// Gets a track's ring, or null if the track doesn't exist.
+  static EventRing? forTrack(int trackIndex) {
+    final existingRing = _rings[trackIndex];
+    if (existingRing != null) return existingRing;
+
+    final eventsOut = calloc<Pointer<Uint8>>();
+    final readPositionOut = calloc<Pointer<Uint32>>();
+    final writePositionOut = calloc<Pointer<Uint32>>();
+    final capacity = nGetEventRing(
+        trackIndex, eventsOut, readPositionOut, writePositionOut);
+
+    final ring = capacity == 0
+        ? null
+        : EventRing._(trackIndex, eventsOut.value, readPositionOut.value,
+            writePositionOut.value, capacity);
+    calloc.free(eventsOut);
+    calloc.free(readPositionOut);
+    calloc.free(writePositionOut);
+
+    if (ring != null) _rings[trackIndex] = ring;
+    return ring;
+  }
+
+  /// Must be called when the track is removed, since its ring is reused.
+  static void forget(int trackIndex) {
+    _rings.remove(trackIndex);
+  }
+
+  final int trackIndex;
+  final Pointer<Uint8> events;
+  final Pointer<Uint32> readPosition;
+  final Pointer<Uint32> writePosition;
+  final int capacity;
+  final ByteData eventBytes;
+
+  /// How many more events fit before the ring is full, counting only what has
+  /// been published.
+  int get freeCount =>
+      capacity - ((writePosition.value - readPosition.value) & 0xFFFFFFFF);
+
+  /// Serializes events straight into the ring from writeIndex on, stopping
+  /// when it's full. Returns how many were written. They aren't visible to
+  /// the audio thread until the new write index is published.
+  int write(
+      int writeIndex, List<SchedulerEvent> eventsToWrite, int tickOffset) {
+    final usedCount = (writeIndex - readPosition.value) & 0xFFFFFFFF;
+    final count = min(capacity - usedCount, eventsToWrite.length);
+
+    for (var i = 0; i < count; i++) {
+      final slot = (writeIndex + i) & (capacity - 1);
+
+      eventsToWrite[i]
+          .serializeInto(eventBytes, slot * SCHEDULER_EVENT_SIZE, tickOffset);
+    }
+
+    return count;
+  }
+}
+
+/// {@macro flutter_sequencer_library_private}
+/// Collects events for any number of tracks and schedules them all at once.
+/// Each run of events is written straight into its track's event ring, in
+/// the order it was added to the batch, and the rings are published with a
+/// single call into native code.
+class ScheduleBatch {
+  final _runs = <_ScheduleRun>[];
+  final _queuedCounts = <int, int>{};
+
+  bool get isEmpty => _runs.isEmpty;
+
+  /// How many more events the track's buffer can take, after what is already
+  /// queued for it. 0 if the track doesn't exist.
+  int getFreeCount(int trackIndex) {
+    final ring = EventRing.forTrack(trackIndex);
+    if (ring == null) return 0;
+
+    return max(0, ring.freeCount - (_queuedCounts[trackIndex] ?? 0));
+  }
+
+  /// Queues as many of the events as fit in the track's buffer, after what is
+  /// already queued for it, and returns how many that is. The audio thread
+  /// only frees space until the batch is flushed, so all of them are accepted.
+  /// onScheduled is called on flush with the same count.
+  int add(int trackIndex, List<SchedulerEvent> events, int tickOffset,
+      [void Function(int acceptedCount)? onScheduled]) {
+    final acceptedCount = min(getFreeCount(trackIndex), events.length);
+
+    _queuedCounts[trackIndex] =
+        (_queuedCounts[trackIndex] ?? 0) + acceptedCount;
+    _runs.add(_ScheduleRun(trackIndex, events.sublist(0, acceptedCount),
+        tickOffset, onScheduled));
+
+    return acceptedCount;
+  }
+
+  /// Schedules everything queued so far and empties the batch.
+  void flush() {
+    if (_runs.isEmpty) return;
+
+    // Where each track's next event goes, until they're all published
+    final writeIndices = <int, int>{};
+    final acceptedCounts = <int>[];
+
+    for (final run in _runs) {
+      final ring = EventRing.forTrack(run.trackIndex);
+      if (ring == null) {
+        acceptedCounts.add(0);
+        continue;
+      }
+
+      final writeIndex =
+          writeIndices[run.trackIndex] ?? ring.writePosition.value;
+      final acceptedCount =
+          ring.write(writeIndex, run.events, run.tickOffset);
+
+      writeIndices[run.trackIndex] = (writeIndex + acceptedCount) & 0xFFFFFFFF;
+      acceptedCounts.add(acceptedCount);
+    }
+
+    final nativeTrackIndices = calloc<Int32>(max(writeIndices.length, 1));
+    final nativeWriteIndices = calloc<Uint32>(max(writeIndices.length, 1));
+    var i = 0;
+    writeIndices.forEach((trackIndex, writeIndex) {
+      nativeTrackIndices[i] = trackIndex;
+      nativeWriteIndices[i] = writeIndex;
+      i++;
+    });
+
+    nPublishEventRings(
+        nativeTrackIndices, nativeWriteIndices, writeIndices.length);
+    calloc.free(nativeTrackIndices);
+    calloc.free(nativeWriteIndices);
+
+    for (var runIndex = 0; runIndex < _runs.length; runIndex++) {
+      _runs[runIndex].onScheduled?.call(acceptedCounts[runIndex]);
+    }
+
+    _runs.clear();
+    _queuedCounts.clear();
+  }
 }
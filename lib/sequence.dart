@@ -29,11 +29,13 @@ class Sequence {
   /// Call this to remove this sequence and its tracks from the global sequencer
   /// engine.
   void destroy() {
+    cancelLoads();
     _tracks.values.forEach((track) => deleteTrack(track));
     globalState.unregisterSequence(this);
   }
 
   final _tracks = <int, Track>{};
+  final _pendingLoadIds = <Instrument, int>{};
   late int id;
 
   // Sequencer state
@@ -42,6 +44,7 @@ class Sequence {
   double endBeat;
   double pauseBeat = 0;
   int engineStartFrame = 0;
+  int engineStartTick = 0;
   LoopState loopState = LoopState.Off;
   double loopStartBeat = 0;
   double loopEndBeat = 0;
@@ -52,14 +55,19 @@ class Sequence {
   }
 
   /// Creates tracks in the underlying sequencer engine.
-  Future<List<Track>> createTracks(List<Instrument> instruments) async {
+  ///
+  /// On Android, instruments with a higher priority in [priorities] load
+  /// first, so tracks that are visible or about to play can be ready sooner.
+  /// Instruments that fail to load or are cancelled get no track.
+  Future<List<Track>> createTracks(List<Instrument> instruments,
+      {List<int>? priorities}) async {
     if (globalState.isEngineReady) {
-      return _createTracks(instruments);
+      return _createTracks(instruments, priorities);
     } else {
       final completer = Completer<List<Track>>.sync();
 
       globalState.onEngineReady(() async {
-        final tracks = await _createTracks(instruments);
+        final tracks = await _createTracks(instruments, priorities);
 
         completer.complete(tracks);
       });
@@ -68,6 +76,18 @@ class Sequence {
     }
   }
 
+  /// Moves an instrument that is still waiting to load up or down the queue.
+  void setLoadPriority(Instrument instrument, int priority) {
+    final loadId = _pendingLoadIds[instrument];
+
+    if (loadId != null) NativeBridge.setLoadPriority(loadId, priority);
+  }
+
+  /// Cancels every instrument of this sequence that hasn't loaded yet.
+  void cancelLoads() {
+    _pendingLoadIds.values.forEach(NativeBridge.cancelLoad);
+  }
+
   /// Removes a track from the underlying sequencer engine.
   List<Track> deleteTrack(Track track) {
     final keysToRemove = [];
@@ -120,25 +140,26 @@ class Sequence {
     });
   }
 
-  /// Sets the tempo.
+  /// Sets the tempo. Sequences that play at the same time share the engine's
+  /// tempo, so this changes it for all of them, and a sequence that starts
+  /// while others are playing takes on theirs.
   void setTempo(double nextTempo) {
-    // Update engine start frame to remove excess loops
-    final loopsElapsed = loopState == LoopState.BeforeLoopEnd
-        ? getLoopsElapsed(_getFramesRendered())
-        : 0;
-    engineStartFrame += loopsElapsed * getLoopLengthFrames();
+    if (isPlaying) {
+      globalState.setTempo(nextTempo);
+    } else {
+      tempo = nextTempo;
+    }
+  }
 
-    // Update engine start frame to adjust to new tempo
-    final framesRendered = _getFramesRendered();
-    final nextFramesRendered = (framesRendered * (tempo / nextTempo)).round();
-    final framesToAdvance = framesRendered - nextFramesRendered;
-    engineStartFrame += framesToAdvance;
+  /// {@macro flutter_sequencer_library_private}
+  /// Keeps the playhead on the same beat when the tempo changes at pivotFrame.
+  /// The events are scheduled in ticks, so they don't need syncing again.
+  void applyTempo(int pivotFrame, double nextTempo) {
+    final framesSinceStart = pivotFrame - engineStartFrame;
 
+    engineStartFrame =
+        pivotFrame - (framesSinceStart * (tempo / nextTempo)).round();
     tempo = nextTempo;
-
-    getTracks().forEach((track) {
-      track.syncBuffer();
-    });
   }
 
   /// Enables looping.
@@ -147,11 +168,12 @@ class Sequence {
     // doesn't start playing
     checkIsOver();
 
-    // Update engine start frame to remove excess loops
+    // Update engine start frame and tick to remove excess loops
     final loopsElapsed = loopState == LoopState.BeforeLoopEnd
         ? getLoopsElapsed(_getFramesRendered())
         : 0;
     engineStartFrame += loopsElapsed * getLoopLengthFrames();
+    engineStartTick += loopsElapsed * getLoopLengthTicks();
 
     // Update loop state and bounds
     final loopEndFrame = beatToFrames(loopEndBeat);
@@ -175,6 +197,7 @@ class Sequence {
       final loopsElapsed = getLoopsElapsed(_getFramesRendered());
 
       engineStartFrame += loopsElapsed * getLoopLengthFrames();
+      engineStartTick += loopsElapsed * getLoopLengthTicks();
     }
 
     loopStartBeat = 0;
@@ -203,11 +226,15 @@ class Sequence {
 
     final frame = beatToFrames(beat) - leadFrames;
 
-    engineStartFrame = NativeBridge.getPosition() - frame;
+    final position = NativeBridge.getPosition();
+
+    engineStartFrame = position - frame;
+    engineStartTick =
+        globalState.getTickAtFrame(position) - beatToTicks(framesToBeat(frame));
     pauseBeat = beat;
 
     getTracks().forEach((track) {
-      track.syncBuffer(engineStartFrame);
+      track.syncBuffer(engineStartTick);
     });
 
     if (loopState != LoopState.Off) {
@@ -249,28 +276,41 @@ class Sequence {
     return loopEndFrame - loopStartFrame;
   }
 
+  /// {@macro flutter_sequencer_library_private}
+  /// Returns the length of the loop in engine ticks.
+  int getLoopLengthTicks() {
+    return beatToTicks(loopEndBeat) - beatToTicks(loopStartBeat);
+  }
+
   /// {@macro flutter_sequencer_library_private}
   /// Returns the number of loops that have been played
   /// since the sequence started playing.
   int getLoopsElapsed(int frame) {
-    final loopStartFrame = beatToFrames(loopStartBeat);
-
-    if (frame <= loopStartFrame) return 0;
-    if (getLoopLengthFrames() == 0) return 0;
+    return _getLoopsElapsed(
+        frame, beatToFrames(loopStartBeat), getLoopLengthFrames());
+  }
 
-    return ((frame - loopStartFrame) / getLoopLengthFrames()).floor();
+  /// {@macro flutter_sequencer_library_private}
+  /// Returns the number of loops that have been played by a tick relative to
+  /// the start of the sequence.
+  int getLoopsElapsedAtTick(int tick) {
+    return _getLoopsElapsed(
+        tick, beatToTicks(loopStartBeat), getLoopLengthTicks());
   }
 
   /// {@macro flutter_sequencer_library_private}
   /// Maps a frame beyond the end of the loop range to
   /// where it would be inside the loop range.
   int getLoopedFrame(int frame) {
-    final loopStartFrame = beatToFrames(loopStartBeat);
-    final loopLengthFrames = getLoopLengthFrames();
-
-    if (frame <= loopStartFrame || loopLengthFrames == 0) return frame;
+    return _getLooped(
+        frame, beatToFrames(loopStartBeat), getLoopLengthFrames());
+  }
 
-    return ((frame - loopStartFrame) % loopLengthFrames) + loopStartFrame;
+  /// {@macro flutter_sequencer_library_private}
+  /// Maps a tick beyond the end of the loop range to
+  /// where it would be inside the loop range.
+  int getLoopedTick(int tick) {
+    return _getLooped(tick, beatToTicks(loopStartBeat), getLoopLengthTicks());
   }
 
   /// {@macro flutter_sequencer_library_private}
@@ -282,6 +322,12 @@ class Sequence {
     return Sequence.globalState.usToFrames(us);
   }
 
+  /// {@macro flutter_sequencer_library_private}
+  /// Converts a beat to engine ticks, which don't depend on the tempo.
+  int beatToTicks(double beat) {
+    return (beat * TICKS_PER_BEAT).round();
+  }
+
   /// {@macro flutter_sequencer_library_private}
   /// Converts sample frames to a beat.
   double framesToBeat(int frames) {
@@ -302,6 +348,18 @@ class Sequence {
     }
   }
 
+  int _getLoopsElapsed(int position, int loopStart, int loopLength) {
+    if (position <= loopStart || loopLength == 0) return 0;
+
+    return ((position - loopStart) / loopLength).floor();
+  }
+
+  int _getLooped(int position, int loopStart, int loopLength) {
+    if (position <= loopStart || loopLength == 0) return position;
+
+    return ((position - loopStart) % loopLength) + loopStart;
+  }
+
   /// Number of frames elapsed since the sequence was started. Does not account
   /// for the number of loops that may have occurred.
   int _getFramesRendered() {
@@ -315,8 +373,9 @@ class Sequence {
     if (!globalState.isEngineReady) return 0;
 
     if (isPlaying) {
-      final frame = _getFramesRendered() +
-          (estimateFramesSinceLastRender ? _getFramesSinceLastRender() : 0);
+      final frame = estimateFramesSinceLastRender
+          ? _getEstimatedFramesRendered()
+          : _getFramesRendered();
       final loopedFrame =
           loopState == LoopState.Off ? frame : getLoopedFrame(frame);
 
@@ -326,19 +385,30 @@ class Sequence {
     }
   }
 
-  /// Returns the number of frames elapsed since the last audio render callback
-  /// was called.
-  int _getFramesSinceLastRender() {
-    final microsecondsSinceLastRender = max(
-        0,
-        DateTime.now().microsecondsSinceEpoch -
-            NativeBridge.getLastRenderTimeUs());
-
-    return globalState.usToFrames(microsecondsSinceLastRender);
+  /// Estimates the number of frames elapsed since the sequence was started,
+  /// including those played since the last audio render callback. The
+  /// position and render time come from one snapshot, so they always match.
+  int _getEstimatedFramesRendered() {
+    final snapshot = NativeBridge.getTransportSnapshot();
+    final sampleRate = globalState.sampleRate ?? 0;
+
+    return snapshot.positionFrame +
+        snapshot.getFramesSinceRender(sampleRate) -
+        engineStartFrame -
+        LEAD_FRAMES;
   }
 
-  Future<Track?> _createTrack(Instrument instrument) async {
-    final track = await Track.build(sequence: this, instrument: instrument);
+  Future<Track?> _createTrack(Instrument instrument, int priority) async {
+    final loadId = NativeBridge.allocateLoadId();
+    _pendingLoadIds[instrument] = loadId;
+
+    final track = await Track.build(
+        sequence: this,
+        instrument: instrument,
+        loadId: loadId,
+        priority: priority);
+
+    _pendingLoadIds.remove(instrument);
 
     if (track != null) {
       _tracks.putIfAbsent(track.id, () => track);
@@ -347,9 +417,10 @@ class Sequence {
     return track;
   }
 
-  Future<List<Track>> _createTracks(List<Instrument> instruments) async {
-    final tracks = await Future.wait(
-        instruments.map((instrument) => _createTrack(instrument)));
+  Future<List<Track>> _createTracks(
+      List<Instrument> instruments, List<int>? priorities) async {
+    final tracks = await Future.wait(instruments.asMap().entries.map(
+        (entry) => _createTrack(entry.value, priorities?[entry.key] ?? 0)));
     final nonNullTracks = tracks.whereType<Track>().toList();
 
     return nonNullTracks;
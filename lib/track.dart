@@ -6,6 +6,7 @@ import 'package:path/path.dart' as p;
 import 'constants.dart';
 import 'models/instrument.dart';
 import 'models/events.dart';
+import 'models/sfizz_config.dart';
 import 'native_bridge.dart';
 import 'sequence.dart';
 
@@ -16,19 +17,30 @@ class Track {
   final int id;
   final Instrument instrument;
   final events = <SchedulerEvent>[];
-  int lastFrameSynced = 0;
+  int lastTickSynced = 0;
+
+  /// Whether the native scheduler is repeating the loop range on its own. Once
+  /// it is, the buffer doesn't need topping off until the events change.
+  bool _isLoopNative = false;
 
   Track._withId(
       {required this.sequence, required this.id, required this.instrument});
 
   /// Creates a track in the underlying sequencer engine.
   static Future<Track?> build(
-      {required Sequence sequence, required Instrument instrument}) async {
+      {required Sequence sequence,
+      required Instrument instrument,
+      int? loadId,
+      int priority = 0}) async {
     int? id;
 
     if (instrument is Sf2Instrument) {
       id = await NativeBridge.addTrackSf2(
-          instrument.idOrPath, instrument.isAsset, instrument.presetIndex);
+          instrument.idOrPath, instrument.isAsset, instrument.presetIndex,
+          maxVoices: instrument.maxVoices,
+          stealPolicy: instrument.stealPolicy,
+          loadId: loadId,
+          priority: priority);
     } else if (instrument is SfzInstrument) {
       final sfzFile = File(instrument.idOrPath);
       String? normalizedSfzPath;
@@ -46,7 +58,8 @@ class Track {
       }
 
       id = await NativeBridge.addTrackSfz(
-          normalizedSfzPath, instrument.tuningPath);
+          normalizedSfzPath, instrument.tuningPath,
+          config: instrument.config, loadId: loadId, priority: priority);
     } else if (instrument is RuntimeSfzInstrument) {
       final sfzContent = instrument.sfz.buildString();
       String? normalizedSampleRoot;
@@ -66,7 +79,8 @@ class Track {
       final fakeSfzDir = '$normalizedSampleRoot/does_not_exist.sfz';
 
       id = await NativeBridge.addTrackSfzString(
-          fakeSfzDir, sfzContent, instrument.tuningString);
+          fakeSfzDir, sfzContent, instrument.tuningString,
+          config: instrument.config, loadId: loadId, priority: priority);
     } else if (instrument is AudioUnitInstrument) {
       id = await NativeBridge.addTrackAudioUnit(instrument.idOrPath);
     } else {
@@ -91,8 +105,7 @@ class Track {
         noteNumber: noteNumber,
         velocity: _velocityToMidi(velocity));
 
-    NativeBridge.handleEventsNow(
-        id, [event], Sequence.globalState.sampleRate!, sequence.tempo);
+    NativeBridge.handleEventsNow(id, [event]);
   }
 
   /// Handles a Note Off event on this track immediately.
@@ -101,8 +114,7 @@ class Track {
     final nextBeat = sequence.getBeat();
     final event = MidiEvent.ofNoteOff(beat: nextBeat, noteNumber: noteNumber);
 
-    NativeBridge.handleEventsNow(
-        id, [event], Sequence.globalState.sampleRate!, sequence.tempo);
+    NativeBridge.handleEventsNow(id, [event]);
   }
 
   /// Handles a MIDI CC event on this track immediately.
@@ -112,8 +124,7 @@ class Track {
     final event =
         MidiEvent.cc(beat: nextBeat, ccNumber: ccNumber, ccValue: ccValue);
 
-    NativeBridge.handleEventsNow(
-        id, [event], Sequence.globalState.sampleRate!, sequence.tempo);
+    NativeBridge.handleEventsNow(id, [event]);
   }
 
   /// Handles a MIDI pitch bend event on this track immediately.
@@ -122,8 +133,7 @@ class Track {
     final nextBeat = sequence.getBeat();
     final event = MidiEvent.pitchBend(beat: nextBeat, value: value);
 
-    NativeBridge.handleEventsNow(
-        id, [event], Sequence.globalState.sampleRate!, sequence.tempo);
+    NativeBridge.handleEventsNow(id, [event]);
   }
 
   /// Handles a Volume Change event on this track immediately.
@@ -132,8 +142,16 @@ class Track {
     final nextBeat = sequence.getBeat();
     final event = VolumeEvent(beat: nextBeat, volume: volume);
 
-    NativeBridge.handleEventsNow(
-        id, [event], Sequence.globalState.sampleRate!, sequence.tempo);
+    NativeBridge.handleEventsNow(id, [event]);
+  }
+
+  /// Changes how much of this track goes to a SendBus immediately.
+  /// The event will not be added to this track's events.
+  void changeSendNow({required int sendBus, required double level}) {
+    final nextBeat = sequence.getBeat();
+    final event = SendEvent(beat: nextBeat, sendBus: sendBus, level: level);
+
+    NativeBridge.handleEventsNow(id, [event]);
   }
 
   /// Adds a Note On and Note Off event to this track.
@@ -210,11 +228,47 @@ class Track {
     _addEvent(volumeChangeEvent);
   }
 
+  /// Adds an event that changes how much of this track goes to a SendBus.
+  /// This does not sync the events to the backend.
+  void addSendChange(
+      {required int sendBus, required double level, required double beat}) {
+    final sendChangeEvent =
+        SendEvent(beat: beat, sendBus: sendBus, level: level);
+
+    _addEvent(sendChangeEvent);
+  }
+
+  /// Gets how much of the track goes to a SendBus. Always 0 on iOS.
+  double getSend(int sendBus) {
+    return NativeBridge.getTrackSend(id, sendBus);
+  }
+
   /// Gets the current volume of the track.
   double getVolume() {
     return NativeBridge.getTrackVolume(id);
   }
 
+  /// Gets the track's peak and RMS levels over the last meter window. Turn
+  /// metering on first with NativeBridge.setMeteringEnabled. Returns null on
+  /// iOS, or if the track wasn't mixed in the last window.
+  ChannelLevels? getLevels() {
+    return NativeBridge.getMeterLevels()?.getTrack(id);
+  }
+
+  /// Changes how an SFZ track trades memory against CPU. A new preload size or
+  /// oversampling factor reloads sample data, so this can take a while.
+  /// Completes with false if this isn't an SFZ track, an option was invalid,
+  /// or on iOS.
+  Future<bool> setSfizzConfig(SfizzConfig config) {
+    return NativeBridge.setTrackSfzConfig(id, config);
+  }
+
+  /// Gets the options an SFZ track is using, its estimated preload memory and
+  /// its render time. Returns null if this isn't an SFZ track, or on iOS.
+  SfizzStats? getSfizzStats() {
+    return NativeBridge.getTrackSfzStats(id);
+  }
+
   /// Clears all events on this track.
   /// This does not sync the events to the backend.
   void clearEvents() {
@@ -223,34 +277,48 @@ class Track {
 
   /// Syncs events to the backend. This should be called after making changes to
   /// track events to ensure that the changes are synced immediately.
+  ///
+  /// If a batch is given, the events are added to it instead of being sent
+  /// straight away, and are synced when the batch is flushed.
   void syncBuffer(
-      [int? absoluteStartFrame, int maxEventsToSync = BUFFER_SIZE]) {
-    final position = NativeBridge.getPosition();
-
-    if (absoluteStartFrame == null) {
-      absoluteStartFrame = position;
+      [int? absoluteStartTick,
+      int maxEventsToSync = BUFFER_SIZE,
+      ScheduleBatch? batch]) {
+    final positionTick =
+        Sequence.globalState.getTickAtFrame(NativeBridge.getPosition());
+
+    if (absoluteStartTick == null) {
+      absoluteStartTick = positionTick;
     } else {
-      absoluteStartFrame = max(absoluteStartFrame, position);
+      absoluteStartTick = max(absoluteStartTick, positionTick);
     }
 
-    NativeBridge.clearEvents(id, absoluteStartFrame);
+    NativeBridge.clearEvents(id, absoluteStartTick);
+    _clearNativeLoop();
 
     if (sequence.isPlaying) {
-      final relativeStartFrame = absoluteStartFrame - sequence.engineStartFrame;
-      _scheduleEvents(relativeStartFrame, maxEventsToSync);
+      final relativeStartTick = absoluteStartTick - sequence.engineStartTick;
+      final eventsBatch = batch ?? ScheduleBatch();
+
+      _scheduleEvents(relativeStartTick, maxEventsToSync, eventsBatch);
+      if (batch == null) eventsBatch.flush();
     } else {
-      lastFrameSynced = 0;
+      lastTickSynced = 0;
     }
   }
 
   /// {@macro flutter_sequencer_library_private}
   /// Triggers a sync that will fill any available space in the buffer with
-  /// any un-synced events.
-  void topOffBuffer() {
-    final bufferAvailableCount = NativeBridge.getBufferAvailableCount(id);
+  /// any un-synced events. Pass bufferAvailableCount and a batch to top off
+  /// many tracks with one native call each for the counts and the events.
+  void topOffBuffer([int? bufferAvailableCount, ScheduleBatch? batch]) {
+    if (_isLoopNative) return;
+
+    final availableCount =
+        bufferAvailableCount ?? NativeBridge.getBufferAvailableCount(id);
 
-    if (bufferAvailableCount > 0) {
-      syncBuffer(lastFrameSynced + 1, bufferAvailableCount);
+    if (availableCount > 0) {
+      syncBuffer(lastTickSynced + 1, availableCount, batch);
     }
   }
 
@@ -258,6 +326,7 @@ class Track {
   /// Clears any scheduled events in the backend.
   void clearBuffer() {
     NativeBridge.clearEvents(id, 0);
+    _clearNativeLoop();
   }
 
   /// Adds an event to the event list at the appropriate index given the sort
@@ -283,73 +352,119 @@ class Track {
 
   /// Builds events that can be scheduled in the sequencer engine's event buffer
   /// and adds them to eventsList.
-  void _scheduleEvents(int startFrame, [int maxEventsToSync = BUFFER_SIZE]) {
+  void _scheduleEvents(
+      int startTick, int maxEventsRequested, ScheduleBatch batch) {
+    // Counting against the space that's really left tells a full buffer apart
+    // from a range that ran out of events
+    final maxEventsToSync = min(maxEventsRequested, batch.getFreeCount(id));
+
     final isBeforeLoopEnd = sequence.loopState == LoopState.BeforeLoopEnd;
-    final loopLength = sequence.getLoopLengthFrames();
+    final loopLength = sequence.getLoopLengthTicks();
     final loopsElapsed = sequence.loopState == LoopState.Off
         ? 0
-        : sequence.getLoopsElapsed(startFrame);
+        : sequence.getLoopsElapsedAtTick(startTick);
 
     var eventsSyncedCount = _scheduleEventsInRange(
         maxEventsToSync,
-        isBeforeLoopEnd ? sequence.getLoopedFrame(startFrame) : startFrame,
-        sequence.beatToFrames(
+        isBeforeLoopEnd ? sequence.getLoopedTick(startTick) : startTick,
+        sequence.beatToTicks(
             isBeforeLoopEnd ? sequence.loopEndBeat : sequence.endBeat),
-        loopLength * loopsElapsed);
-
-    if (isBeforeLoopEnd) {
-      var loopIndex = loopsElapsed + 1;
-      var lastBatchCount = 0;
-      final loopStartFrame = sequence.beatToFrames(sequence.loopStartBeat);
-      final loopEndFrame = sequence.beatToFrames(sequence.loopEndBeat);
-
-      while (eventsSyncedCount < maxEventsToSync) {
-        // Schedule all events in one loop range
-        lastBatchCount = _scheduleEventsInRange(
-            maxEventsToSync - eventsSyncedCount,
-            loopStartFrame,
-            loopEndFrame,
-            loopLength * loopIndex);
-
-        eventsSyncedCount += lastBatchCount;
-        if (lastBatchCount == 0) break;
-        loopIndex++;
-      }
+        loopLength * loopsElapsed,
+        batch);
+
+    if (!isBeforeLoopEnd || eventsSyncedCount >= maxEventsToSync) return;
+
+    // Once the rest of the current loop iteration is in the buffer, the native
+    // scheduler repeats the loop range from the next iteration on.
+    if (loopLength > 0 && _setNativeLoop(loopLength * (loopsElapsed + 1))) {
+      return;
+    }
+
+    // The loop range has too many events for the native loop, so schedule
+    // loop iterations until the buffer is full
+    var loopIndex = loopsElapsed + 1;
+    var lastBatchCount = 0;
+    final loopStartTick = sequence.beatToTicks(sequence.loopStartBeat);
+    final loopEndTick = sequence.beatToTicks(sequence.loopEndBeat);
+
+    while (eventsSyncedCount < maxEventsToSync) {
+      // Schedule all events in one loop range
+      lastBatchCount = _scheduleEventsInRange(
+          maxEventsToSync - eventsSyncedCount,
+          loopStartTick,
+          loopEndTick,
+          loopLength * loopIndex,
+          batch);
+
+      eventsSyncedCount += lastBatchCount;
+      if (lastBatchCount == 0) break;
+      loopIndex++;
     }
   }
 
-  /// Schedules this track's events that start on or after startBeat and end
-  /// on or before endBeat. Adds frameOffset to every scheduled event.
-  int _scheduleEventsInRange(
-      int maxEventsToSync, int startFrame, int? endFrame, int frameOffset) {
+  /// Sends the events in the loop range to the native scheduler, to be
+  /// repeated from tickOffset, relative to the start of the sequence. Returns
+  /// false if the loop range holds more events than the native loop can.
+  bool _setNativeLoop(int tickOffset) {
+    final loopStartTick = sequence.beatToTicks(sequence.loopStartBeat);
+    final loopEndTick = sequence.beatToTicks(sequence.loopEndBeat);
+    final loopEvents = events.where((event) {
+      return event.tick >= loopStartTick && event.tick <= loopEndTick;
+    }).toList();
+
+    if (loopEvents.length > LOOP_MAX_EVENTS) return false;
+
+    NativeBridge.setTrackLoop(
+        id,
+        loopEvents,
+        -loopStartTick,
+        sequence.engineStartTick + loopStartTick + tickOffset,
+        loopEndTick - loopStartTick);
+    _isLoopNative = true;
+
+    return true;
+  }
+
+  void _clearNativeLoop() {
+    if (!_isLoopNative) return;
+
+    NativeBridge.clearTrackLoop(id);
+    _isLoopNative = false;
+  }
+
+  /// Adds this track's events from startTick up to and including endTick to
+  /// the batch. Adds tickOffset to every scheduled event. Returns the number
+  /// of events the buffer accepts, which can be fewer than were in range if
+  /// it's nearly full. lastTickSynced is updated once the batch is flushed.
+  int _scheduleEventsInRange(int maxEventsToSync, int startTick, int? endTick,
+      int tickOffset, ScheduleBatch batch) {
     final eventsToSync = <SchedulerEvent>[];
 
     for (var eventIndex = 0; eventIndex < events.length; eventIndex++) {
       if (eventsToSync.length == maxEventsToSync) break;
 
       final event = events[eventIndex];
-      final eventFrame = sequence.beatToFrames(event.beat);
 
-      if (eventFrame < startFrame) continue;
-      if (endFrame != null && eventFrame > endFrame) break;
+      if (event.tick < startTick) continue;
+      if (endTick != null && event.tick > endTick) break;
 
       eventsToSync.add(event);
     }
 
-    final eventsSyncedCount = NativeBridge.scheduleEvents(
-        id,
-        eventsToSync,
-        Sequence.globalState.sampleRate!,
-        sequence.tempo,
-        sequence.engineStartFrame + frameOffset);
-
-    if (eventsSyncedCount > 0) {
-      lastFrameSynced = sequence.engineStartFrame +
-          sequence.beatToFrames(eventsToSync[eventsSyncedCount - 1].beat) +
-          frameOffset;
-    }
+    if (eventsToSync.isEmpty) return 0;
+
+    final absoluteTickOffset = sequence.engineStartTick + tickOffset;
+
+    return batch.add(id, eventsToSync, absoluteTickOffset, (eventsSyncedCount) {
+      if (eventsSyncedCount > 0) {
+        lastTickSynced =
+            absoluteTickOffset + eventsToSync[eventsSyncedCount - 1].tick;
+      }
+    });
+  }
 
-    return eventsSyncedCount;
+  bool _isLevelEvent(SchedulerEvent event) {
+    return event is VolumeEvent || event is SendEvent;
   }
 
   /// Used for ordering events.
@@ -361,10 +476,10 @@ class Track {
     } else {
       // Beats are the same
 
-      if (eventA is VolumeEvent && !(eventB is VolumeEvent)) {
-        // Volume should come before anything else
+      if (_isLevelEvent(eventA) && !_isLevelEvent(eventB)) {
+        // Volume and sends should come before anything else
         return -1;
-      } else if (eventB is VolumeEvent && !(eventA is VolumeEvent)) {
+      } else if (_isLevelEvent(eventB) && !_isLevelEvent(eventA)) {
         return 1;
       } else if (eventA is MidiEvent && eventB is MidiEvent) {
         // Note off should come before note on if the note is the same